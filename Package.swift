@@ -49,7 +49,8 @@ let package = Package(
                 .linkedFramework("AppTrackingTransparency"),
                 .linkedFramework("WebKit"),
                 .linkedFramework("CoreGraphics"),
-                .linkedFramework("StoreKit")
+                .linkedFramework("StoreKit"),
+                .linkedLibrary("z")
             ]
         ),
         .testTarget(
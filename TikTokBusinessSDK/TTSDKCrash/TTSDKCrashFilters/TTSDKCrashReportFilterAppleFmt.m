@@ -34,6 +34,7 @@
 
 #import "TTSDKCPU.h"
 #import "TTSDKCrashReportFields.h"
+#import "TTSDKJSONCodec.h"
 #import "TTSDKJSONCodecObjC.h"
 
 // #define TTSDKLogger_LocalLevel TRACE
@@ -396,6 +397,30 @@ static NSDictionary *g_registerOrders;
     return [crash objectForKey:TTSDKCrashField_CrashedThread];
 }
 
+/** Stack dumps are shown as hex, whichever data encoding the report was written with. */
+- (NSString *)stackContentsStringForReport:(NSDictionary *)report stack:(NSDictionary *)stack
+{
+    NSString *contents = [stack objectForKey:TTSDKCrashField_Contents];
+    NSString *dataEncoding = [[self infoReport:report] objectForKey:TTSDKCrashField_DataEncoding];
+    if (![dataEncoding isEqualToString:@"base64"] || ![contents isKindOfClass:[NSString class]]) {
+        return contents;
+    }
+
+    NSData *encoded = [contents dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *decoded = [NSMutableData dataWithLength:encoded.length / 4 * 3];
+    int decodedLength = (int)decoded.length;
+    if (ttsdkjson_decodeDataElement(encoded.bytes, (int)encoded.length, TTSDKJSONDataEncodingBase64,
+                                    decoded.mutableBytes, &decodedLength) != TTSDKJSON_OK) {
+        return contents;
+    }
+    const unsigned char *bytes = decoded.bytes;
+    NSMutableString *hex = [NSMutableString stringWithCapacity:(NSUInteger)decodedLength * 2];
+    for (int i = 0; i < decodedLength; i++) {
+        [hex appendFormat:@"%02X", bytes[i]];
+    }
+    return hex;
+}
+
 - (NSString *)mainExecutableNameForReport:(NSDictionary *)report
 {
     NSDictionary *info = [self infoReport:report];
@@ -552,7 +577,7 @@ static NSDictionary *g_registerOrders;
             [str appendFormat:@"\nStack Dump (" FMT_PTR_LONG "-" FMT_PTR_LONG "):\n\n%@\n",
                               (uintptr_t)[[stack objectForKey:TTSDKCrashField_DumpStart] unsignedLongLongValue],
                               (uintptr_t)[[stack objectForKey:TTSDKCrashField_DumpEnd] unsignedLongLongValue],
-                              [stack objectForKey:TTSDKCrashField_Contents]];
+                              [self stackContentsStringForReport:report stack:stack]];
         }
 
         NSDictionary *notableAddresses = [crashedThread objectForKey:TTSDKCrashField_NotableAddresses];
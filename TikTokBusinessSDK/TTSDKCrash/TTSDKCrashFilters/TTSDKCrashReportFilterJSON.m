@@ -55,6 +55,11 @@
 {
     NSMutableArray<id<TTSDKCrashReport>> *filteredReports = [NSMutableArray arrayWithCapacity:[reports count]];
     for (TTSDKCrashReportDictionary *report in reports) {
+        if ([report isKindOfClass:[TTSDKCrashReportData class]] && self.encodeOptions == TTSDKJSONEncodeOptionPretty) {
+            NSData *jsonData = [TTSDKJSONCodec prettyPrint:((TTSDKCrashReportData *)report).value];
+            [filteredReports addObject:[TTSDKCrashReportData reportWithValue:jsonData]];
+            continue;
+        }
         if ([report isKindOfClass:[TTSDKCrashReportDictionary class]] == NO) {
             TTSDKLOG_ERROR(@"Unexpected non-dictionary report: %@", report);
             continue;
@@ -33,7 +33,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** Converts reports from dict to JSON.
  *
- * Input: NSDictionary
+ * JSON data is also accepted when pretty printing without sorting, and is
+ * re-indented without being decoded.
+ *
+ * Input: NSDictionary or NSData
  * Output: NSData
  */
 NS_SWIFT_NAME(CrashReportFilterJSONEncode)
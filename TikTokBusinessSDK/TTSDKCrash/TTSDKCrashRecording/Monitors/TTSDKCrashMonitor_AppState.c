@@ -56,6 +56,25 @@
 #define kKeySessionsSinceLastCrash "sessionsSinceLastCrash"
 #define kKeySessionsSinceLaunch "sessionsSinceLaunch"
 
+/** IDs of the persistent fields, for the key dictionary. */
+enum {
+    StateKeyFormatVersion,
+    StateKeyCrashedLastLaunch,
+    StateKeyActiveDurationSinceLastCrash,
+    StateKeyBackgroundDurationSinceLastCrash,
+    StateKeyLaunchesSinceLastCrash,
+    StateKeySessionsSinceLastCrash,
+};
+
+static const char *const g_stateKeys[] = {
+    [StateKeyFormatVersion] = kKeyFormatVersion,
+    [StateKeyCrashedLastLaunch] = kKeyCrashedLastLaunch,
+    [StateKeyActiveDurationSinceLastCrash] = kKeyActiveDurationSinceLastCrash,
+    [StateKeyBackgroundDurationSinceLastCrash] = kKeyBackgroundDurationSinceLastCrash,
+    [StateKeyLaunchesSinceLastCrash] = kKeyLaunchesSinceLastCrash,
+    [StateKeySessionsSinceLastCrash] = kKeySessionsSinceLastCrash,
+};
+
 // ============================================================================
 #pragma mark - Globals -
 // ============================================================================
@@ -68,15 +87,34 @@ static TTSDKCrash_AppState g_state;
 
 static volatile bool g_isEnabled = false;
 
+/** The persistent fields' names, so that the decode callbacks can switch on key IDs. */
+static TTSDKJSONKeyDictionary g_keyDictionary;
+/** Whether g_keyDictionary could be compiled. If not, names are compared instead. */
+static bool g_isKeyDictionaryCompiled;
+
 // ============================================================================
 #pragma mark - JSON Encoding -
 // ============================================================================
 
+/** Get the ID of a persistent field's name, or TTSDKJSON_KEY_UNKNOWN. */
+static int getStateKeyID(const char *const name)
+{
+    if (g_isKeyDictionaryCompiled) {
+        return ttsdkjson_keyID(&g_keyDictionary, name);
+    }
+    for (int i = 0; i < (int)(sizeof(g_stateKeys) / sizeof(*g_stateKeys)); i++) {
+        if (name != NULL && strcmp(name, g_stateKeys[i]) == 0) {
+            return i;
+        }
+    }
+    return TTSDKJSON_KEY_UNKNOWN;
+}
+
 static int onBooleanElement(const char *const name, const bool value, void *const userData)
 {
     TTSDKCrash_AppState *state = userData;
 
-    if (strcmp(name, kKeyCrashedLastLaunch) == 0) {
+    if (getStateKeyID(name) == StateKeyCrashedLastLaunch) {
         state->crashedLastLaunch = value;
     }
 
@@ -87,11 +125,15 @@ static int onFloatingPointElement(const char *const name, const double value, vo
 {
     TTSDKCrash_AppState *state = userData;
 
-    if (strcmp(name, kKeyActiveDurationSinceLastCrash) == 0) {
-        state->activeDurationSinceLastCrash = value;
-    }
-    if (strcmp(name, kKeyBackgroundDurationSinceLastCrash) == 0) {
-        state->backgroundDurationSinceLastCrash = value;
+    switch (getStateKeyID(name)) {
+        case StateKeyActiveDurationSinceLastCrash:
+            state->activeDurationSinceLastCrash = value;
+            break;
+        case StateKeyBackgroundDurationSinceLastCrash:
+            state->backgroundDurationSinceLastCrash = value;
+            break;
+        default:
+            break;
     }
 
     return TTSDKJSON_OK;
@@ -101,15 +143,21 @@ static int onIntegerElement(const char *const name, const int64_t value, void *c
 {
     TTSDKCrash_AppState *state = userData;
 
-    if (strcmp(name, kKeyFormatVersion) == 0) {
-        if (value != kFormatVersion) {
-            TTSDKLOG_ERROR("Expected version 1 but got %" PRId64, value);
-            return TTSDKJSON_ERROR_INVALID_DATA;
-        }
-    } else if (strcmp(name, kKeyLaunchesSinceLastCrash) == 0) {
-        state->launchesSinceLastCrash = (int)value;
-    } else if (strcmp(name, kKeySessionsSinceLastCrash) == 0) {
-        state->sessionsSinceLastCrash = (int)value;
+    switch (getStateKeyID(name)) {
+        case StateKeyFormatVersion:
+            if (value != kFormatVersion) {
+                TTSDKLOG_ERROR("Expected version 1 but got %" PRId64, value);
+                return TTSDKJSON_ERROR_INVALID_DATA;
+            }
+            break;
+        case StateKeyLaunchesSinceLastCrash:
+            state->launchesSinceLastCrash = (int)value;
+            break;
+        case StateKeySessionsSinceLastCrash:
+            state->sessionsSinceLastCrash = (int)value;
+            break;
+        default:
+            break;
     }
 
     // FP value might have been written as a whole number.
@@ -120,25 +168,31 @@ static int onUnsignedIntegerElement(const char *const name, const uint64_t value
 {
     TTSDKCrash_AppState *state = userData;
 
-    if (strcmp(name, kKeyFormatVersion) == 0) {
-        if (value != kFormatVersion) {
-            TTSDKLOG_ERROR("Expected version 1 but got %" PRIu64, value);
-            return TTSDKJSON_ERROR_INVALID_DATA;
-        }
-    } else if (strcmp(name, kKeyLaunchesSinceLastCrash) == 0) {
-        if (value <= INT_MAX) {
-            state->launchesSinceLastCrash = (int)value;
-        } else {
-            TTSDKLOG_ERROR("launchesSinceLastCrash (%" PRIu64 ") exceeds INT_MAX", value);
-            return TTSDKJSON_ERROR_INVALID_DATA;
-        }
-    } else if (strcmp(name, kKeySessionsSinceLastCrash) == 0) {
-        if (value <= INT_MAX) {
-            state->sessionsSinceLastCrash = (int)value;
-        } else {
-            TTSDKLOG_ERROR("sessionsSinceLastCrash (%" PRIu64 ") exceeds INT_MAX", value);
-            return TTSDKJSON_ERROR_INVALID_DATA;
-        }
+    switch (getStateKeyID(name)) {
+        case StateKeyFormatVersion:
+            if (value != kFormatVersion) {
+                TTSDKLOG_ERROR("Expected version 1 but got %" PRIu64, value);
+                return TTSDKJSON_ERROR_INVALID_DATA;
+            }
+            break;
+        case StateKeyLaunchesSinceLastCrash:
+            if (value <= INT_MAX) {
+                state->launchesSinceLastCrash = (int)value;
+            } else {
+                TTSDKLOG_ERROR("launchesSinceLastCrash (%" PRIu64 ") exceeds INT_MAX", value);
+                return TTSDKJSON_ERROR_INVALID_DATA;
+            }
+            break;
+        case StateKeySessionsSinceLastCrash:
+            if (value <= INT_MAX) {
+                state->sessionsSinceLastCrash = (int)value;
+            } else {
+                TTSDKLOG_ERROR("sessionsSinceLastCrash (%" PRIu64 ") exceeds INT_MAX", value);
+                return TTSDKJSON_ERROR_INVALID_DATA;
+            }
+            break;
+        default:
+            break;
     }
 
     // For other fields or if the value doesn't fit in an int, treat it as a floating point
@@ -206,23 +260,40 @@ static bool loadState(const char *const path)
         return false;
     }
 
-    TTSDKJSONDecodeCallbacks callbacks;
-    callbacks.onBeginArray = onBeginArray;
-    callbacks.onBeginObject = onBeginObject;
-    callbacks.onBooleanElement = onBooleanElement;
-    callbacks.onEndContainer = onEndContainer;
-    callbacks.onEndData = onEndData;
-    callbacks.onFloatingPointElement = onFloatingPointElement;
-    callbacks.onIntegerElement = onIntegerElement;
-    callbacks.onUnsignedIntegerElement = onUnsignedIntegerElement;
-    callbacks.onNullElement = onNullElement;
-    callbacks.onStringElement = onStringElement;
+    TTSDKJSONDecodeCallbacks callbacks = {
+        .onBeginArray = onBeginArray,
+        .onBeginObject = onBeginObject,
+        .onBooleanElement = onBooleanElement,
+        .onEndContainer = onEndContainer,
+        .onEndData = onEndData,
+        .onFloatingPointElement = onFloatingPointElement,
+        .onIntegerElement = onIntegerElement,
+        .onUnsignedIntegerElement = onUnsignedIntegerElement,
+        .onNullElement = onNullElement,
+        .onStringElement = onStringElement,
+        .keyDictionary = &g_keyDictionary,
+    };
+
+    // Only the persistent fields are wanted. Anything else is skipped without being decoded.
+    const int keyCount = (int)(sizeof(g_stateKeys) / sizeof(*g_stateKeys));
+    g_isKeyDictionaryCompiled = ttsdkjson_compileKeyDictionary(&g_keyDictionary, g_stateKeys, keyCount) == TTSDKJSON_OK;
+    if (!g_isKeyDictionaryCompiled) {
+        TTSDKLOG_ERROR("Could not compile the app state keys");
+        callbacks.keyDictionary = NULL;
+    }
+    TTSDKJSONPathFilter filter;
+    const bool isFiltered = ttsdkjson_compilePathFilter(&filter, g_stateKeys, keyCount) == TTSDKJSON_OK;
+    if (!isFiltered) {
+        TTSDKLOG_ERROR("Could not compile the app state paths. Decoding the whole file");
+    }
 
     int errorOffset = 0;
 
     char stringBuffer[1000];
-    const int result =
-        ttsdkjson_decode(data, (int)length, stringBuffer, sizeof(stringBuffer), &callbacks, &g_state, &errorOffset);
+    const int result = isFiltered ? ttsdkjson_decodeFiltered(data, (int)length, stringBuffer, sizeof(stringBuffer),
+                                                             &filter, &callbacks, &g_state, &errorOffset)
+                                  : ttsdkjson_decode(data, (int)length, stringBuffer, sizeof(stringBuffer),
+                                                     &callbacks, &g_state, &errorOffset);
     free(data);
     if (result != TTSDKJSON_OK) {
         TTSDKLOG_ERROR("%s, offset %d: %s", path, errorOffset, ttsdkjson_stringForError(result));
@@ -245,8 +316,10 @@ static bool saveState(const char *const path)
         return false;
     }
 
+    char buffer[512];
     TTSDKJSONEncodeContext JSONContext;
     ttsdkjson_beginEncode(&JSONContext, true, addJSONData, &fd);
+    ttsdkjson_setOutputBuffer(&JSONContext, buffer, sizeof(buffer));
 
     int result;
     if ((result = ttsdkjson_beginObject(&JSONContext, NULL)) != TTSDKJSON_OK) {
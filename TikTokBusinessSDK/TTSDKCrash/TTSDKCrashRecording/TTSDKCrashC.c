@@ -193,6 +193,11 @@ void handleConfiguration(TTSDKCrashCConfiguration *configuration)
 #endif
     ttsdkccd_setSearchQueueNames(configuration->enableQueueNameSearch);
     ttsdkcrashreport_setIntrospectMemory(configuration->enableMemoryIntrospection);
+    ttsdkcrashreport_setWriteCBOR(configuration->enableCBORReports);
+    ttsdkcrashreport_setWriteBase64Data(configuration->enableBase64DataElements);
+    ttsdkcrashreport_setWriteCompact(configuration->enableCompactReports);
+    ttsdkcrashreport_setWriteSectionIndex(configuration->enableSectionIndex);
+    ttsdkcrashreport_setCompressReports(configuration->reportStoreConfiguration.compressReports);
     ttsdkcm_signal_sigterm_setMonitoringEnabled(configuration->enableSigTermMonitoring);
 
     if (configuration->doNotIntrospectClasses.strings != NULL) {
@@ -61,10 +61,15 @@
         _printPreviousLogOnStartup = cConfig.printPreviousLogOnStartup ? YES : NO;
         _enableSwapCxaThrow = cConfig.enableSwapCxaThrow ? YES : NO;
         _enableSigTermMonitoring = cConfig.enableSigTermMonitoring ? YES : NO;
+        _enableCBORReports = cConfig.enableCBORReports ? YES : NO;
+        _enableBase64DataElements = cConfig.enableBase64DataElements ? YES : NO;
+        _enableCompactReports = cConfig.enableCompactReports ? YES : NO;
+        _enableSectionIndex = cConfig.enableSectionIndex ? YES : NO;
 
         _reportStoreConfiguration = [TTSDKCrashReportStoreConfiguration new];
         _reportStoreConfiguration.appName = nil;
         _reportStoreConfiguration.maxReportCount = cConfig.reportStoreConfiguration.maxReportCount;
+        _reportStoreConfiguration.compressReports = cConfig.reportStoreConfiguration.compressReports ? YES : NO;
 
         TTSDKCrashCConfiguration_Release(&cConfig);
     }
@@ -104,6 +109,10 @@
     config.printPreviousLogOnStartup = self.printPreviousLogOnStartup;
     config.enableSwapCxaThrow = self.enableSwapCxaThrow;
     config.enableSigTermMonitoring = self.enableSigTermMonitoring;
+    config.enableCBORReports = self.enableCBORReports;
+    config.enableBase64DataElements = self.enableBase64DataElements;
+    config.enableCompactReports = self.enableCompactReports;
+    config.enableSectionIndex = self.enableSectionIndex;
 
     return config;
 }
@@ -157,6 +166,10 @@
     copy.printPreviousLogOnStartup = self.printPreviousLogOnStartup;
     copy.enableSwapCxaThrow = self.enableSwapCxaThrow;
     copy.enableSigTermMonitoring = self.enableSigTermMonitoring;
+    copy.enableCBORReports = self.enableCBORReports;
+    copy.enableBase64DataElements = self.enableBase64DataElements;
+    copy.enableCompactReports = self.enableCompactReports;
+    copy.enableSectionIndex = self.enableSectionIndex;
     return copy;
 }
 
@@ -173,6 +186,8 @@
 
         TTSDKCrashReportStoreCConfiguration cConfig = TTSDKCrashReportStoreCConfiguration_Default();
         _maxReportCount = (NSInteger)cConfig.maxReportCount;
+        _compressReports = cConfig.compressReports ? YES : NO;
+        _logUserReports = cConfig.logUserReports ? YES : NO;
     }
     return self;
 }
@@ -192,6 +207,8 @@
     config.appName = resolvedAppName != nil ? strdup(resolvedAppName.UTF8String) : NULL;
     config.reportsPath = resolvedReportsPath != nil ? strdup(resolvedReportsPath.UTF8String) : NULL;
     config.maxReportCount = (int)self.maxReportCount;
+    config.compressReports = self.compressReports;
+    config.logUserReports = self.logUserReports;
 
     return config;
 }
@@ -204,6 +221,8 @@
     copy.reportsPath = [self.reportsPath copyWithZone:zone];
     copy.appName = [self.appName copyWithZone:zone];
     copy.maxReportCount = self.maxReportCount;
+    copy.compressReports = self.compressReports;
+    copy.logUserReports = self.logUserReports;
     return copy;
 }
 
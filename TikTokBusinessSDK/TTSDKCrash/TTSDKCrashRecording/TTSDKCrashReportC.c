@@ -26,6 +26,7 @@
 
 #include "TTSDKCrashReportC.h"
 
+#include "TTSDKCBORCodec.h"
 #include "TTSDKCPU.h"
 #include "TTSDKCrashCachedData.h"
 #include "TTSDKCrashMonitorHelper.h"
@@ -40,11 +41,13 @@
 #include "TTSDKCrashMonitor_User.h"
 #include "TTSDKCrashMonitor_Zombie.h"
 #include "TTSDKCrashReportFields.h"
+#include "TTSDKCrashReportSectionIndex.h"
 #include "TTSDKCrashReportVersion.h"
 #include "TTSDKCrashReportWriter.h"
 #include "TTSDKDate.h"
 #include "TTSDKDynamicLinker.h"
 #include "TTSDKFileUtils.h"
+#include "TTSDKGZip.h"
 #include "TTSDKJSONCodec.h"
 #include "TTSDKMach.h"
 #include "TTSDKMemory.h"
@@ -93,6 +96,29 @@
 
 #define getJsonContext(REPORT_WRITER) ((TTSDKJSONEncodeContext *)((REPORT_WRITER)->context))
 
+/** A report field's pre-escaped JSON key and its length, for the ttsdkjson_*Literal() functions,
+ * which copy it instead of escaping the field's name again.
+ */
+#define fieldKey(FIELD) FIELD##_JSONKey, (int)sizeof(FIELD##_JSONKey) - 1
+
+#define addBooleanField(REPORT_WRITER, FIELD, VALUE) \
+    ttsdkjson_addBooleanElementLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD), VALUE)
+#define addFloatingPointField(REPORT_WRITER, FIELD, VALUE) \
+    ttsdkjson_addFloatingPointElementLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD), VALUE)
+#define addIntegerField(REPORT_WRITER, FIELD, VALUE) \
+    ttsdkjson_addIntegerElementLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD), VALUE)
+#define addUIntegerField(REPORT_WRITER, FIELD, VALUE) \
+    ttsdkjson_addUIntegerElementLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD), VALUE)
+#define addStringField(REPORT_WRITER, FIELD, VALUE) \
+    ttsdkjson_addStringElementLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD), VALUE, TTSDKJSON_SIZE_AUTOMATIC)
+#define addDataField(REPORT_WRITER, FIELD, VALUE, LENGTH) \
+    ttsdkjson_addDataElementLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD), VALUE, LENGTH)
+#define addUUIDField(REPORT_WRITER, FIELD, VALUE) addUUIDElementLiteral(REPORT_WRITER, fieldKey(FIELD), VALUE)
+#define beginObjectField(REPORT_WRITER, FIELD) \
+    ttsdkjson_beginObjectLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD))
+#define beginArrayField(REPORT_WRITER, FIELD) \
+    ttsdkjson_beginArrayLiteral(getJsonContext(REPORT_WRITER), fieldKey(FIELD))
+
 /** Used for writing hex string values. */
 static const char g_hexNybbles[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
 
@@ -115,11 +141,30 @@ typedef struct {
     int restrictedClassesCount;
 } TTSDKCrash_IntrospectionRules;
 
+/** The file a report is being written to. */
+typedef struct {
+    TTSDKBufferedWriter bufferedWriter;
+    TTSDKGZipWriter gzipWriter;
+    bool isCompressed;
+} TTSDKCrash_ReportFile;
+
 static const char *g_userInfoJSON;
 static pthread_mutex_t g_userInfoMutex = PTHREAD_MUTEX_INITIALIZER;
 
 static TTSDKCrash_IntrospectionRules g_introspectionRules;
 static TTSDKReportWriteCallback g_userSectionWriteCallback;
+static bool g_shouldWriteCBOR;
+static bool g_shouldWriteBase64Data;
+static bool g_shouldWriteCompact;
+static bool g_shouldWriteSectionIndex;
+static TTSDKJSONSectionIndex g_sectionIndex;
+static TTSDKJSONSectionIndexEntry g_sectionIndexEntries[TTSDKCRSI_MAX_ENTRIES];
+
+/** zlib's state while writing a compressed report. It's allocated up front
+ * because a crash handler can't allocate.
+ */
+static TTSDKGZipArena g_zlibArena;
+static bool g_shouldCompress;
 
 extern void * TikTokBusinessSDKFuncBeginAddress(void);
 extern void * TikTokBusinessSDKFuncEndAddress(void);
@@ -198,6 +243,45 @@ static void appendDataElement(const TTSDKCrashReportWriter *const writer, const
 
 static void endDataElement(const TTSDKCrashReportWriter *const writer) { ttsdkjson_endDataElement(getJsonContext(writer)); }
 
+/** Format a UUID as text.
+ *
+ * @param value The UUID's 16 bytes.
+ *
+ * @param buffer Where to write the text, which needs 36 bytes (it isn't terminated).
+ *
+ * @return The length of the text.
+ */
+static int formatUUID(const unsigned char *const value, char *const buffer)
+{
+    const unsigned char *src = value;
+    char *dst = buffer;
+    for (int i = 0; i < 4; i++) {
+        *dst++ = g_hexNybbles[(*src >> 4) & 15];
+        *dst++ = g_hexNybbles[(*src++) & 15];
+    }
+    *dst++ = '-';
+    for (int i = 0; i < 2; i++) {
+        *dst++ = g_hexNybbles[(*src >> 4) & 15];
+        *dst++ = g_hexNybbles[(*src++) & 15];
+    }
+    *dst++ = '-';
+    for (int i = 0; i < 2; i++) {
+        *dst++ = g_hexNybbles[(*src >> 4) & 15];
+        *dst++ = g_hexNybbles[(*src++) & 15];
+    }
+    *dst++ = '-';
+    for (int i = 0; i < 2; i++) {
+        *dst++ = g_hexNybbles[(*src >> 4) & 15];
+        *dst++ = g_hexNybbles[(*src++) & 15];
+    }
+    *dst++ = '-';
+    for (int i = 0; i < 6; i++) {
+        *dst++ = g_hexNybbles[(*src >> 4) & 15];
+        *dst++ = g_hexNybbles[(*src++) & 15];
+    }
+    return (int)(dst - buffer);
+}
+
 static void addUUIDElement(const TTSDKCrashReportWriter *const writer, const char *const key,
                            const unsigned char *const value)
 {
@@ -205,37 +289,19 @@ static void addUUIDElement(const TTSDKCrashReportWriter *const writer, const cha
         ttsdkjson_addNullElement(getJsonContext(writer), key);
     } else {
         char uuidBuffer[37];
-        const unsigned char *src = value;
-        char *dst = uuidBuffer;
-        for (int i = 0; i < 4; i++) {
-            *dst++ = g_hexNybbles[(*src >> 4) & 15];
-            *dst++ = g_hexNybbles[(*src++) & 15];
-        }
-        *dst++ = '-';
-        for (int i = 0; i < 2; i++) {
-            *dst++ = g_hexNybbles[(*src >> 4) & 15];
-            *dst++ = g_hexNybbles[(*src++) & 15];
-        }
-        *dst++ = '-';
-        for (int i = 0; i < 2; i++) {
-            *dst++ = g_hexNybbles[(*src >> 4) & 15];
-            *dst++ = g_hexNybbles[(*src++) & 15];
-        }
-        *dst++ = '-';
-        for (int i = 0; i < 2; i++) {
-            *dst++ = g_hexNybbles[(*src >> 4) & 15];
-            *dst++ = g_hexNybbles[(*src++) & 15];
-        }
-        *dst++ = '-';
-        for (int i = 0; i < 6; i++) {
-            *dst++ = g_hexNybbles[(*src >> 4) & 15];
-            *dst++ = g_hexNybbles[(*src++) & 15];
-        }
-
-        ttsdkjson_addStringElement(getJsonContext(writer), key, uuidBuffer, (int)(dst - uuidBuffer));
+        ttsdkjson_addStringElement(getJsonContext(writer), key, uuidBuffer, formatUUID(value, uuidBuffer));
     }
 }
 
+/** Add a UUID element under a literal key, like addUUIDElement(). */
+static void addUUIDElementLiteral(const TTSDKCrashReportWriter *const writer, const char *const literalKey,
+                                  const int length, const unsigned char *const value)
+{
+    char uuidBuffer[37];
+    ttsdkjson_addStringElementLiteral(getJsonContext(writer), literalKey, length, value == NULL ? NULL : uuidBuffer,
+                                     value == NULL ? 0 : formatUUID(value, uuidBuffer));
+}
+
 static void addJSONElement(const TTSDKCrashReportWriter *const writer, const char *const key,
                            const char *const jsonElement, bool closeLastContainer)
 {
@@ -296,11 +362,107 @@ static void addTextLinesFromFile(const TTSDKCrashReportWriter *const writer, con
 
 static int addJSONData(const char *restrict const data, const int length, void *restrict userData)
 {
-    TTSDKBufferedWriter *writer = (TTSDKBufferedWriter *)userData;
-    const bool success = ttsdkfu_writeBufferedWriter(writer, data, length);
+    TTSDKCrash_ReportFile *file = (TTSDKCrash_ReportFile *)userData;
+    const bool success = file->isCompressed ? ttsdkgz_write(&file->gzipWriter, data, length)
+                                            : ttsdkfu_writeBufferedWriter(&file->bufferedWriter, data, length);
     return success ? TTSDKJSON_OK : TTSDKJSON_ERROR_CANNOT_ADD_DATA;
 }
 
+/** Open a report file for writing. A path ending in ".gz" is gzip compressed,
+ * unless compression hasn't been set up, in which case it's written plain
+ * (readers check the contents, not the name).
+ *
+ * @param file The report file to open.
+ *
+ * @param path The path to write to.
+ *
+ * @param writeBuffer The buffer to write through.
+ *
+ * @param writeBufferLength The length of the write buffer.
+ *
+ * @return true if the file was opened.
+ */
+static bool openReportFile(TTSDKCrash_ReportFile *const file, const char *const path, char *const writeBuffer,
+                           const int writeBufferLength)
+{
+    file->isCompressed = false;
+    if (!ttsdkfu_openBufferedWriter(&file->bufferedWriter, path, writeBuffer, writeBufferLength)) {
+        return false;
+    }
+    const size_t pathLength = strlen(path);
+    if (g_shouldCompress && pathLength > 3 && strcmp(path + pathLength - 3, ".gz") == 0) {
+        ttsdkgz_resetArena(&g_zlibArena);
+        file->isCompressed = ttsdkgz_openWriter(&file->gzipWriter, &file->bufferedWriter, &g_zlibArena);
+    }
+    return true;
+}
+
+/** Start indexing a report's sections if configured to. Any index left over
+ * from a previous report at the same path is removed.
+ *
+ * @param writer The writer, after its encoding format has been set.
+ *
+ * @param reportPath The report's path.
+ *
+ * @param indexPath Buffer to hold the index's path.
+ *
+ * @param maxLength The size of the buffer.
+ *
+ * @return true if the report is being indexed.
+ */
+static bool beginSectionIndex(const TTSDKCrashReportWriter *const writer, const char *const reportPath,
+                              char *const indexPath, const int maxLength)
+{
+    if (!ttsdkcrsi_getIndexPath(reportPath, indexPath, maxLength)) {
+        return false;
+    }
+    unlink(indexPath);
+    if (!g_shouldWriteSectionIndex) {
+        return false;
+    }
+    ttsdkjson_beginSectionIndex(getJsonContext(writer), &g_sectionIndex, g_sectionIndexEntries,
+                                TTSDKCRSI_MAX_ENTRIES);
+    return true;
+}
+
+/** Write the index of a finished report.
+ *
+ * @param writer The writer, after encoding has ended.
+ *
+ * @param indexPath The index's path.
+ */
+static void writeSectionIndex(const TTSDKCrashReportWriter *const writer, const char *const indexPath)
+{
+    ttsdkcrsi_writeIndex(indexPath, &g_sectionIndex, ttsdkjson_getOutputPosition(getJsonContext(writer)),
+                         g_shouldWriteCBOR);
+}
+
+static void closeReportFile(TTSDKCrash_ReportFile *const file)
+{
+    if (file->isCompressed) {
+        ttsdkgz_closeWriter(&file->gzipWriter);
+    }
+    ttsdkfu_closeBufferedWriter(&file->bufferedWriter);
+}
+
+/** Push everything encoded so far out to the report file, so that it survives
+ * if writing the rest of the report crashes.
+ *
+ * @param writer The writer.
+ *
+ * @param file The report file.
+ */
+static void flushReport(const TTSDKCrashReportWriter *const writer, TTSDKCrash_ReportFile *const file)
+{
+    ttsdkjson_flushOutputBuffer(getJsonContext(writer));
+    if (file->isCompressed) {
+        // A sync flush ends on a byte boundary, so everything up to here can be decompressed.
+        ttsdkgz_flush(&file->gzipWriter);
+    } else {
+        ttsdkfu_flushBufferedWriter(&file->bufferedWriter);
+    }
+}
+
 // ============================================================================
 #pragma mark - Utility -
 // ============================================================================
@@ -612,13 +774,13 @@ static bool writeObjCObject(const TTSDKCrashReportWriter *const writer, const ui
     const void *object = (const void *)address;
     switch (ttsdkobjc_objectType(object)) {
         case TTSDKObjCTypeClass:
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Class);
-            writer->addStringElement(writer, TTSDKCrashField_Class, ttsdkobjc_className(object));
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Class);
+            addStringField(writer, TTSDKCrashField_Class, ttsdkobjc_className(object));
             return true;
         case TTSDKObjCTypeObject: {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Object);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Object);
             const char *className = ttsdkobjc_objectClassName(object);
-            writer->addStringElement(writer, TTSDKCrashField_Class, className);
+            addStringField(writer, TTSDKCrashField_Class, className);
             if (!isRestrictedClass(className)) {
                 switch (ttsdkobjc_objectClassType(object)) {
                     case TTSDKObjCClassTypeString:
@@ -655,9 +817,9 @@ static bool writeObjCObject(const TTSDKCrashReportWriter *const writer, const ui
             break;
         }
         case TTSDKObjCTypeBlock:
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Block);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Block);
             const char *className = ttsdkobjc_objectClassName(object);
-            writer->addStringElement(writer, TTSDKCrashField_Class, className);
+            addStringField(writer, TTSDKCrashField_Class, className);
             return true;
         case TTSDKObjCTypeUnknown:
             break;
@@ -685,16 +847,16 @@ static void writeMemoryContents(const TTSDKCrashReportWriter *const writer, cons
     const void *object = (const void *)address;
     writer->beginObject(writer, key);
     {
-        writer->addUIntegerElement(writer, TTSDKCrashField_Address, address);
+        addUIntegerField(writer, TTSDKCrashField_Address, address);
         writeZombieIfPresent(writer, TTSDKCrashField_LastDeallocObject, address);
         if (!writeObjCObject(writer, address, limit)) {
             if (object == NULL) {
-                writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashMemType_NullPointer);
+                addStringField(writer, TTSDKCrashField_Type, TTSDKCrashMemType_NullPointer);
             } else if (isValidString(object)) {
-                writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashMemType_String);
-                writer->addStringElement(writer, TTSDKCrashField_Value, (const char *)object);
+                addStringField(writer, TTSDKCrashField_Type, TTSDKCrashMemType_String);
+                addStringField(writer, TTSDKCrashField_Value, (const char *)object);
             } else {
-                writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Unknown);
+                addStringField(writer, TTSDKCrashField_Type, TTSDKCrashMemType_Unknown);
             }
         }
     }
@@ -795,32 +957,29 @@ static void writeBacktrace(const TTSDKCrashReportWriter *const writer, const cha
 {
     writer->beginObject(writer, key);
     {
-        writer->beginArray(writer, TTSDKCrashField_Contents);
+        beginArrayField(writer, TTSDKCrashField_Contents);
         {
             while (stackCursor->advanceCursor(stackCursor)) {
                 writer->beginObject(writer, NULL);
                 {
                     if (stackCursor->symbolicate(stackCursor)) {
                         if (stackCursor->stackEntry.imageName != NULL) {
-                            writer->addStringElement(writer, TTSDKCrashField_ObjectName,
-                                                     ttsdkfu_lastPathEntry(stackCursor->stackEntry.imageName));
+                            addStringField(writer, TTSDKCrashField_ObjectName,
+                                           ttsdkfu_lastPathEntry(stackCursor->stackEntry.imageName));
                         }
-                        writer->addUIntegerElement(writer, TTSDKCrashField_ObjectAddr,
-                                                   stackCursor->stackEntry.imageAddress);
+                        addUIntegerField(writer, TTSDKCrashField_ObjectAddr, stackCursor->stackEntry.imageAddress);
                         if (stackCursor->stackEntry.symbolName != NULL) {
-                            writer->addStringElement(writer, TTSDKCrashField_SymbolName,
-                                                     stackCursor->stackEntry.symbolName);
+                            addStringField(writer, TTSDKCrashField_SymbolName, stackCursor->stackEntry.symbolName);
                         }
-                        writer->addUIntegerElement(writer, TTSDKCrashField_SymbolAddr,
-                                                   stackCursor->stackEntry.symbolAddress);
+                        addUIntegerField(writer, TTSDKCrashField_SymbolAddr, stackCursor->stackEntry.symbolAddress);
                     }
-                    writer->addUIntegerElement(writer, TTSDKCrashField_InstructionAddr, stackCursor->stackEntry.address);
+                    addUIntegerField(writer, TTSDKCrashField_InstructionAddr, stackCursor->stackEntry.address);
                 }
                 writer->endContainer(writer);
             }
         }
         writer->endContainer(writer);
-        writer->addIntegerElement(writer, TTSDKCrashField_Skipped, 0);
+        addIntegerField(writer, TTSDKCrashField_Skipped, 0);
     }
     writer->endContainer(writer);
 }
@@ -856,17 +1015,17 @@ static void writeStackContents(const TTSDKCrashReportWriter *const writer, const
     }
     writer->beginObject(writer, key);
     {
-        writer->addStringElement(writer, TTSDKCrashField_GrowDirection, ttsdkcpu_stackGrowDirection() > 0 ? "+" : "-");
-        writer->addUIntegerElement(writer, TTSDKCrashField_DumpStart, lowAddress);
-        writer->addUIntegerElement(writer, TTSDKCrashField_DumpEnd, highAddress);
-        writer->addUIntegerElement(writer, TTSDKCrashField_StackPtr, sp);
-        writer->addBooleanElement(writer, TTSDKCrashField_Overflow, isStackOverflow);
+        addStringField(writer, TTSDKCrashField_GrowDirection, ttsdkcpu_stackGrowDirection() > 0 ? "+" : "-");
+        addUIntegerField(writer, TTSDKCrashField_DumpStart, lowAddress);
+        addUIntegerField(writer, TTSDKCrashField_DumpEnd, highAddress);
+        addUIntegerField(writer, TTSDKCrashField_StackPtr, sp);
+        addBooleanField(writer, TTSDKCrashField_Overflow, isStackOverflow);
         uint8_t stackBuffer[kStackContentsTotalDistance * sizeof(sp)];
         int copyLength = (int)(highAddress - lowAddress);
         if (ttsdkmem_copySafely((void *)lowAddress, stackBuffer, copyLength)) {
-            writer->addDataElement(writer, TTSDKCrashField_Contents, (void *)stackBuffer, copyLength);
+            addDataField(writer, TTSDKCrashField_Contents, (void *)stackBuffer, copyLength);
         } else {
-            writer->addStringElement(writer, TTSDKCrashField_Error, "Stack contents not accessible");
+            addStringField(writer, TTSDKCrashField_Error, "Stack contents not accessible");
         }
     }
     writer->endContainer(writer);
@@ -1062,17 +1221,17 @@ static void writeThread(const TTSDKCrashReportWriter *const writer, const char *
         if (ttsdkmc_canHaveCPUState(machineContext)) {
             writeRegisters(writer, TTSDKCrashField_Registers, machineContext);
         }
-        writer->addIntegerElement(writer, TTSDKCrashField_Index, threadIndex);
+        addIntegerField(writer, TTSDKCrashField_Index, threadIndex);
         const char *name = ttsdkccd_getThreadName(thread);
         if (name != NULL) {
-            writer->addStringElement(writer, TTSDKCrashField_Name, name);
+            addStringField(writer, TTSDKCrashField_Name, name);
         }
         name = ttsdkccd_getQueueName(thread);
         if (name != NULL) {
-            writer->addStringElement(writer, TTSDKCrashField_DispatchQueue, name);
+            addStringField(writer, TTSDKCrashField_DispatchQueue, name);
         }
-        writer->addBooleanElement(writer, TTSDKCrashField_Crashed, isCrashedThread);
-        writer->addBooleanElement(writer, TTSDKCrashField_CurrentThread, thread == ttsdkthread_self());
+        addBooleanField(writer, TTSDKCrashField_Crashed, isCrashedThread);
+        addBooleanField(writer, TTSDKCrashField_CurrentThread, thread == ttsdkthread_self());
         if (isCrashedThread) {
             writeStackContents(writer, TTSDKCrashField_Stack, machineContext, stackCursor.state.hasGivenUp);
             if (shouldWriteNotableAddresses) {
@@ -1135,27 +1294,27 @@ static void writeBinaryImage(const TTSDKCrashReportWriter *const writer, const c
 
     writer->beginObject(writer, key);
     {
-        writer->addUIntegerElement(writer, TTSDKCrashField_ImageAddress, image.address);
-        writer->addUIntegerElement(writer, TTSDKCrashField_ImageVmAddress, image.vmAddress);
-        writer->addUIntegerElement(writer, TTSDKCrashField_ImageSize, image.size);
-        writer->addStringElement(writer, TTSDKCrashField_Name, image.name);
-        writer->addUUIDElement(writer, TTSDKCrashField_UUID, image.uuid);
-        writer->addIntegerElement(writer, TTSDKCrashField_CPUType, image.cpuType);
-        writer->addIntegerElement(writer, TTSDKCrashField_CPUSubType, image.cpuSubType);
-        writer->addUIntegerElement(writer, TTSDKCrashField_ImageMajorVersion, image.majorVersion);
-        writer->addUIntegerElement(writer, TTSDKCrashField_ImageMinorVersion, image.minorVersion);
-        writer->addUIntegerElement(writer, TTSDKCrashField_ImageRevisionVersion, image.revisionVersion);
+        addUIntegerField(writer, TTSDKCrashField_ImageAddress, image.address);
+        addUIntegerField(writer, TTSDKCrashField_ImageVmAddress, image.vmAddress);
+        addUIntegerField(writer, TTSDKCrashField_ImageSize, image.size);
+        addStringField(writer, TTSDKCrashField_Name, image.name);
+        addUUIDField(writer, TTSDKCrashField_UUID, image.uuid);
+        addIntegerField(writer, TTSDKCrashField_CPUType, image.cpuType);
+        addIntegerField(writer, TTSDKCrashField_CPUSubType, image.cpuSubType);
+        addUIntegerField(writer, TTSDKCrashField_ImageMajorVersion, image.majorVersion);
+        addUIntegerField(writer, TTSDKCrashField_ImageMinorVersion, image.minorVersion);
+        addUIntegerField(writer, TTSDKCrashField_ImageRevisionVersion, image.revisionVersion);
         if (image.crashInfoMessage != NULL) {
-            writer->addStringElement(writer, TTSDKCrashField_ImageCrashInfoMessage, image.crashInfoMessage);
+            addStringField(writer, TTSDKCrashField_ImageCrashInfoMessage, image.crashInfoMessage);
         }
         if (image.crashInfoMessage2 != NULL) {
-            writer->addStringElement(writer, TTSDKCrashField_ImageCrashInfoMessage2, image.crashInfoMessage2);
+            addStringField(writer, TTSDKCrashField_ImageCrashInfoMessage2, image.crashInfoMessage2);
         }
         if (image.crashInfoBacktrace != NULL) {
-            writer->addStringElement(writer, TTSDKCrashField_ImageCrashInfoBacktrace, image.crashInfoBacktrace);
+            addStringField(writer, TTSDKCrashField_ImageCrashInfoBacktrace, image.crashInfoBacktrace);
         }
         if (image.crashInfoSignature != NULL) {
-            writer->addStringElement(writer, TTSDKCrashField_ImageCrashInfoSignature, image.crashInfoSignature);
+            addStringField(writer, TTSDKCrashField_ImageCrashInfoSignature, image.crashInfoSignature);
         }
     }
     writer->endContainer(writer);
@@ -1191,9 +1350,9 @@ static void writeMemoryInfo(const TTSDKCrashReportWriter *const writer, const ch
 {
     writer->beginObject(writer, key);
     {
-        writer->addUIntegerElement(writer, TTSDKCrashField_Size, monitorContext->System.memorySize);
-        writer->addUIntegerElement(writer, TTSDKCrashField_Usable, monitorContext->System.usableMemory);
-        writer->addUIntegerElement(writer, TTSDKCrashField_Free, monitorContext->System.freeMemory);
+        addUIntegerField(writer, TTSDKCrashField_Size, monitorContext->System.memorySize);
+        addUIntegerField(writer, TTSDKCrashField_Usable, monitorContext->System.usableMemory);
+        addUIntegerField(writer, TTSDKCrashField_Free, monitorContext->System.freeMemory);
     }
     writer->endContainer(writer);
 }
@@ -1217,82 +1376,82 @@ static void writeError(const TTSDKCrashReportWriter *const writer, const char *c
     writer->beginObject(writer, key);
     {
 #if TTSDKCRASH_HOST_APPLE
-        writer->beginObject(writer, TTSDKCrashField_Mach);
+        beginObjectField(writer, TTSDKCrashField_Mach);
         {
             const char *machExceptionName = ttsdkmach_exceptionName(crash->mach.type);
             const char *machCodeName = crash->mach.code == 0 ? NULL : ttsdkmach_kernelReturnCodeName(crash->mach.code);
-            writer->addUIntegerElement(writer, TTSDKCrashField_Exception, (unsigned)crash->mach.type);
+            addUIntegerField(writer, TTSDKCrashField_Exception, (unsigned)crash->mach.type);
             if (machExceptionName != NULL) {
-                writer->addStringElement(writer, TTSDKCrashField_ExceptionName, machExceptionName);
+                addStringField(writer, TTSDKCrashField_ExceptionName, machExceptionName);
             }
-            writer->addUIntegerElement(writer, TTSDKCrashField_Code, (unsigned)crash->mach.code);
+            addUIntegerField(writer, TTSDKCrashField_Code, (unsigned)crash->mach.code);
             if (machCodeName != NULL) {
-                writer->addStringElement(writer, TTSDKCrashField_CodeName, machCodeName);
+                addStringField(writer, TTSDKCrashField_CodeName, machCodeName);
             }
-            writer->addUIntegerElement(writer, TTSDKCrashField_Subcode, (size_t)crash->mach.subcode);
+            addUIntegerField(writer, TTSDKCrashField_Subcode, (size_t)crash->mach.subcode);
         }
         writer->endContainer(writer);
 #endif
-        writer->beginObject(writer, TTSDKCrashField_Signal);
+        beginObjectField(writer, TTSDKCrashField_Signal);
         {
             const char *sigName = ttsdksignal_signalName(crash->signal.signum);
             const char *sigCodeName = ttsdksignal_signalCodeName(crash->signal.signum, crash->signal.sigcode);
-            writer->addUIntegerElement(writer, TTSDKCrashField_Signal, (unsigned)crash->signal.signum);
+            addUIntegerField(writer, TTSDKCrashField_Signal, (unsigned)crash->signal.signum);
             if (sigName != NULL) {
-                writer->addStringElement(writer, TTSDKCrashField_Name, sigName);
+                addStringField(writer, TTSDKCrashField_Name, sigName);
             }
-            writer->addUIntegerElement(writer, TTSDKCrashField_Code, (unsigned)crash->signal.sigcode);
+            addUIntegerField(writer, TTSDKCrashField_Code, (unsigned)crash->signal.sigcode);
             if (sigCodeName != NULL) {
-                writer->addStringElement(writer, TTSDKCrashField_CodeName, sigCodeName);
+                addStringField(writer, TTSDKCrashField_CodeName, sigCodeName);
             }
         }
         writer->endContainer(writer);
 
-        writer->addUIntegerElement(writer, TTSDKCrashField_Address, crash->faultAddress);
+        addUIntegerField(writer, TTSDKCrashField_Address, crash->faultAddress);
         if (crash->crashReason != NULL) {
-            writer->addStringElement(writer, TTSDKCrashField_Reason, crash->crashReason);
+            addStringField(writer, TTSDKCrashField_Reason, crash->crashReason);
         }
 
         if (isCrashOfMonitorType(crash, ttsdkcm_nsexception_getAPI())) {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashExcType_NSException);
-            writer->beginObject(writer, TTSDKCrashField_NSException);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashExcType_NSException);
+            beginObjectField(writer, TTSDKCrashField_NSException);
             {
-                writer->addStringElement(writer, TTSDKCrashField_Name, crash->NSException.name);
-                writer->addStringElement(writer, TTSDKCrashField_UserInfo, crash->NSException.userInfo);
+                addStringField(writer, TTSDKCrashField_Name, crash->NSException.name);
+                addStringField(writer, TTSDKCrashField_UserInfo, crash->NSException.userInfo);
                 writeAddressReferencedByString(writer, TTSDKCrashField_ReferencedObject, crash->crashReason);
             }
             writer->endContainer(writer);
         } else if (isCrashOfMonitorType(crash, ttsdkcm_machexception_getAPI())) {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashExcType_Mach);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashExcType_Mach);
         } else if (isCrashOfMonitorType(crash, ttsdkcm_signal_getAPI())) {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashExcType_Signal);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashExcType_Signal);
         } else if (isCrashOfMonitorType(crash, ttsdkcm_cppexception_getAPI())) {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashExcType_CPPException);
-            writer->beginObject(writer, TTSDKCrashField_CPPException);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashExcType_CPPException);
+            beginObjectField(writer, TTSDKCrashField_CPPException);
             {
-                writer->addStringElement(writer, TTSDKCrashField_Name, crash->CPPException.name);
+                addStringField(writer, TTSDKCrashField_Name, crash->CPPException.name);
             }
             writer->endContainer(writer);
         } else if (isCrashOfMonitorType(crash, ttsdkcm_deadlock_getAPI())) {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashExcType_Deadlock);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashExcType_Deadlock);
         } else if (isCrashOfMonitorType(crash, ttsdkcm_memory_getAPI())) {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashExcType_MemoryTermination);
-            writer->beginObject(writer, TTSDKCrashField_MemoryTermination);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashExcType_MemoryTermination);
+            beginObjectField(writer, TTSDKCrashField_MemoryTermination);
             {
-                writer->addStringElement(writer, TTSDKCrashField_MemoryPressure, crash->AppMemory.pressure);
-                writer->addStringElement(writer, TTSDKCrashField_MemoryLevel, crash->AppMemory.level);
+                addStringField(writer, TTSDKCrashField_MemoryPressure, crash->AppMemory.pressure);
+                addStringField(writer, TTSDKCrashField_MemoryLevel, crash->AppMemory.level);
             }
             writer->endContainer(writer);
         } else if (isCrashOfMonitorType(crash, ttsdkcm_user_getAPI())) {
-            writer->addStringElement(writer, TTSDKCrashField_Type, TTSDKCrashExcType_User);
-            writer->beginObject(writer, TTSDKCrashField_UserReported);
+            addStringField(writer, TTSDKCrashField_Type, TTSDKCrashExcType_User);
+            beginObjectField(writer, TTSDKCrashField_UserReported);
             {
-                writer->addStringElement(writer, TTSDKCrashField_Name, crash->userException.name);
+                addStringField(writer, TTSDKCrashField_Name, crash->userException.name);
                 if (crash->userException.language != NULL) {
-                    writer->addStringElement(writer, TTSDKCrashField_Language, crash->userException.language);
+                    addStringField(writer, TTSDKCrashField_Language, crash->userException.language);
                 }
                 if (crash->userException.lineOfCode != NULL) {
-                    writer->addStringElement(writer, TTSDKCrashField_LineOfCode, crash->userException.lineOfCode);
+                    addStringField(writer, TTSDKCrashField_LineOfCode, crash->userException.lineOfCode);
                 }
                 if (crash->userException.customStackTrace != NULL) {
                     writer->addJSONElement(writer, TTSDKCrashField_Backtrace, crash->userException.customStackTrace, true);
@@ -1323,24 +1482,21 @@ static void writeAppStats(const TTSDKCrashReportWriter *const writer, const char
 {
     writer->beginObject(writer, key);
     {
-        writer->addBooleanElement(writer, TTSDKCrashField_AppActive, monitorContext->AppState.applicationIsActive);
-        writer->addBooleanElement(writer, TTSDKCrashField_AppInFG, monitorContext->AppState.applicationIsInForeground);
-
-        writer->addIntegerElement(writer, TTSDKCrashField_LaunchesSinceCrash,
-                                  monitorContext->AppState.launchesSinceLastCrash);
-        writer->addIntegerElement(writer, TTSDKCrashField_SessionsSinceCrash,
-                                  monitorContext->AppState.sessionsSinceLastCrash);
-        writer->addFloatingPointElement(writer, TTSDKCrashField_ActiveTimeSinceCrash,
-                                        monitorContext->AppState.activeDurationSinceLastCrash);
-        writer->addFloatingPointElement(writer, TTSDKCrashField_BGTimeSinceCrash,
-                                        monitorContext->AppState.backgroundDurationSinceLastCrash);
-
-        writer->addIntegerElement(writer, TTSDKCrashField_SessionsSinceLaunch,
-                                  monitorContext->AppState.sessionsSinceLaunch);
-        writer->addFloatingPointElement(writer, TTSDKCrashField_ActiveTimeSinceLaunch,
-                                        monitorContext->AppState.activeDurationSinceLaunch);
-        writer->addFloatingPointElement(writer, TTSDKCrashField_BGTimeSinceLaunch,
-                                        monitorContext->AppState.backgroundDurationSinceLaunch);
+        addBooleanField(writer, TTSDKCrashField_AppActive, monitorContext->AppState.applicationIsActive);
+        addBooleanField(writer, TTSDKCrashField_AppInFG, monitorContext->AppState.applicationIsInForeground);
+
+        addIntegerField(writer, TTSDKCrashField_LaunchesSinceCrash, monitorContext->AppState.launchesSinceLastCrash);
+        addIntegerField(writer, TTSDKCrashField_SessionsSinceCrash, monitorContext->AppState.sessionsSinceLastCrash);
+        addFloatingPointField(writer, TTSDKCrashField_ActiveTimeSinceCrash,
+                              monitorContext->AppState.activeDurationSinceLastCrash);
+        addFloatingPointField(writer, TTSDKCrashField_BGTimeSinceCrash,
+                              monitorContext->AppState.backgroundDurationSinceLastCrash);
+
+        addIntegerField(writer, TTSDKCrashField_SessionsSinceLaunch, monitorContext->AppState.sessionsSinceLaunch);
+        addFloatingPointField(writer, TTSDKCrashField_ActiveTimeSinceLaunch,
+                              monitorContext->AppState.activeDurationSinceLaunch);
+        addFloatingPointField(writer, TTSDKCrashField_BGTimeSinceLaunch,
+                              monitorContext->AppState.backgroundDurationSinceLaunch);
     }
     writer->endContainer(writer);
 }
@@ -1357,11 +1513,11 @@ static void writeProcessState(const TTSDKCrashReportWriter *const writer, const
     writer->beginObject(writer, key);
     {
         if (monitorContext->ZombieException.address != 0) {
-            writer->beginObject(writer, TTSDKCrashField_LastDeallocedNSException);
+            beginObjectField(writer, TTSDKCrashField_LastDeallocedNSException);
             {
-                writer->addUIntegerElement(writer, TTSDKCrashField_Address, monitorContext->ZombieException.address);
-                writer->addStringElement(writer, TTSDKCrashField_Name, monitorContext->ZombieException.name);
-                writer->addStringElement(writer, TTSDKCrashField_Reason, monitorContext->ZombieException.reason);
+                addUIntegerField(writer, TTSDKCrashField_Address, monitorContext->ZombieException.address);
+                addStringField(writer, TTSDKCrashField_Name, monitorContext->ZombieException.name);
+                addStringField(writer, TTSDKCrashField_Reason, monitorContext->ZombieException.reason);
                 writeAddressReferencedByString(writer, TTSDKCrashField_ReferencedObject,
                                                monitorContext->ZombieException.reason);
             }
@@ -1386,20 +1542,58 @@ static void writeReportInfo(const TTSDKCrashReportWriter *const writer, const ch
 {
     writer->beginObject(writer, key);
     {
-        writer->addStringElement(writer, TTSDKCrashField_Version, TTSDKCRASH_REPORT_VERSION);
-        writer->addStringElement(writer, TTSDKCrashField_ID, reportID);
-        writer->addStringElement(writer, TTSDKCrashField_ProcessName, processName);
-        writer->addIntegerElement(writer, TTSDKCrashField_Timestamp, ttsdkdate_microseconds());
-        writer->addStringElement(writer, TTSDKCrashField_Type, type);
+        addStringField(writer, TTSDKCrashField_Version, TTSDKCRASH_REPORT_VERSION);
+        addStringField(writer, TTSDKCrashField_ID, reportID);
+        addStringField(writer, TTSDKCrashField_ProcessName, processName);
+        addIntegerField(writer, TTSDKCrashField_Timestamp, ttsdkdate_microseconds());
+        addStringField(writer, TTSDKCrashField_Type, type);
+        const TTSDKJSONEncodeContext *const context = getJsonContext(writer);
+        if (context->format == TTSDKJSONEncodeFormatJSON && context->dataEncoding == TTSDKJSONDataEncodingBase64) {
+            addStringField(writer, TTSDKCrashField_DataEncoding, "base64");
+        }
     }
     writer->endContainer(writer);
 }
 
-static void writeRecrash(const TTSDKCrashReportWriter *const writer, const char *const key, const char *crashReportPath)
+/** Embed a previous report, converting it to JSON if it was written as CBOR. */
+static void writeRecrashContents(const TTSDKCrashReportWriter *const writer, const char *const key,
+                                 const char *crashReportPath)
 {
+    if (ttsdkcbor_isCBORFile(crashReportPath)) {
+        // The CBOR report doesn't declare a data encoding, so its data must use the default.
+        TTSDKJSONEncodeContext *const context = getJsonContext(writer);
+        const TTSDKJSONDataEncoding dataEncoding = context->dataEncoding;
+        ttsdkjson_setDataEncoding(context, TTSDKJSONDataEncodingHex);
+        int result = ttsdkcbor_transcodeFile(crashReportPath, key, context);
+        ttsdkjson_setDataEncoding(context, dataEncoding);
+        if (result != TTSDKJSON_OK) {
+            TTSDKLOG_ERROR("Could not add CBOR report %s: %s", crashReportPath, ttsdkjson_stringForError(result));
+        }
+        return;
+    }
     writer->addJSONFileElement(writer, key, crashReportPath, true);
 }
 
+static void writeRecrash(const TTSDKCrashReportWriter *const writer, const char *const key, const char *crashReportPath)
+{
+    if (!ttsdkgz_isGZipFile(crashReportPath)) {
+        writeRecrashContents(writer, key, crashReportPath);
+        return;
+    }
+
+    static char inflatedPath[TTSDKFU_MAX_PATH_LENGTH];
+    snprintf(inflatedPath, sizeof(inflatedPath), "%s.raw", crashReportPath);
+    // The inflater's state goes after the deflater's in the arena.
+    if (ttsdkgz_inflateFile(crashReportPath, inflatedPath, g_shouldCompress ? &g_zlibArena : NULL)) {
+        writeRecrashContents(writer, key, inflatedPath);
+    } else {
+        TTSDKLOG_ERROR("Could not decompress %s", crashReportPath);
+    }
+    if (remove(inflatedPath) < 0) {
+        TTSDKLOG_ERROR("Could not remove %s: %s", inflatedPath, strerror(errno));
+    }
+}
+
 #pragma mark Setup
 
 /** Prepare a report writer for use.
@@ -1437,56 +1631,77 @@ static void prepareReportWriter(TTSDKCrashReportWriter *const writer, TTSDKJSONE
 void ttsdkcrashreport_writeRecrashReport(const TTSDKCrash_MonitorContext *const monitorContext, const char *const path)
 {
     char writeBuffer[1024];
-    TTSDKBufferedWriter bufferedWriter;
+    char jsonBuffer[1024];
+    TTSDKCrash_ReportFile reportFile;
     static char tempPath[TTSDKFU_MAX_PATH_LENGTH];
     strncpy(tempPath, path, sizeof(tempPath) - 10);
-    strncpy(tempPath + strlen(tempPath) - 5, ".old", 5);
+    // Swap the ".json" or ".json.gz" ending for ".old". The report's contents say whether it's compressed.
+    size_t baseLength = strlen(tempPath);
+    if (baseLength >= 3 && strcmp(tempPath + baseLength - 3, ".gz") == 0) {
+        baseLength -= 3;
+    }
+    if (baseLength >= 5 && strncmp(tempPath + baseLength - 5, ".json", 5) == 0) {
+        baseLength -= 5;
+    }
+    memcpy(tempPath + baseLength, ".old", 5);
     TTSDKLOG_INFO("Writing recrash report to %s", path);
 
     if (rename(path, tempPath) < 0) {
         TTSDKLOG_ERROR("Could not rename %s to %s: %s", path, tempPath, strerror(errno));
     }
-    if (!ttsdkfu_openBufferedWriter(&bufferedWriter, path, writeBuffer, sizeof(writeBuffer))) {
+    if (!openReportFile(&reportFile, path, writeBuffer, sizeof(writeBuffer))) {
         return;
     }
 
     ttsdkccd_freeze();
 
     TTSDKJSONEncodeContext jsonContext;
-    jsonContext.userData = &bufferedWriter;
+    jsonContext.userData = &reportFile;
     TTSDKCrashReportWriter concreteWriter;
     TTSDKCrashReportWriter *writer = &concreteWriter;
     prepareReportWriter(writer, &jsonContext);
 
-    ttsdkjson_beginEncode(getJsonContext(writer), true, addJSONData, &bufferedWriter);
+    ttsdkjson_beginEncode(getJsonContext(writer), !g_shouldWriteCompact, addJSONData, &reportFile);
+    ttsdkjson_setOutputBuffer(getJsonContext(writer), jsonBuffer, sizeof(jsonBuffer));
+    if (g_shouldWriteCBOR) {
+        ttsdkjson_setEncodeFormat(getJsonContext(writer), TTSDKJSONEncodeFormatCBOR);
+    }
+    if (g_shouldWriteBase64Data) {
+        ttsdkjson_setDataEncoding(getJsonContext(writer), TTSDKJSONDataEncodingBase64);
+    }
+    char indexPath[TTSDKFU_MAX_PATH_LENGTH];
+    const bool isIndexed = beginSectionIndex(writer, path, indexPath, sizeof(indexPath));
 
-    writer->beginObject(writer, TTSDKCrashField_Report);
+    beginObjectField(writer, TTSDKCrashField_Report);
     {
         writeRecrash(writer, TTSDKCrashField_RecrashReport, tempPath);
-        ttsdkfu_flushBufferedWriter(&bufferedWriter);
+        flushReport(writer, &reportFile);
         if (remove(tempPath) < 0) {
             TTSDKLOG_ERROR("Could not remove %s: %s", tempPath, strerror(errno));
         }
         writeReportInfo(writer, TTSDKCrashField_Report, TTSDKCrashReportType_Minimal, monitorContext->eventID,
                         monitorContext->System.processName);
-        ttsdkfu_flushBufferedWriter(&bufferedWriter);
+        flushReport(writer, &reportFile);
 
-        writer->beginObject(writer, TTSDKCrashField_Crash);
+        beginObjectField(writer, TTSDKCrashField_Crash);
         {
             writeError(writer, TTSDKCrashField_Error, monitorContext);
-            ttsdkfu_flushBufferedWriter(&bufferedWriter);
+            flushReport(writer, &reportFile);
             int threadIndex = ttsdkmc_indexOfThread(monitorContext->offendingMachineContext,
                                                  ttsdkmc_getThreadFromContext(monitorContext->offendingMachineContext));
             writeThread(writer, TTSDKCrashField_CrashedThread, monitorContext, monitorContext->offendingMachineContext,
                         threadIndex, false);
-            ttsdkfu_flushBufferedWriter(&bufferedWriter);
+            flushReport(writer, &reportFile);
         }
         writer->endContainer(writer);
     }
     writer->endContainer(writer);
 
     ttsdkjson_endEncode(getJsonContext(writer));
-    ttsdkfu_closeBufferedWriter(&bufferedWriter);
+    closeReportFile(&reportFile);
+    if (isIndexed) {
+        writeSectionIndex(writer, indexPath);
+    }
     ttsdkccd_unfreeze();
 }
 
@@ -1495,12 +1710,12 @@ static void writeAppMemoryInfo(const TTSDKCrashReportWriter *const writer, const
 {
     writer->beginObject(writer, key);
     {
-        writer->addUIntegerElement(writer, TTSDKCrashField_MemoryFootprint, monitorContext->AppMemory.footprint);
-        writer->addUIntegerElement(writer, TTSDKCrashField_MemoryRemaining, monitorContext->AppMemory.remaining);
-        writer->addStringElement(writer, TTSDKCrashField_MemoryPressure, monitorContext->AppMemory.pressure);
-        writer->addStringElement(writer, TTSDKCrashField_MemoryLevel, monitorContext->AppMemory.level);
-        writer->addUIntegerElement(writer, TTSDKCrashField_MemoryLimit, monitorContext->AppMemory.limit);
-        writer->addStringElement(writer, TTSDKCrashField_AppTransitionState, monitorContext->AppMemory.state);
+        addUIntegerField(writer, TTSDKCrashField_MemoryFootprint, monitorContext->AppMemory.footprint);
+        addUIntegerField(writer, TTSDKCrashField_MemoryRemaining, monitorContext->AppMemory.remaining);
+        addStringField(writer, TTSDKCrashField_MemoryPressure, monitorContext->AppMemory.pressure);
+        addStringField(writer, TTSDKCrashField_MemoryLevel, monitorContext->AppMemory.level);
+        addUIntegerField(writer, TTSDKCrashField_MemoryLimit, monitorContext->AppMemory.limit);
+        addStringField(writer, TTSDKCrashField_AppTransitionState, monitorContext->AppMemory.state);
     }
     writer->endContainer(writer);
 }
@@ -1510,37 +1725,37 @@ static void writeSystemInfo(const TTSDKCrashReportWriter *const writer, const ch
 {
     writer->beginObject(writer, key);
     {
-        writer->addStringElement(writer, TTSDKCrashField_SystemName, monitorContext->System.systemName);
-        writer->addStringElement(writer, TTSDKCrashField_SystemVersion, monitorContext->System.systemVersion);
-        writer->addStringElement(writer, TTSDKCrashField_Machine, monitorContext->System.machine);
-        writer->addStringElement(writer, TTSDKCrashField_Model, monitorContext->System.model);
-        writer->addStringElement(writer, TTSDKCrashField_KernelVersion, monitorContext->System.kernelVersion);
-        writer->addStringElement(writer, TTSDKCrashField_OSVersion, monitorContext->System.osVersion);
-        writer->addBooleanElement(writer, TTSDKCrashField_Jailbroken, monitorContext->System.isJailbroken);
-        writer->addStringElement(writer, TTSDKCrashField_BootTime, monitorContext->System.bootTime);
-        writer->addStringElement(writer, TTSDKCrashField_AppStartTime, monitorContext->System.appStartTime);
-        writer->addStringElement(writer, TTSDKCrashField_ExecutablePath, monitorContext->System.executablePath);
-        writer->addStringElement(writer, TTSDKCrashField_Executable, monitorContext->System.executableName);
-        writer->addStringElement(writer, TTSDKCrashField_BundleID, monitorContext->System.bundleID);
-        writer->addStringElement(writer, TTSDKCrashField_BundleName, monitorContext->System.bundleName);
-        writer->addStringElement(writer, TTSDKCrashField_BundleVersion, monitorContext->System.bundleVersion);
-        writer->addStringElement(writer, TTSDKCrashField_BundleShortVersion, monitorContext->System.bundleShortVersion);
-        writer->addStringElement(writer, TTSDKCrashField_AppUUID, monitorContext->System.appID);
-        writer->addStringElement(writer, TTSDKCrashField_CPUArch, monitorContext->System.cpuArchitecture);
-        writer->addIntegerElement(writer, TTSDKCrashField_CPUType, monitorContext->System.cpuType);
-        writer->addIntegerElement(writer, TTSDKCrashField_CPUSubType, monitorContext->System.cpuSubType);
-        writer->addIntegerElement(writer, TTSDKCrashField_BinaryCPUType, monitorContext->System.binaryCPUType);
-        writer->addIntegerElement(writer, TTSDKCrashField_BinaryCPUSubType, monitorContext->System.binaryCPUSubType);
-        writer->addStringElement(writer, TTSDKCrashField_TimeZone, monitorContext->System.timezone);
-        writer->addStringElement(writer, TTSDKCrashField_ProcessName, monitorContext->System.processName);
-        writer->addIntegerElement(writer, TTSDKCrashField_ProcessID, monitorContext->System.processID);
-        writer->addIntegerElement(writer, TTSDKCrashField_ParentProcessID, monitorContext->System.parentProcessID);
-        writer->addStringElement(writer, TTSDKCrashField_DeviceAppHash, monitorContext->System.deviceAppHash);
-        writer->addStringElement(writer, TTSDKCrashField_BuildType, monitorContext->System.buildType);
-        writer->addIntegerElement(writer, TTSDKCrashField_Storage, (int64_t)monitorContext->System.storageSize);
+        addStringField(writer, TTSDKCrashField_SystemName, monitorContext->System.systemName);
+        addStringField(writer, TTSDKCrashField_SystemVersion, monitorContext->System.systemVersion);
+        addStringField(writer, TTSDKCrashField_Machine, monitorContext->System.machine);
+        addStringField(writer, TTSDKCrashField_Model, monitorContext->System.model);
+        addStringField(writer, TTSDKCrashField_KernelVersion, monitorContext->System.kernelVersion);
+        addStringField(writer, TTSDKCrashField_OSVersion, monitorContext->System.osVersion);
+        addBooleanField(writer, TTSDKCrashField_Jailbroken, monitorContext->System.isJailbroken);
+        addStringField(writer, TTSDKCrashField_BootTime, monitorContext->System.bootTime);
+        addStringField(writer, TTSDKCrashField_AppStartTime, monitorContext->System.appStartTime);
+        addStringField(writer, TTSDKCrashField_ExecutablePath, monitorContext->System.executablePath);
+        addStringField(writer, TTSDKCrashField_Executable, monitorContext->System.executableName);
+        addStringField(writer, TTSDKCrashField_BundleID, monitorContext->System.bundleID);
+        addStringField(writer, TTSDKCrashField_BundleName, monitorContext->System.bundleName);
+        addStringField(writer, TTSDKCrashField_BundleVersion, monitorContext->System.bundleVersion);
+        addStringField(writer, TTSDKCrashField_BundleShortVersion, monitorContext->System.bundleShortVersion);
+        addStringField(writer, TTSDKCrashField_AppUUID, monitorContext->System.appID);
+        addStringField(writer, TTSDKCrashField_CPUArch, monitorContext->System.cpuArchitecture);
+        addIntegerField(writer, TTSDKCrashField_CPUType, monitorContext->System.cpuType);
+        addIntegerField(writer, TTSDKCrashField_CPUSubType, monitorContext->System.cpuSubType);
+        addIntegerField(writer, TTSDKCrashField_BinaryCPUType, monitorContext->System.binaryCPUType);
+        addIntegerField(writer, TTSDKCrashField_BinaryCPUSubType, monitorContext->System.binaryCPUSubType);
+        addStringField(writer, TTSDKCrashField_TimeZone, monitorContext->System.timezone);
+        addStringField(writer, TTSDKCrashField_ProcessName, monitorContext->System.processName);
+        addIntegerField(writer, TTSDKCrashField_ProcessID, monitorContext->System.processID);
+        addIntegerField(writer, TTSDKCrashField_ParentProcessID, monitorContext->System.parentProcessID);
+        addStringField(writer, TTSDKCrashField_DeviceAppHash, monitorContext->System.deviceAppHash);
+        addStringField(writer, TTSDKCrashField_BuildType, monitorContext->System.buildType);
+        addIntegerField(writer, TTSDKCrashField_Storage, (int64_t)monitorContext->System.storageSize);
         
-        writer->addIntegerElement(writer, TTSDKCrashField_BeginAddress, (int64_t)TikTokBusinessSDKFuncBeginAddress());
-        writer->addIntegerElement(writer, TTSDKCrashField_EndAddress, (int64_t)TikTokBusinessSDKFuncEndAddress());
+        addIntegerField(writer, TTSDKCrashField_BeginAddress, (int64_t)TikTokBusinessSDKFuncBeginAddress());
+        addIntegerField(writer, TTSDKCrashField_EndAddress, (int64_t)TikTokBusinessSDKFuncEndAddress());
 
         writeMemoryInfo(writer, TTSDKCrashField_Memory, monitorContext);
         writeAppStats(writer, TTSDKCrashField_AppStats, monitorContext);
@@ -1565,69 +1780,82 @@ void ttsdkcrashreport_writeStandardReport(const TTSDKCrash_MonitorContext *const
 {
     TTSDKLOG_INFO("Writing crash report to %s", path);
     char writeBuffer[1024];
-    TTSDKBufferedWriter bufferedWriter;
+    char jsonBuffer[1024];
+    TTSDKCrash_ReportFile reportFile;
 
-    if (!ttsdkfu_openBufferedWriter(&bufferedWriter, path, writeBuffer, sizeof(writeBuffer))) {
+    if (!openReportFile(&reportFile, path, writeBuffer, sizeof(writeBuffer))) {
         return;
     }
 
     ttsdkccd_freeze();
 
     TTSDKJSONEncodeContext jsonContext;
-    jsonContext.userData = &bufferedWriter;
+    jsonContext.userData = &reportFile;
     TTSDKCrashReportWriter concreteWriter;
     TTSDKCrashReportWriter *writer = &concreteWriter;
     prepareReportWriter(writer, &jsonContext);
 
-    ttsdkjson_beginEncode(getJsonContext(writer), true, addJSONData, &bufferedWriter);
+    ttsdkjson_beginEncode(getJsonContext(writer), !g_shouldWriteCompact, addJSONData, &reportFile);
+    ttsdkjson_setOutputBuffer(getJsonContext(writer), jsonBuffer, sizeof(jsonBuffer));
+    if (g_shouldWriteCBOR) {
+        ttsdkjson_setEncodeFormat(getJsonContext(writer), TTSDKJSONEncodeFormatCBOR);
+    }
+    if (g_shouldWriteBase64Data) {
+        ttsdkjson_setDataEncoding(getJsonContext(writer), TTSDKJSONDataEncodingBase64);
+    }
+    char indexPath[TTSDKFU_MAX_PATH_LENGTH];
+    const bool isIndexed = beginSectionIndex(writer, path, indexPath, sizeof(indexPath));
 
-    writer->beginObject(writer, TTSDKCrashField_Report);
+    beginObjectField(writer, TTSDKCrashField_Report);
     {
         writeReportInfo(writer, TTSDKCrashField_Report, TTSDKCrashReportType_Standard, monitorContext->eventID,
                         monitorContext->System.processName);
-        ttsdkfu_flushBufferedWriter(&bufferedWriter);
+        flushReport(writer, &reportFile);
 
         if (!monitorContext->omitBinaryImages) {
             writeBinaryImages(writer, TTSDKCrashField_BinaryImages);
-            ttsdkfu_flushBufferedWriter(&bufferedWriter);
+            flushReport(writer, &reportFile);
         }
 
         writeProcessState(writer, TTSDKCrashField_ProcessState, monitorContext);
-        ttsdkfu_flushBufferedWriter(&bufferedWriter);
+        flushReport(writer, &reportFile);
 
         writeSystemInfo(writer, TTSDKCrashField_System, monitorContext);
-        ttsdkfu_flushBufferedWriter(&bufferedWriter);
+        flushReport(writer, &reportFile);
 
-        writer->beginObject(writer, TTSDKCrashField_Crash);
+        beginObjectField(writer, TTSDKCrashField_Crash);
         {
             writeError(writer, TTSDKCrashField_Error, monitorContext);
-            ttsdkfu_flushBufferedWriter(&bufferedWriter);
+            flushReport(writer, &reportFile);
             writeAllThreads(writer, TTSDKCrashField_Threads, monitorContext, g_introspectionRules.enabled);
-            ttsdkfu_flushBufferedWriter(&bufferedWriter);
+            flushReport(writer, &reportFile);
         }
         writer->endContainer(writer);
 
         if (g_userInfoJSON != NULL) {
             addJSONElement(writer, TTSDKCrashField_User, g_userInfoJSON, false);
-            ttsdkfu_flushBufferedWriter(&bufferedWriter);
+            flushReport(writer, &reportFile);
         } else {
-            writer->beginObject(writer, TTSDKCrashField_User);
+            beginObjectField(writer, TTSDKCrashField_User);
         }
         if (g_userSectionWriteCallback != NULL) {
-            ttsdkfu_flushBufferedWriter(&bufferedWriter);
+            flushReport(writer, &reportFile);
             if (monitorContext->currentSnapshotUserReported == false) {
                 g_userSectionWriteCallback(writer);
             }
         }
         writer->endContainer(writer);
-        ttsdkfu_flushBufferedWriter(&bufferedWriter);
+        flushReport(writer, &reportFile);
 
         writeDebugInfo(writer, TTSDKCrashField_Debug, monitorContext);
     }
     writer->endContainer(writer);
 
     ttsdkjson_endEncode(getJsonContext(writer));
-    ttsdkfu_closeBufferedWriter(&bufferedWriter);
+    closeReportFile(&reportFile);
+    if (isIndexed) {
+        writeSectionIndex(writer, indexPath);
+    }
     ttsdkccd_unfreeze();
 }
 
@@ -1665,6 +1893,41 @@ void ttsdkcrashreport_setIntrospectMemory(bool shouldIntrospectMemory)
     g_introspectionRules.enabled = shouldIntrospectMemory;
 }
 
+void ttsdkcrashreport_setWriteCBOR(bool shouldWriteCBOR)
+{
+    g_shouldWriteCBOR = shouldWriteCBOR;
+}
+
+void ttsdkcrashreport_setWriteBase64Data(bool shouldWriteBase64Data)
+{
+    g_shouldWriteBase64Data = shouldWriteBase64Data;
+}
+
+void ttsdkcrashreport_setWriteCompact(bool shouldWriteCompact)
+{
+    g_shouldWriteCompact = shouldWriteCompact;
+}
+
+void ttsdkcrashreport_setWriteSectionIndex(bool shouldWriteSectionIndex)
+{
+    g_shouldWriteSectionIndex = shouldWriteSectionIndex;
+}
+
+void ttsdkcrashreport_setCompressReports(bool shouldCompressReports)
+{
+    if (shouldCompressReports && g_zlibArena.memory == NULL) {
+        // Room to deflate the report and inflate a previous one for a recrash report at the same time.
+        const int size = TTSDKGZ_DEFLATE_MEMORY_SIZE + TTSDKGZ_INFLATE_MEMORY_SIZE + 16;
+        char *memory = malloc((size_t)size);
+        if (memory == NULL) {
+            TTSDKLOG_ERROR("Could not allocate %d bytes for report compression", size);
+            return;
+        }
+        ttsdkgz_initArena(&g_zlibArena, memory, size);
+    }
+    g_shouldCompress = shouldCompressReports;
+}
+
 void ttsdkcrashreport_setDoNotIntrospectClasses(const char **doNotIntrospectClasses, int length)
 {
     const char **oldClasses = g_introspectionRules.restrictedClasses;
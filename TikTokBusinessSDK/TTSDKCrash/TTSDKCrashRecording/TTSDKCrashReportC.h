@@ -64,6 +64,39 @@ const char *ttsdkcrashreport_getUserInfoJSON(void);
  */
 void ttsdkcrashreport_setIntrospectMemory(bool shouldIntrospectMemory);
 
+/** Configure whether to write reports as CBOR instead of JSON.
+ *  The report store converts CBOR reports back to JSON when reading them.
+ *
+ * @param shouldWriteCBOR If true, write CBOR.
+ */
+void ttsdkcrashreport_setWriteCBOR(bool shouldWriteCBOR);
+
+/** Configure whether to write data elements as base64 instead of hex.
+ *
+ * @param shouldWriteBase64Data If true, write base64.
+ */
+void ttsdkcrashreport_setWriteBase64Data(bool shouldWriteBase64Data);
+
+/** Configure whether to write JSON reports without pretty printing.
+ *
+ * @param shouldWriteCompact If true, write compact JSON.
+ */
+void ttsdkcrashreport_setWriteCompact(bool shouldWriteCompact);
+
+/** Configure whether to write an index of each report's sections next to it.
+ *
+ * @param shouldWriteSectionIndex If true, write section indexes.
+ */
+void ttsdkcrashreport_setWriteSectionIndex(bool shouldWriteSectionIndex);
+
+/** Configure whether reports whose path ends in ".gz" are gzip compressed.
+ *  Enabling this allocates the compressor's memory, so that none is
+ *  allocated while handling a crash.
+ *
+ * @param shouldCompressReports If true, compress reports.
+ */
+void ttsdkcrashreport_setCompressReports(bool shouldCompressReports);
+
 /** Specify which objective-c classes should not be introspected.
  *
  * @param doNotIntrospectClasses Array of class names.
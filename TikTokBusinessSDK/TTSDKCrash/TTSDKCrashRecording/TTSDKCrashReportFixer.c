@@ -24,50 +24,147 @@
 // THE SOFTWARE.
 //
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "TTSDKCrashReportFields.h"
 #include "TTSDKDate.h"
+#include "TTSDKFileUtils.h"
 #include "TTSDKJSONCodec.h"
 #include "TTSDKLogger.h"
 #include "TTSDKSystemCapabilities.h"
 
 #define MAX_DEPTH 100
-#define MAX_NAME_LENGTH 100
+#define MAX_PATH_LENGTH 4
 #define REPORT_VERSION_COMPONENTS_COUNT 3
+#define STRING_BUFFER_LENGTH 10000
+#define READ_BUFFER_LENGTH 4096
+#define OUTPUT_BUFFER_LENGTH 4096
+
+/** The keys that the fixer looks for, by key ID. */
+enum {
+    FixupKeyReport,
+    FixupKeyRecrashReport,
+    FixupKeyTimestamp,
+    FixupKeyVersion,
+    FixupKeyCount,
+};
 
-static const char *datePaths[][MAX_DEPTH] = {
-    { "", TTSDKCrashField_Report, TTSDKCrashField_Timestamp },
-    { "", TTSDKCrashField_RecrashReport, TTSDKCrashField_Report, TTSDKCrashField_Timestamp },
+static const char *const fixupKeys[] = {
+    [FixupKeyReport] = TTSDKCrashField_Report,
+    [FixupKeyRecrashReport] = TTSDKCrashField_RecrashReport,
+    [FixupKeyTimestamp] = TTSDKCrashField_Timestamp,
+    [FixupKeyVersion] = TTSDKCrashField_Version,
 };
-static int datePathsCount = sizeof(datePaths) / sizeof(*datePaths);
 
-static const char *versionPaths[][MAX_DEPTH] = {
-    { "", TTSDKCrashField_Report, TTSDKCrashField_Version },
-    { "", TTSDKCrashField_RecrashReport, TTSDKCrashField_Report, TTSDKCrashField_Version },
+/** What to do with an element. */
+typedef enum {
+    FixupActionNone,
+    FixupActionDate,
+    FixupActionVersion,
+} FixupAction;
+
+/** An element to fix up, by the path of member names from the top-level object to it. */
+typedef struct {
+    int length;
+    int keys[MAX_PATH_LENGTH];
+    FixupAction action;
+} FixupRule;
+
+static const FixupRule fixupRules[] = {
+    { 2, { FixupKeyReport, FixupKeyTimestamp }, FixupActionDate },
+    { 3, { FixupKeyRecrashReport, FixupKeyReport, FixupKeyTimestamp }, FixupActionDate },
+    { 2, { FixupKeyReport, FixupKeyVersion }, FixupActionVersion },
+    { 3, { FixupKeyRecrashReport, FixupKeyReport, FixupKeyVersion }, FixupActionVersion },
 };
-static int versionPathsCount = sizeof(versionPaths) / sizeof(*versionPaths);
+static const int fixupRulesCount = sizeof(fixupRules) / sizeof(*fixupRules);
+
+/** The most states the rules can compile to: the top-level object, plus one per container on a rule's path. */
+#define MAX_MATCHER_STATES (1 + sizeof(fixupRules) / sizeof(*fixupRules) * (MAX_PATH_LENGTH - 1))
+
+/** The state of a container that no rule reaches into. */
+#define MATCHER_STATE_NONE (-1)
+
+/** A container that the rules reach into, as a node of a trie over key IDs. */
+typedef struct {
+    /** The state of a member container with each key ID as its name. */
+    int8_t next[FixupKeyCount];
+    /** What to do with a member element with each key ID as its name. */
+    uint8_t actions[FixupKeyCount];
+} MatcherState;
+
+/** The fixup rules compiled into a state machine that's advanced as containers
+ * begin and end, so finding an element's action takes the same time however
+ * many rules there are.
+ */
+typedef struct {
+    MatcherState states[MAX_MATCHER_STATES];
+    int stateCount;
+} PathMatcher;
 
 typedef struct {
     TTSDKJSONEncodeContext *encodeContext;
+    const TTSDKJSONKeyDictionary *keyDictionary;
+    const PathMatcher *matcher;
     int reportVersionComponents[REPORT_VERSION_COMPONENTS_COUNT];
-    char objectPath[MAX_DEPTH][MAX_NAME_LENGTH];
+    /** The matcher state of each open container. */
+    int8_t containerStates[MAX_DEPTH];
     int currentDepth;
-    char *outputPtr;
-    int outputBytesLeft;
 } FixupContext;
 
+/** A fixed up report that grows as it's written. */
+typedef struct {
+    char *data;
+    int length;
+    int capacity;
+} FixedReport;
+
+static int addMatcherState(PathMatcher *matcher)
+{
+    MatcherState *state = &matcher->states[matcher->stateCount];
+    memset(state->next, MATCHER_STATE_NONE, sizeof(state->next));
+    memset(state->actions, FixupActionNone, sizeof(state->actions));
+    return matcher->stateCount++;
+}
+
+static void compilePathMatcher(PathMatcher *matcher)
+{
+    matcher->stateCount = 0;
+    const int topLevelState = addMatcherState(matcher);
+    for (int i = 0; i < fixupRulesCount; i++) {
+        const FixupRule *rule = &fixupRules[i];
+        int state = topLevelState;
+        for (int j = 0; j < rule->length - 1; j++) {
+            const int key = rule->keys[j];
+            if (matcher->states[state].next[key] == MATCHER_STATE_NONE) {
+                matcher->states[state].next[key] = (int8_t)addMatcherState(matcher);
+            }
+            state = matcher->states[state].next[key];
+        }
+        matcher->states[state].actions[rule->keys[rule->length - 1]] = (uint8_t)rule->action;
+    }
+}
+
 static bool increaseDepth(FixupContext *context, const char *name)
 {
     if (context->currentDepth >= MAX_DEPTH) {
         return false;
     }
-    if (name == NULL) {
-        *context->objectPath[context->currentDepth] = '\0';
+    int state = MATCHER_STATE_NONE;
+    if (context->currentDepth == 0) {
+        state = 0;
     } else {
-        strncpy(context->objectPath[context->currentDepth], name, sizeof(context->objectPath[context->currentDepth]));
+        const int parentState = context->containerStates[context->currentDepth - 1];
+        if (parentState != MATCHER_STATE_NONE) {
+            const int key = ttsdkjson_keyID(context->keyDictionary, name);
+            if (key != TTSDKJSON_KEY_UNKNOWN) {
+                state = context->matcher->states[parentState].next[key];
+            }
+        }
     }
+    context->containerStates[context->currentDepth] = (int8_t)state;
     context->currentDepth++;
     return true;
 }
@@ -81,31 +178,21 @@ static bool decreaseDepth(FixupContext *context)
     return true;
 }
 
-static bool matchesPath(FixupContext *context, const char **path, const char *finalName)
+/** Find what to do with an element in the current container. */
+static FixupAction actionForElement(FixupContext *context, const char *name)
 {
-    if (finalName == NULL) {
-        finalName = "";
-    }
-
-    for (int i = 0; i < context->currentDepth; i++) {
-        if (strncmp(context->objectPath[i], path[i], MAX_NAME_LENGTH) != 0) {
-            return false;
-        }
+    if (context->currentDepth == 0) {
+        return FixupActionNone;
     }
-    if (strncmp(finalName, path[context->currentDepth], MAX_NAME_LENGTH) != 0) {
-        return false;
+    const int state = context->containerStates[context->currentDepth - 1];
+    if (state == MATCHER_STATE_NONE) {
+        return FixupActionNone;
     }
-    return true;
-}
-
-static bool matchesAPath(FixupContext *context, const char *name, const char *paths[][MAX_DEPTH], int pathsCount)
-{
-    for (int i = 0; i < pathsCount; i++) {
-        if (matchesPath(context, paths[i], name)) {
-            return true;
-        }
+    const int key = ttsdkjson_keyID(context->keyDictionary, name);
+    if (key == TTSDKJSON_KEY_UNKNOWN) {
+        return FixupActionNone;
     }
-    return false;
+    return (FixupAction)context->matcher->states[state].actions[key];
 }
 
 static bool matchesMinVersion(FixupContext *context, int major, int minor, int patch)
@@ -119,16 +206,6 @@ static bool matchesMinVersion(FixupContext *context, int major, int minor, int p
     return result;
 }
 
-static bool shouldFixDate(FixupContext *context, const char *name)
-{
-    return matchesAPath(context, name, datePaths, datePathsCount);
-}
-
-static bool shouldSaveVersion(FixupContext *context, const char *name)
-{
-    return matchesAPath(context, name, versionPaths, versionPathsCount);
-}
-
 static int onBooleanElement(const char *const name, const bool value, void *const userData)
 {
     FixupContext *context = (FixupContext *)userData;
@@ -145,7 +222,7 @@ static int onIntegerElement(const char *const name, const int64_t value, void *c
 {
     FixupContext *context = (FixupContext *)userData;
     int result = TTSDKJSON_OK;
-    if (shouldFixDate(context, name)) {
+    if (actionForElement(context, name) == FixupActionDate) {
         char buffer[28];
 
         if (matchesMinVersion(context, 3, 3, 0)) {
@@ -173,15 +250,15 @@ static int onNullElement(const char *const name, void *const userData)
     return ttsdkjson_addNullElement(context->encodeContext, name);
 }
 
-static int onStringElement(const char *const name, const char *const value, void *const userData)
+static int onStringElementSlice(const char *const name, __unused const int nameLength, const char *const value,
+                                const int valueLength, void *const userData)
 {
     FixupContext *context = (FixupContext *)userData;
-    const char *stringValue = value;
-    int result = ttsdkjson_addStringElement(context->encodeContext, name, stringValue, (int)strlen(stringValue));
-    if (shouldSaveVersion(context, name)) {
+    int result = ttsdkjson_addStringElement(context->encodeContext, name, value, valueLength);
+    if (actionForElement(context, name) == FixupActionVersion) {
         memset(context->reportVersionComponents, 0, sizeof(context->reportVersionComponents));
         int versionPartsIndex = 0;
-        char *mutableValue = strdup(value);
+        char *mutableValue = strndup(value, (size_t)valueLength);
         char *versionPart = strtok(mutableValue, ".");
         while (versionPart != NULL && versionPartsIndex < REPORT_VERSION_COMPONENTS_COUNT) {
             context->reportVersionComponents[versionPartsIndex++] = atoi(versionPart);
@@ -192,6 +269,28 @@ static int onStringElement(const char *const name, const char *const value, void
     return result;
 }
 
+static int onStringElement(const char *const name, const char *const value, void *const userData)
+{
+    return onStringElementSlice(name, name != NULL ? (int)strlen(name) : 0, value, (int)strlen(value), userData);
+}
+
+static int onStringElementPart(const char *const name, const char *const value, const int valueLength,
+                               const bool isFirstPart, const bool isLastPart, void *const userData)
+{
+    FixupContext *context = (FixupContext *)userData;
+    int result = TTSDKJSON_OK;
+    if (isFirstPart) {
+        result = ttsdkjson_beginStringElement(context->encodeContext, name);
+    }
+    if (result == TTSDKJSON_OK) {
+        result = ttsdkjson_appendStringElement(context->encodeContext, value, valueLength);
+    }
+    if (result == TTSDKJSON_OK && isLastPart) {
+        result = ttsdkjson_endStringElement(context->encodeContext);
+    }
+    return result;
+}
+
 static int onBeginObject(const char *const name, void *const userData)
 {
     FixupContext *context = (FixupContext *)userData;
@@ -228,26 +327,38 @@ static int onEndData(__unused void *const userData)
     return ttsdkjson_endEncode(context->encodeContext);
 }
 
-static int addJSONData(const char *data, int length, void *userData)
+static int addFixedReportData(const char *data, int length, void *userData)
 {
-    FixupContext *context = (FixupContext *)userData;
-    if (length > context->outputBytesLeft) {
-        return TTSDKJSON_ERROR_DATA_TOO_LONG;
+    FixedReport *report = (FixedReport *)userData;
+    if (report->length + length >= report->capacity) {
+        int capacity = (report->length + length) * 2 + 1;
+        char *newData = realloc(report->data, (size_t)capacity);
+        if (newData == NULL) {
+            return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+        }
+        report->data = newData;
+        report->capacity = capacity;
     }
-    memcpy(context->outputPtr, data, length);
-    context->outputPtr += length;
-    context->outputBytesLeft -= length;
-
+    memcpy(report->data + report->length, data, (size_t)length);
+    report->length += length;
+    report->data[report->length] = '\0';
     return TTSDKJSON_OK;
 }
 
-char *ttsdkcrf_fixupCrashReport(const char *crashReport)
+static int addDataToFD(const char *data, int length, void *userData)
 {
-    if (crashReport == NULL) {
-        return NULL;
-    }
+    const int fd = *(const int *)userData;
+    return ttsdkfu_writeBytesToFD(fd, data, length) ? TTSDKJSON_OK : TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+}
 
-    TTSDKJSONDecodeCallbacks callbacks = {
+/** Set up the decode callbacks and encoder that do a fixup. */
+static void beginFixup(FixupContext *fixupContext, TTSDKJSONKeyDictionary *keyDictionary, PathMatcher *matcher,
+                       TTSDKJSONDecodeCallbacks *callbacks, TTSDKJSONEncodeContext *encodeContext, bool prettyPrint,
+                       TTSDKJSONAddDataFunc addJSONData, void *userData, TTSDKJSONSectionIndex *sectionIndex)
+{
+    ttsdkjson_compileKeyDictionary(keyDictionary, fixupKeys, (int)(sizeof(fixupKeys) / sizeof(*fixupKeys)));
+    compilePathMatcher(matcher);
+    *callbacks = (TTSDKJSONDecodeCallbacks) {
         .onBeginArray = onBeginArray,
         .onBeginObject = onBeginObject,
         .onBooleanElement = onBooleanElement,
@@ -258,32 +369,124 @@ char *ttsdkcrf_fixupCrashReport(const char *crashReport)
         .onUnsignedIntegerElement = onUnsignedIntegerElement,
         .onNullElement = onNullElement,
         .onStringElement = onStringElement,
+        .onStringElementSlice = onStringElementSlice,
+        .onStringElementPart = onStringElementPart,
+        .keyDictionary = keyDictionary,
     };
-    int stringBufferLength = 10000;
-    char *stringBuffer = malloc((unsigned)stringBufferLength);
-    int crashReportLength = (int)strlen(crashReport);
-    int fixedReportLength = (int)(crashReportLength * 1.5);
-    char *fixedReport = malloc((unsigned)fixedReportLength);
-    TTSDKJSONEncodeContext encodeContext;
-    FixupContext fixupContext = {
-        .encodeContext = &encodeContext,
+    *fixupContext = (FixupContext) {
+        .encodeContext = encodeContext,
+        .keyDictionary = keyDictionary,
+        .matcher = matcher,
         .reportVersionComponents = { 0 },
         .currentDepth = 0,
-        .outputPtr = fixedReport,
-        .outputBytesLeft = fixedReportLength,
     };
+    ttsdkjson_beginEncode(encodeContext, prettyPrint, addJSONData, userData);
+    if (sectionIndex != NULL) {
+        ttsdkjson_beginSectionIndex(encodeContext, sectionIndex, sectionIndex->entries, sectionIndex->capacity);
+    }
+}
 
-    ttsdkjson_beginEncode(&encodeContext, true, addJSONData, &fixupContext);
-
+int ttsdkcrf_fixupCrashReportData(const char *crashReport, int length, TTSDKJSONAddDataFunc addJSONData,
+                                  void *userData, TTSDKJSONSectionIndex *sectionIndex)
+{
+    TTSDKJSONKeyDictionary keyDictionary;
+    PathMatcher matcher;
+    TTSDKJSONDecodeCallbacks callbacks;
+    TTSDKJSONEncodeContext encodeContext;
+    FixupContext fixupContext;
+    // Keep the report's layout. Compact JSON has no newlines outside of strings, where they're escaped.
+    bool prettyPrint = memchr(crashReport, '\n', (size_t)length) != NULL;
+    beginFixup(&fixupContext, &keyDictionary, &matcher, &callbacks, &encodeContext, prettyPrint, addJSONData, userData,
+               sectionIndex);
+    char outputBuffer[OUTPUT_BUFFER_LENGTH];
+    ttsdkjson_setOutputBuffer(&encodeContext, outputBuffer, sizeof(outputBuffer));
+
+    char *stringBuffer = malloc(STRING_BUFFER_LENGTH);
+    if (stringBuffer == NULL) {
+        return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+    }
     int errorOffset = 0;
-    int result = ttsdkjson_decode(crashReport, (int)strlen(crashReport), stringBuffer, stringBufferLength, &callbacks,
-                               &fixupContext, &errorOffset);
-    *fixupContext.outputPtr = '\0';
+    int result = ttsdkjson_decode(crashReport, length, stringBuffer, STRING_BUFFER_LENGTH, &callbacks, &fixupContext,
+                                  &errorOffset);
     free(stringBuffer);
     if (result != TTSDKJSON_OK) {
         TTSDKLOG_ERROR("Could not decode report: %s", ttsdkjson_stringForError(result));
-        free(fixedReport);
+    }
+    return result;
+}
+
+char *ttsdkcrf_fixupCrashReport(const char *crashReport)
+{
+    if (crashReport == NULL) {
         return NULL;
     }
-    return fixedReport;
+
+    FixedReport fixedReport = { 0 };
+    if (ttsdkcrf_fixupCrashReportData(crashReport, (int)strlen(crashReport), addFixedReportData, &fixedReport, NULL) !=
+        TTSDKJSON_OK) {
+        free(fixedReport.data);
+        return NULL;
+    }
+    return fixedReport.data;
+}
+
+/** Read the next piece of a report, retrying if interrupted.
+ *
+ * @return The number of bytes read, 0 at the end of the file, or -1 on error.
+ */
+static int readReportPiece(int fd, char *buffer, int length)
+{
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(fd, buffer, (size_t)length);
+    } while (bytesRead < 0 && errno == EINTR);
+    if (bytesRead < 0) {
+        TTSDKLOG_ERROR("Could not read report: %s", strerror(errno));
+    }
+    return (int)bytesRead;
+}
+
+int ttsdkcrf_fixupCrashReportFromFD(int fd, TTSDKJSONAddDataFunc addJSONData, void *userData,
+                                    TTSDKJSONSectionIndex *sectionIndex)
+{
+    char readBuffer[READ_BUFFER_LENGTH];
+    int bytesRead = readReportPiece(fd, readBuffer, sizeof(readBuffer));
+
+    TTSDKJSONKeyDictionary keyDictionary;
+    PathMatcher matcher;
+    TTSDKJSONDecodeCallbacks callbacks;
+    TTSDKJSONEncodeContext encodeContext;
+    FixupContext fixupContext;
+    // A pretty printed report has a newline right after its opening brace, so the first piece is enough to tell.
+    bool prettyPrint = bytesRead > 0 && memchr(readBuffer, '\n', (size_t)bytesRead) != NULL;
+    beginFixup(&fixupContext, &keyDictionary, &matcher, &callbacks, &encodeContext, prettyPrint, addJSONData, userData,
+               sectionIndex);
+    char outputBuffer[OUTPUT_BUFFER_LENGTH];
+    ttsdkjson_setOutputBuffer(&encodeContext, outputBuffer, sizeof(outputBuffer));
+
+    char *stringBuffer = malloc(STRING_BUFFER_LENGTH);
+    if (stringBuffer == NULL) {
+        return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+    }
+    TTSDKJSONDecoder decoder;
+    ttsdkjson_decoderInit(&decoder, stringBuffer, STRING_BUFFER_LENGTH, &callbacks, &fixupContext);
+    int result = TTSDKJSON_OK;
+    while (bytesRead > 0 && result == TTSDKJSON_OK) {
+        result = ttsdkjson_decoderFeed(&decoder, readBuffer, bytesRead);
+        bytesRead = readReportPiece(fd, readBuffer, sizeof(readBuffer));
+    }
+    if (result == TTSDKJSON_OK) {
+        // Reports the error if the document ended early, or calls onEndData(), which flushes the output.
+        result = ttsdkjson_decoderFinish(&decoder);
+    }
+    free(stringBuffer);
+    if (result != TTSDKJSON_OK) {
+        TTSDKLOG_ERROR("Could not decode report: %s", ttsdkjson_stringForError(result));
+    }
+    return result;
+}
+
+int ttsdkcrf_fixupCrashReportToFD(int inputFD, int outputFD)
+{
+    return ttsdkcrf_fixupCrashReportFromFD(inputFD, addDataToFD, &outputFD, NULL);
 }
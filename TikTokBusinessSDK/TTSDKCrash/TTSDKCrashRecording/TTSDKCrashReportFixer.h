@@ -27,6 +27,8 @@
 #ifndef HDR_TTSDKCrashReportFixer_h
 #define HDR_TTSDKCrashReportFixer_h
 
+#include "TTSDKJSONCodec.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -37,11 +39,64 @@ extern "C" {
  *
  * @param crashReport A raw report loaded from disk.
  *
- * @return A fixed up crash report.
+ * @return A fixed up crash report, pretty printed only if the raw report was.
  *         MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
  */
 char *ttsdkcrf_fixupCrashReport(const char *crashReport);
 
+/** Fix up a crash report that's in memory, passing on the fixed up report as
+ * it's produced.
+ *
+ * @param crashReport A raw report loaded from disk.
+ *
+ * @param length The length of the raw report.
+ *
+ * @param addJSONData Called with each piece of the fixed up report, which is
+ *                    pretty printed only if the raw report was.
+ *
+ * @param userData Data to pass to addJSONData.
+ *
+ * @param sectionIndex If not NULL, a section index with its entries and
+ *                     capacity set, which is filled in with where each
+ *                     section of the fixed up report was written.
+ *
+ * @return TTSDKJSON_OK if successful. On failure, part of the report may
+ *         already have been passed to addJSONData.
+ */
+int ttsdkcrf_fixupCrashReportData(const char *crashReport, int length, TTSDKJSONAddDataFunc addJSONData,
+                                  void *userData, TTSDKJSONSectionIndex *sectionIndex);
+
+/** Fix up a crash report as it's read from a file, passing on the fixed up
+ * report as it's produced. The report is read and written through
+ * fixed-size buffers, so memory use doesn't depend on its size.
+ *
+ * @param fd The file to read the raw report from.
+ *
+ * @param addJSONData Called with each piece of the fixed up report, which is
+ *                    pretty printed only if the raw report was.
+ *
+ * @param userData Data to pass to addJSONData.
+ *
+ * @param sectionIndex If not NULL, a section index to fill in.
+ *                     See ttsdkcrf_fixupCrashReportData().
+ *
+ * @return TTSDKJSON_OK if successful. On failure, part of the report may
+ *         already have been passed to addJSONData.
+ */
+int ttsdkcrf_fixupCrashReportFromFD(int fd, TTSDKJSONAddDataFunc addJSONData, void *userData,
+                                    TTSDKJSONSectionIndex *sectionIndex);
+
+/** Fix up a crash report from one file into another.
+ * See ttsdkcrf_fixupCrashReportFromFD().
+ *
+ * @param inputFD The file to read the raw report from.
+ *
+ * @param outputFD The file to write the fixed up report to.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+int ttsdkcrf_fixupCrashReportToFD(int inputFD, int outputFD);
+
 #ifdef __cplusplus
 }
 #endif
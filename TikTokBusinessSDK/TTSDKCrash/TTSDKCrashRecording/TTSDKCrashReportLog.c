@@ -0,0 +1,649 @@
+//
+//  TTSDKCrashReportLog.c
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "TTSDKCrashReportLog.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "TTSDKFileUtils.h"
+
+// #define TTSDKLogger_LocalLevel TRACE
+#include "TTSDKLogger.h"
+
+#define SEGMENT_EXTENSION ".seg"
+
+/** Don't bother compacting until at least this much of the log is dead. */
+#define kMinimumCompactionSize (64 * 1024)
+
+typedef enum {
+    RecordTypeReport = 1,
+    RecordTypeFixedReport = 2,
+    RecordTypeDeletion = 3,
+} RecordType;
+
+typedef struct {
+    char magic[4];
+    uint8_t type;
+    uint8_t reserved[3];
+    /** The length of the report that follows. */
+    int32_t length;
+    /** CRC-32 of this header, with this field set to 0, followed by the report. */
+    uint32_t checksum;
+    int64_t reportID;
+} RecordHeader;
+
+static const char g_recordMagic[4] = { 'T', 'T', 'R', 'L' };
+
+static uint32_t getChecksum(const RecordHeader *const header, const char *const report)
+{
+    RecordHeader unsummedHeader = *header;
+    unsummedHeader.checksum = 0;
+    uLong checksum = crc32(0L, Z_NULL, 0);
+    checksum = crc32(checksum, (const Bytef *)&unsummedHeader, sizeof(unsummedHeader));
+    if (header->length > 0) {
+        checksum = crc32(checksum, (const Bytef *)report, (uInt)header->length);
+    }
+    return (uint32_t)checksum;
+}
+
+static void getSegmentPath(const TTSDKCrashReportLog *const log, const uint32_t number, char *const path)
+{
+    snprintf(path, TTSDKCRL_MAX_PATH_LENGTH, "%s%08x" SEGMENT_EXTENSION, log->pathPrefix, number);
+}
+
+static int64_t getRecordSize(const int32_t length) { return (int64_t)sizeof(RecordHeader) + length; }
+
+// ============================================================================
+#pragma mark - Index -
+// ============================================================================
+
+/** Get the index of a report's entry, or of where it would be inserted. */
+static int getEntryIndex(const TTSDKCrashReportLog *const log, const int64_t reportID)
+{
+    int low = 0;
+    int high = log->count;
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        if (log->entries[middle].reportID < reportID) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static TTSDKCrashReportLogSegment *getSegment(TTSDKCrashReportLog *const log, const uint32_t number)
+{
+    for (int i = log->segmentCount - 1; i >= 0; i--) {
+        if (log->segments[i].number == number) {
+            return log->segments + i;
+        }
+    }
+    return NULL;
+}
+
+static void addDeadSize(TTSDKCrashReportLog *const log, const uint32_t number, const int64_t size)
+{
+    TTSDKCrashReportLogSegment *segment = getSegment(log, number);
+    if (segment != NULL) {
+        segment->deadSize += size;
+    }
+}
+
+/** Point a report's entry at a new copy of it. The old copy, if any, is dead. */
+static bool setEntry(TTSDKCrashReportLog *const log, const TTSDKCrashReportLogEntry *const entry)
+{
+    const int index = getEntryIndex(log, entry->reportID);
+    if (index < log->count && log->entries[index].reportID == entry->reportID) {
+        addDeadSize(log, log->entries[index].segment, getRecordSize(log->entries[index].length));
+        log->entries[index] = *entry;
+        return true;
+    }
+    if (log->count == log->capacity) {
+        const int capacity = log->capacity > 0 ? log->capacity * 2 : 16;
+        TTSDKCrashReportLogEntry *entries = realloc(log->entries, (size_t)capacity * sizeof(*entries));
+        if (entries == NULL) {
+            TTSDKLOG_ERROR("Could not allocate %d report log entries", capacity);
+            return false;
+        }
+        log->entries = entries;
+        log->capacity = capacity;
+    }
+    memmove(log->entries + index + 1, log->entries + index, (size_t)(log->count - index) * sizeof(*entry));
+    log->entries[index] = *entry;
+    log->count++;
+    return true;
+}
+
+/** Remove a report's entry. Its copy is dead. */
+static bool removeEntry(TTSDKCrashReportLog *const log, const int64_t reportID)
+{
+    const int index = getEntryIndex(log, reportID);
+    if (index >= log->count || log->entries[index].reportID != reportID) {
+        return false;
+    }
+    addDeadSize(log, log->entries[index].segment, getRecordSize(log->entries[index].length));
+    memmove(log->entries + index, log->entries + index + 1,
+            (size_t)(log->count - index - 1) * sizeof(*log->entries));
+    log->count--;
+    return true;
+}
+
+static bool addSegment(TTSDKCrashReportLog *const log, const uint32_t number, const int64_t size)
+{
+    if (log->segmentCount == log->segmentCapacity) {
+        const int capacity = log->segmentCapacity > 0 ? log->segmentCapacity * 2 : 4;
+        TTSDKCrashReportLogSegment *segments = realloc(log->segments, (size_t)capacity * sizeof(*segments));
+        if (segments == NULL) {
+            TTSDKLOG_ERROR("Could not allocate %d report log segments", capacity);
+            return false;
+        }
+        log->segments = segments;
+        log->segmentCapacity = capacity;
+    }
+    log->segments[log->segmentCount++] = (TTSDKCrashReportLogSegment) { .number = number, .size = size };
+    if (number >= log->nextSegmentNumber) {
+        log->nextSegmentNumber = number + 1;
+    }
+    return true;
+}
+
+static void applyRecord(TTSDKCrashReportLog *const log, const RecordHeader *const header, const uint32_t number,
+                        const int64_t offset)
+{
+    if (header->type == RecordTypeDeletion) {
+        removeEntry(log, header->reportID);
+        addDeadSize(log, number, getRecordSize(header->length));
+        return;
+    }
+    const TTSDKCrashReportLogEntry entry = {
+        .reportID = header->reportID,
+        .offset = offset,
+        .segment = number,
+        .length = header->length,
+        .isFixed = header->type == RecordTypeFixedReport,
+    };
+    if (!setEntry(log, &entry)) {
+        addDeadSize(log, number, getRecordSize(header->length));
+    }
+}
+
+// ============================================================================
+#pragma mark - Opening -
+// ============================================================================
+
+static int compareSegments(const void *a, const void *b)
+{
+    const uint32_t numberA = ((const TTSDKCrashReportLogSegment *)a)->number;
+    const uint32_t numberB = ((const TTSDKCrashReportLogSegment *)b)->number;
+    return numberA < numberB ? -1 : numberA > numberB ? 1 : 0;
+}
+
+/** Read the records in a segment into the index. Only the last segment can
+ * end with a record that was cut short, so its records are checked in full
+ * and anything after the last good one is cut off.
+ */
+static void scanSegment(TTSDKCrashReportLog *const log, const int segmentIndex)
+{
+    const bool isLast = segmentIndex == log->segmentCount - 1;
+    const uint32_t number = log->segments[segmentIndex].number;
+    char path[TTSDKCRL_MAX_PATH_LENGTH];
+    getSegmentPath(log, number, path);
+    int fd = open(path, isLast ? O_RDWR : O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        TTSDKLOG_ERROR("Could not open report log segment %s: %s", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    char *report = NULL;
+    int64_t offset = 0;
+    RecordHeader header;
+    while (offset + (int64_t)sizeof(header) <= st.st_size) {
+        if (pread(fd, &header, sizeof(header), (off_t)offset) != (ssize_t)sizeof(header) ||
+            memcmp(header.magic, g_recordMagic, sizeof(g_recordMagic)) != 0 || header.type < RecordTypeReport ||
+            header.type > RecordTypeDeletion || header.length < 0 ||
+            offset + getRecordSize(header.length) > st.st_size) {
+            break;
+        }
+        if (isLast) {
+            char *newReport = realloc(report, (size_t)header.length + 1);
+            if (newReport == NULL) {
+                break;
+            }
+            report = newReport;
+            if (pread(fd, report, (size_t)header.length, (off_t)(offset + (int64_t)sizeof(header))) !=
+                    header.length ||
+                getChecksum(&header, report) != header.checksum) {
+                break;
+            }
+        }
+        applyRecord(log, &header, number, offset);
+        offset += getRecordSize(header.length);
+    }
+    free(report);
+
+    if (offset < st.st_size) {
+        if (isLast) {
+            TTSDKLOG_INFO("Cutting off %lld bytes at the end of report log segment %s",
+                          (long long)(st.st_size - offset), path);
+            if (ftruncate(fd, (off_t)offset) != 0) {
+                TTSDKLOG_ERROR("Could not truncate report log segment %s: %s", path, strerror(errno));
+            }
+        } else {
+            TTSDKLOG_ERROR("Report log segment %s is corrupt after offset %lld", path, (long long)offset);
+            log->segments[segmentIndex].deadSize += st.st_size - offset;
+            offset = st.st_size;
+        }
+    }
+    log->segments[segmentIndex].size = offset;
+    close(fd);
+}
+
+bool ttsdkcrl_open(TTSDKCrashReportLog *const log, const char *const reportsPath, const char *const appName)
+{
+    *log = (TTSDKCrashReportLog) { .fd = -1 };
+    const int prefixLength = snprintf(log->pathPrefix, sizeof(log->pathPrefix), "%s/%s-log-", reportsPath, appName);
+    if (prefixLength < 0 || prefixLength >= (int)sizeof(log->pathPrefix)) {
+        TTSDKLOG_ERROR("Report log path is too long: %s", reportsPath);
+        return false;
+    }
+    DIR *dir = opendir(reportsPath);
+    if (dir == NULL) {
+        TTSDKLOG_ERROR("Could not open directory %s", reportsPath);
+        return false;
+    }
+    const char *namePrefix = log->pathPrefix + strlen(reportsPath) + 1;
+    const size_t namePrefixLength = strlen(namePrefix);
+    bool success = true;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, namePrefix, namePrefixLength) != 0) {
+            continue;
+        }
+        const char *numberString = ent->d_name + namePrefixLength;
+        char *end = NULL;
+        const unsigned long number = strtoul(numberString, &end, 16);
+        if (end - numberString != 8 || strcmp(end, SEGMENT_EXTENSION) != 0) {
+            continue;
+        }
+        if (!addSegment(log, (uint32_t)number, 0)) {
+            success = false;
+            break;
+        }
+    }
+    closedir(dir);
+    if (!success) {
+        ttsdkcrl_close(log);
+        return false;
+    }
+
+    if (log->segmentCount > 1) {
+        qsort(log->segments, (size_t)log->segmentCount, sizeof(*log->segments), compareSegments);
+    }
+    for (int i = 0; i < log->segmentCount; i++) {
+        scanSegment(log, i);
+    }
+    return true;
+}
+
+void ttsdkcrl_close(TTSDKCrashReportLog *const log)
+{
+    if (log->fd >= 0) {
+        close(log->fd);
+    }
+    free(log->entries);
+    free(log->segments);
+    *log = (TTSDKCrashReportLog) { .fd = -1 };
+}
+
+// ============================================================================
+#pragma mark - Records -
+// ============================================================================
+
+/** Append a record to the last segment, starting a new one if it's full or
+ * being compacted.
+ *
+ * @param segment Place to store the number of the segment it was appended to.
+ *
+ * @param offset Place to store where in the segment it was appended.
+ */
+static bool appendRecord(TTSDKCrashReportLog *const log, const RecordType type, const int64_t reportID,
+                         const char *const report, const int length, uint32_t *const segment, int64_t *const offset)
+{
+    const int64_t recordSize = getRecordSize(length);
+    TTSDKCrashReportLogSegment *last = log->segmentCount > 0 ? log->segments + log->segmentCount - 1 : NULL;
+    if (last == NULL || log->segmentCount <= log->compactingSegmentCount ||
+        (last->size > 0 && last->size + recordSize > TTSDKCRL_SEGMENT_SIZE)) {
+        if (log->fd >= 0) {
+            close(log->fd);
+            log->fd = -1;
+        }
+        if (!addSegment(log, log->nextSegmentNumber, 0)) {
+            return false;
+        }
+        last = log->segments + log->segmentCount - 1;
+    }
+
+    char path[TTSDKCRL_MAX_PATH_LENGTH];
+    getSegmentPath(log, last->number, path);
+    if (log->fd < 0) {
+        log->fd = open(path, O_WRONLY | O_CREAT, 0644);
+        if (log->fd < 0) {
+            TTSDKLOG_ERROR("Could not open report log segment %s: %s", path, strerror(errno));
+            return false;
+        }
+    }
+
+    RecordHeader header = {
+        .magic = { g_recordMagic[0], g_recordMagic[1], g_recordMagic[2], g_recordMagic[3] },
+        .type = (uint8_t)type,
+        .length = length,
+        .reportID = reportID,
+    };
+    header.checksum = getChecksum(&header, report);
+    if (lseek(log->fd, (off_t)last->size, SEEK_SET) < 0 ||
+        !ttsdkfu_writeBytesToFD(log->fd, (const char *)&header, sizeof(header)) ||
+        !ttsdkfu_writeBytesToFD(log->fd, report, length)) {
+        TTSDKLOG_ERROR("Could not append to report log segment %s", path);
+        // Don't leave half a record for the next one to be appended after.
+        if (ftruncate(log->fd, (off_t)last->size) != 0) {
+            TTSDKLOG_ERROR("Could not truncate report log segment %s: %s", path, strerror(errno));
+        }
+        return false;
+    }
+    *segment = last->number;
+    *offset = last->size;
+    last->size += recordSize;
+    return true;
+}
+
+const TTSDKCrashReportLogEntry *ttsdkcrl_findEntry(const TTSDKCrashReportLog *const log, const int64_t reportID)
+{
+    const int index = getEntryIndex(log, reportID);
+    if (index < log->count && log->entries[index].reportID == reportID) {
+        return log->entries + index;
+    }
+    return NULL;
+}
+
+bool ttsdkcrl_appendReport(TTSDKCrashReportLog *const log, const int64_t reportID, const char *const report,
+                           const int length, const bool isFixed)
+{
+    TTSDKCrashReportLogEntry entry = { .reportID = reportID, .length = length, .isFixed = isFixed };
+    if (!appendRecord(log, isFixed ? RecordTypeFixedReport : RecordTypeReport, reportID, report, length,
+                      &entry.segment, &entry.offset)) {
+        return false;
+    }
+    if (!setEntry(log, &entry)) {
+        addDeadSize(log, entry.segment, getRecordSize(length));
+        return false;
+    }
+    return true;
+}
+
+char *ttsdkcrl_readReport(const TTSDKCrashReportLog *const log, const TTSDKCrashReportLogEntry *const entry)
+{
+    char path[TTSDKCRL_MAX_PATH_LENGTH];
+    getSegmentPath(log, entry->segment, path);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Could not open report log segment %s: %s", path, strerror(errno));
+        return NULL;
+    }
+    RecordHeader header;
+    char *report = malloc((size_t)entry->length + 1);
+    bool success = report != NULL &&
+                   pread(fd, &header, sizeof(header), (off_t)entry->offset) == (ssize_t)sizeof(header) &&
+                   header.reportID == entry->reportID && header.length == entry->length &&
+                   pread(fd, report, (size_t)entry->length, (off_t)(entry->offset + (int64_t)sizeof(header))) ==
+                       entry->length &&
+                   getChecksum(&header, report) == header.checksum;
+    close(fd);
+    if (!success) {
+        TTSDKLOG_ERROR("Report %016llx in report log segment %s is corrupt", (long long)entry->reportID, path);
+        free(report);
+        return NULL;
+    }
+    report[entry->length] = '\0';
+    return report;
+}
+
+bool ttsdkcrl_deleteReport(TTSDKCrashReportLog *const log, const int64_t reportID)
+{
+    if (ttsdkcrl_findEntry(log, reportID) == NULL) {
+        return false;
+    }
+    uint32_t segment = 0;
+    int64_t offset = 0;
+    if (!appendRecord(log, RecordTypeDeletion, reportID, NULL, 0, &segment, &offset)) {
+        return false;
+    }
+    removeEntry(log, reportID);
+    addDeadSize(log, segment, getRecordSize(0));
+    return true;
+}
+
+// ============================================================================
+#pragma mark - Compaction -
+// ============================================================================
+
+bool ttsdkcrl_shouldCompact(const TTSDKCrashReportLog *const log)
+{
+    int64_t size = 0;
+    int64_t deadSize = 0;
+    for (int i = 0; i < log->segmentCount; i++) {
+        size += log->segments[i].size;
+        deadSize += log->segments[i].deadSize;
+    }
+    // A log with nothing left in it is always worth removing.
+    if (deadSize > 0 && deadSize == size) {
+        return true;
+    }
+    return deadSize >= kMinimumCompactionSize && deadSize * 2 >= size;
+}
+
+/** Remove the first segments of a log, oldest first. */
+static void removeSegments(const TTSDKCrashReportLog *const log, const int count)
+{
+    char path[TTSDKCRL_MAX_PATH_LENGTH];
+    for (int i = 0; i < count; i++) {
+        getSegmentPath(log, log->segments[i].number, path);
+        ttsdkfu_removeFile(path, false);
+    }
+}
+
+/** Sync a log's segments, and the folder that they're in, to disk. */
+static bool syncSegments(const TTSDKCrashReportLog *const log)
+{
+    char path[TTSDKCRL_MAX_PATH_LENGTH];
+    for (int i = 0; i < log->segmentCount; i++) {
+        getSegmentPath(log, log->segments[i].number, path);
+        const int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            TTSDKLOG_ERROR("Could not open report log segment %s: %s", path, strerror(errno));
+            return false;
+        }
+        const bool success = ttsdkfu_syncFD(fd);
+        close(fd);
+        if (!success) {
+            return false;
+        }
+    }
+    snprintf(path, sizeof(path), "%s", log->pathPrefix);
+    char *const separator = strrchr(path, '/');
+    if (separator != NULL) {
+        *separator = '\0';
+    }
+    return ttsdkfu_syncDirectory(path);
+}
+
+bool ttsdkcrl_beginCompaction(TTSDKCrashReportLog *const log, TTSDKCrashReportLogCompaction *const compaction)
+{
+    *compaction = (TTSDKCrashReportLogCompaction) { .snapshot = { .fd = -1 }, .compacted = { .fd = -1 } };
+    if (log->count > 0) {
+        compaction->snapshot.entries = malloc((size_t)log->count * sizeof(*log->entries));
+        if (compaction->snapshot.entries == NULL) {
+            TTSDKLOG_ERROR("Could not allocate %d report log entries", log->count);
+            return false;
+        }
+        memcpy(compaction->snapshot.entries, log->entries, (size_t)log->count * sizeof(*log->entries));
+    }
+    compaction->snapshot.count = log->count;
+    compaction->snapshot.capacity = log->count;
+    compaction->snapshot.nextSegmentNumber = log->nextSegmentNumber;
+    memcpy(compaction->snapshot.pathPrefix, log->pathPrefix, sizeof(log->pathPrefix));
+    memcpy(compaction->compacted.pathPrefix, log->pathPrefix, sizeof(log->pathPrefix));
+    compaction->segmentCount = log->segmentCount;
+
+    // Every report starts at most one new segment, so that many numbers are kept
+    // for the copies. Records appended meanwhile go in segments numbered after
+    // them, so that they're still read after the copies.
+    compaction->compacted.nextSegmentNumber = log->nextSegmentNumber;
+    log->nextSegmentNumber += (uint32_t)log->count;
+    log->compactingSegmentCount = log->segmentCount;
+    if (log->fd >= 0) {
+        close(log->fd);
+        log->fd = -1;
+    }
+    return true;
+}
+
+bool ttsdkcrl_copyCompaction(TTSDKCrashReportLogCompaction *const compaction)
+{
+    const TTSDKCrashReportLog *const snapshot = &compaction->snapshot;
+    bool success = true;
+    for (int i = 0; i < snapshot->count && success; i++) {
+        const TTSDKCrashReportLogEntry *entry = snapshot->entries + i;
+        char *report = ttsdkcrl_readReport(snapshot, entry);
+        if (report == NULL) {
+            // Nothing can be done for it, so it's dropped.
+            continue;
+        }
+        success = ttsdkcrl_appendReport(&compaction->compacted, entry->reportID, report, entry->length, entry->isFixed);
+        free(report);
+    }
+    if (compaction->compacted.fd >= 0) {
+        close(compaction->compacted.fd);
+        compaction->compacted.fd = -1;
+    }
+    // The new segments must be on disk before the old ones go.
+    compaction->isCopied = success && syncSegments(&compaction->compacted);
+    return compaction->isCopied;
+}
+
+/** Point the reports that haven't changed since the compaction began at their
+ * copies. The others were replaced or deleted meanwhile, which leaves their
+ * copies dead.
+ */
+static void adoptCopies(TTSDKCrashReportLog *const log, TTSDKCrashReportLogCompaction *const compaction)
+{
+    TTSDKCrashReportLog *const compacted = &compaction->compacted;
+    int count = 0;
+    for (int i = 0; i < log->count; i++) {
+        TTSDKCrashReportLogEntry entry = log->entries[i];
+        if (entry.segment < compaction->snapshot.nextSegmentNumber) {
+            const TTSDKCrashReportLogEntry *copy = ttsdkcrl_findEntry(compacted, entry.reportID);
+            if (copy == NULL) {
+                // It couldn't be read, so it goes with the old segments.
+                continue;
+            }
+            entry = *copy;
+        }
+        log->entries[count++] = entry;
+    }
+    log->count = count;
+
+    for (int i = 0; i < compacted->count; i++) {
+        const TTSDKCrashReportLogEntry *copy = compacted->entries + i;
+        const TTSDKCrashReportLogEntry *entry = ttsdkcrl_findEntry(log, copy->reportID);
+        if (entry == NULL || entry->segment != copy->segment || entry->offset != copy->offset) {
+            addDeadSize(compacted, copy->segment, getRecordSize(copy->length));
+        }
+    }
+}
+
+bool ttsdkcrl_endCompaction(TTSDKCrashReportLog *const log, TTSDKCrashReportLogCompaction *const compaction)
+{
+    TTSDKCrashReportLog *const compacted = &compaction->compacted;
+    const int copySegmentCount = compacted->segmentCount;
+    log->compactingSegmentCount = 0;
+    // The segments started meanwhile follow the copies.
+    bool success = compaction->isCopied;
+    for (int i = compaction->segmentCount; i < log->segmentCount && success; i++) {
+        success = addSegment(compacted, log->segments[i].number, log->segments[i].size);
+        if (success) {
+            compacted->segments[compacted->segmentCount - 1].deadSize = log->segments[i].deadSize;
+        }
+    }
+    if (!success) {
+        TTSDKLOG_ERROR("Could not compact report log %s", log->pathPrefix);
+        removeSegments(compacted, copySegmentCount);
+        ttsdkcrl_close(compacted);
+        ttsdkcrl_close(&compaction->snapshot);
+        return false;
+    }
+    adoptCopies(log, compaction);
+
+    // The copies have higher numbers than the old segments, so if the app dies
+    // part way through removing them, the reports that are left behind are read
+    // first and replaced by their copies. Removing the oldest first makes sure
+    // that a deleted report isn't left without the record that deleted it.
+    TTSDKLOG_DEBUG("Compacting report log %s from %d segments to %d", log->pathPrefix, compaction->segmentCount,
+                   copySegmentCount);
+    removeSegments(log, compaction->segmentCount);
+    free(log->segments);
+    log->segments = compacted->segments;
+    log->segmentCount = compacted->segmentCount;
+    log->segmentCapacity = compacted->segmentCapacity;
+    compacted->segments = NULL;
+    ttsdkcrl_close(compacted);
+    ttsdkcrl_close(&compaction->snapshot);
+    return true;
+}
+
+bool ttsdkcrl_compact(TTSDKCrashReportLog *const log)
+{
+    TTSDKCrashReportLogCompaction compaction;
+    if (!ttsdkcrl_beginCompaction(log, &compaction)) {
+        return false;
+    }
+    ttsdkcrl_copyCompaction(&compaction);
+    return ttsdkcrl_endCompaction(log, &compaction);
+}
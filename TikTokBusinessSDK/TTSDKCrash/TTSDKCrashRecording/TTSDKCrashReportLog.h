@@ -0,0 +1,202 @@
+//
+//  TTSDKCrashReportLog.h
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/* An append-only log of reports, for stores that record many small user
+ * reports. Adding a report appends one record to the current segment file
+ * instead of creating a file of its own, and deleting one appends a record
+ * saying so. Segments are named <app>-log-<number>.seg and roll over once
+ * they reach TTSDKCRL_SEGMENT_SIZE.
+ *
+ * Each record is a RecordHeader followed by the report, with a CRC-32 of
+ * both. Only the end of the last segment can be cut short, by the app
+ * dying while appending, and it's cut off when the log is opened.
+ *
+ * Once enough of the log is taken up by deleted or replaced reports, it's
+ * compacted by copying the live reports into new segments and removing the
+ * old ones.
+ */
+
+#ifndef HDR_TTSDKCrashReportLog_h
+#define HDR_TTSDKCrashReportLog_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The size a segment can grow to before a new one is started. */
+#define TTSDKCRL_SEGMENT_SIZE (1024 * 1024)
+
+#define TTSDKCRL_MAX_PATH_LENGTH 500
+
+/** Where a report is in the log. */
+typedef struct {
+    int64_t reportID;
+    int64_t offset;
+    uint32_t segment;
+    int32_t length;
+    /** Whether the report has already been fixed up. */
+    bool isFixed;
+} TTSDKCrashReportLogEntry;
+
+typedef struct {
+    uint32_t number;
+    int64_t size;
+    /** Bytes taken up by reports that have since been deleted or replaced, and by the records saying so. */
+    int64_t deadSize;
+} TTSDKCrashReportLogSegment;
+
+typedef struct {
+    /** The start of every segment's path, such as "/path/to/Reports/App-log-". */
+    char pathPrefix[TTSDKCRL_MAX_PATH_LENGTH];
+    /** The reports in the log, sorted by report ID. */
+    TTSDKCrashReportLogEntry *entries;
+    int count;
+    int capacity;
+    /** Sorted by number. The last one is appended to. */
+    TTSDKCrashReportLogSegment *segments;
+    int segmentCount;
+    int segmentCapacity;
+    /** The number to give the next segment that's started. */
+    uint32_t nextSegmentNumber;
+    /** The last segment, kept open for appending, or -1. */
+    int fd;
+    /** How many of the first segments are being compacted. They aren't appended to. */
+    int compactingSegmentCount;
+} TTSDKCrashReportLog;
+
+/** A compaction of a log, which copies the live reports without needing the
+ * log itself, so that the log can go on being used meanwhile.
+ */
+typedef struct {
+    /** The log's reports when the compaction began. */
+    TTSDKCrashReportLog snapshot;
+    /** The new segments that the reports are copied into. */
+    TTSDKCrashReportLog compacted;
+    /** How many of the log's segments the compaction replaces. */
+    int segmentCount;
+    /** Whether the reports were all copied and synced to disk. */
+    bool isCopied;
+} TTSDKCrashReportLogCompaction;
+
+/** Open the log in a reports folder, reading the records in its segments to
+ * find its reports.
+ *
+ * @param log The log to open.
+ *
+ * @param reportsPath The reports folder.
+ *
+ * @param appName The app name that the store's files are named with.
+ *
+ * @return true if the log could be opened. It's empty if it has no segments yet.
+ */
+bool ttsdkcrl_open(TTSDKCrashReportLog *log, const char *reportsPath, const char *appName);
+
+/** Free the memory used by a log. Its segments are left as they are. */
+void ttsdkcrl_close(TTSDKCrashReportLog *log);
+
+/** Find a report in the log.
+ *
+ * @return The report's entry, or NULL if it's not in the log.
+ */
+const TTSDKCrashReportLogEntry *ttsdkcrl_findEntry(const TTSDKCrashReportLog *log, int64_t reportID);
+
+/** Append a report, replacing any earlier copy of it.
+ *
+ * @param log The log.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param report The report.
+ *
+ * @param length The report's length.
+ *
+ * @param isFixed Whether the report has already been fixed up.
+ *
+ * @return true if the report was appended.
+ */
+bool ttsdkcrl_appendReport(TTSDKCrashReportLog *log, int64_t reportID, const char *report, int length, bool isFixed);
+
+/** Read a report from the log.
+ *
+ * @param log The log.
+ *
+ * @param entry The report's entry.
+ *
+ * @return The NULL terminated report, or NULL if it couldn't be read or was corrupt.
+ *         The caller is responsible for freeing it.
+ */
+char *ttsdkcrl_readReport(const TTSDKCrashReportLog *log, const TTSDKCrashReportLogEntry *entry);
+
+/** Delete a report from the log by appending a record saying so.
+ *
+ * @return true if the report was in the log and was deleted.
+ */
+bool ttsdkcrl_deleteReport(TTSDKCrashReportLog *log, int64_t reportID);
+
+/** Whether enough of the log is taken up by deleted reports that it's worth compacting. */
+bool ttsdkcrl_shouldCompact(const TTSDKCrashReportLog *log);
+
+/** Copy the live reports into new segments and remove the old ones.
+ *
+ * @return true if the log was compacted.
+ */
+bool ttsdkcrl_compact(TTSDKCrashReportLog *log);
+
+/** Begin compacting a log, taking a snapshot of its reports. Until the
+ * compaction ends, records are appended to new segments.
+ *
+ * @param log The log.
+ *
+ * @param compaction The compaction to begin.
+ *
+ * @return true if the compaction began. If not, it mustn't be ended.
+ */
+bool ttsdkcrl_beginCompaction(TTSDKCrashReportLog *log, TTSDKCrashReportLogCompaction *compaction);
+
+/** Copy the reports in a compaction's snapshot into new segments. This doesn't
+ * touch the log, so it can be done while the log is being used elsewhere.
+ *
+ * @return true if the reports were copied.
+ */
+bool ttsdkcrl_copyCompaction(TTSDKCrashReportLogCompaction *compaction);
+
+/** End a compaction. If the reports were copied, the ones that weren't changed
+ * meanwhile are pointed at their copies, and the old segments are removed.
+ * Otherwise the copies are removed.
+ *
+ * @return true if the log was compacted.
+ */
+bool ttsdkcrl_endCompaction(TTSDKCrashReportLog *log, TTSDKCrashReportLogCompaction *compaction);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HDR_TTSDKCrashReportLog_h
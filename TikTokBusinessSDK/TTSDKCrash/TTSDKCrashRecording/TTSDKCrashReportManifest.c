@@ -0,0 +1,219 @@
+//
+//  TTSDKCrashReportManifest.c
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "TTSDKCrashReportManifest.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "TTSDKFileUtils.h"
+
+// #define TTSDKLogger_LocalLevel TRACE
+#include "TTSDKLogger.h"
+
+#define kManifestVersion 1
+
+typedef struct {
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved[3];
+    uint32_t entrySize;
+    uint32_t entryCount;
+    int64_t directoryTimeSeconds;
+    int64_t directoryTimeNanoseconds;
+    /** CRC-32 of the header, with this field set to 0, followed by the entries. */
+    uint32_t checksum;
+    uint32_t reserved2;
+} ManifestHeader;
+
+static const char g_manifestMagic[4] = { 'T', 'T', 'R', 'M' };
+
+static uint32_t getChecksum(const ManifestHeader *const header, const TTSDKCrashReportManifestEntry *const entries)
+{
+    ManifestHeader unsummedHeader = *header;
+    unsummedHeader.checksum = 0;
+    uLong checksum = crc32(0L, Z_NULL, 0);
+    checksum = crc32(checksum, (const Bytef *)&unsummedHeader, sizeof(unsummedHeader));
+    if (header->entryCount > 0) {
+        checksum = crc32(checksum, (const Bytef *)entries, header->entryCount * (uInt)sizeof(*entries));
+    }
+    return (uint32_t)checksum;
+}
+
+static bool reserveEntries(TTSDKCrashReportManifest *const manifest, const int count)
+{
+    if (count <= manifest->capacity) {
+        return true;
+    }
+    int capacity = manifest->capacity > 0 ? manifest->capacity : 16;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    TTSDKCrashReportManifestEntry *entries = realloc(manifest->entries, (size_t)capacity * sizeof(*entries));
+    if (entries == NULL) {
+        TTSDKLOG_ERROR("Could not allocate %d manifest entries", capacity);
+        return false;
+    }
+    manifest->entries = entries;
+    manifest->capacity = capacity;
+    return true;
+}
+
+/** Get the index of a report's entry, or of where it would be inserted. */
+static int getEntryIndex(const TTSDKCrashReportManifest *const manifest, const int64_t reportID)
+{
+    int low = 0;
+    int high = manifest->count;
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        if (manifest->entries[middle].reportID < reportID) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+bool ttsdkcrm_readManifest(const char *const path, TTSDKCrashReportManifest *const manifest)
+{
+    manifest->count = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        TTSDKLOG_DEBUG("No report manifest at %s", path);
+        return false;
+    }
+    bool success = false;
+    ManifestHeader header;
+    struct stat st;
+    if (!ttsdkfu_readBytesFromFD(fd, (char *)&header, sizeof(header)) ||
+        memcmp(header.magic, g_manifestMagic, sizeof(g_manifestMagic)) != 0 || header.version != kManifestVersion ||
+        header.entrySize != sizeof(TTSDKCrashReportManifestEntry) || fstat(fd, &st) != 0 ||
+        st.st_size != (off_t)(sizeof(header) + (size_t)header.entryCount * sizeof(TTSDKCrashReportManifestEntry))) {
+        TTSDKLOG_ERROR("Invalid report manifest %s", path);
+        goto done;
+    }
+    const int count = (int)header.entryCount;
+    if (!reserveEntries(manifest, count) ||
+        !ttsdkfu_readBytesFromFD(fd, (char *)manifest->entries, count * (int)sizeof(TTSDKCrashReportManifestEntry))) {
+        goto done;
+    }
+    if (getChecksum(&header, manifest->entries) != header.checksum) {
+        TTSDKLOG_ERROR("Report manifest %s is corrupt", path);
+        goto done;
+    }
+    for (int i = 1; i < count; i++) {
+        if (manifest->entries[i].reportID <= manifest->entries[i - 1].reportID) {
+            TTSDKLOG_ERROR("Report manifest %s is out of order", path);
+            goto done;
+        }
+    }
+    manifest->count = count;
+    manifest->directoryTimeSeconds = header.directoryTimeSeconds;
+    manifest->directoryTimeNanoseconds = header.directoryTimeNanoseconds;
+    success = true;
+
+done:
+    close(fd);
+    return success;
+}
+
+bool ttsdkcrm_writeManifest(const char *const path, const TTSDKCrashReportManifest *const manifest)
+{
+    ManifestHeader header = {
+        .magic = { g_manifestMagic[0], g_manifestMagic[1], g_manifestMagic[2], g_manifestMagic[3] },
+        .version = kManifestVersion,
+        .entrySize = sizeof(TTSDKCrashReportManifestEntry),
+        .entryCount = (uint32_t)manifest->count,
+        .directoryTimeSeconds = manifest->directoryTimeSeconds,
+        .directoryTimeNanoseconds = manifest->directoryTimeNanoseconds,
+    };
+    header.checksum = getChecksum(&header, manifest->entries);
+
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Could not open report manifest %s: %s", path, strerror(errno));
+        return false;
+    }
+    const int entriesLength = manifest->count * (int)sizeof(TTSDKCrashReportManifestEntry);
+    bool success = ttsdkfu_writeBytesToFD(fd, (const char *)&header, sizeof(header)) &&
+                   ttsdkfu_writeBytesToFD(fd, (const char *)manifest->entries, entriesLength) &&
+                   ftruncate(fd, (off_t)sizeof(header) + entriesLength) == 0;
+    close(fd);
+    if (!success) {
+        TTSDKLOG_ERROR("Could not write report manifest %s", path);
+    }
+    return success;
+}
+
+bool ttsdkcrm_addEntry(TTSDKCrashReportManifest *const manifest, const TTSDKCrashReportManifestEntry *const entry)
+{
+    const int index = getEntryIndex(manifest, entry->reportID);
+    if (index < manifest->count && manifest->entries[index].reportID == entry->reportID) {
+        manifest->entries[index] = *entry;
+        return true;
+    }
+    if (!reserveEntries(manifest, manifest->count + 1)) {
+        return false;
+    }
+    memmove(manifest->entries + index + 1, manifest->entries + index,
+            (size_t)(manifest->count - index) * sizeof(*entry));
+    manifest->entries[index] = *entry;
+    manifest->count++;
+    return true;
+}
+
+TTSDKCrashReportManifestEntry *ttsdkcrm_findEntry(const TTSDKCrashReportManifest *const manifest,
+                                                  const int64_t reportID)
+{
+    const int index = getEntryIndex(manifest, reportID);
+    if (index < manifest->count && manifest->entries[index].reportID == reportID) {
+        return manifest->entries + index;
+    }
+    return NULL;
+}
+
+void ttsdkcrm_removeEntry(TTSDKCrashReportManifest *const manifest, const int64_t reportID)
+{
+    const int index = getEntryIndex(manifest, reportID);
+    if (index < manifest->count && manifest->entries[index].reportID == reportID) {
+        memmove(manifest->entries + index, manifest->entries + index + 1,
+                (size_t)(manifest->count - index - 1) * sizeof(*manifest->entries));
+        manifest->count--;
+    }
+}
+
+void ttsdkcrm_freeManifest(TTSDKCrashReportManifest *const manifest)
+{
+    free(manifest->entries);
+    *manifest = (TTSDKCrashReportManifest) { 0 };
+}
@@ -0,0 +1,122 @@
+//
+//  TTSDKCrashReportManifest.h
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/* A record of which reports are in a reports folder, so that they can be
+ * counted and listed without reading the folder.
+ *
+ * The file is a fixed-size header followed by TTSDKCrashReportManifestEntry
+ * records sorted by report ID, with a CRC-32 over both. The header also holds
+ * the folder's modification time as of when the manifest last matched it.
+ * Reports written by the crash handler don't go through the manifest, but
+ * writing them changes the folder's modification time, which tells the store
+ * to rebuild the manifest from the folder.
+ */
+
+#ifndef HDR_TTSDKCrashReportManifest_h
+#define HDR_TTSDKCrashReportManifest_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Where a report came from, as far as the store knows. */
+typedef enum {
+    /** Found in the reports folder, such as a report written by the crash handler. */
+    TTSDKCrashReportManifestTypeUnknown = 0,
+    /** Added with ttsdkcrs_addUserReport(). */
+    TTSDKCrashReportManifestTypeUser = 1,
+} TTSDKCrashReportManifestType;
+
+typedef struct {
+    int64_t reportID;
+    /** The size of the report's file. */
+    int64_t size;
+    /** When the report's file was last written, in seconds since 1970. */
+    int64_t timestamp;
+    uint8_t type;
+    uint8_t reserved[7];
+} TTSDKCrashReportManifestEntry;
+
+typedef struct {
+    /** Sorted by report ID. Owned by the manifest. */
+    TTSDKCrashReportManifestEntry *entries;
+    int count;
+    int capacity;
+    /** The reports folder's modification time when the manifest last matched it. */
+    int64_t directoryTimeSeconds;
+    int64_t directoryTimeNanoseconds;
+} TTSDKCrashReportManifest;
+
+/** Read a manifest file.
+ *
+ * @param path The manifest file.
+ *
+ * @param manifest The manifest to read into. Its entries are replaced.
+ *
+ * @return true if the file was there and intact. If not, the manifest is left empty.
+ */
+bool ttsdkcrm_readManifest(const char *path, TTSDKCrashReportManifest *manifest);
+
+/** Write a manifest file.
+ * The file is written in place rather than renamed into place, so that writing
+ * it doesn't change the folder's modification time once it exists. A write
+ * that's cut short fails its checksum the next time it's read, and is rebuilt.
+ *
+ * @param path The manifest file.
+ *
+ * @param manifest The manifest to write.
+ *
+ * @return true if the file was written.
+ */
+bool ttsdkcrm_writeManifest(const char *path, const TTSDKCrashReportManifest *manifest);
+
+/** Add an entry, or replace the entry with the same report ID.
+ *
+ * @return false if there was no memory for the entry.
+ */
+bool ttsdkcrm_addEntry(TTSDKCrashReportManifest *manifest, const TTSDKCrashReportManifestEntry *entry);
+
+/** Find a report's entry.
+ *
+ * @return The entry, or NULL if the report isn't in the manifest.
+ */
+TTSDKCrashReportManifestEntry *ttsdkcrm_findEntry(const TTSDKCrashReportManifest *manifest, int64_t reportID);
+
+/** Remove a report's entry, if it has one. */
+void ttsdkcrm_removeEntry(TTSDKCrashReportManifest *manifest, int64_t reportID);
+
+/** Free a manifest's entries and empty it. */
+void ttsdkcrm_freeManifest(TTSDKCrashReportManifest *manifest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HDR_TTSDKCrashReportManifest_h
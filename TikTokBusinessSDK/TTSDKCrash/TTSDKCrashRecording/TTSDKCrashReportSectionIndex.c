@@ -0,0 +1,122 @@
+//
+//  TTSDKCrashReportSectionIndex.c
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "TTSDKCrashReportSectionIndex.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "TTSDKFileUtils.h"
+
+// #define TTSDKLogger_LocalLevel TRACE
+#include "TTSDKLogger.h"
+
+#define kIndexVersion 1
+
+typedef struct {
+    char magic[4];
+    uint8_t version;
+    uint8_t isCBOR;
+    uint16_t entryCount;
+    uint32_t entrySize;
+    uint32_t reserved;
+    int64_t reportLength;
+} IndexHeader;
+
+static const char g_indexMagic[4] = { 'T', 'T', 'S', 'I' };
+
+bool ttsdkcrsi_getIndexPath(const char *const reportPath, char *const indexPath, const int maxLength)
+{
+    const size_t pathLength = strlen(reportPath);
+    const size_t extensionLength = sizeof(TTSDKCRSI_EXTENSION) - 1;
+    if (pathLength + extensionLength >= (size_t)maxLength) {
+        return false;
+    }
+    memcpy(indexPath, reportPath, pathLength);
+    memcpy(indexPath + pathLength, TTSDKCRSI_EXTENSION, extensionLength + 1);
+    return true;
+}
+
+bool ttsdkcrsi_writeIndex(const char *const indexPath, const TTSDKJSONSectionIndex *const index,
+                          const int64_t reportLength, const bool isCBOR)
+{
+    const IndexHeader header = {
+        .magic = { g_indexMagic[0], g_indexMagic[1], g_indexMagic[2], g_indexMagic[3] },
+        .version = kIndexVersion,
+        .isCBOR = isCBOR ? 1 : 0,
+        .entryCount = (uint16_t)index->count,
+        .entrySize = sizeof(TTSDKJSONSectionIndexEntry),
+        .reserved = 0,
+        .reportLength = reportLength,
+    };
+    int fd = open(indexPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Could not open section index %s: %s", indexPath, strerror(errno));
+        return false;
+    }
+    bool success = ttsdkfu_writeBytesToFD(fd, (const char *)&header, sizeof(header)) &&
+                   ttsdkfu_writeBytesToFD(fd, (const char *)index->entries,
+                                          index->count * (int)sizeof(TTSDKJSONSectionIndexEntry));
+    close(fd);
+    if (!success) {
+        unlink(indexPath);
+    }
+    return success;
+}
+
+bool ttsdkcrsi_findSection(const char *const indexPath, const char *const sectionPath,
+                           TTSDKJSONSectionIndexEntry *const entry, int64_t *const reportLength, bool *const isCBOR)
+{
+    int fd = open(indexPath, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool found = false;
+    IndexHeader header;
+    if (!ttsdkfu_readBytesFromFD(fd, (char *)&header, sizeof(header)) ||
+        memcmp(header.magic, g_indexMagic, sizeof(g_indexMagic)) != 0 || header.version != kIndexVersion ||
+        header.entrySize != sizeof(*entry)) {
+        TTSDKLOG_ERROR("Invalid section index %s", indexPath);
+        goto done;
+    }
+    for (int i = 0; i < header.entryCount; i++) {
+        if (!ttsdkfu_readBytesFromFD(fd, (char *)entry, sizeof(*entry))) {
+            break;
+        }
+        if (strncmp(entry->path, sectionPath, sizeof(entry->path)) == 0) {
+            found = entry->length > 0;
+            break;
+        }
+    }
+    *reportLength = header.reportLength;
+    *isCBOR = header.isCBOR != 0;
+
+done:
+    close(fd);
+    return found;
+}
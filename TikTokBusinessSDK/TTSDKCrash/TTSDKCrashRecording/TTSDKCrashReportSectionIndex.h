@@ -0,0 +1,101 @@
+//
+//  TTSDKCrashReportSectionIndex.h
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Sidecar files that say where each section of a report starts and ends, so
+ * that one section can be read without reading the whole report.
+ *
+ * The file is a fixed-size header followed by TTSDKJSONSectionIndexEntry
+ * records, in the order the sections were begun. Offsets are into the report
+ * as it was encoded, before any compression.
+ */
+
+#ifndef HDR_TTSDKCrashReportSectionIndex_h
+#define HDR_TTSDKCrashReportSectionIndex_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "TTSDKJSONCodec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The extension appended to a report's path to get its index's path. */
+#define TTSDKCRSI_EXTENSION ".idx"
+
+/** The most sections indexed in a report. */
+#define TTSDKCRSI_MAX_ENTRIES 128
+
+/** Get the path of a report's index file.
+ *
+ * @param reportPath The report's path.
+ *
+ * @param indexPath Buffer to hold the index's path.
+ *
+ * @param maxLength The size of the buffer.
+ *
+ * @return true if the path fit in the buffer.
+ */
+bool ttsdkcrsi_getIndexPath(const char *reportPath, char *indexPath, int maxLength);
+
+/** Write an index file. Async safe.
+ *
+ * @param indexPath The index file to write.
+ *
+ * @param index The index that was filled in while encoding the report.
+ *
+ * @param reportLength The encoded length of the report.
+ *
+ * @param isCBOR true if the report was encoded as CBOR.
+ *
+ * @return true if the file was written.
+ */
+bool ttsdkcrsi_writeIndex(const char *indexPath, const TTSDKJSONSectionIndex *index, int64_t reportLength,
+                          bool isCBOR);
+
+/** Look up a section in an index file.
+ *
+ * @param indexPath The index file.
+ *
+ * @param sectionPath The section's path, such as "crash.threads[2]".
+ *
+ * @param entry Place to store the section's entry.
+ *
+ * @param reportLength Place to store the encoded length of the report.
+ *
+ * @param isCBOR Place to store whether the report was encoded as CBOR.
+ *
+ * @return true if the section was found and was completely written.
+ */
+bool ttsdkcrsi_findSection(const char *indexPath, const char *sectionPath, TTSDKJSONSectionIndexEntry *entry,
+                           int64_t *reportLength, bool *isCBOR);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HDR_TTSDKCrashReportSectionIndex_h
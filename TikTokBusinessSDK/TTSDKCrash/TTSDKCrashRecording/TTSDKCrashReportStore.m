@@ -161,10 +161,10 @@
     }
 
     NSError *error = nil;
-    NSMutableDictionary *crashReport =
+    NSDictionary *crashReport =
         [TTSDKJSONCodec decode:jsonData
                     options:TTSDKJSONDecodeOptionIgnoreNullInArray | TTSDKJSONDecodeOptionIgnoreNullInObject |
-                            TTSDKJSONDecodeOptionKeepPartialObject
+                            TTSDKJSONDecodeOptionKeepPartialObject | TTSDKJSONDecodeOptionLazy
                       error:&error];
     if (error != nil) {
         TTSDKLOG_ERROR(@"Encountered error loading crash report %" PRIx64 ": %@", reportID, error);
@@ -177,6 +177,26 @@
     return [TTSDKCrashReportDictionary reportWithValue:crashReport];
 }
 
+- (id)reportSection:(NSString *)sectionPath forReportID:(int64_t)reportID
+{
+    char *section = ttsdkcrs_readReportSection(reportID, sectionPath.UTF8String, &_cConfig);
+    if (section == NULL) {
+        return nil;
+    }
+    NSData *jsonData = [NSData dataWithBytesNoCopy:section length:strlen(section) freeWhenDone:YES];
+
+    NSError *error = nil;
+    id value = [TTSDKJSONCodec decode:jsonData
+                              options:TTSDKJSONDecodeOptionIgnoreNullInArray | TTSDKJSONDecodeOptionIgnoreNullInObject |
+                                      TTSDKJSONDecodeOptionLazy
+                                error:&error];
+    if (error != nil) {
+        TTSDKLOG_ERROR(@"Encountered error loading section %@ of crash report %" PRIx64 ": %@", sectionPath, reportID,
+                       error);
+    }
+    return value;
+}
+
 - (NSArray<TTSDKCrashReportDictionary *> *)allReports
 {
     int reportCount = ttsdkcrs_getReportCount(&_cConfig);
@@ -33,11 +33,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include "TTSDKCBORCodec.h"
 #include "TTSDKCrashReportFixer.h"
+#include "TTSDKCrashReportLog.h"
+#include "TTSDKCrashReportManifest.h"
+#include "TTSDKCrashReportSectionIndex.h"
 #include "TTSDKCrashReportStoreC+Private.h"
 #include "TTSDKFileUtils.h"
+#include "TTSDKGZip.h"
 #include "TTSDKLogger.h"
 
 // Have to use max 32-bit atomics because of MIPS.
@@ -45,87 +51,389 @@ static _Atomic(uint32_t) g_nextUniqueIDLow;
 static int64_t g_nextUniqueIDHigh;
 static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static int compareInt64(const void *a, const void *b)
+static inline int64_t getNextUniqueID(void) { return g_nextUniqueIDHigh + g_nextUniqueIDLow++; }
+
+static void getCrashReportPathByID(int64_t id, char *pathBuffer, const TTSDKCrashReportStoreCConfiguration *const config)
 {
-    int64_t diff = *(int64_t *)a - *(int64_t *)b;
-    if (diff < 0) {
-        return -1;
-    } else if (diff > 0) {
-        return 1;
-    }
-    return 0;
+    snprintf(pathBuffer, TTSDKCRS_MAX_PATH_LENGTH, "%s/%s-report-%016llx.json%s", config->reportsPath, config->appName,
+             id, config->compressReports ? ".gz" : "");
 }
 
-static inline int64_t getNextUniqueID(void) { return g_nextUniqueIDHigh + g_nextUniqueIDLow++; }
+/** The ending of a report's file name once it has been fixed up. */
+#define FIXED_REPORT_EXTENSION ".fixed.json"
+
+/** The ending of a fixed up report's file name while it's being written. */
+#define TEMPORARY_EXTENSION ".tmp"
+
+/** The most bytes of a report that are read into memory, after decompressing. */
+#define MAX_REPORT_LENGTH 20000000
+
+/** The endings a report's file name can have, in the order they're looked for.
+ * A report is fixed up the first time it's read, and kept that way so that
+ * later reads don't have to fix it up again.
+ */
+static const char *const g_reportExtensions[] = {
+    FIXED_REPORT_EXTENSION,
+    FIXED_REPORT_EXTENSION ".gz",
+    ".json",
+    ".json.gz",
+};
+static const int g_reportExtensionsCount = sizeof(g_reportExtensions) / sizeof(*g_reportExtensions);
+
+/** Used to index reports as they're fixed up. Protected by g_mutex. */
+static TTSDKJSONSectionIndexEntry g_sectionIndexEntries[TTSDKCRSI_MAX_ENTRIES];
+
+/** The ending of the manifest's file name. See TTSDKCrashReportManifest.h. */
+#define MANIFEST_EXTENSION "-reports.manifest"
+
+/** The reports in the folder that g_manifestPath is in. Protected by g_mutex. */
+static TTSDKCrashReportManifest g_manifest;
+static char g_manifestPath[TTSDKCRS_MAX_PATH_LENGTH];
+/** Whether g_manifest has been read or rebuilt for g_manifestPath. */
+static bool g_isManifestLoaded;
+
+/** The log that user reports are appended to when logUserReports is set. Protected by g_mutex. */
+static TTSDKCrashReportLog g_log;
+static bool g_isLogOpen;
+static bool g_isCompactingLog;
+/** Signalled when a compaction of g_log ends. */
+static pthread_cond_t g_logCompactedCondition = PTHREAD_COND_INITIALIZER;
+
+static bool hasSuffix(const char *string, const char *suffix)
+{
+    const size_t length = strlen(string);
+    const size_t suffixLength = strlen(suffix);
+    return length >= suffixLength && strcmp(string + length - suffixLength, suffix) == 0;
+}
 
-static void getCrashReportPathByID(int64_t id, char *pathBuffer, const TTSDKCrashReportStoreCConfiguration *const config)
+static bool isFixedReportPath(const char *path)
+{
+    return hasSuffix(path, FIXED_REPORT_EXTENSION) || hasSuffix(path, FIXED_REPORT_EXTENSION ".gz");
+}
+
+static void getReportPathWithExtension(int64_t id, const char *extension, char *pathBuffer,
+                                       const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    snprintf(pathBuffer, TTSDKCRS_MAX_PATH_LENGTH, "%s/%s-report-%016llx%s", config->reportsPath, config->appName, id,
+             extension);
+}
+
+/** Find the file of an existing report. Reports may have been written with or
+ * without compression, regardless of the current configuration, and may have
+ * been fixed up already.
+ */
+static void getExistingCrashReportPathByID(int64_t id, char *pathBuffer,
+                                           const TTSDKCrashReportStoreCConfiguration *const config)
 {
-    snprintf(pathBuffer, TTSDKCRS_MAX_PATH_LENGTH, "%s/%s-report-%016llx.json", config->reportsPath, config->appName, id);
+    for (int i = 0; i < g_reportExtensionsCount; i++) {
+        getReportPathWithExtension(id, g_reportExtensions[i], pathBuffer, config);
+        if (access(pathBuffer, F_OK) == 0) {
+            return;
+        }
+    }
 }
 
 static int64_t getReportIDFromFilename(const char *filename, const TTSDKCrashReportStoreCConfiguration *const config)
 {
     char scanFormat[100];
-    sprintf(scanFormat, "%s-report-%%" PRIx64 ".json", config->appName);
+    sprintf(scanFormat, "%s-report-%%" PRIx64, config->appName);
 
     int64_t reportID = 0;
-    sscanf(filename, scanFormat, &reportID);
-    return reportID;
+    int length = 0;
+    strcat(scanFormat, "%n");
+    sscanf(filename, scanFormat, &reportID, &length);
+    if (length == 0) {
+        return 0;
+    }
+    // Only count the report itself, not its section index or a fixed up report that's still being written.
+    for (int i = 0; i < g_reportExtensionsCount; i++) {
+        if (strcmp(filename + length, g_reportExtensions[i]) == 0) {
+            return reportID;
+        }
+    }
+    return 0;
 }
 
-static int getReportCount(const TTSDKCrashReportStoreCConfiguration *const config)
+static void getManifestPath(char *pathBuffer, const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    snprintf(pathBuffer, TTSDKCRS_MAX_PATH_LENGTH, "%s/%s" MANIFEST_EXTENSION, config->reportsPath, config->appName);
+}
+
+static bool getDirectoryTime(const char *path, int64_t *seconds, int64_t *nanoseconds)
 {
-    int count = 0;
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        TTSDKLOG_ERROR("Could not stat %s: %s", path, strerror(errno));
+        return false;
+    }
+    *seconds = (int64_t)st.st_mtimespec.tv_sec;
+    *nanoseconds = (int64_t)st.st_mtimespec.tv_nsec;
+    return true;
+}
+
+/** Fill in a manifest entry from a report's file.
+ *
+ * @return true if the file is there.
+ */
+static bool fillManifestEntry(int64_t reportID, const char *path, TTSDKCrashReportManifestType type,
+                              TTSDKCrashReportManifestEntry *entry)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    *entry = (TTSDKCrashReportManifestEntry) {
+        .reportID = reportID,
+        .size = (int64_t)st.st_size,
+        .timestamp = (int64_t)st.st_mtimespec.tv_sec,
+        .type = (uint8_t)type,
+    };
+    return true;
+}
+
+/** Rebuild the manifest from the reports folder, keeping the types of reports that were already in it.
+ *
+ * @return true if the folder could be read.
+ */
+static bool rebuildManifest(const char *manifestPath, const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    TTSDKLOG_DEBUG("Rebuilding report manifest %s", manifestPath);
+    // Creating the manifest's file changes the folder's time, so it has to be done before the time is taken.
+    int fd = open(manifestPath, O_WRONLY | O_CREAT, 0644);
+    if (fd >= 0) {
+        close(fd);
+    }
+    TTSDKCrashReportManifest manifest = { 0 };
+    if (!getDirectoryTime(config->reportsPath, &manifest.directoryTimeSeconds, &manifest.directoryTimeNanoseconds)) {
+        return false;
+    }
     DIR *dir = opendir(config->reportsPath);
     if (dir == NULL) {
         TTSDKLOG_ERROR("Could not open directory %s", config->reportsPath);
-        goto done;
+        return false;
     }
+
+    bool success = true;
+    char path[TTSDKCRS_MAX_PATH_LENGTH];
     struct dirent *ent;
     while ((ent = readdir(dir)) != NULL) {
-        if (getReportIDFromFilename(ent->d_name, config) > 0) {
-            count++;
+        int64_t reportID = getReportIDFromFilename(ent->d_name, config);
+        // A raw report is left next to its fixed up copy if the app dies before removing it.
+        if (reportID <= 0 || ttsdkcrm_findEntry(&manifest, reportID) != NULL) {
+            continue;
+        }
+        const TTSDKCrashReportManifestEntry *knownEntry = ttsdkcrm_findEntry(&g_manifest, reportID);
+        TTSDKCrashReportManifestEntry entry;
+        snprintf(path, sizeof(path), "%s/%s", config->reportsPath, ent->d_name);
+        if (!fillManifestEntry(reportID, path,
+                               knownEntry != NULL ? knownEntry->type : TTSDKCrashReportManifestTypeUnknown, &entry)) {
+            continue;
         }
+        if (!ttsdkcrm_addEntry(&manifest, &entry)) {
+            success = false;
+            break;
+        }
+    }
+    closedir(dir);
+    if (!success) {
+        ttsdkcrm_freeManifest(&manifest);
+        return false;
     }
 
-done:
-    if (dir != NULL) {
-        closedir(dir);
+    ttsdkcrm_freeManifest(&g_manifest);
+    g_manifest = manifest;
+    ttsdkcrm_writeManifest(manifestPath, &g_manifest);
+    return true;
+}
+
+/** Make sure the manifest matches the reports folder. It's read from its file
+ * the first time, and rebuilt from the folder if the file is missing or
+ * corrupt, or if something other than the store has changed the folder since,
+ * such as the crash handler writing a report.
+ *
+ * @return true if the manifest can be used.
+ */
+static bool syncManifest(const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    char manifestPath[TTSDKCRS_MAX_PATH_LENGTH];
+    getManifestPath(manifestPath, config);
+    if (!g_isManifestLoaded || strcmp(manifestPath, g_manifestPath) != 0) {
+        strncpy(g_manifestPath, manifestPath, sizeof(g_manifestPath));
+        g_isManifestLoaded = ttsdkcrm_readManifest(manifestPath, &g_manifest);
     }
-    return count;
+
+    int64_t seconds = 0;
+    int64_t nanoseconds = 0;
+    if (g_isManifestLoaded && getDirectoryTime(config->reportsPath, &seconds, &nanoseconds) &&
+        seconds == g_manifest.directoryTimeSeconds && nanoseconds == g_manifest.directoryTimeNanoseconds) {
+        return true;
+    }
+    g_isManifestLoaded = rebuildManifest(manifestPath, config);
+    return g_isManifestLoaded;
 }
 
-static int getReportIDs(int64_t *reportIDs, int count, const TTSDKCrashReportStoreCConfiguration *const config)
+/** Write out the manifest after the store itself has changed the reports folder.
+ * The manifest must have been synced before the change. A report that the crash
+ * handler writes between the change and this call isn't noticed until the
+ * folder next changes.
+ */
+static void saveManifest(const TTSDKCrashReportStoreCConfiguration *const config)
 {
-    int index = 0;
-    DIR *dir = opendir(config->reportsPath);
-    if (dir == NULL) {
-        TTSDKLOG_ERROR("Could not open directory %s", config->reportsPath);
-        goto done;
+    if (!getDirectoryTime(config->reportsPath, &g_manifest.directoryTimeSeconds,
+                          &g_manifest.directoryTimeNanoseconds)) {
+        g_isManifestLoaded = false;
+        return;
     }
+    char manifestPath[TTSDKCRS_MAX_PATH_LENGTH];
+    getManifestPath(manifestPath, config);
+    ttsdkcrm_writeManifest(manifestPath, &g_manifest);
+}
 
-    struct dirent *ent;
-    while ((ent = readdir(dir)) != NULL && index < count) {
-        int64_t reportID = getReportIDFromFilename(ent->d_name, config);
-        if (reportID > 0) {
-            reportIDs[index++] = reportID;
-        }
+/** Close the report log, once any compaction of it has ended. */
+static void closeLog(void)
+{
+    while (g_isCompactingLog) {
+        pthread_cond_wait(&g_logCompactedCondition, &g_mutex);
+    }
+    if (g_isLogOpen) {
+        ttsdkcrl_close(&g_log);
+        g_isLogOpen = false;
+    }
+}
+
+/** Get the report log, opening it the first time.
+ *
+ * @return The log, or NULL if the store doesn't use one or it couldn't be opened.
+ */
+static TTSDKCrashReportLog *getLog(const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    if (!config->logUserReports) {
+        return NULL;
     }
+    char pathPrefix[TTSDKCRL_MAX_PATH_LENGTH];
+    snprintf(pathPrefix, sizeof(pathPrefix), "%s/%s-log-", config->reportsPath, config->appName);
+    if (g_isLogOpen && strcmp(pathPrefix, g_log.pathPrefix) == 0) {
+        return &g_log;
+    }
+    closeLog();
+    g_isLogOpen = ttsdkcrl_open(&g_log, config->reportsPath, config->appName);
+    return g_isLogOpen ? &g_log : NULL;
+}
 
-    qsort(reportIDs, (unsigned)count, sizeof(reportIDs[0]), compareInt64);
+/** Compact the report log. The reports are copied without holding g_mutex, so
+ * that the store can go on being used meanwhile, and the log is only locked to
+ * begin and end the compaction. closeLog() waits for it to end.
+ */
+static void *compactLog(__unused void *userData)
+{
+    TTSDKCrashReportLogCompaction compaction;
+    pthread_mutex_lock(&g_mutex);
+    bool isBegun = g_isLogOpen && ttsdkcrl_shouldCompact(&g_log) && ttsdkcrl_beginCompaction(&g_log, &compaction);
+    pthread_mutex_unlock(&g_mutex);
 
-done:
-    if (dir != NULL) {
-        closedir(dir);
+    if (isBegun) {
+        ttsdkcrl_copyCompaction(&compaction);
+    }
+
+    pthread_mutex_lock(&g_mutex);
+    if (isBegun) {
+        ttsdkcrl_endCompaction(&g_log, &compaction);
+    }
+    g_isCompactingLog = false;
+    pthread_cond_broadcast(&g_logCompactedCondition);
+    pthread_mutex_unlock(&g_mutex);
+    return NULL;
+}
+
+/** Compact the report log on a background thread, if enough of it has been deleted. */
+static void compactLogIfNeeded(const TTSDKCrashReportLog *log)
+{
+    if (log == NULL || g_isCompactingLog || !ttsdkcrl_shouldCompact(log)) {
+        return;
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    int error = pthread_create(&thread, &attr, &compactLog, NULL);
+    if (error != 0) {
+        TTSDKLOG_ERROR("pthread_create: %s", strerror(error));
+    }
+    g_isCompactingLog = error == 0;
+    pthread_attr_destroy(&attr);
+}
+
+static int getReportCount(const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    const TTSDKCrashReportLog *log = getLog(config);
+    return (syncManifest(config) ? g_manifest.count : 0) + (log != NULL ? log->count : 0);
+}
+
+static int getReportIDs(int64_t *reportIDs, int count, const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    const int fileCount = syncManifest(config) ? g_manifest.count : 0;
+    const TTSDKCrashReportLog *log = getLog(config);
+    const int logCount = log != NULL ? log->count : 0;
+
+    // Reports with files of their own and reports in the log are both sorted by ID, so merge them.
+    int index = 0;
+    int fileIndex = 0;
+    int logIndex = 0;
+    while (index < count && (fileIndex < fileCount || logIndex < logCount)) {
+        if (logIndex == logCount ||
+            (fileIndex < fileCount && g_manifest.entries[fileIndex].reportID < log->entries[logIndex].reportID)) {
+            reportIDs[index++] = g_manifest.entries[fileIndex++].reportID;
+        } else {
+            reportIDs[index++] = log->entries[logIndex++].reportID;
+        }
     }
     return index;
 }
 
+static void deleteReportFile(const char *path)
+{
+    ttsdkfu_removeFile(path, false);
+    char indexPath[TTSDKCRS_MAX_PATH_LENGTH];
+    if (ttsdkcrsi_getIndexPath(path, indexPath, sizeof(indexPath))) {
+        ttsdkfu_removeFile(indexPath, false);
+    }
+}
+
 static void deleteReportWithID(int64_t reportID, const TTSDKCrashReportStoreCConfiguration *const config)
 {
     char path[TTSDKCRS_MAX_PATH_LENGTH];
-    getCrashReportPathByID(reportID, path, config);
-    ttsdkfu_removeFile(path, true);
+    for (int i = 0; i < g_reportExtensionsCount; i++) {
+        getReportPathWithExtension(reportID, g_reportExtensions[i], path, config);
+        if (access(path, F_OK) == 0) {
+            deleteReportFile(path);
+        }
+    }
+    ttsdkcrm_removeEntry(&g_manifest, reportID);
+}
+
+/** Record a report in the manifest after the store has written its file. */
+static void addManifestEntry(int64_t reportID, TTSDKCrashReportManifestType type,
+                             const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    char path[TTSDKCRS_MAX_PATH_LENGTH];
+    getExistingCrashReportPathByID(reportID, path, config);
+    TTSDKCrashReportManifestEntry entry;
+    if (fillManifestEntry(reportID, path, type, &entry) && !ttsdkcrm_addEntry(&g_manifest, &entry)) {
+        g_isManifestLoaded = false;
+        return;
+    }
+    saveManifest(config);
+}
+
+/** Delete a report, whether it's in the report log or has a file of its own.
+ * The manifest must be saved afterwards.
+ */
+static void deleteReport(int64_t reportID, TTSDKCrashReportLog *log,
+                         const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    if (log == NULL || !ttsdkcrl_deleteReport(log, reportID)) {
+        deleteReportWithID(reportID, config);
+    }
 }
 
 static void pruneReports(const TTSDKCrashReportStoreCConfiguration *const config)
@@ -133,15 +441,22 @@ static void pruneReports(const TTSDKCrashReportStoreCConfiguration *const config
     if (config->maxReportCount <= 0) {
         return;
     }
-    int reportCount = getReportCount(config);
-    if (reportCount > config->maxReportCount) {
-        int64_t reportIDs[reportCount];
-        reportCount = getReportIDs(reportIDs, reportCount, config);
-
-        for (int i = 0; i < reportCount - config->maxReportCount; i++) {
-            deleteReportWithID(reportIDs[i], config);
-        }
+    const bool isManifestSynced = syncManifest(config);
+    TTSDKCrashReportLog *log = getLog(config);
+    const int reportCount = getReportCount(config);
+    if (reportCount <= config->maxReportCount) {
+        return;
+    }
+    // IDs come out oldest first.
+    int64_t reportIDs[reportCount - config->maxReportCount];
+    const int pruneCount = getReportIDs(reportIDs, reportCount - config->maxReportCount, config);
+    for (int i = 0; i < pruneCount; i++) {
+        deleteReport(reportIDs[i], log, config);
     }
+    if (isManifestSynced) {
+        saveManifest(config);
+    }
+    compactLogIfNeeded(log);
 }
 // clang-format off
 static void initializeIDs(void)
@@ -172,6 +487,10 @@ TTSDKCrashInstallErrorCode ttsdkcrs_initialize(const TTSDKCrashReportStoreCConfi
         TTSDKLOG_ERROR("Could not create path: %s", configuration->reportsPath);
         result = TTSDKCrashInstallErrorCouldNotCreatePath;
     } else {
+        // Read the manifest and log from their files again, in case this is a different folder or they were changed
+        // meanwhile.
+        g_isManifestLoaded = false;
+        closeLog();
         pruneReports(configuration);
         initializeIDs();
     }
@@ -205,39 +524,382 @@ int ttsdkcrs_getReportIDs(int64_t *reportIDs, int count, const TTSDKCrashReportS
     return count;
 }
 
-static char *readReportAtPath(const char *path)
+/** A report that grows as it's converted or fixed up. */
+typedef struct {
+    char *data;
+    int length;
+    int capacity;
+} ReportBuffer;
+
+static int addReportData(const char *const data, const int length, void *const userData)
+{
+    ReportBuffer *report = (ReportBuffer *)userData;
+    if (report->length + length >= report->capacity) {
+        int capacity = (report->length + length) * 2 + 1;
+        char *newData = realloc(report->data, (size_t)capacity);
+        if (newData == NULL) {
+            return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+        }
+        report->data = newData;
+        report->capacity = capacity;
+    }
+    memcpy(report->data + report->length, data, (size_t)length);
+    report->length += length;
+    report->data[report->length] = '\0';
+    return TTSDKJSON_OK;
+}
+
+/** Convert a report that was written as CBOR to JSON.
+ *
+ * @param path The path the report was read from (for logging).
+ *
+ * @param data The CBOR report.
+ *
+ * @param length The length of the CBOR report.
+ *
+ * @return A NULL terminated JSON string, or NULL if nothing could be converted.
+ *         The caller is responsible for freeing it.
+ */
+static char *transcodeCBORReport(const char *path, const char *data, int length)
 {
-    char *rawReport;
-    ttsdkfu_readEntireFile(path, &rawReport, NULL, 2000000);
+    ReportBuffer report = { 0 };
+    char buffer[1024];
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addReportData, &report);
+    ttsdkjson_setOutputBuffer(&context, buffer, sizeof(buffer));
+    int result = ttsdkcbor_transcode(data, length, NULL, &context);
+    ttsdkjson_endEncode(&context);
+    if (result != TTSDKJSON_OK) {
+        // A truncated or partly invalid report is still worth keeping, the same as a truncated JSON report.
+        TTSDKLOG_ERROR("Error converting CBOR report at path %s: %s", path, ttsdkjson_stringForError(result));
+        if (result != TTSDKJSON_ERROR_INCOMPLETE && result != TTSDKJSON_ERROR_INVALID_DATA) {
+            free(report.data);
+            return NULL;
+        }
+    }
+    return report.data;
+}
+
+/** Fix up a JSON report as it's read from its file, without reading all of it into memory first.
+ *
+ * @param sectionIndex If not NULL, an index to fill in for the fixed up report.
+ *
+ * @return The NULL terminated report, or NULL if it couldn't be read.
+ *         The caller is responsible for freeing it.
+ */
+static char *fixupReportFromFile(const char *path, TTSDKJSONSectionIndex *sectionIndex)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Failed to load report at path: %s", path);
+        return NULL;
+    }
+    ReportBuffer report = { 0 };
+    int result = ttsdkcrf_fixupCrashReportFromFD(fd, addReportData, &report, sectionIndex);
+    close(fd);
+    if (result != TTSDKJSON_OK) {
+        TTSDKLOG_ERROR("Failed to fixup report at path: %s", path);
+        free(report.data);
+        return NULL;
+    }
+    return report.data;
+}
+
+/** Read a report that has already been fixed up. */
+static char *readFixedReport(const char *path)
+{
+    char *report = NULL;
+    if (ttsdkgz_isGZipFile(path)) {
+        ttsdkgz_readEntireFile(path, &report, NULL, MAX_REPORT_LENGTH);
+    } else {
+        ttsdkfu_readEntireFile(path, &report, NULL, 0);
+    }
+    if (report == NULL) {
+        TTSDKLOG_ERROR("Failed to load report at path: %s", path);
+    }
+    return report;
+}
+
+/** Read and fix up a report.
+ *
+ * @param sectionIndex If not NULL, an index to fill in for the fixed up report.
+ *
+ * @return The NULL terminated report, or NULL if it couldn't be read.
+ *         The caller is responsible for freeing it.
+ */
+static char *readReportAtPath(const char *path, TTSDKJSONSectionIndex *sectionIndex)
+{
+    if (isFixedReportPath(path)) {
+        return readFixedReport(path);
+    }
+    if (!ttsdkgz_isGZipFile(path) && !ttsdkcbor_isCBORFile(path)) {
+        return fixupReportFromFile(path, sectionIndex);
+    }
+
+    char *rawReport = NULL;
+    int rawReportLength = 0;
+    if (ttsdkgz_isGZipFile(path)) {
+        ttsdkgz_readEntireFile(path, &rawReport, &rawReportLength, MAX_REPORT_LENGTH);
+    } else {
+        ttsdkfu_readEntireFile(path, &rawReport, &rawReportLength, MAX_REPORT_LENGTH);
+    }
+    if (rawReport != NULL && ttsdkcbor_isCBOR(rawReport, rawReportLength)) {
+        char *transcoded = transcodeCBORReport(path, rawReport, rawReportLength);
+        free(rawReport);
+        rawReport = transcoded;
+        rawReportLength = rawReport != NULL ? (int)strlen(rawReport) : 0;
+    }
     if (rawReport == NULL) {
         TTSDKLOG_ERROR("Failed to load report at path: %s", path);
         return NULL;
     }
 
-    char *result = ttsdkcrf_fixupCrashReport(rawReport);
+    ReportBuffer report = { 0 };
+    int result = ttsdkcrf_fixupCrashReportData(rawReport, rawReportLength, addReportData, &report, sectionIndex);
     free(rawReport);
-    if (result == NULL) {
+    if (result != TTSDKJSON_OK) {
         TTSDKLOG_ERROR("Failed to fixup report at path: %s", path);
+        free(report.data);
         return NULL;
     }
 
-    return result;
+    return report.data;
 }
 
 char *ttsdkcrs_readReportAtPath(const char *path)
 {
     pthread_mutex_lock(&g_mutex);
-    char *result = readReportAtPath(path);
+    char *result = readReportAtPath(path, NULL);
+    pthread_mutex_unlock(&g_mutex);
+    return result;
+}
+
+/** Read the part of a report that an index entry covers.
+ *
+ * @return The NULL terminated section, or NULL if it couldn't be read.
+ *         The caller is responsible for freeing it.
+ */
+static char *readReportRange(const char *path, const TTSDKJSONSectionIndexEntry *const entry,
+                             const int64_t reportLength)
+{
+    const int64_t end = entry->offset + entry->length;
+    if (entry->offset < 0 || end > reportLength || end > INT32_MAX) {
+        return NULL;
+    }
+    const int length = (int)entry->length;
+    char *section = malloc((size_t)length + 1);
+    if (section == NULL) {
+        return NULL;
+    }
+
+    bool success = false;
+    if (ttsdkgz_isGZipFile(path)) {
+        // An index is only good for the report it was written with, whose length is in the gzip trailer.
+        // Only the data up to the end of the section needs to be decompressed.
+        uint32_t uncompressedSize = 0;
+        char *data = NULL;
+        int dataLength = 0;
+        if (ttsdkgz_getUncompressedSize(path, &uncompressedSize) && uncompressedSize == (uint32_t)reportLength &&
+            ttsdkgz_readEntireFile(path, &data, &dataLength, (int)end) && dataLength == (int)end) {
+            memcpy(section, data + entry->offset, (size_t)length);
+            success = true;
+        }
+        free(data);
+    } else {
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0) {
+            // An index is only good for the report it was written with.
+            success = lseek(fd, 0, SEEK_END) == reportLength &&
+                      pread(fd, section, (size_t)length, (off_t)entry->offset) == length;
+            close(fd);
+        }
+    }
+    if (!success) {
+        free(section);
+        return NULL;
+    }
+    section[length] = '\0';
+    return section;
+}
+
+static char *readReportSection(const char *path, const char *sectionPath)
+{
+    char indexPath[TTSDKCRS_MAX_PATH_LENGTH];
+    TTSDKJSONSectionIndexEntry entry;
+    int64_t reportLength = 0;
+    bool isCBOR = false;
+    if (!ttsdkcrsi_getIndexPath(path, indexPath, sizeof(indexPath)) ||
+        !ttsdkcrsi_findSection(indexPath, sectionPath, &entry, &reportLength, &isCBOR)) {
+        return NULL;
+    }
+    char *section = readReportRange(path, &entry, reportLength);
+    if (section != NULL && isCBOR) {
+        char *transcoded = transcodeCBORReport(path, section, (int)entry.length);
+        free(section);
+        section = transcoded;
+    }
+    return section;
+}
+
+char *ttsdkcrs_readReportSection(int64_t reportID, const char *sectionPath,
+                                 const TTSDKCrashReportStoreCConfiguration *const configuration)
+{
+    pthread_mutex_lock(&g_mutex);
+    char path[TTSDKCRS_MAX_PATH_LENGTH];
+    getExistingCrashReportPathByID(reportID, path, configuration);
+    char *result = readReportSection(path, sectionPath);
     pthread_mutex_unlock(&g_mutex);
     return result;
 }
 
+static bool writeCompressedReport(const char *path, const char *report, int reportLength)
+{
+    char buffer[4096];
+    TTSDKBufferedWriter bufferedWriter;
+    TTSDKGZipWriter writer;
+    if (!ttsdkfu_openBufferedWriter(&bufferedWriter, path, buffer, sizeof(buffer))) {
+        return false;
+    }
+    if (!ttsdkgz_openWriter(&writer, &bufferedWriter, NULL)) {
+        TTSDKLOG_ERROR("Could not start compressing file %s", path);
+        ttsdkfu_closeBufferedWriter(&bufferedWriter);
+        return false;
+    }
+    bool success = ttsdkgz_write(&writer, report, reportLength);
+    if (!success) {
+        TTSDKLOG_ERROR("Could not write to file %s", path);
+    }
+    success = ttsdkgz_closeWriter(&writer) && success;
+    success = ttsdkfu_flushBufferedWriter(&bufferedWriter) && success;
+    success = success && ttsdkfu_syncFD(bufferedWriter.fd);
+    ttsdkfu_closeBufferedWriter(&bufferedWriter);
+    return success;
+}
+
+static bool writeUncompressedReport(const char *path, const char *report, int reportLength)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Could not open file %s: %s", path, strerror(errno));
+        return false;
+    }
+    bool success = ttsdkfu_writeBytesToFD(fd, report, reportLength) && ttsdkfu_syncFD(fd);
+    close(fd);
+    return success;
+}
+
+/** Replace a raw report with its fixed up form, so that it doesn't need to be
+ * fixed up the next time it's read. The fixed up report is written to a
+ * temporary file and renamed into place, so a report is never seen half
+ * written. The fixed up report and its rename are synced to disk before the
+ * raw report is removed, so a power loss can't lose both. It's compressed if
+ * the raw report was.
+ *
+ * @param reportID The report's ID.
+ *
+ * @param path The raw report's path.
+ *
+ * @param report The fixed up report.
+ *
+ * @param sectionIndex The fixed up report's index, or NULL if it has none.
+ */
+static void keepFixedReport(int64_t reportID, const char *path, const char *report,
+                            const TTSDKJSONSectionIndex *sectionIndex,
+                            const TTSDKCrashReportStoreCConfiguration *const config)
+{
+    const bool isCompressed = ttsdkgz_isGZipFile(path);
+    char fixedPath[TTSDKCRS_MAX_PATH_LENGTH];
+    char temporaryPath[TTSDKCRS_MAX_PATH_LENGTH + sizeof(TEMPORARY_EXTENSION)];
+    char indexPath[TTSDKCRS_MAX_PATH_LENGTH];
+    getReportPathWithExtension(reportID, isCompressed ? FIXED_REPORT_EXTENSION ".gz" : FIXED_REPORT_EXTENSION,
+                               fixedPath, config);
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s" TEMPORARY_EXTENSION, fixedPath);
+
+    // Left behind if the app died while writing it.
+    ttsdkfu_removeFile(temporaryPath, false);
+    const int reportLength = (int)strlen(report);
+    bool success = isCompressed ? writeCompressedReport(temporaryPath, report, reportLength)
+                                : writeUncompressedReport(temporaryPath, report, reportLength);
+    // The index goes in first, so that it's there as soon as the report is.
+    const bool isIndexed = success && sectionIndex != NULL &&
+                           ttsdkcrsi_getIndexPath(fixedPath, indexPath, sizeof(indexPath)) &&
+                           ttsdkcrsi_writeIndex(indexPath, sectionIndex, reportLength, false);
+    if (success && rename(temporaryPath, fixedPath) != 0) {
+        TTSDKLOG_ERROR("Could not rename %s to %s: %s", temporaryPath, fixedPath, strerror(errno));
+        success = false;
+    }
+    if (!success) {
+        ttsdkfu_removeFile(temporaryPath, false);
+        if (isIndexed) {
+            ttsdkfu_removeFile(indexPath, false);
+        }
+        return;
+    }
+    // The raw report is all there is until the rename is on disk.
+    if (!ttsdkfu_syncDirectory(config->reportsPath)) {
+        return;
+    }
+    deleteReportFile(path);
+}
+
+/** Read a report from the report log. The first read fixes the report up and
+ * appends the fixed up report to the log in place of the raw one.
+ *
+ * @return The NULL terminated report, or NULL if it couldn't be read.
+ *         The caller is responsible for freeing it.
+ */
+static char *readLoggedReport(TTSDKCrashReportLog *log, const TTSDKCrashReportLogEntry *entry)
+{
+    const int64_t reportID = entry->reportID;
+    char *rawReport = ttsdkcrl_readReport(log, entry);
+    if (rawReport == NULL || entry->isFixed) {
+        return rawReport;
+    }
+
+    ReportBuffer report = { 0 };
+    int result = ttsdkcrf_fixupCrashReportData(rawReport, entry->length, addReportData, &report, NULL);
+    free(rawReport);
+    if (result != TTSDKJSON_OK) {
+        TTSDKLOG_ERROR("Failed to fixup report %016llx in the report log", reportID);
+        free(report.data);
+        return NULL;
+    }
+    if (report.data != NULL) {
+        ttsdkcrl_appendReport(log, reportID, report.data, report.length, true);
+        compactLogIfNeeded(log);
+    }
+    return report.data;
+}
+
 char *ttsdkcrs_readReport(int64_t reportID, const TTSDKCrashReportStoreCConfiguration *const configuration)
 {
     pthread_mutex_lock(&g_mutex);
+    TTSDKCrashReportLog *log = getLog(configuration);
+    const TTSDKCrashReportLogEntry *logEntry = log != NULL ? ttsdkcrl_findEntry(log, reportID) : NULL;
     char path[TTSDKCRS_MAX_PATH_LENGTH];
-    getCrashReportPathByID(reportID, path, configuration);
-    char *result = readReportAtPath(path);
+    getExistingCrashReportPathByID(reportID, path, configuration);
+    char *result = NULL;
+    if (logEntry != NULL) {
+        result = readLoggedReport(log, logEntry);
+    } else if (isFixedReportPath(path)) {
+        result = readFixedReport(path);
+    } else {
+        // Only keep an index for the fixed up report if the raw report had one.
+        const bool isManifestSynced = syncManifest(configuration);
+        char indexPath[TTSDKCRS_MAX_PATH_LENGTH];
+        const bool isIndexed =
+            ttsdkcrsi_getIndexPath(path, indexPath, sizeof(indexPath)) && access(indexPath, F_OK) == 0;
+        TTSDKJSONSectionIndex sectionIndex = { .entries = g_sectionIndexEntries, .capacity = TTSDKCRSI_MAX_ENTRIES };
+        result = readReportAtPath(path, isIndexed ? &sectionIndex : NULL);
+        if (result != NULL) {
+            keepFixedReport(reportID, path, result, isIndexed ? &sectionIndex : NULL, configuration);
+            if (isManifestSynced) {
+                const TTSDKCrashReportManifestEntry *entry = ttsdkcrm_findEntry(&g_manifest, reportID);
+                addManifestEntry(reportID, entry != NULL ? entry->type : TTSDKCrashReportManifestTypeUnknown,
+                                 configuration);
+            }
+        }
+    }
     pthread_mutex_unlock(&g_mutex);
     return result;
 }
@@ -246,11 +908,26 @@ int64_t ttsdkcrs_addUserReport(const char *report, int reportLength,
                             const TTSDKCrashReportStoreCConfiguration *const configuration)
 {
     pthread_mutex_lock(&g_mutex);
+    TTSDKCrashReportLog *log = getLog(configuration);
+    if (log != NULL) {
+        int64_t currentID = getNextUniqueID();
+        ttsdkcrl_appendReport(log, currentID, report, reportLength, false);
+        pthread_mutex_unlock(&g_mutex);
+        return currentID;
+    }
+
+    const bool isManifestSynced = syncManifest(configuration);
     int64_t currentID = getNextUniqueID();
     char crashReportPath[TTSDKCRS_MAX_PATH_LENGTH];
     getCrashReportPathByID(currentID, crashReportPath, configuration);
+    int fd = -1;
+
+    if (configuration->compressReports) {
+        writeCompressedReport(crashReportPath, report, reportLength);
+        goto done;
+    }
 
-    int fd = open(crashReportPath, O_WRONLY | O_CREAT, 0644);
+    fd = open(crashReportPath, O_WRONLY | O_CREAT, 0644);
     if (fd < 0) {
         TTSDKLOG_ERROR("Could not open file %s: %s", crashReportPath, strerror(errno));
         goto done;
@@ -269,6 +946,9 @@ done:
     if (fd >= 0) {
         close(fd);
     }
+    if (isManifestSynced) {
+        addManifestEntry(currentID, TTSDKCrashReportManifestTypeUser, configuration);
+    }
     pthread_mutex_unlock(&g_mutex);
 
     return currentID;
@@ -277,13 +957,24 @@ done:
 void ttsdkcrs_deleteAllReports(const TTSDKCrashReportStoreCConfiguration *const configuration)
 {
     pthread_mutex_lock(&g_mutex);
+    // A compaction could still be writing to the folder, so it's waited for first.
+    closeLog();
     ttsdkfu_deleteContentsOfPath(configuration->reportsPath);
+    // The manifest and log went with everything else, so they will be started again.
+    ttsdkcrm_freeManifest(&g_manifest);
+    g_isManifestLoaded = false;
     pthread_mutex_unlock(&g_mutex);
 }
 
 void ttsdkcrs_deleteReportWithID(int64_t reportID, const TTSDKCrashReportStoreCConfiguration *const configuration)
 {
     pthread_mutex_lock(&g_mutex);
-    deleteReportWithID(reportID, configuration);
+    const bool isManifestSynced = syncManifest(configuration);
+    TTSDKCrashReportLog *log = getLog(configuration);
+    deleteReport(reportID, log, configuration);
+    if (isManifestSynced) {
+        saveManifest(configuration);
+    }
+    compactLogIfNeeded(log);
     pthread_mutex_unlock(&g_mutex);
 }
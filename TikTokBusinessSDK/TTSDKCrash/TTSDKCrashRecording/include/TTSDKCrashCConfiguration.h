@@ -70,6 +70,27 @@ typedef struct {
      * **Default**: 5
      */
     int maxReportCount;
+
+    /** If true, new reports are gzip compressed as they are written, and saved
+     * with a `.json.gz` extension.
+     *
+     * Compressed and uncompressed reports can be mixed in the same store, and
+     * reading a report always returns plain JSON.
+     *
+     * **Default**: false
+     */
+    bool compressReports;
+
+    /** If true, user reports are appended to a log of segment files instead of
+     * each being written to a file of its own.
+     *
+     * This makes adding and deleting many small user reports much cheaper.
+     * Crash reports still get files of their own. Reports in the log are not
+     * compressed, and are only seen by the store while this is set.
+     *
+     * **Default**: false
+     */
+    bool logUserReports;
 } TTSDKCrashReportStoreCConfiguration;
 
 static inline TTSDKCrashReportStoreCConfiguration TTSDKCrashReportStoreCConfiguration_Default(void)
@@ -78,6 +99,8 @@ static inline TTSDKCrashReportStoreCConfiguration TTSDKCrashReportStoreCConfigur
         .appName = NULL,
         .reportsPath = NULL,
         .maxReportCount = 5,
+        .compressReports = false,
+        .logUserReports = false,
     };
 }
 
@@ -88,6 +111,8 @@ static inline TTSDKCrashReportStoreCConfiguration TTSDKCrashReportStoreCConfigur
         .appName = configuration->appName ? strdup(configuration->appName) : NULL,
         .reportsPath = configuration->reportsPath ? strdup(configuration->reportsPath) : NULL,
         .maxReportCount = configuration->maxReportCount,
+        .compressReports = configuration->compressReports,
+        .logUserReports = configuration->logUserReports,
     };
 }
 
@@ -220,6 +245,48 @@ typedef struct {
      * **Default**: false
      */
     bool enableSigTermMonitoring;
+
+    /** If true, write crash reports as CBOR instead of JSON.
+     *
+     * CBOR needs no string escaping or number formatting, which makes writing
+     * cheaper at crash time and reports smaller on disk. Reports are converted
+     * back to JSON when they are read from the report store, so consumers
+     * don't see the difference.
+     *
+     * **Default**: false
+     */
+    bool enableCBORReports;
+
+    /** If true, write data elements (such as stack dumps) as base64 instead of hex.
+     *
+     * Base64 data is a third smaller than hex. Reports written this way say so
+     * with a `data_encoding` field of "base64" in their `report` section.
+     * Has no effect on CBOR reports, which store data as raw bytes.
+     *
+     * **Default**: false
+     */
+    bool enableBase64DataElements;
+
+    /** If true, write crash reports without pretty printing whitespace.
+     *
+     * Indentation is a large share of a pretty printed report, so compact
+     * reports are faster to write, fix up and upload. Human-facing output,
+     * such as the console installation and the Apple format filter, is
+     * still pretty printed.
+     *
+     * **Default**: false
+     */
+    bool enableCompactReports;
+
+    /** If true, write an index of each crash report's sections next to it.
+     *
+     * The index records where sections such as `crash.error` and each of
+     * `crash.threads` start and end, so that one of them can be read with
+     * `ttsdkcrs_readReportSection()` without reading the whole report.
+     *
+     * **Default**: false
+     */
+    bool enableSectionIndex;
 } TTSDKCrashCConfiguration;
 
 static inline TTSDKCrashCConfiguration TTSDKCrashCConfiguration_Default(void)
@@ -238,6 +305,10 @@ static inline TTSDKCrashCConfiguration TTSDKCrashCConfiguration_Default(void)
         .printPreviousLogOnStartup = false,
         .enableSwapCxaThrow = true,
         .enableSigTermMonitoring = false,
+        .enableCBORReports = false,
+        .enableBase64DataElements = false,
+        .enableCompactReports = false,
+        .enableSectionIndex = false,
     };
 }
 
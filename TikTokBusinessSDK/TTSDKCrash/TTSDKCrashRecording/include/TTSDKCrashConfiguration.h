@@ -163,6 +163,48 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, assign) BOOL enableSigTermMonitoring;
 
+/** If true, write crash reports as CBOR instead of JSON.
+ *
+ * CBOR needs no string escaping or number formatting, which makes writing
+ * cheaper at crash time and reports smaller on disk. Reports are converted
+ * back to JSON when they are read from the report store, so consumers
+ * don't see the difference.
+ *
+ * **Default**: false
+ */
+@property(nonatomic, assign) BOOL enableCBORReports;
+
+/** If true, write data elements (such as stack dumps) as base64 instead of hex.
+ *
+ * Base64 data is a third smaller than hex. Reports written this way say so
+ * with a `data_encoding` field of "base64" in their `report` section.
+ * Has no effect on CBOR reports, which store data as raw bytes.
+ *
+ * **Default**: false
+ */
+@property(nonatomic, assign) BOOL enableBase64DataElements;
+
+/** If true, write crash reports without pretty printing whitespace.
+ *
+ * Indentation is a large share of a pretty printed report, so compact
+ * reports are faster to write, fix up and upload. Human-facing output,
+ * such as the console installation and the Apple format filter, is
+ * still pretty printed.
+ *
+ * **Default**: false
+ */
+@property(nonatomic, assign) BOOL enableCompactReports;
+
+/** If true, write an index of each crash report's sections next to it.
+ *
+ * The index records where sections such as `crash.error` and each of
+ * `crash.threads` start and end, so that one of them can be read with
+ * `-[TTSDKCrashReportStore reportSection:forReportID:]` without reading the whole report.
+ *
+ * **Default**: false
+ */
+@property(nonatomic, assign) BOOL enableSectionIndex;
+
 @end
 
 NS_SWIFT_NAME(CrashReportStoreConfiguration)
@@ -191,6 +233,27 @@ NS_SWIFT_NAME(CrashReportStoreConfiguration)
  */
 @property(nonatomic, assign) NSInteger maxReportCount;
 
+/** If true, new reports are gzip compressed as they are written, and saved
+ * with a `.json.gz` extension.
+ *
+ * Compressed and uncompressed reports can be mixed in the same store, and
+ * reading a report always returns plain JSON.
+ *
+ * **Default**: false
+ */
+@property(nonatomic, assign) BOOL compressReports;
+
+/** If true, user reports are appended to a log of segment files instead of
+ * each being written to a file of its own.
+ *
+ * This makes adding and deleting many small user reports much cheaper.
+ * Crash reports still get files of their own. Reports in the log are not
+ * compressed, and are only seen by the store while this is set.
+ *
+ * **Default**: false
+ */
+@property(nonatomic, assign) BOOL logUserReports;
+
 @end
 
 NS_ASSUME_NONNULL_END
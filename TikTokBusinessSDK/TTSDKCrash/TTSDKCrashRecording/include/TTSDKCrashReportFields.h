@@ -44,8 +44,17 @@ typedef const char *TTSDKCrashReportField;
 #define NS_SWIFT_NAME(_name)
 #endif
 
+#ifdef __OBJC__
 #define TTSDKCRF_DEFINE_CONSTANT(type, name, swift_name, string) \
     static type const type##_##name NS_SWIFT_NAME(swift_name) = TTSDKCRF_CONVERT_STRING(string);
+#else /* __OBJC__ */
+/** In C, each constant also gets a pre-quoted JSON key token (e.g. "\"name\":"),
+ * usable with the ttsdkjson_*Literal() functions.
+ */
+#define TTSDKCRF_DEFINE_CONSTANT(type, name, swift_name, string)                                 \
+    static type const type##_##name NS_SWIFT_NAME(swift_name) = TTSDKCRF_CONVERT_STRING(string); \
+    static const char type##_##name##_JSONKey[] = "\"" string "\":";
+#endif /* __OBJC__ */
 
 #ifdef __cplusplus
 extern "C" {
@@ -190,6 +199,7 @@ TTSDKCRF_DEFINE_CONSTANT(TTSDKCrashField, SessionsSinceLaunch, sessionsSinceLaun
 #pragma mark - Report -
 
 TTSDKCRF_DEFINE_CONSTANT(TTSDKCrashField, Crash, crash, "crash")
+TTSDKCRF_DEFINE_CONSTANT(TTSDKCrashField, DataEncoding, dataEncoding, "data_encoding")
 TTSDKCRF_DEFINE_CONSTANT(TTSDKCrashField, Debug, debug, "debug")
 TTSDKCRF_DEFINE_CONSTANT(TTSDKCrashField, Diagnosis, diagnosis, "diagnosis")
 TTSDKCRF_DEFINE_CONSTANT(TTSDKCrashField, ID, id, "id")
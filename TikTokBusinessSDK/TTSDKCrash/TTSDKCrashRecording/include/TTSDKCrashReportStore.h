@@ -119,6 +119,18 @@ NS_SWIFT_NAME(CrashReportStore)
  */
 - (nullable TTSDKCrashReportDictionary *)reportForID:(int64_t)reportID NS_SWIFT_NAME(report(for:));
 
+/** Get one section of a report without loading the rest of it.
+ * Only reports written with `enableSectionIndex` have sections to load.
+ *
+ * @param sectionPath The section's path, such as "crash.error" or "crash.threads[2]".
+ *
+ * @param reportID An ID of report.
+ *
+ * @return The section's dictionary or array, as it was written (without fixups),
+ *         or nil if it couldn't be loaded this way.
+ */
+- (nullable id)reportSection:(NSString *)sectionPath forReportID:(int64_t)reportID NS_SWIFT_NAME(reportSection(_:for:));
+
 /** Delete all unsent reports.
  */
 - (void)deleteAllReports;
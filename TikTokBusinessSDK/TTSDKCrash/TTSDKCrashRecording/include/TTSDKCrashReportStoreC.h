@@ -67,6 +67,8 @@ int ttsdkcrs_getReportCount(const TTSDKCrashReportStoreCConfiguration *const con
 int ttsdkcrs_getReportIDs(int64_t *reportIDs, int count, const TTSDKCrashReportStoreCConfiguration *const configuration);
 
 /** Read a report.
+ * The first read fixes the report up and keeps it that way on disk, so later
+ * reads of the same report only need to load its file.
  *
  * @warning MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
  *
@@ -77,8 +79,27 @@ int ttsdkcrs_getReportIDs(int64_t *reportIDs, int count, const TTSDKCrashReportS
  */
 char *ttsdkcrs_readReport(int64_t reportID, const TTSDKCrashReportStoreCConfiguration *const configuration);
 
+/** Read one section of a report, without reading the rest of it.
+ * This needs the section index that is written when enableSectionIndex is set.
+ * The section is returned as it was written, without the fixups that
+ * ttsdkcrs_readReport() applies, unless the report has already been read
+ * with ttsdkcrs_readReport().
+ *
+ * @warning MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
+ *
+ * @param reportID The report's ID.
+ * @param sectionPath The section's path, such as "crash.error" or "crash.threads[2]".
+ * @param configuration The store configuretion (e.g. reports path, app name etc).
+ *
+ * @return The section as NULL terminated JSON, or NULL if the report has no
+ *         index or the section isn't in it.
+ */
+char *ttsdkcrs_readReportSection(int64_t reportID, const char *sectionPath,
+                                 const TTSDKCrashReportStoreCConfiguration *const configuration);
+
 /** Read a report at a given path.
  * This is a convenience method for reading reports that are not in the standard reports directory.
+ * Unlike ttsdkcrs_readReport(), the report is fixed up every time it's read and the file is left as it is.
  *
  * @warning MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
  *
@@ -89,6 +110,8 @@ char *ttsdkcrs_readReport(int64_t reportID, const TTSDKCrashReportStoreCConfigur
 char *ttsdkcrs_readReportAtPath(const char *path);
 
 /** Add a custom report to the store.
+ * If logUserReports is set, the report is appended to the store's report log
+ * rather than written to a file of its own.
  *
  * @param report The report's contents (must be JSON encoded).
  * @param reportLength The length of the report in bytes.
@@ -0,0 +1,420 @@
+//
+//  TTSDKCBORCodec.c
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "TTSDKCBORCodec.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+//#define TTSDKLogger_LocalLevel TRACE
+#include "TTSDKLogger.h"
+
+#define likely_if(x) if (__builtin_expect(x, 1))
+#define unlikely_if(x) if (__builtin_expect(x, 0))
+
+/** Size of the read buffer when streaming from a file. */
+#define kReadBufferSize 1024
+
+/** Longest map key that is passed to the encoder in one piece. Longer keys are passed in fragments. */
+#define kMaxNameLength 256
+
+/** Deepest container nesting that will be transcoded, the same as the encoder allows. */
+#define kMaxDepth 200
+
+#define kIndefinite 31
+#define kBreak 0xff
+
+typedef struct {
+    const uint8_t *ptr;
+    const uint8_t *end;
+
+    /** File to refill from, or -1 if all data is in memory. */
+    int fd;
+    uint8_t *buffer;
+    int bufferSize;
+
+    TTSDKJSONEncodeContext *encodeContext;
+    char name[kMaxNameLength + 1];
+} CBORReader;
+
+typedef struct {
+    int majorType;
+    int info;
+    uint64_t argument;
+} CBORHead;
+
+// ============================================================================
+#pragma mark - Reading -
+// ============================================================================
+
+/** Make sure that at least `count` bytes are available (count <= buffer size). */
+static bool ensureAvailable(CBORReader *const reader, const int count)
+{
+    int available = (int)(reader->end - reader->ptr);
+    likely_if(available >= count) { return true; }
+    unlikely_if(reader->fd < 0) { return false; }
+
+    memmove(reader->buffer, reader->ptr, (size_t)available);
+    reader->ptr = reader->buffer;
+    reader->end = reader->buffer + available;
+    while (available < count) {
+        ssize_t bytesRead = read(reader->fd, reader->buffer + available, (size_t)(reader->bufferSize - available));
+        unlikely_if(bytesRead <= 0)
+        {
+            if (bytesRead < 0) {
+                TTSDKLOG_ERROR("Error reading CBOR: %s", strerror(errno));
+            }
+            return false;
+        }
+        available += (int)bytesRead;
+        reader->end = reader->buffer + available;
+    }
+    return true;
+}
+
+static int peekByte(CBORReader *const reader)
+{
+    unlikely_if(!ensureAvailable(reader, 1)) { return -1; }
+    return *reader->ptr;
+}
+
+static int readHead(CBORReader *const reader, CBORHead *const head)
+{
+    unlikely_if(!ensureAvailable(reader, 1)) { return TTSDKJSON_ERROR_INCOMPLETE; }
+    const uint8_t initial = *reader->ptr++;
+    head->majorType = initial >> 5;
+    head->info = initial & 0x1f;
+    head->argument = (uint64_t)head->info;
+
+    int extraBytes;
+    switch (head->info) {
+        case 24:
+            extraBytes = 1;
+            break;
+        case 25:
+            extraBytes = 2;
+            break;
+        case 26:
+            extraBytes = 4;
+            break;
+        case 27:
+            extraBytes = 8;
+            break;
+        case 28:
+        case 29:
+        case 30:
+            return TTSDKJSON_ERROR_INVALID_DATA;
+        default:
+            return TTSDKJSON_OK;
+    }
+    unlikely_if(!ensureAvailable(reader, extraBytes)) { return TTSDKJSON_ERROR_INCOMPLETE; }
+    head->argument = 0;
+    for (int i = 0; i < extraBytes; i++) {
+        head->argument = head->argument << 8 | *reader->ptr++;
+    }
+    return TTSDKJSON_OK;
+}
+
+/** Consume a break byte if it is next. */
+static bool readBreak(CBORReader *const reader, int *const result)
+{
+    const int next = peekByte(reader);
+    unlikely_if(next < 0)
+    {
+        *result = TTSDKJSON_ERROR_INCOMPLETE;
+        return true;
+    }
+    if (next == kBreak) {
+        reader->ptr++;
+        return true;
+    }
+    return false;
+}
+
+static double halfToDouble(const uint16_t half)
+{
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0) {
+        value = ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = mantissa == 0 ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+// ============================================================================
+#pragma mark - Transcoding -
+// ============================================================================
+
+/** Pass a definite-length string's contents to an append function, a buffer at a time. */
+static int copyStringChunk(CBORReader *const reader, uint64_t length,
+                           int (*append)(TTSDKJSONEncodeContext *, const char *, int))
+{
+    while (length > 0) {
+        unlikely_if(!ensureAvailable(reader, 1)) { return TTSDKJSON_ERROR_INCOMPLETE; }
+        int available = (int)(reader->end - reader->ptr);
+        int count = length < (uint64_t)available ? (int)length : available;
+        int result = append(reader->encodeContext, (const char *)reader->ptr, count);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        reader->ptr += count;
+        length -= (uint64_t)count;
+    }
+    return TTSDKJSON_OK;
+}
+
+/** Pass a string's contents to an append function, whether it has a definite length or is split into chunks. */
+static int copyString(CBORReader *const reader, const CBORHead *const head,
+                      int (*append)(TTSDKJSONEncodeContext *, const char *, int))
+{
+    likely_if(head->info != kIndefinite) { return copyStringChunk(reader, head->argument, append); }
+    int result = TTSDKJSON_OK;
+    while (result == TTSDKJSON_OK && !readBreak(reader, &result)) {
+        CBORHead chunk;
+        unlikely_if((result = readHead(reader, &chunk)) != TTSDKJSON_OK) { break; }
+        unlikely_if(chunk.majorType != head->majorType || chunk.info == kIndefinite)
+        {
+            result = TTSDKJSON_ERROR_INVALID_DATA;
+            break;
+        }
+        result = copyStringChunk(reader, chunk.argument, append);
+    }
+    return result;
+}
+
+/** Transcode a text or byte string, which may be split into chunks. */
+static int transcodeString(CBORReader *const reader, const CBORHead *const head, const char *const name)
+{
+    TTSDKJSONEncodeContext *const context = reader->encodeContext;
+    const bool isText = head->majorType == 3;
+    int (*append)(TTSDKJSONEncodeContext *, const char *, int) =
+        isText ? ttsdkjson_appendStringElement : ttsdkjson_appendDataElement;
+
+    int result = isText ? ttsdkjson_beginStringElement(context, name) : ttsdkjson_beginDataElement(context, name);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+
+    result = copyString(reader, head, append);
+
+    // Always close the string, even if we failed to write its content
+    int closeResult = isText ? ttsdkjson_endStringElement(context) : ttsdkjson_endDataElement(context);
+    return result != TTSDKJSON_OK ? result : closeResult;
+}
+
+/** Read a map key.
+ *
+ * @param name Set to the key in the reader's name buffer, or to NULL if the
+ *             key was too long for it and was passed to the encoder in fragments.
+ */
+static int readName(CBORReader *const reader, const char **const name)
+{
+    CBORHead head;
+    int result = readHead(reader, &head);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    unlikely_if(head.majorType != 3)
+    {
+        TTSDKLOG_DEBUG("Unsupported map key (major type %d)", head.majorType);
+        return TTSDKJSON_ERROR_INVALID_DATA;
+    }
+    unlikely_if(head.info == kIndefinite || head.argument > kMaxNameLength)
+    {
+        *name = NULL;
+        result = ttsdkjson_beginElementName(reader->encodeContext);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        return copyString(reader, &head, ttsdkjson_appendElementName);
+    }
+    *name = reader->name;
+    const int length = (int)head.argument;
+    unlikely_if(length > 0 && !ensureAvailable(reader, length)) { return TTSDKJSON_ERROR_INCOMPLETE; }
+    memcpy(reader->name, reader->ptr, (size_t)length);
+    reader->name[length] = '\0';
+    reader->ptr += length;
+    return TTSDKJSON_OK;
+}
+
+static int transcodeItem(CBORReader *const reader, const char *const name, const int depth);
+
+/** Transcode an array or map, which may have an indefinite length. */
+static int transcodeContainer(CBORReader *const reader, const CBORHead *const head, const char *const name,
+                              const int depth)
+{
+    TTSDKJSONEncodeContext *const context = reader->encodeContext;
+    const int maxLevel = (int)(sizeof(context->isObject) / sizeof(*context->isObject)) - 1;
+    unlikely_if(depth >= kMaxDepth || context->containerLevel >= maxLevel) { return TTSDKJSON_ERROR_INVALID_DATA; }
+
+    const bool isMap = head->majorType == 5;
+    int result = isMap ? ttsdkjson_beginObject(context, name) : ttsdkjson_beginArray(context, name);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+
+    const bool isIndefinite = head->info == kIndefinite;
+    uint64_t remaining = head->argument;
+    while (result == TTSDKJSON_OK) {
+        if (isIndefinite ? readBreak(reader, &result) : remaining-- == 0) {
+            break;
+        }
+        const char *childName = NULL;
+        if (isMap) {
+            unlikely_if((result = readName(reader, &childName)) != TTSDKJSON_OK) { break; }
+        }
+        result = transcodeItem(reader, childName, depth + 1);
+    }
+    // A key passed in fragments still needs a value if its item couldn't be read.
+    unlikely_if(context->isNameOpen) { ttsdkjson_addNullElement(context, NULL); }
+
+    int closeResult = ttsdkjson_endContainer(context);
+    return result != TTSDKJSON_OK ? result : closeResult;
+}
+
+static int transcodeSimpleValue(CBORReader *const reader, const CBORHead *const head, const char *const name)
+{
+    TTSDKJSONEncodeContext *const context = reader->encodeContext;
+    switch (head->info) {
+        case 20:
+            return ttsdkjson_addBooleanElement(context, name, false);
+        case 21:
+            return ttsdkjson_addBooleanElement(context, name, true);
+        case 25:
+            return ttsdkjson_addFloatingPointElement(context, name, halfToDouble((uint16_t)head->argument));
+        case 26: {
+            const uint32_t bits = (uint32_t)head->argument;
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return ttsdkjson_addFloatingPointElement(context, name, value);
+        }
+        case 27: {
+            const uint64_t bits = head->argument;
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return ttsdkjson_addFloatingPointElement(context, name, value);
+        }
+        case kIndefinite:
+            TTSDKLOG_DEBUG("Unexpected break");
+            return TTSDKJSON_ERROR_INVALID_DATA;
+        default:
+            // null, undefined, and unassigned simple values.
+            return ttsdkjson_addNullElement(context, name);
+    }
+}
+
+static int transcodeItem(CBORReader *const reader, const char *const name, const int depth)
+{
+    CBORHead head;
+    int result = readHead(reader, &head);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+
+    TTSDKJSONEncodeContext *const context = reader->encodeContext;
+    switch (head.majorType) {
+        case 0:
+            return ttsdkjson_addUIntegerElement(context, name, head.argument);
+        case 1:
+            likely_if(head.argument <= INT64_MAX) { return ttsdkjson_addIntegerElement(context, name, -1 - (int64_t)head.argument); }
+            return ttsdkjson_addFloatingPointElement(context, name, -1.0 - (double)head.argument);
+        case 2:
+        case 3:
+            return transcodeString(reader, &head, name);
+        case 4:
+        case 5:
+            return transcodeContainer(reader, &head, name, depth);
+        case 6:
+            // Tags (such as self-describe) don't change how the value is written.
+            unlikely_if(depth >= kMaxDepth) { return TTSDKJSON_ERROR_INVALID_DATA; }
+            return transcodeItem(reader, name, depth + 1);
+        default:
+            return transcodeSimpleValue(reader, &head, name);
+    }
+}
+
+static int transcode(CBORReader *const reader, const char *const name)
+{
+    TTSDKJSONEncodeContext *const context = reader->encodeContext;
+    const int containerLevel = context->containerLevel;
+    int result = transcodeItem(reader, name, 0);
+    while (context->containerLevel > containerLevel) {
+        ttsdkjson_endContainer(context);
+    }
+    return result;
+}
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+bool ttsdkcbor_isCBOR(const char *const data, const int length)
+{
+    return data != NULL && length >= 3 && (uint8_t)data[0] == 0xd9 && (uint8_t)data[1] == 0xd9 &&
+           (uint8_t)data[2] == 0xf7;
+}
+
+bool ttsdkcbor_isCBORFile(const char *const path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    char magic[3];
+    bool isCBOR = read(fd, magic, sizeof(magic)) == sizeof(magic) && ttsdkcbor_isCBOR(magic, sizeof(magic));
+    close(fd);
+    return isCBOR;
+}
+
+int ttsdkcbor_transcode(const char *const data, const int length, const char *const name,
+                        TTSDKJSONEncodeContext *const encodeContext)
+{
+    CBORReader reader = {
+        .ptr = (const uint8_t *)data,
+        .end = (const uint8_t *)data + length,
+        .fd = -1,
+        .encodeContext = encodeContext,
+    };
+    return transcode(&reader, name);
+}
+
+int ttsdkcbor_transcodeFile(const char *const path, const char *const name, TTSDKJSONEncodeContext *const encodeContext)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Could not open file %s: %s", path, strerror(errno));
+        return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+    }
+    uint8_t buffer[kReadBufferSize];
+    CBORReader reader = {
+        .ptr = buffer,
+        .end = buffer,
+        .fd = fd,
+        .buffer = buffer,
+        .bufferSize = sizeof(buffer),
+        .encodeContext = encodeContext,
+    };
+    int result = transcode(&reader, name);
+    close(fd);
+    return result;
+}
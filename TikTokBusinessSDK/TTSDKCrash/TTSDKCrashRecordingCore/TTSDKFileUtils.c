@@ -390,6 +390,33 @@ bool ttsdkfu_deleteContentsOfPath(const char *path)
     return deletePathContents(path, false);
 }
 
+bool ttsdkfu_syncFD(const int fd)
+{
+#ifdef F_FULLFSYNC
+    if (fcntl(fd, F_FULLFSYNC) == 0) {
+        return true;
+    }
+    // Not every file system supports it.
+#endif
+    if (fsync(fd) != 0) {
+        TTSDKLOG_ERROR("Could not sync file descriptor %d: %s", fd, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool ttsdkfu_syncDirectory(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Could not open directory %s: %s", path, strerror(errno));
+        return false;
+    }
+    const bool success = ttsdkfu_syncFD(fd);
+    close(fd);
+    return success;
+}
+
 bool ttsdkfu_openBufferedWriter(TTSDKBufferedWriter *writer, const char *const path, char *writeBuffer, int writeBufferLength)
 {
     writer->buffer = writeBuffer;
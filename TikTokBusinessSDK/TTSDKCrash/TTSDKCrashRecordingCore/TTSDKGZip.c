@@ -0,0 +1,352 @@
+//
+//  TTSDKGZip.c
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "TTSDKGZip.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// #define TTSDKLogger_LocalLevel TRACE
+#include "TTSDKLogger.h"
+
+/** Size of the stack buffers used when decompressing. */
+#define kInflateBufferSize 4096
+
+// ============================================================================
+#pragma mark - Arena -
+// ============================================================================
+
+static voidpf arenaAlloc(voidpf opaque, uInt items, uInt size)
+{
+    TTSDKGZipArena *arena = (TTSDKGZipArena *)opaque;
+    const uint64_t length = ((uint64_t)items * size + 15) & ~(uint64_t)15;
+    if (length > (uint64_t)(arena->size - arena->used)) {
+        TTSDKLOG_ERROR("zlib needs %llu bytes, but only %d are left", (unsigned long long)length,
+                    arena->size - arena->used);
+        return Z_NULL;
+    }
+    voidpf memory = arena->memory + arena->used;
+    arena->used += (int)length;
+    return memory;
+}
+
+static void arenaFree(__unused voidpf opaque, __unused voidpf address)
+{
+    // Everything is released at once by ttsdkgz_resetArena().
+}
+
+static void useArena(z_stream *const stream, TTSDKGZipArena *const arena)
+{
+    if (arena != NULL) {
+        stream->zalloc = arenaAlloc;
+        stream->zfree = arenaFree;
+        stream->opaque = arena;
+    }
+}
+
+void ttsdkgz_initArena(TTSDKGZipArena *const arena, char *const memory, const int size)
+{
+    // Keep allocations 16 byte aligned.
+    const int misalignment = (int)((uintptr_t)memory & 15);
+    const int offset = misalignment == 0 ? 0 : 16 - misalignment;
+    arena->memory = memory + offset;
+    arena->size = size > offset ? size - offset : 0;
+    arena->used = 0;
+}
+
+void ttsdkgz_resetArena(TTSDKGZipArena *const arena) { arena->used = 0; }
+
+// ============================================================================
+#pragma mark - Writing -
+// ============================================================================
+
+/** Run deflate until it has taken all of its input and, if flushing, written
+ * all of its output. Output goes straight into the buffered writer's buffer.
+ */
+static bool deflateToOutput(TTSDKGZipWriter *const writer, const int flush)
+{
+    z_stream *const stream = &writer->stream;
+    TTSDKBufferedWriter *const output = writer->output;
+    for (;;) {
+        if (output->position >= output->bufferLength && !ttsdkfu_flushBufferedWriter(output)) {
+            return false;
+        }
+        stream->next_out = (Bytef *)(output->buffer + output->position);
+        stream->avail_out = (uInt)(output->bufferLength - output->position);
+        const int result = deflate(stream, flush);
+        output->position = output->bufferLength - (int)stream->avail_out;
+
+        if (result == Z_STREAM_END) {
+            return true;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            TTSDKLOG_ERROR("deflate failed: %d", result);
+            return false;
+        }
+        if (stream->avail_in == 0 && stream->avail_out > 0 && flush != Z_FINISH) {
+            return true;
+        }
+    }
+}
+
+bool ttsdkgz_openWriter(TTSDKGZipWriter *const writer, TTSDKBufferedWriter *const output, TTSDKGZipArena *const arena)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->output = output;
+    useArena(&writer->stream, arena);
+    // Favor speed, since this usually runs in a crash handler.
+    const int result = deflateInit2(&writer->stream, Z_BEST_SPEED, Z_DEFLATED, TTSDKGZ_WINDOW_BITS + 16,
+                                    TTSDKGZ_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (result != Z_OK) {
+        TTSDKLOG_ERROR("deflateInit2 failed: %d", result);
+        writer->output = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool ttsdkgz_write(TTSDKGZipWriter *const writer, const char *const data, const int length)
+{
+    writer->stream.next_in = (Bytef *)data;
+    writer->stream.avail_in = (uInt)length;
+    return deflateToOutput(writer, Z_NO_FLUSH);
+}
+
+bool ttsdkgz_flush(TTSDKGZipWriter *const writer)
+{
+    return deflateToOutput(writer, Z_SYNC_FLUSH) && ttsdkfu_flushBufferedWriter(writer->output);
+}
+
+bool ttsdkgz_closeWriter(TTSDKGZipWriter *const writer)
+{
+    if (writer->output == NULL) {
+        return false;
+    }
+    writer->stream.avail_in = 0;
+    bool success = deflateToOutput(writer, Z_FINISH);
+    deflateEnd(&writer->stream);
+    success = ttsdkfu_flushBufferedWriter(writer->output) && success;
+    writer->output = NULL;
+    return success;
+}
+
+// ============================================================================
+#pragma mark - Reading -
+// ============================================================================
+
+bool ttsdkgz_isGZip(const char *const data, const int length)
+{
+    return data != NULL && length >= 2 && (uint8_t)data[0] == 0x1f && (uint8_t)data[1] == 0x8b;
+}
+
+bool ttsdkgz_isGZipFile(const char *const path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    char magic[2];
+    bool isGZip = read(fd, magic, sizeof(magic)) == sizeof(magic) && ttsdkgz_isGZip(magic, sizeof(magic));
+    close(fd);
+    return isGZip;
+}
+
+bool ttsdkgz_getUncompressedSize(const char *const path, uint32_t *const size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // The trailer ends with ISIZE, in little endian order.
+    uint8_t trailer[4];
+    const off_t fileSize = lseek(fd, 0, SEEK_END);
+    const bool success = fileSize >= (off_t)sizeof(trailer) &&
+                         pread(fd, trailer, sizeof(trailer), fileSize - (off_t)sizeof(trailer)) == sizeof(trailer);
+    close(fd);
+    if (success) {
+        *size = (uint32_t)trailer[0] | (uint32_t)trailer[1] << 8 | (uint32_t)trailer[2] << 16 | (uint32_t)trailer[3] << 24;
+    }
+    return success;
+}
+
+/** Feed the next block of a file to inflate.
+ *
+ * @return false at the end of the file.
+ */
+static bool readInflateInput(const int fd, z_stream *const stream, char *const buffer, const int bufferSize)
+{
+    if (stream->avail_in > 0) {
+        return true;
+    }
+    ssize_t bytesRead = read(fd, buffer, (size_t)bufferSize);
+    if (bytesRead < 0) {
+        TTSDKLOG_ERROR("Could not read: %s", strerror(errno));
+    }
+    if (bytesRead <= 0) {
+        return false;
+    }
+    stream->next_in = (Bytef *)buffer;
+    stream->avail_in = (uInt)bytesRead;
+    return true;
+}
+
+bool ttsdkgz_inflateFile(const char *const srcPath, const char *const dstPath, TTSDKGZipArena *const arena)
+{
+    bool wroteAnything = false;
+    bool isInitialized = false;
+    z_stream stream = { 0 };
+    char inBuffer[kInflateBufferSize];
+    char outBuffer[kInflateBufferSize];
+    int dstFD = -1;
+    int srcFD = open(srcPath, O_RDONLY);
+    if (srcFD < 0) {
+        TTSDKLOG_ERROR("Could not open %s: %s", srcPath, strerror(errno));
+        goto done;
+    }
+    dstFD = open(dstPath, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (dstFD < 0) {
+        TTSDKLOG_ERROR("Could not open %s: %s", dstPath, strerror(errno));
+        goto done;
+    }
+
+    useArena(&stream, arena);
+    int result = inflateInit2(&stream, TTSDKGZ_WINDOW_BITS + 16);
+    if (result != Z_OK) {
+        TTSDKLOG_ERROR("inflateInit2 failed: %d", result);
+        goto done;
+    }
+    isInitialized = true;
+
+    while (result == Z_OK && readInflateInput(srcFD, &stream, inBuffer, sizeof(inBuffer))) {
+        // Keep going while the output buffer fills up, since inflate may be holding more.
+        do {
+            stream.next_out = (Bytef *)outBuffer;
+            stream.avail_out = sizeof(outBuffer);
+            result = inflate(&stream, Z_NO_FLUSH);
+            const int length = (int)(sizeof(outBuffer) - stream.avail_out);
+            if (length > 0) {
+                if (!ttsdkfu_writeBytesToFD(dstFD, outBuffer, length)) {
+                    goto done;
+                }
+                wroteAnything = true;
+            }
+        } while (result == Z_OK && stream.avail_out == 0);
+        if (result == Z_BUF_ERROR) {
+            result = Z_OK;
+        }
+    }
+    if (result != Z_OK && result != Z_STREAM_END) {
+        TTSDKLOG_ERROR("inflate of %s failed: %d", srcPath, result);
+    }
+
+done:
+    if (isInitialized) {
+        inflateEnd(&stream);
+    }
+    if (srcFD >= 0) {
+        close(srcFD);
+    }
+    if (dstFD >= 0) {
+        close(dstFD);
+    }
+    return wroteAnything;
+}
+
+bool ttsdkgz_readEntireFile(const char *const path, char **const data, int *const length, const int maxLength)
+{
+    char *mem = NULL;
+    int capacity = 0;
+    int used = 0;
+    bool isInitialized = false;
+    z_stream stream = { 0 };
+    char inBuffer[kInflateBufferSize];
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        TTSDKLOG_ERROR("Could not open %s: %s", path, strerror(errno));
+        goto done;
+    }
+
+    // Accept anything gzip or zlib, not just what our writer produces.
+    int result = inflateInit2(&stream, MAX_WBITS + 32);
+    if (result != Z_OK) {
+        TTSDKLOG_ERROR("inflateInit2 failed: %d", result);
+        goto done;
+    }
+    isInitialized = true;
+
+    while (result == Z_OK && used < maxLength && readInflateInput(fd, &stream, inBuffer, sizeof(inBuffer))) {
+        // Keep going while the output buffer fills up, since inflate may be holding more.
+        do {
+            if (capacity - used < kInflateBufferSize && capacity < maxLength) {
+                int newCapacity = capacity == 0 ? 65536 : capacity * 2;
+                if (newCapacity > maxLength) {
+                    newCapacity = maxLength;
+                }
+                char *newMem = realloc(mem, (size_t)newCapacity + 1);
+                if (newMem == NULL) {
+                    TTSDKLOG_ERROR("Out of memory");
+                    goto done;
+                }
+                mem = newMem;
+                capacity = newCapacity;
+            }
+            stream.next_out = (Bytef *)(mem + used);
+            stream.avail_out = (uInt)(capacity - used);
+            result = inflate(&stream, Z_NO_FLUSH);
+            used = capacity - (int)stream.avail_out;
+        } while (result == Z_OK && stream.avail_out == 0 && used < maxLength);
+        if (result == Z_BUF_ERROR) {
+            result = Z_OK;
+        }
+    }
+    if (result != Z_STREAM_END) {
+        TTSDKLOG_INFO("%s is truncated, damaged, or too large (inflate: %d). Using the first %d bytes.", path, result,
+                   used);
+    }
+
+done:
+    if (isInitialized) {
+        inflateEnd(&stream);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (used == 0) {
+        free(mem);
+        mem = NULL;
+    } else {
+        mem[used] = '\0';
+    }
+    *data = mem;
+    if (length != NULL) {
+        *length = used;
+    }
+    return mem != NULL;
+}
@@ -30,13 +30,15 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <float.h>
-#include <inttypes.h>
 #include <limits.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "TTSDKNumber.h"
+
 // ============================================================================
 #pragma mark - Configuration -
 // ============================================================================
@@ -59,6 +61,50 @@
 #define TTSDKJSONCODEC_WorkBufferSize 512
 #endif
 
+/** Set to 0 to disable the vectorized string scanners and always use the
+ * scalar loops.
+ */
+#ifndef TTSDKJSONCODEC_UseSIMD
+#define TTSDKJSONCODEC_UseSIMD 1
+#endif
+
+/** Set to 0 to always decode and re-encode embedded JSON (ttsdkjson_addJSONElement()
+ * and ttsdkjson_addJSONFromFile()) instead of copying it when it's valid.
+ */
+#ifndef TTSDKJSONCODEC_SpliceEmbeddedJSON
+#define TTSDKJSONCODEC_SpliceEmbeddedJSON 1
+#endif
+
+/** Set to 0 to always decode with the byte-at-a-time parser. Otherwise
+ * ttsdkjson_decode() first finds the structural characters with vector
+ * instructions (when SIMD is available) and then walks those.
+ */
+#ifndef TTSDKJSONCODEC_UseStructuralIndex
+#define TTSDKJSONCODEC_UseStructuralIndex 1
+#endif
+
+#if TTSDKJSONCODEC_UseSIMD
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TTSDKJSONCODEC_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TTSDKJSONCODEC_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define TTSDKJSONCODEC_SSSE3 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TTSDKJSONCODEC_AVX2 1
+#endif
+#endif
+#endif
+
+#if TTSDKJSONCODEC_UseStructuralIndex && (TTSDKJSONCODEC_SSE2 || TTSDKJSONCODEC_NEON)
+#define TTSDKJSONCODEC_STRUCTURAL_INDEX 1
+#endif
+
 // ============================================================================
 #pragma mark - Helpers -
 // ============================================================================
@@ -92,9 +138,20 @@ const char *ttsdkjson_stringForError(const int error)
 #pragma mark - Encode -
 // ============================================================================
 
+int ttsdkjson_flushOutputBuffer(TTSDKJSONEncodeContext *const context)
+{
+    unlikely_if(context->outputBufferPosition == 0) { return TTSDKJSON_OK; }
+    const int length = context->outputBufferPosition;
+    context->outputBufferPosition = 0;
+    context->bytesFlushed += length;
+    return context->addJSONData(context->outputBuffer, length, context->userData);
+}
+
 /** Add JSON encoded data to an external handler.
  * The external handler will decide how to handle the data (store/transmit/etc).
  *
+ * If the context has an output buffer, the data is gathered there first.
+ *
  * @param context The encoding context.
  *
  * @param data The encoded data.
@@ -103,74 +160,127 @@ const char *ttsdkjson_stringForError(const int error)
  *
  * @return TTSDKJSON_OK if the data was handled successfully.
  */
-#define addJSONData(CONTEXT, DATA, LENGTH) (CONTEXT)->addJSONData(DATA, LENGTH, (CONTEXT)->userData)
+static inline int addJSONData(TTSDKJSONEncodeContext *const context, const char *const data, const int length)
+{
+    likely_if(context->outputBuffer != NULL)
+    {
+        likely_if(length <= context->outputBufferLength - context->outputBufferPosition)
+        {
+            memcpy(context->outputBuffer + context->outputBufferPosition, data, (size_t)length);
+            context->outputBufferPosition += length;
+            return TTSDKJSON_OK;
+        }
+        int result = ttsdkjson_flushOutputBuffer(context);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        likely_if(length < context->outputBufferLength)
+        {
+            memcpy(context->outputBuffer, data, (size_t)length);
+            context->outputBufferPosition = length;
+            return TTSDKJSON_OK;
+        }
+    }
+    context->bytesFlushed += length;
+    return context->addJSONData(data, length, context->userData);
+}
 
-/** Escape a string portion for use with JSON and send to data handler.
+/** Find the first byte in a string that can't be copied verbatim into a JSON
+ * string: a control character, a double quote or a backslash.
  *
- * @param context The JSON context.
+ * Clean runs are checked 16 (or 32 with AVX2) bytes at a time where vector
+ * instructions are available. Everything here is async-safe.
  *
- * @param string The string to escape and write.
+ * @param src The start of the string.
  *
- * @param length The length of the string.
+ * @param end The end of the string.
  *
- * @return TTSDKJSON_OK if the data was handled successfully.
+ * @return A pointer to the first such byte, or end if there is none.
  */
-static int appendEscapedString(TTSDKJSONEncodeContext *const context, const char *restrict const string, int length)
+static inline const char *findEscapeCandidate(const char *src, const char *const end)
 {
-    char workBuffer[TTSDKJSONCODEC_WorkBufferSize];
-    const char *const srcEnd = string + length;
-
-    const char *restrict src = string;
-    char *restrict dst = workBuffer;
-
-    // Simple case (no escape or special characters)
-    for (; src < srcEnd && *src != '\\' && *src != '\"' && (unsigned char)*src >= ' '; src++) {
-        *dst++ = *src;
+#if TTSDKJSONCODEC_AVX2
+    {
+        const __m256i quote = _mm256_set1_epi8('\"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i lastControl = _mm256_set1_epi8(0x1f);
+        for (; end - src >= 32; src += 32) {
+            const __m256i chunk = _mm256_loadu_si256((const __m256i *)(const void *)src);
+            const __m256i isControl = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, lastControl), chunk);
+            const __m256i hits = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)), isControl);
+            const uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+            unlikely_if(mask != 0) { return src + __builtin_ctz(mask); }
+        }
     }
-
-    // Deal with complicated case (if any)
-    for (; src < srcEnd; src++) {
-        switch (*src) {
-            case '\\':
-            case '\"':
-                *dst++ = '\\';
-                *dst++ = *src;
-                break;
-            case '\b':
-                *dst++ = '\\';
-                *dst++ = 'b';
-                break;
-            case '\f':
-                *dst++ = '\\';
-                *dst++ = 'f';
-                break;
-            case '\n':
-                *dst++ = '\\';
-                *dst++ = 'n';
-                break;
-            case '\r':
-                *dst++ = '\\';
-                *dst++ = 'r';
-                break;
-            case '\t':
-                *dst++ = '\\';
-                *dst++ = 't';
-                break;
-            default:
-                unlikely_if((unsigned char)*src < ' ')
-                {
-                    TTSDKLOG_DEBUG("Invalid character 0x%02x in string: %s", *src, string);
-                    return TTSDKJSON_ERROR_INVALID_CHARACTER;
-                }
-                *dst++ = *src;
+#endif
+#if TTSDKJSONCODEC_SSE2
+    {
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i lastControl = _mm_set1_epi8(0x1f);
+        for (; end - src >= 16; src += 16) {
+            const __m128i chunk = _mm_loadu_si128((const __m128i *)(const void *)src);
+            const __m128i isControl = _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk);
+            const __m128i hits =
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), isControl);
+            const uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+            unlikely_if(mask != 0) { return src + __builtin_ctz(mask); }
+        }
+    }
+#endif
+#if TTSDKJSONCODEC_NEON
+    {
+        const uint8x16_t quote = vdupq_n_u8('\"');
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        const uint8x16_t space = vdupq_n_u8(' ');
+        for (; end - src >= 16; src += 16) {
+            const uint8x16_t chunk = vld1q_u8((const uint8_t *)src);
+            const uint8x16_t hits =
+                vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)), vcltq_u8(chunk, space));
+            // Narrow each byte of the comparison to a nybble so the whole result fits in 64 bits.
+            const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+            unlikely_if(mask != 0) { return src + (__builtin_ctzll(mask) >> 2); }
         }
     }
-    int encLength = (int)(dst - workBuffer);
-    dst -= encLength;
-    return addJSONData(context, dst, encLength);
+#endif
+    for (; src < end; src++) {
+        const unsigned char ch = (unsigned char)*src;
+        unlikely_if(ch < ' ' || ch == '\"' || ch == '\\') { break; }
+    }
+    return src;
+}
+
+/** Get the character that follows the backslash when escaping a character.
+ *
+ * @param ch The character to escape.
+ *
+ * @return The escape character, or 0 if the character can't be escaped.
+ */
+static inline char escapeCharFor(const char ch)
+{
+    switch (ch) {
+        case '\\':
+        case '\"':
+            return ch;
+        case '\b':
+            return 'b';
+        case '\f':
+            return 'f';
+        case '\n':
+            return 'n';
+        case '\r':
+            return 'r';
+        case '\t':
+            return 't';
+        default:
+            return 0;
+    }
 }
 
 /** Escape a string for use with JSON and send to data handler.
+ *
+ * Runs of characters that don't need escaping are passed to the data handler
+ * straight from the source string. Only the escaped characters go through a
+ * work buffer.
  *
  * @param context The JSON context.
  *
@@ -182,16 +292,38 @@ static int appendEscapedString(TTSDKJSONEncodeContext *const context, const char
  */
 static int addEscapedString(TTSDKJSONEncodeContext *const context, const char *restrict const string, int length)
 {
+    char workBuffer[TTSDKJSONCODEC_WorkBufferSize];
+    const char *const srcEnd = string + length;
+    const char *src = string;
     int result = TTSDKJSON_OK;
 
-    // Keep adding portions until the whole string has been processed.
-    int offset = 0;
-    while (offset < length) {
-        int toAdd = length - offset;
-        unlikely_if(toAdd > TTSDKJSONCODEC_WorkBufferSize / 2) { toAdd = TTSDKJSONCODEC_WorkBufferSize / 2; }
-        result = appendEscapedString(context, string + offset, toAdd);
-        unlikely_if(result != TTSDKJSON_OK) { break; }
-        offset += toAdd;
+    while (src < srcEnd) {
+        const char *special = findEscapeCandidate(src, srcEnd);
+        likely_if(special > src)
+        {
+            unlikely_if((result = addJSONData(context, src, (int)(special - src))) != TTSDKJSON_OK) { return result; }
+        }
+        likely_if(special >= srcEnd) { break; }
+
+        // Escape this character and any that immediately follow it.
+        char *dst = workBuffer;
+        char *const dstEnd = workBuffer + sizeof(workBuffer) - 1;
+        for (src = special; src < srcEnd && dst < dstEnd; src++) {
+            const unsigned char ch = (unsigned char)*src;
+            likely_if(ch >= ' ' && ch != '\"' && ch != '\\') { break; }
+            const char escapeChar = escapeCharFor(*src);
+            unlikely_if(escapeChar == 0)
+            {
+                TTSDKLOG_DEBUG("Invalid character 0x%02x in string: %s", *src, string);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            }
+            *dst++ = '\\';
+            *dst++ = escapeChar;
+        }
+        unlikely_if((result = addJSONData(context, workBuffer, (int)(dst - workBuffer))) != TTSDKJSON_OK)
+        {
+            return result;
+        }
     }
     return result;
 }
@@ -218,97 +350,28 @@ static int addQuotedEscapedString(TTSDKJSONEncodeContext *const context, const c
     return result || closeResult;
 }
 
-/** Check the result of snprintf and handle error cases.
- *
- * @param written The return value from snprintf.
- * @param buffSize The size of the buffer passed to snprintf.
- * @param bytesWritten Pointer to store the number of bytes written.
- * @return TTSDKJSON_OK if successful, or an error code.
- */
-static int checkWriteResult(int written, size_t buffSize, int *bytesWritten)
-{
-    if (written < 0) {
-        // An encoding error occurred
-        return TTSDKJSON_ERROR_INVALID_CHARACTER;
-    } else if (written >= (int)buffSize) {
-        // The number was too long to fit in the buffer
-        // Note: In this case, buffer is still null-terminated, but truncated
-        return TTSDKJSON_ERROR_DATA_TOO_LONG;
-    }
-    *bytesWritten = written;
-    return TTSDKJSON_OK;
-}
-
 /** Format a double value to a string buffer.
  *
- * @param buff The buffer to write to.
- * @param buffSize The size of the buffer.
+ * NaN becomes null and infinity becomes a literal that overflows to infinity
+ * when parsed, since JSON has no representation for either.
+ *
+ * @param buff The buffer to write to (at least TTSDKNUM_DOUBLE_BUFFER_SIZE bytes).
  * @param value The double value to format.
- * @param bytesWritten Pointer to store the number of bytes written.
- * @return TTSDKJSON_OK if successful, or an error code.
+ * @return The number of bytes written.
  */
-static int formatDouble(char *buff, size_t buffSize, double value, int *bytesWritten)
+static int formatDouble(char *buff, double value)
 {
-    int written = 0;
     if (isnan(value)) {
-        written = snprintf(buff, buffSize, "null");
-    } else if (isinf(value)) {
-        written = snprintf(buff, buffSize, value > 0 ? "1e999" : "-1e999");
-    } else {
-        float floatValue = (float)value;
-        if (fabs(value - floatValue) <= FLT_EPSILON * fabs(value)) {
-            written = snprintf(buff, buffSize, "%.*g", FLT_DIG, floatValue);
-        } else {
-            written = snprintf(buff, buffSize, "%.*g", DBL_DIG, value);
-        }
-
-        if (written > 0 && written < (int)buffSize) {
-            char *dot = strchr(buff, '.');
-            char *e = strchr(buff, 'e');
-            if (dot == NULL && e == NULL) {
-                written = snprintf(buff, buffSize, "%.1f", value);
-            } else if (dot != NULL && e == NULL) {
-                char *end = buff + written - 1;
-                while (end > dot && *end == '0') {
-                    *end-- = '\0';
-                    written--;
-                }
-                if (end == dot) {
-                    *++end = '0';
-                    written++;
-                }
-            }
-        }
+        memcpy(buff, "null", 4);
+        return 4;
     }
-    return checkWriteResult(written, buffSize, bytesWritten);
-}
-
-/** Format an int64_t value to a string buffer.
- *
- * @param buff The buffer to write to.
- * @param buffSize The size of the buffer.
- * @param value The int64_t value to format.
- * @param bytesWritten Pointer to store the number of bytes written.
- * @return TTSDKJSON_OK if successful, or an error code.
- */
-static int formatInt64(char *buff, size_t buffSize, int64_t value, int *bytesWritten)
-{
-    int written = snprintf(buff, buffSize, "%" PRId64, value);
-    return checkWriteResult(written, buffSize, bytesWritten);
-}
-
-/** Format a uint64_t value to a string buffer.
- *
- * @param buff The buffer to write to.
- * @param buffSize The size of the buffer.
- * @param value The uint64_t value to format.
- * @param bytesWritten Pointer to store the number of bytes written.
- * @return TTSDKJSON_OK if successful, or an error code.
- */
-static int formatUint64(char *buff, size_t buffSize, uint64_t value, int *bytesWritten)
-{
-    int written = snprintf(buff, buffSize, "%" PRIu64, value);
-    return checkWriteResult(written, buffSize, bytesWritten);
+    if (isinf(value)) {
+        const char *inf = value > 0 ? "1e999" : "-1e999";
+        const int length = value > 0 ? 5 : 6;
+        memcpy(buff, inf, (size_t)length);
+        return length;
+    }
+    return ttsdknum_formatDouble(value, buff);
 }
 
 /** Add a formatted number to the JSON encoding context.
@@ -326,855 +389,4718 @@ static int addFormattedNumber(TTSDKJSONEncodeContext *const context, const char
     return addJSONData(context, buff, written);
 }
 
-int ttsdkjson_beginElement(TTSDKJSONEncodeContext *const context, const char *const name)
-{
-    int result = TTSDKJSON_OK;
+// ============================================================================
+#pragma mark - CBOR -
+// ============================================================================
 
-    // Decide if a comma is warranted.
-    unlikely_if(context->containerFirstEntry) { context->containerFirstEntry = false; }
-    else
-    {
-        unlikely_if((result = addJSONData(context, ",", 1)) != TTSDKJSON_OK) { return result; }
-    }
+#define isCBOR(CONTEXT) ((CONTEXT)->format == TTSDKJSONEncodeFormatCBOR)
 
-    // Pretty printing
-    unlikely_if(context->prettyPrint && context->containerLevel > 0)
-    {
-        unlikely_if((result = addJSONData(context, "\n", 1)) != TTSDKJSON_OK) { return result; }
-        for (int i = 0; i < context->containerLevel; i++) {
-            unlikely_if((result = addJSONData(context, "    ", 4)) != TTSDKJSON_OK) { return result; }
-        }
-    }
+enum {
+    CBORMajorUnsigned = 0,
+    CBORMajorNegative = 1,
+    CBORMajorBytes = 2,
+    CBORMajorText = 3,
+    CBORMajorArray = 4,
+    CBORMajorMap = 5,
+};
 
-    // Add a name field if we're in an object.
-    if (context->isObject[context->containerLevel]) {
-        unlikely_if(name == NULL)
-        {
-            TTSDKLOG_DEBUG("Name was null inside an object");
-            return TTSDKJSON_ERROR_INVALID_DATA;
-        }
-        unlikely_if((result = addQuotedEscapedString(context, name, (int)strlen(name))) != TTSDKJSON_OK) { return result; }
-        unlikely_if(context->prettyPrint)
-        {
-            unlikely_if((result = addJSONData(context, ": ", 2)) != TTSDKJSON_OK) { return result; }
-        }
-        else
-        {
-            unlikely_if((result = addJSONData(context, ":", 1)) != TTSDKJSON_OK) { return result; }
-        }
-    }
-    return result;
-}
+#define CBORFalse 0xf4
+#define CBORTrue 0xf5
+#define CBORNull 0xf6
+#define CBORFloat32 0xfa
+#define CBORFloat64 0xfb
+#define CBORIndefiniteBytes 0x5f
+#define CBORIndefiniteText 0x7f
+#define CBORIndefiniteArray 0x9f
+#define CBORIndefiniteMap 0xbf
+#define CBORBreak 0xff
 
-int ttsdkjson_addRawJSONData(TTSDKJSONEncodeContext *const context, const char *const data, const int length)
+/** Add a single CBOR initial byte. */
+static inline int addCBORByte(TTSDKJSONEncodeContext *const context, const uint8_t byte)
 {
-    return addJSONData(context, data, length);
+    return addJSONData(context, (const char *)&byte, 1);
 }
 
-int ttsdkjson_addBooleanElement(TTSDKJSONEncodeContext *const context, const char *const name, const bool value)
+/** Add a CBOR item head: the major type and its argument, in the shortest form. */
+static int addCBORHead(TTSDKJSONEncodeContext *const context, const int majorType, const uint64_t argument)
 {
-    int result = ttsdkjson_beginElement(context, name);
-    unlikely_if(result != TTSDKJSON_OK) { return result; }
-    if (value) {
-        return addJSONData(context, "true", 4);
-    } else {
-        return addJSONData(context, "false", 5);
+    uint8_t head[9];
+    int length;
+    head[0] = (uint8_t)(majorType << 5);
+    likely_if(argument < 24)
+    {
+        head[0] |= (uint8_t)argument;
+        return addJSONData(context, (const char *)head, 1);
     }
+    else if (argument <= 0xff)
+    {
+        head[0] |= 24;
+        length = 2;
+    }
+    else if (argument <= 0xffff)
+    {
+        head[0] |= 25;
+        length = 3;
+    }
+    else if (argument <= 0xffffffff)
+    {
+        head[0] |= 26;
+        length = 5;
+    }
+    else
+    {
+        head[0] |= 27;
+        length = 9;
+    }
+    for (int i = 1; i < length; i++) {
+        head[i] = (uint8_t)(argument >> ((length - 1 - i) * 8));
+    }
+    return addJSONData(context, (const char *)head, length);
 }
 
-int ttsdkjson_addFloatingPointElement(TTSDKJSONEncodeContext *const context, const char *const name, double value)
-{
-    char buff[64];
-    int bytesWritten = 0;
-    int result = formatDouble(buff, sizeof(buff), value, &bytesWritten);
-    unlikely_if(result != TTSDKJSON_OK) { return result; }
-    return addFormattedNumber(context, name, buff, bytesWritten);
-}
-
-int ttsdkjson_addIntegerElement(TTSDKJSONEncodeContext *const context, const char *const name, int64_t value)
-{
-    char buff[21];
-    int bytesWritten = 0;
-    int result = formatInt64(buff, sizeof(buff), value, &bytesWritten);
-    unlikely_if(result != TTSDKJSON_OK) { return result; }
-    return addFormattedNumber(context, name, buff, bytesWritten);
-}
-
-int ttsdkjson_addUIntegerElement(TTSDKJSONEncodeContext *const context, const char *const name, uint64_t value)
-{
-    char buff[21];
-    int bytesWritten = 0;
-    int result = formatUint64(buff, sizeof(buff), value, &bytesWritten);
-    unlikely_if(result != TTSDKJSON_OK) { return result; }
-    return addFormattedNumber(context, name, buff, bytesWritten);
-}
-
-int ttsdkjson_addNullElement(TTSDKJSONEncodeContext *const context, const char *const name)
+/** Add a CBOR text or byte string with a known length. */
+static int addCBORString(TTSDKJSONEncodeContext *const context, const int majorType, const char *const string,
+                         const int length)
 {
-    int result = ttsdkjson_beginElement(context, name);
+    int result = addCBORHead(context, majorType, (uint64_t)length);
     unlikely_if(result != TTSDKJSON_OK) { return result; }
-    return addJSONData(context, "null", 4);
+    return addJSONData(context, string, length);
 }
 
-int ttsdkjson_addStringElement(TTSDKJSONEncodeContext *const context, const char *const name, const char *const value,
-                            int length)
+/** Add a CBOR text string, stopping at the first control character that JSON
+ * can't escape so that CBOR reports hold the same strings as JSON reports.
+ */
+static int addCBORText(TTSDKJSONEncodeContext *const context, const char *const string, const int length)
 {
-    unlikely_if(value == NULL) { return ttsdkjson_addNullElement(context, name); }
-    int result = ttsdkjson_beginElement(context, name);
+    const char *const end = string + length;
+    const char *ptr = string;
+    while ((ptr = findEscapeCandidate(ptr, end)) < end && escapeCharFor(*ptr) != 0) {
+        ptr++;
+    }
+    int result = addCBORString(context, CBORMajorText, string, (int)(ptr - string));
     unlikely_if(result != TTSDKJSON_OK) { return result; }
-    if (length == TTSDKJSON_SIZE_AUTOMATIC) {
-        length = (int)strlen(value);
+    unlikely_if(ptr < end)
+    {
+        TTSDKLOG_DEBUG("Invalid character 0x%02x in string: %s", *ptr, string);
+        return TTSDKJSON_ERROR_INVALID_CHARACTER;
     }
-    return addQuotedEscapedString(context, value, length);
+    return TTSDKJSON_OK;
 }
 
-int ttsdkjson_beginStringElement(TTSDKJSONEncodeContext *const context, const char *const name)
+/** Begin a CBOR element, adding the name as a map key if we're in an object. */
+static int beginCBORElement(TTSDKJSONEncodeContext *const context, const char *const name)
 {
-    int result = ttsdkjson_beginElement(context, name);
-    unlikely_if(result != TTSDKJSON_OK) { return result; }
-    return addJSONData(context, "\"", 1);
+    context->containerFirstEntry = false;
+    if (context->isObject[context->containerLevel]) {
+        unlikely_if(name == NULL)
+        {
+            TTSDKLOG_DEBUG("Name was null inside an object");
+            return TTSDKJSON_ERROR_INVALID_DATA;
+        }
+        return addCBORString(context, CBORMajorText, name, (int)strlen(name));
+    }
+    return TTSDKJSON_OK;
 }
 
-int ttsdkjson_appendStringElement(TTSDKJSONEncodeContext *const context, const char *const value, int length)
+/** Check whether a double survives narrowing to a 32-bit float unchanged.
+ *
+ * Finite doubles beyond float's range are rejected before the cast, since converting them is undefined.
+ */
+static bool isExactAsFloat(const double value)
 {
-    return addEscapedString(context, value, length);
+    unlikely_if(isnan(value)) { return true; }
+    unlikely_if(!isinf(value) && fabs(value) > FLT_MAX) { return false; }
+    return (double)(float)value == value;
 }
 
-int ttsdkjson_endStringElement(TTSDKJSONEncodeContext *const context) { return addJSONData(context, "\"", 1); }
-
-int ttsdkjson_addDataElement(TTSDKJSONEncodeContext *const context, const char *name, const char *value, int length)
+/** Add a floating point value, as a 32-bit float if that's exact. */
+static int addCBORDouble(TTSDKJSONEncodeContext *const context, const double value)
 {
-    int result = TTSDKJSON_OK;
-    result = ttsdkjson_beginDataElement(context, name);
-    if (result == TTSDKJSON_OK) {
-        result = ttsdkjson_appendDataElement(context, value, length);
+    uint8_t buffer[9];
+    likely_if(isExactAsFloat(value))
+    {
+        const float floatValue = (float)value;
+        uint32_t bits;
+        memcpy(&bits, &floatValue, sizeof(bits));
+        buffer[0] = CBORFloat32;
+        for (int i = 0; i < 4; i++) {
+            buffer[4 - i] = (uint8_t)(bits >> (i * 8));
+        }
+        return addJSONData(context, (const char *)buffer, 5);
     }
-    if (result == TTSDKJSON_OK) {
-        result = ttsdkjson_endDataElement(context);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    buffer[0] = CBORFloat64;
+    for (int i = 0; i < 8; i++) {
+        buffer[8 - i] = (uint8_t)(bits >> (i * 8));
     }
-    return result;
+    return addJSONData(context, (const char *)buffer, 9);
 }
 
-int ttsdkjson_beginDataElement(TTSDKJSONEncodeContext *const context, const char *const name)
-{
-    return ttsdkjson_beginStringElement(context, name);
-}
+// ============================================================================
+#pragma mark - Data -
+// ============================================================================
 
-int ttsdkjson_appendDataElement(TTSDKJSONEncodeContext *const context, const char *const value, int length)
+/** Used for writing base64 string values. */
+static const char g_base64Alphabet[64] = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+                                           'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+                                           'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+                                           'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/' };
+
+/** Encode bytes as hex and send to data handler, a work buffer at a time.
+ *
+ * @param context The JSON context.
+ *
+ * @param data The bytes to encode.
+ *
+ * @param length The number of bytes.
+ *
+ * @return TTSDKJSON_OK if the data was handled successfully.
+ */
+static int addHexData(TTSDKJSONEncodeContext *const context, const unsigned char *data, int length)
 {
-    unsigned char *currentByte = (unsigned char *)value;
-    unsigned char *end = currentByte + length;
-    char chars[2];
+    char workBuffer[TTSDKJSONCODEC_WorkBufferSize];
     int result = TTSDKJSON_OK;
-    while (currentByte < end) {
-        chars[0] = g_hexNybbles[(*currentByte >> 4) & 15];
-        chars[1] = g_hexNybbles[*currentByte & 15];
-        result = addJSONData(context, chars, sizeof(chars));
-        if (result != TTSDKJSON_OK) {
-            break;
+    while (length > 0) {
+        const int count = length < (int)sizeof(workBuffer) / 2 ? length : (int)sizeof(workBuffer) / 2;
+        char *dst = workBuffer;
+        for (const unsigned char *const end = data + count; data < end; data++) {
+            *dst++ = g_hexNybbles[*data >> 4];
+            *dst++ = g_hexNybbles[*data & 15];
         }
-        currentByte++;
+        unlikely_if((result = addJSONData(context, workBuffer, count * 2)) != TTSDKJSON_OK) { break; }
+        length -= count;
     }
     return result;
 }
 
-int ttsdkjson_endDataElement(TTSDKJSONEncodeContext *const context) { return ttsdkjson_endStringElement(context); }
-
-int ttsdkjson_beginArray(TTSDKJSONEncodeContext *const context, const char *const name)
-{
-    likely_if(context->containerLevel >= 0)
+/** Base64 encode whole 3 byte groups.
+ *
+ * 48 bytes (NEON) or 12 bytes (SSSE3) are encoded at a time where vector
+ * instructions are available. Everything here is async-safe.
+ *
+ * @param src The bytes to encode.
+ *
+ * @param length The number of bytes. MUST be a multiple of 3.
+ *
+ * @param dst Where to write the characters. Needs room for length / 3 * 4.
+ */
+static void encodeBase64Groups(const unsigned char *src, int length, char *dst)
+{
+#if TTSDKJSONCODEC_NEON
     {
-        int result = ttsdkjson_beginElement(context, name);
-        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        const uint8_t *const alphabet = (const uint8_t *)g_base64Alphabet;
+        const uint8x16x4_t table = { { vld1q_u8(alphabet), vld1q_u8(alphabet + 16), vld1q_u8(alphabet + 32),
+                                       vld1q_u8(alphabet + 48) } };
+        const uint8x16_t sixBits = vdupq_n_u8(0x3f);
+        for (; length >= 48; src += 48, length -= 48, dst += 64) {
+            // De-interleave so that lane i of val[0..2] holds the three bytes of group i.
+            const uint8x16x3_t in = vld3q_u8(src);
+            uint8x16x4_t out;
+            out.val[0] = vshrq_n_u8(in.val[0], 2);
+            out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), sixBits);
+            out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), sixBits);
+            out.val[3] = vandq_u8(in.val[2], sixBits);
+            out.val[0] = vqtbl4q_u8(table, out.val[0]);
+            out.val[1] = vqtbl4q_u8(table, out.val[1]);
+            out.val[2] = vqtbl4q_u8(table, out.val[2]);
+            out.val[3] = vqtbl4q_u8(table, out.val[3]);
+            vst4q_u8((uint8_t *)dst, out);
+        }
     }
-
-    context->containerLevel++;
-    context->isObject[context->containerLevel] = false;
-    context->containerFirstEntry = true;
-
-    return addJSONData(context, "[", 1);
-}
-
-int ttsdkjson_beginObject(TTSDKJSONEncodeContext *const context, const char *const name)
-{
-    likely_if(context->containerLevel >= 0)
+#endif
+#if TTSDKJSONCODEC_SSSE3
     {
-        int result = ttsdkjson_beginElement(context, name);
-        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        // Loads 16 bytes but only uses 12, so stop while there's still a full load left.
+        for (; length >= 16; src += 12, length -= 12, dst += 16) {
+            __m128i in = _mm_loadu_si128((const __m128i *)(const void *)src);
+            // Spread each 3 byte group over a 32-bit lane as [b1 b0 b2 b1].
+            in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+            // Move each 6-bit index into its own byte.
+            const __m128i highIndexes =
+                _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+            const __m128i lowIndexes =
+                _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+            const __m128i indexes = _mm_or_si128(highIndexes, lowIndexes);
+            // Map each index to the offset that turns it into its character.
+            __m128i range = _mm_subs_epu8(indexes, _mm_set1_epi8(51));
+            range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indexes), _mm_set1_epi8(13)));
+            const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                  '/' - 63, 'A', 0, 0);
+            const __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indexes);
+            _mm_storeu_si128((__m128i *)(void *)dst, chars);
+        }
+    }
+#endif
+    for (; length >= 3; src += 3, length -= 3, dst += 4) {
+        const unsigned int group = (unsigned int)src[0] << 16 | (unsigned int)src[1] << 8 | src[2];
+        dst[0] = g_base64Alphabet[group >> 18];
+        dst[1] = g_base64Alphabet[(group >> 12) & 0x3f];
+        dst[2] = g_base64Alphabet[(group >> 6) & 0x3f];
+        dst[3] = g_base64Alphabet[group & 0x3f];
     }
-
-    context->containerLevel++;
-    context->isObject[context->containerLevel] = true;
-    context->containerFirstEntry = true;
-
-    return addJSONData(context, "{", 1);
 }
 
-int ttsdkjson_endContainer(TTSDKJSONEncodeContext *const context)
+/** Encode bytes as base64 and send to data handler.
+ *
+ * Bytes that don't make up a whole group are held in the context until more
+ * data arrives or the element ends, so fragments can be any length.
+ *
+ * @param context The JSON context.
+ *
+ * @param data The bytes to encode.
+ *
+ * @param length The number of bytes.
+ *
+ * @return TTSDKJSON_OK if the data was handled successfully.
+ */
+static int addBase64Data(TTSDKJSONEncodeContext *const context, const unsigned char *data, int length)
 {
-    unlikely_if(context->containerLevel <= 0) { return TTSDKJSON_OK; }
-
-    bool isObject = context->isObject[context->containerLevel];
-    context->containerLevel--;
+    char workBuffer[TTSDKJSONCODEC_WorkBufferSize];
+    int result = TTSDKJSON_OK;
 
-    // Pretty printing
-    unlikely_if(context->prettyPrint && !context->containerFirstEntry)
+    unlikely_if(context->pendingDataLength > 0)
     {
-        int result;
-        unlikely_if((result = addJSONData(context, "\n", 1)) != TTSDKJSON_OK) { return result; }
-        for (int i = 0; i < context->containerLevel; i++) {
-            unlikely_if((result = addJSONData(context, "    ", 4)) != TTSDKJSON_OK) { return result; }
+        unsigned char group[3];
+        memcpy(group, context->pendingData, (size_t)context->pendingDataLength);
+        while (context->pendingDataLength < 3 && length > 0) {
+            group[context->pendingDataLength++] = *data++;
+            length--;
+        }
+        unlikely_if(context->pendingDataLength < 3)
+        {
+            memcpy(context->pendingData, group, (size_t)context->pendingDataLength);
+            return TTSDKJSON_OK;
         }
+        context->pendingDataLength = 0;
+        encodeBase64Groups(group, 3, workBuffer);
+        unlikely_if((result = addJSONData(context, workBuffer, 4)) != TTSDKJSON_OK) { return result; }
     }
-    context->containerFirstEntry = false;
-    return addJSONData(context, isObject ? "}" : "]", 1);
-}
 
-void ttsdkjson_beginEncode(TTSDKJSONEncodeContext *const context, bool prettyPrint, TTSDKJSONAddDataFunc addJSONDataFunc,
-                        void *const userData)
-{
-    memset(context, 0, sizeof(*context));
-    context->addJSONData = addJSONDataFunc;
-    context->userData = userData;
-    context->prettyPrint = prettyPrint;
-    context->containerFirstEntry = true;
+    const int maxChunk = (int)sizeof(workBuffer) / 4 * 3;
+    while (length >= 3) {
+        int count = length < maxChunk ? length : maxChunk;
+        count -= count % 3;
+        encodeBase64Groups(data, count, workBuffer);
+        unlikely_if((result = addJSONData(context, workBuffer, count / 3 * 4)) != TTSDKJSON_OK) { return result; }
+        data += count;
+        length -= count;
+    }
+
+    memcpy(context->pendingData, data, (size_t)length);
+    context->pendingDataLength = length;
+    return result;
 }
 
-int ttsdkjson_endEncode(TTSDKJSONEncodeContext *const context)
+/** Write out any bytes held back by addBase64Data(), with padding.
+ *
+ * @param context The JSON context.
+ *
+ * @return TTSDKJSON_OK if the data was handled successfully.
+ */
+static int addBase64Tail(TTSDKJSONEncodeContext *const context)
 {
-    int result = TTSDKJSON_OK;
-    while (context->containerLevel > 0) {
-        unlikely_if((result = ttsdkjson_endContainer(context)) != TTSDKJSON_OK) { return result; }
-    }
-    return result;
+    const int length = context->pendingDataLength;
+    likely_if(length == 0) { return TTSDKJSON_OK; }
+    context->pendingDataLength = 0;
+
+    const unsigned int group = (unsigned int)context->pendingData[0] << 16 |
+                               (length > 1 ? (unsigned int)context->pendingData[1] << 8 : 0);
+    const char chars[4] = {
+        g_base64Alphabet[group >> 18],
+        g_base64Alphabet[(group >> 12) & 0x3f],
+        length > 1 ? g_base64Alphabet[(group >> 6) & 0x3f] : '=',
+        '=',
+    };
+    return addJSONData(context, chars, sizeof(chars));
 }
 
 // ============================================================================
-#pragma mark - Decode -
+#pragma mark - Section Index -
 // ============================================================================
 
-#define INV 0x11111
-
-typedef struct {
-    /** Pointer to current work area in the buffer. */
-    const char *bufferPtr;
-    /** Pointer to the end of the buffer. */
-    const char *bufferEnd;
-    /** Pointer to a buffer for storing a decoded name. */
-    char *nameBuffer;
-    /** Length of the name buffer. */
-    int nameBufferLength;
-    /** Pointer to a buffer for storing a decoded string. */
-    char *stringBuffer;
-    /** Length of the string buffer. */
-    int stringBufferLength;
-    /** The callbacks to call while decoding. */
-    TTSDKJSONDecodeCallbacks *const callbacks;
-    /** Data that was specified when calling ttsdkjson_decode(). */
-    void *userData;
-} TTSDKJSONDecodeContext;
+void ttsdkjson_beginSectionIndex(TTSDKJSONEncodeContext *const context, TTSDKJSONSectionIndex *const index,
+                                 TTSDKJSONSectionIndexEntry *const entries, const int capacity)
+{
+    memset(index, 0, sizeof(*index));
+    index->entries = entries;
+    index->capacity = capacity;
+    index->baseLevel = context->containerLevel;
+    for (int i = 0; i <= TTSDKJSON_SECTION_INDEX_DEPTH; i++) {
+        index->openEntries[i] = -1;
+    }
+    context->sectionIndex = index;
+}
 
-/** Lookup table for converting hex values to integers.
- * INV (0x11111) is used to mark invalid characters so that any attempted
- * invalid nybble conversion is always > 0xffff.
- */
-static const unsigned int g_hexConversion[] = {
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, INV, INV, INV, INV, INV, INV, INV, 0xa,
-    0xb, 0xc, 0xd, 0xe, 0xf, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
-};
+int64_t ttsdkjson_getOutputPosition(const TTSDKJSONEncodeContext *const context)
+{
+    return context->bytesFlushed + context->outputBufferPosition;
+}
 
-/** Encode a UTF-16 character to UTF-8. The dest pointer gets incremented
- * by however many bytes were needed for the conversion (1-4).
- *
- * @param character The UTF-16 character.
- *
- * @param dst Where to write the UTF-8 character.
+/** Append to the path of the container being indexed.
  *
- * @return TTSDKJSON_OK if the encoding was successful.
+ * @return The path's new length, or -1 if it doesn't fit.
  */
-static int writeUTF8(unsigned int character, char **dst);
+static int appendSectionPath(TTSDKJSONSectionIndex *const index, int pathLength, const char *const string,
+                             const int length)
+{
+    unlikely_if(pathLength < 0 || pathLength + length >= TTSDKJSON_SECTION_PATH_LENGTH) { return -1; }
+    memcpy(index->path + pathLength, string, (size_t)length);
+    return pathLength + length;
+}
 
-/** Decode a string value.
- *
- * @param context The decoding context.
+/** Index a container that was just begun, if it's one that gets indexed.
  *
- * @param dstBuffer Buffer to hold the decoded string.
+ * @param context The encoding context, with the container's level already entered.
  *
- * @param dstBufferLength Length of the destination buffer.
+ * @param name The name passed to ttsdkjson_beginObject() or ttsdkjson_beginArray().
  *
- * @return TTSDKJSON_OK if successful.
+ * @param offset Where the container's opening bracket goes.
  */
-static int decodeString(TTSDKJSONDecodeContext *context, char *dstBuffer, int dstBufferLength);
+static void beginIndexedContainer(TTSDKJSONEncodeContext *const context, const char *const name, const int64_t offset)
+{
+    TTSDKJSONSectionIndex *const index = context->sectionIndex;
+    // Strip the quotes and colon from a literal key token.
+    const char *const key = name != NULL ? name : context->literalKey != NULL ? context->literalKey + 1 : NULL;
+    const int keyLength = name != NULL ? (int)strlen(name) : context->literalKeyLength - 3;
 
-/** Decode a JSON element.
- *
- * @param name This element's name (or NULL if it has none).
+    const int depth = context->containerLevel - index->baseLevel - 1;
+    unlikely_if(depth < 0 || depth > TTSDKJSON_SECTION_INDEX_DEPTH) { return; }
+    index->openEntries[depth] = -1;
+    index->containerCounts[depth] = 0;
+    unlikely_if(depth == 0) { return; }
+
+    const int parent = depth - 1;
+    const int element = index->containerCounts[parent]++;
+    const bool isMember = context->isObject[context->containerLevel - 1];
+    const bool isParentIndexed = parent == 0 || index->openEntries[parent] >= 0;
+    const bool shouldIndex = isMember ? depth <= 2 && key != NULL : depth == 3;
+    unlikely_if(!shouldIndex || !isParentIndexed || index->count >= index->capacity) { return; }
+
+    int pathLength = parent == 0 ? 0 : index->pathLengths[parent];
+    if (isMember) {
+        if (pathLength > 0) {
+            pathLength = appendSectionPath(index, pathLength, ".", 1);
+        }
+        pathLength = appendSectionPath(index, pathLength, key, keyLength);
+    } else {
+        char subscript[24] = "[";
+        int length = 1 + ttsdknum_formatInt64(element, subscript + 1);
+        subscript[length++] = ']';
+        pathLength = appendSectionPath(index, pathLength, subscript, length);
+    }
+    // A truncated path could name another section, so the container isn't indexed (nor is anything in it).
+    unlikely_if(pathLength < 0) { return; }
+    index->pathLengths[depth] = pathLength;
+
+    TTSDKJSONSectionIndexEntry *const entry = &index->entries[index->count];
+    memcpy(entry->path, index->path, (size_t)pathLength);
+    entry->path[pathLength] = '\0';
+    entry->offset = offset;
+    entry->length = 0;
+    index->openEntries[depth] = index->count++;
+}
+
+/** Finish indexing a container that was just closed.
  *
- * @param context The decoding context.
+ * @param context The encoding context.
  *
- * @return TTSDKJSON_OK if successful.
+ * @param level The container's level.
  */
-static int decodeElement(const char *const name, TTSDKJSONDecodeContext *context);
+static void endIndexedContainer(TTSDKJSONEncodeContext *const context, const int level)
+{
+    TTSDKJSONSectionIndex *const index = context->sectionIndex;
+    const int depth = level - index->baseLevel - 1;
+    unlikely_if(depth < 0 || depth > TTSDKJSON_SECTION_INDEX_DEPTH || index->openEntries[depth] < 0) { return; }
+    TTSDKJSONSectionIndexEntry *const entry = &index->entries[index->openEntries[depth]];
+    entry->length = ttsdkjson_getOutputPosition(context) - entry->offset;
+    index->openEntries[depth] = -1;
+}
 
-/** Skip past any whitespace.
- *
- * @param CONTEXT The decoding context.
- */
-#define SKIP_WHITESPACE(CONTEXT)                                                      \
-    while (CONTEXT->bufferPtr < CONTEXT->bufferEnd && isspace(*CONTEXT->bufferPtr)) { \
-        CONTEXT->bufferPtr++;                                                         \
-    }
+// ============================================================================
+#pragma mark - Elements -
+// ============================================================================
 
-/** Check if a character is valid for representing part of a floating point
- * number.
+/** Add the comma and pretty-print indentation that precede an element.
  *
- * @param ch The character to test.
+ * @param context The encoding context.
  *
- * @return true if the character is valid for floating point.
+ * @return TTSDKJSON_OK if the process was successful.
  */
-static inline bool isFPChar(char ch)
+static int addElementPreamble(TTSDKJSONEncodeContext *const context)
 {
-    switch (ch) {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-        case '.':
-        case 'e':
-        case 'E':
-        case '+':
-        case '-':
-            return true;
-        default:
-            return false;
+    int result = TTSDKJSON_OK;
+
+    // Decide if a comma is warranted.
+    unlikely_if(context->containerFirstEntry) { context->containerFirstEntry = false; }
+    else
+    {
+        unlikely_if((result = addJSONData(context, ",", 1)) != TTSDKJSON_OK) { return result; }
+    }
+
+    // Pretty printing
+    unlikely_if(context->prettyPrint && context->containerLevel > 0)
+    {
+        unlikely_if((result = addJSONData(context, "\n", 1)) != TTSDKJSON_OK) { return result; }
+        for (int i = 0; i < context->containerLevel; i++) {
+            unlikely_if((result = addJSONData(context, "    ", 4)) != TTSDKJSON_OK) { return result; }
+        }
     }
+    return result;
 }
 
-static int writeUTF8(unsigned int character, char **dst)
+/** Close a name begun with ttsdkjson_beginElementName(), now that its element is being added. */
+static int endElementName(TTSDKJSONEncodeContext *const context, const char *const name)
 {
-    likely_if(character <= 0x7f)
+    context->isNameOpen = false;
+    unlikely_if(name != NULL)
     {
-        **dst = (char)character;
-        (*dst)++;
-        return TTSDKJSON_OK;
-    }
-    if (character <= 0x7ff) {
-        (*dst)[0] = (char)(0xc0 | (character >> 6));
-        (*dst)[1] = (char)(0x80 | (character & 0x3f));
-        *dst += 2;
-        return TTSDKJSON_OK;
-    }
-    if (character <= 0xffff) {
-        (*dst)[0] = (char)(0xe0 | (character >> 12));
-        (*dst)[1] = (char)(0x80 | ((character >> 6) & 0x3f));
-        (*dst)[2] = (char)(0x80 | (character & 0x3f));
-        *dst += 3;
-        return TTSDKJSON_OK;
-    }
-    // RFC3629 restricts UTF-8 to end at 0x10ffff.
-    if (character <= 0x10ffff) {
-        (*dst)[0] = (char)(0xf0 | (character >> 18));
-        (*dst)[1] = (char)(0x80 | ((character >> 12) & 0x3f));
-        (*dst)[2] = (char)(0x80 | ((character >> 6) & 0x3f));
-        (*dst)[3] = (char)(0x80 | (character & 0x3f));
-        *dst += 4;
-        return TTSDKJSON_OK;
+        TTSDKLOG_DEBUG("Element named \"%s\" follows a name that was passed in fragments", name);
+        return TTSDKJSON_ERROR_INVALID_DATA;
     }
-
-    // If we get here, the character cannot be converted to valid UTF-8.
-    TTSDKLOG_DEBUG("Invalid unicode: 0x%04x", character);
-    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    unlikely_if(isCBOR(context)) { return addCBORByte(context, CBORBreak); }
+    return addJSONData(context, context->prettyPrint ? "\": " : "\":", context->prettyPrint ? 3 : 2);
 }
 
-static int decodeString(TTSDKJSONDecodeContext *context, char *dstBuffer, int dstBufferLength)
+/** Begin an element named by the key token that a ttsdkjson_*Literal() function is adding it under.
+ *
+ * @param context The encoding context.
+ *
+ * @param name The name that the element was also given, which must be NULL.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+static int beginLiteralElement(TTSDKJSONEncodeContext *const context, const char *const name)
 {
-    *dstBuffer = '\0';
-    unlikely_if(*context->bufferPtr != '\"')
+    unlikely_if(name != NULL)
     {
-        TTSDKLOG_DEBUG("Expected '\"' but got '%c'", *context->bufferPtr);
-        return TTSDKJSON_ERROR_INVALID_CHARACTER;
+        TTSDKLOG_DEBUG("Element named \"%s\" is already named by a literal key", name);
+        return TTSDKJSON_ERROR_INVALID_DATA;
+    }
+    const bool isMember = context->isObject[context->containerLevel];
+    unlikely_if(isCBOR(context))
+    {
+        context->containerFirstEntry = false;
+        // Strip the quotes and colon from the JSON key token.
+        return isMember ? addCBORString(context, CBORMajorText, context->literalKey + 1, context->literalKeyLength - 3)
+                        : TTSDKJSON_OK;
     }
 
-    const char *src = context->bufferPtr + 1;
-    bool fastCopy = true;
+    int result = addElementPreamble(context);
+    unlikely_if(result != TTSDKJSON_OK || !isMember) { return result; }
+    unlikely_if((result = addJSONData(context, context->literalKey, context->literalKeyLength)) != TTSDKJSON_OK)
+    {
+        return result;
+    }
+    unlikely_if(context->prettyPrint) { return addJSONData(context, " ", 1); }
+    return result;
+}
 
-    for (; src < context->bufferEnd && *src != '\"'; src++) {
-        unlikely_if(*src == '\\')
+/** Make the element that the next call adds use a literal key token instead of a name.
+ * Every ttsdkjson_*Literal() function passes its result through endLiteralKey() afterwards,
+ * so the key never outlives the call, whichever way it returns.
+ */
+static inline void beginLiteralKey(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                   const int length)
+{
+    context->literalKey = literalKey;
+    context->literalKeyLength = length;
+}
+
+static inline int endLiteralKey(TTSDKJSONEncodeContext *const context, const int result)
+{
+    context->literalKey = NULL;
+    return result;
+}
+
+int ttsdkjson_beginElement(TTSDKJSONEncodeContext *const context, const char *const name)
+{
+    unlikely_if(context->literalKey != NULL) { return beginLiteralElement(context, name); }
+    unlikely_if(context->isNameOpen) { return endElementName(context, name); }
+    unlikely_if(isCBOR(context)) { return beginCBORElement(context, name); }
+
+    int result = addElementPreamble(context);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+
+    // Add a name field if we're in an object.
+    if (context->isObject[context->containerLevel]) {
+        unlikely_if(name == NULL)
+        {
+            TTSDKLOG_DEBUG("Name was null inside an object");
+            return TTSDKJSON_ERROR_INVALID_DATA;
+        }
+        unlikely_if((result = addQuotedEscapedString(context, name, (int)strlen(name))) != TTSDKJSON_OK) { return result; }
+        unlikely_if(context->prettyPrint)
+        {
+            unlikely_if((result = addJSONData(context, ": ", 2)) != TTSDKJSON_OK) { return result; }
+        }
+        else
+        {
+            unlikely_if((result = addJSONData(context, ":", 1)) != TTSDKJSON_OK) { return result; }
+        }
+    }
+    return result;
+}
+
+int ttsdkjson_addRawJSONData(TTSDKJSONEncodeContext *const context, const char *const data, const int length)
+{
+    unlikely_if(isCBOR(context)) { return TTSDKJSON_ERROR_INVALID_DATA; }
+    return addJSONData(context, data, length);
+}
+
+int ttsdkjson_addBooleanElement(TTSDKJSONEncodeContext *const context, const char *const name, const bool value)
+{
+    int result = ttsdkjson_beginElement(context, name);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    unlikely_if(isCBOR(context)) { return addCBORByte(context, value ? CBORTrue : CBORFalse); }
+    if (value) {
+        return addJSONData(context, "true", 4);
+    } else {
+        return addJSONData(context, "false", 5);
+    }
+}
+
+int ttsdkjson_addFloatingPointElement(TTSDKJSONEncodeContext *const context, const char *const name, double value)
+{
+    unlikely_if(isCBOR(context))
+    {
+        int result = ttsdkjson_beginElement(context, name);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        return addCBORDouble(context, value);
+    }
+    char buff[TTSDKNUM_DOUBLE_BUFFER_SIZE];
+    return addFormattedNumber(context, name, buff, formatDouble(buff, value));
+}
+
+int ttsdkjson_addIntegerElement(TTSDKJSONEncodeContext *const context, const char *const name, int64_t value)
+{
+    unlikely_if(isCBOR(context))
+    {
+        int result = ttsdkjson_beginElement(context, name);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        return value < 0 ? addCBORHead(context, CBORMajorNegative, (uint64_t)(-1 - value))
+                         : addCBORHead(context, CBORMajorUnsigned, (uint64_t)value);
+    }
+    char buff[TTSDKNUM_INTEGER_BUFFER_SIZE];
+    return addFormattedNumber(context, name, buff, ttsdknum_formatInt64(value, buff));
+}
+
+int ttsdkjson_addUIntegerElement(TTSDKJSONEncodeContext *const context, const char *const name, uint64_t value)
+{
+    unlikely_if(isCBOR(context))
+    {
+        int result = ttsdkjson_beginElement(context, name);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        return addCBORHead(context, CBORMajorUnsigned, value);
+    }
+    char buff[TTSDKNUM_INTEGER_BUFFER_SIZE];
+    return addFormattedNumber(context, name, buff, ttsdknum_formatUInt64(value, buff));
+}
+
+int ttsdkjson_addNullElement(TTSDKJSONEncodeContext *const context, const char *const name)
+{
+    int result = ttsdkjson_beginElement(context, name);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    unlikely_if(isCBOR(context)) { return addCBORByte(context, CBORNull); }
+    return addJSONData(context, "null", 4);
+}
+
+int ttsdkjson_addStringElement(TTSDKJSONEncodeContext *const context, const char *const name, const char *const value,
+                            int length)
+{
+    unlikely_if(value == NULL) { return ttsdkjson_addNullElement(context, name); }
+    int result = ttsdkjson_beginElement(context, name);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    if (length == TTSDKJSON_SIZE_AUTOMATIC) {
+        length = (int)strlen(value);
+    }
+    unlikely_if(isCBOR(context)) { return addCBORText(context, value, length); }
+    return addQuotedEscapedString(context, value, length);
+}
+
+int ttsdkjson_beginStringElement(TTSDKJSONEncodeContext *const context, const char *const name)
+{
+    int result = ttsdkjson_beginElement(context, name);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    unlikely_if(isCBOR(context)) { return addCBORByte(context, CBORIndefiniteText); }
+    return addJSONData(context, "\"", 1);
+}
+
+int ttsdkjson_appendStringElement(TTSDKJSONEncodeContext *const context, const char *const value, int length)
+{
+    unlikely_if(isCBOR(context)) { return length > 0 ? addCBORText(context, value, length) : TTSDKJSON_OK; }
+    return addEscapedString(context, value, length);
+}
+
+int ttsdkjson_endStringElement(TTSDKJSONEncodeContext *const context)
+{
+    unlikely_if(isCBOR(context)) { return addCBORByte(context, CBORBreak); }
+    return addJSONData(context, "\"", 1);
+}
+
+int ttsdkjson_beginElementName(TTSDKJSONEncodeContext *const context)
+{
+    unlikely_if(!context->isObject[context->containerLevel]) { return TTSDKJSON_OK; }
+    unlikely_if(isCBOR(context))
+    {
+        context->containerFirstEntry = false;
+        context->isNameOpen = true;
+        return addCBORByte(context, CBORIndefiniteText);
+    }
+    int result = addElementPreamble(context);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    context->isNameOpen = true;
+    return addJSONData(context, "\"", 1);
+}
+
+int ttsdkjson_appendElementName(TTSDKJSONEncodeContext *const context, const char *const name, const int length)
+{
+    unlikely_if(!context->isNameOpen) { return TTSDKJSON_OK; }
+    unlikely_if(isCBOR(context)) { return length > 0 ? addCBORText(context, name, length) : TTSDKJSON_OK; }
+    return addEscapedString(context, name, length);
+}
+
+int ttsdkjson_addDataElement(TTSDKJSONEncodeContext *const context, const char *name, const char *value, int length)
+{
+    unlikely_if(isCBOR(context))
+    {
+        int result = ttsdkjson_beginElement(context, name);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        return addCBORString(context, CBORMajorBytes, value, length);
+    }
+    int result = TTSDKJSON_OK;
+    result = ttsdkjson_beginDataElement(context, name);
+    if (result == TTSDKJSON_OK) {
+        result = ttsdkjson_appendDataElement(context, value, length);
+    }
+    if (result == TTSDKJSON_OK) {
+        result = ttsdkjson_endDataElement(context);
+    }
+    return result;
+}
+
+int ttsdkjson_beginDataElement(TTSDKJSONEncodeContext *const context, const char *const name)
+{
+    unlikely_if(isCBOR(context))
+    {
+        int result = ttsdkjson_beginElement(context, name);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        return addCBORByte(context, CBORIndefiniteBytes);
+    }
+    context->pendingDataLength = 0;
+    return ttsdkjson_beginStringElement(context, name);
+}
+
+int ttsdkjson_appendDataElement(TTSDKJSONEncodeContext *const context, const char *const value, int length)
+{
+    unlikely_if(isCBOR(context)) { return length > 0 ? addCBORString(context, CBORMajorBytes, value, length) : TTSDKJSON_OK; }
+    if (context->dataEncoding == TTSDKJSONDataEncodingBase64) {
+        return addBase64Data(context, (const unsigned char *)value, length);
+    }
+    return addHexData(context, (const unsigned char *)value, length);
+}
+
+int ttsdkjson_endDataElement(TTSDKJSONEncodeContext *const context)
+{
+    if (!isCBOR(context) && context->dataEncoding == TTSDKJSONDataEncodingBase64) {
+        int result = addBase64Tail(context);
+        // Always close the string, even if we failed to write its content
+        int closeResult = ttsdkjson_endStringElement(context);
+        return result != TTSDKJSON_OK ? result : closeResult;
+    }
+    return ttsdkjson_endStringElement(context);
+}
+
+int ttsdkjson_beginArray(TTSDKJSONEncodeContext *const context, const char *const name)
+{
+    likely_if(context->containerLevel >= 0)
+    {
+        int result = ttsdkjson_beginElement(context, name);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+    }
+
+    context->containerLevel++;
+    context->isObject[context->containerLevel] = false;
+    context->containerFirstEntry = true;
+
+    unlikely_if(context->sectionIndex != NULL)
+    {
+        beginIndexedContainer(context, name, ttsdkjson_getOutputPosition(context));
+    }
+    unlikely_if(isCBOR(context)) { return addCBORByte(context, CBORIndefiniteArray); }
+    return addJSONData(context, "[", 1);
+}
+
+int ttsdkjson_beginObject(TTSDKJSONEncodeContext *const context, const char *const name)
+{
+    likely_if(context->containerLevel >= 0)
+    {
+        int result = ttsdkjson_beginElement(context, name);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+    }
+
+    context->containerLevel++;
+    context->isObject[context->containerLevel] = true;
+    context->containerFirstEntry = true;
+
+    unlikely_if(context->sectionIndex != NULL)
+    {
+        beginIndexedContainer(context, name, ttsdkjson_getOutputPosition(context));
+    }
+    unlikely_if(isCBOR(context)) { return addCBORByte(context, CBORIndefiniteMap); }
+    return addJSONData(context, "{", 1);
+}
+
+int ttsdkjson_addBooleanElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                      const int length, const bool value)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_addBooleanElement(context, NULL, value));
+}
+
+int ttsdkjson_addFloatingPointElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                            const int length, const double value)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_addFloatingPointElement(context, NULL, value));
+}
+
+int ttsdkjson_addIntegerElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                      const int length, const int64_t value)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_addIntegerElement(context, NULL, value));
+}
+
+int ttsdkjson_addUIntegerElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                       const int length, const uint64_t value)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_addUIntegerElement(context, NULL, value));
+}
+
+int ttsdkjson_addStringElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                     const int length, const char *const value, const int valueLength)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_addStringElement(context, NULL, value, valueLength));
+}
+
+int ttsdkjson_addDataElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                   const int length, const char *const value, const int valueLength)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_addDataElement(context, NULL, value, valueLength));
+}
+
+int ttsdkjson_beginObjectLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, const int length)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_beginObject(context, NULL));
+}
+
+int ttsdkjson_beginArrayLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, const int length)
+{
+    beginLiteralKey(context, literalKey, length);
+    return endLiteralKey(context, ttsdkjson_beginArray(context, NULL));
+}
+
+/** Close the current container.
+ *
+ * @param context The encoding context, which must be in a container.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+static int closeContainer(TTSDKJSONEncodeContext *const context)
+{
+    bool isObject = context->isObject[context->containerLevel];
+    context->containerLevel--;
+
+    unlikely_if(isCBOR(context))
+    {
+        context->containerFirstEntry = false;
+        return addCBORByte(context, CBORBreak);
+    }
+
+    // Pretty printing
+    unlikely_if(context->prettyPrint && !context->containerFirstEntry)
+    {
+        int result;
+        unlikely_if((result = addJSONData(context, "\n", 1)) != TTSDKJSON_OK) { return result; }
+        for (int i = 0; i < context->containerLevel; i++) {
+            unlikely_if((result = addJSONData(context, "    ", 4)) != TTSDKJSON_OK) { return result; }
+        }
+    }
+    context->containerFirstEntry = false;
+    return addJSONData(context, isObject ? "}" : "]", 1);
+}
+
+int ttsdkjson_endContainer(TTSDKJSONEncodeContext *const context)
+{
+    unlikely_if(context->containerLevel <= 0) { return TTSDKJSON_OK; }
+
+    const int level = context->containerLevel;
+    const int result = closeContainer(context);
+    unlikely_if(context->sectionIndex != NULL) { endIndexedContainer(context, level); }
+    return result;
+}
+
+void ttsdkjson_beginEncode(TTSDKJSONEncodeContext *const context, bool prettyPrint, TTSDKJSONAddDataFunc addJSONDataFunc,
+                        void *const userData)
+{
+    memset(context, 0, sizeof(*context));
+    context->addJSONData = addJSONDataFunc;
+    context->userData = userData;
+    context->prettyPrint = prettyPrint;
+    context->containerFirstEntry = true;
+}
+
+void ttsdkjson_setOutputBuffer(TTSDKJSONEncodeContext *const context, char *const buffer, const int length)
+{
+    ttsdkjson_flushOutputBuffer(context);
+    context->outputBuffer = length > 0 ? buffer : NULL;
+    context->outputBufferLength = context->outputBuffer != NULL ? length : 0;
+    context->outputBufferPosition = 0;
+}
+
+int ttsdkjson_setEncodeFormat(TTSDKJSONEncodeContext *const context, const TTSDKJSONEncodeFormat format)
+{
+    context->format = format;
+    if (isCBOR(context)) {
+        // Self-describe tag 55799, so that readers can tell CBOR from JSON.
+        static const char selfDescribeTag[] = { (char)0xd9, (char)0xd9, (char)0xf7 };
+        return addJSONData(context, selfDescribeTag, sizeof(selfDescribeTag));
+    }
+    return TTSDKJSON_OK;
+}
+
+void ttsdkjson_setDataEncoding(TTSDKJSONEncodeContext *const context, const TTSDKJSONDataEncoding encoding)
+{
+    context->dataEncoding = encoding;
+    context->pendingDataLength = 0;
+}
+
+int ttsdkjson_endEncode(TTSDKJSONEncodeContext *const context)
+{
+    int result = TTSDKJSON_OK;
+    while (context->containerLevel > 0) {
+        unlikely_if((result = ttsdkjson_endContainer(context)) != TTSDKJSON_OK) { return result; }
+    }
+    return ttsdkjson_flushOutputBuffer(context);
+}
+
+int ttsdkjson_endRecord(TTSDKJSONEncodeContext *const context)
+{
+    int result = TTSDKJSON_OK;
+    while (context->containerLevel > 0) {
+        unlikely_if((result = ttsdkjson_endContainer(context)) != TTSDKJSON_OK) { return result; }
+    }
+    unlikely_if(isCBOR(context)) { return ttsdkjson_flushOutputBuffer(context); }
+    unlikely_if(context->containerFirstEntry) { return TTSDKJSON_OK; }
+    unlikely_if((result = addJSONData(context, "\n", 1)) != TTSDKJSON_OK) { return result; }
+    context->containerFirstEntry = true;
+    return ttsdkjson_flushOutputBuffer(context);
+}
+
+// ============================================================================
+#pragma mark - Key Dictionary -
+// ============================================================================
+
+/* A key dictionary is a perfect hash in the "hash and displace" style. Each
+ * key's hash picks a bucket (about two keys per bucket) and gives the key a
+ * starting slot and a stride. Every bucket has a displacement: how many
+ * strides its keys move along from their starting slots. The displacements
+ * are chosen when compiling so that no two keys share a slot, so a lookup is
+ * one hash, one slot and one comparison.
+ */
+
+/** How many hash seeds to try before giving up on placing a set of keys. */
+#define kKeyDictionaryMaxSeeds 32
+
+static inline uint64_t hashKey(const uint32_t seed, const char *const name, const int length)
+{
+    // FNV-1a, with the final mix from MurmurHash3 to spread it into the high bits.
+    uint64_t hash = 0xcbf29ce484222325ull ^ seed;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 0x100000001b3ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static inline uint32_t keyBucket(const TTSDKJSONKeyDictionary *const dictionary, const uint64_t hash)
+{
+    return (uint32_t)(hash >> 40) & dictionary->bucketMask;
+}
+
+static inline uint32_t keySlot(const TTSDKJSONKeyDictionary *const dictionary, const uint64_t hash,
+                               const uint32_t displacement)
+{
+    // The stride is odd, so a key can reach every slot of the power-of-two table.
+    return ((uint32_t)hash + displacement * ((uint32_t)(hash >> 32) | 1)) & dictionary->slotMask;
+}
+
+/** Try to give every key a slot of its own with the dictionary's current seed.
+ *
+ * @return true if all keys were placed.
+ */
+static bool placeKeys(TTSDKJSONKeyDictionary *const dictionary)
+{
+    const int keyCount = dictionary->keyCount;
+    const int bucketCount = (int)dictionary->bucketMask + 1;
+    uint64_t hashes[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS];
+    uint8_t bucketSizes[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS] = { 0 };
+    int maxBucketSize = 0;
+
+    memset(dictionary->displacements, 0, sizeof(dictionary->displacements));
+    memset(dictionary->slots, 0, sizeof(dictionary->slots));
+    for (int i = 0; i < keyCount; i++) {
+        hashes[i] = hashKey(dictionary->seed, dictionary->keys + dictionary->keyOffsets[i], dictionary->keyLengths[i]);
+        const int size = ++bucketSizes[keyBucket(dictionary, hashes[i])];
+        if (size > maxBucketSize) {
+            maxBucketSize = size;
+        }
+    }
+
+    // Place the fullest buckets first, while there is the most room.
+    for (int size = maxBucketSize; size > 0; size--) {
+        for (int bucket = 0; bucket < bucketCount; bucket++) {
+            if (bucketSizes[bucket] != size) {
+                continue;
+            }
+            bool isPlaced = false;
+            for (uint32_t displacement = 0; displacement <= dictionary->slotMask && !isPlaced; displacement++) {
+                isPlaced = true;
+                for (int i = 0; i < keyCount; i++) {
+                    if (keyBucket(dictionary, hashes[i]) != (uint32_t)bucket) {
+                        continue;
+                    }
+                    const uint32_t slot = keySlot(dictionary, hashes[i], displacement);
+                    if (dictionary->slots[slot] != 0) {
+                        isPlaced = false;
+                        break;
+                    }
+                    dictionary->slots[slot] = (uint8_t)(i + 1);
+                }
+                if (!isPlaced) {
+                    // Take back the keys of this bucket that were already placed.
+                    for (uint32_t slot = 0; slot <= dictionary->slotMask; slot++) {
+                        const int key = dictionary->slots[slot] - 1;
+                        if (key >= 0 && keyBucket(dictionary, hashes[key]) == (uint32_t)bucket) {
+                            dictionary->slots[slot] = 0;
+                        }
+                    }
+                } else {
+                    dictionary->displacements[bucket] = (uint8_t)displacement;
+                }
+            }
+            unlikely_if(!isPlaced) { return false; }
+        }
+    }
+    return true;
+}
+
+int ttsdkjson_compileKeyDictionary(TTSDKJSONKeyDictionary *const dictionary, const char *const *const keys,
+                                   const int keyCount)
+{
+    memset(dictionary, 0, sizeof(*dictionary));
+    unlikely_if(keyCount < 0 || keyCount > TTSDKJSON_KEY_DICTIONARY_MAX_KEYS)
+    {
+        TTSDKLOG_DEBUG("Too many keys: %d", keyCount);
+        return TTSDKJSON_ERROR_DATA_TOO_LONG;
+    }
+
+    int offset = 0;
+    for (int i = 0; i < keyCount; i++) {
+        const size_t length = strlen(keys[i]);
+        unlikely_if(length + 2 > (size_t)(TTSDKJSON_KEY_DICTIONARY_MAX_KEY_BYTES - offset))
+        {
+            TTSDKLOG_DEBUG("Keys are too long");
+            return TTSDKJSON_ERROR_DATA_TOO_LONG;
+        }
+        for (int j = 0; j < i; j++) {
+            unlikely_if(dictionary->keyLengths[j] == length &&
+                        memcmp(dictionary->keys + dictionary->keyOffsets[j], keys[i], length) == 0)
+            {
+                TTSDKLOG_DEBUG("Key \"%s\" appears more than once", keys[i]);
+                return TTSDKJSON_ERROR_INVALID_DATA;
+            }
+        }
+        // The ID goes just before the name, where ttsdkjson_keyID() finds it.
+        dictionary->keys[offset++] = (char)i;
+        dictionary->keyOffsets[i] = (uint16_t)offset;
+        dictionary->keyLengths[i] = (uint16_t)length;
+        memcpy(dictionary->keys + offset, keys[i], length + 1);
+        offset += (int)length + 1;
+    }
+    dictionary->keyCount = keyCount;
+
+    uint32_t slotCount = 8;
+    while (slotCount < (uint32_t)keyCount * 2) {
+        slotCount *= 2;
+    }
+    uint32_t bucketCount = 1;
+    while (bucketCount * 2 < (uint32_t)keyCount) {
+        bucketCount *= 2;
+    }
+    dictionary->slotMask = slotCount - 1;
+    dictionary->bucketMask = bucketCount - 1;
+
+    for (uint32_t seed = 0; seed < kKeyDictionaryMaxSeeds; seed++) {
+        dictionary->seed = seed;
+        likely_if(placeKeys(dictionary)) { return TTSDKJSON_OK; }
+    }
+    TTSDKLOG_DEBUG("Could not find a perfect hash for %d keys", keyCount);
+    return TTSDKJSON_ERROR_DATA_TOO_LONG;
+}
+
+int ttsdkjson_findKey(const TTSDKJSONKeyDictionary *const dictionary, const char *const name, const int length)
+{
+    const uint64_t hash = hashKey(dictionary->seed, name, length);
+    const uint32_t displacement = dictionary->displacements[keyBucket(dictionary, hash)];
+    const int key = dictionary->slots[keySlot(dictionary, hash, displacement)] - 1;
+    likely_if(key >= 0 && dictionary->keyLengths[key] == length &&
+              memcmp(dictionary->keys + dictionary->keyOffsets[key], name, (size_t)length) == 0)
+    {
+        return key;
+    }
+    return TTSDKJSON_KEY_UNKNOWN;
+}
+
+int ttsdkjson_keyID(const TTSDKJSONKeyDictionary *const dictionary, const char *const name)
+{
+    unlikely_if(dictionary == NULL) { return TTSDKJSON_KEY_UNKNOWN; }
+    const uintptr_t keys = (uintptr_t)dictionary->keys;
+    const uintptr_t address = (uintptr_t)name;
+    likely_if(address <= keys || address >= keys + sizeof(dictionary->keys)) { return TTSDKJSON_KEY_UNKNOWN; }
+    return (uint8_t)name[-1];
+}
+
+// ============================================================================
+#pragma mark - Decode -
+// ============================================================================
+
+#define INV 0x11111
+
+typedef struct {
+    /** Pointer to current work area in the buffer. */
+    const char *bufferPtr;
+    /** Pointer to the end of the buffer. */
+    const char *bufferEnd;
+    /** Pointer to a buffer for storing a decoded name. */
+    char *nameBuffer;
+    /** Length of the name buffer. */
+    int nameBufferLength;
+    /** Pointer to a buffer for storing a decoded string. */
+    char *stringBuffer;
+    /** Length of the string buffer. */
+    int stringBufferLength;
+    /** The callbacks to call while decoding. */
+    TTSDKJSONDecodeCallbacks *const callbacks;
+    /** Data that was specified when calling ttsdkjson_decode(). */
+    void *userData;
+} TTSDKJSONDecodeContext;
+
+/** Lookup table for converting hex values to integers.
+ * INV (0x11111) is used to mark invalid characters so that any attempted
+ * invalid nybble conversion is always > 0xffff.
+ */
+static const unsigned int g_hexConversion[] = {
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, INV, INV, INV, INV, INV, INV, INV, 0xa,
+    0xb, 0xc, 0xd, 0xe, 0xf, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+};
+
+/** Lookup table for the character that a two-character escape sequence
+ * stands for, indexed by the character after the backslash. 0 marks the
+ * ones that aren't (including 'u', which is followed by hex digits).
+ */
+static const char g_simpleEscapes[256] = {
+    ['\"'] = '\"', ['\\'] = '\\', ['/'] = '/', ['b'] = '\b', ['f'] = '\f', ['n'] = '\n', ['r'] = '\r', ['t'] = '\t',
+};
+
+/** Lookup table for converting base64 characters to their 6-bit values.
+ * INV is used to mark invalid characters, since it's always > 0x3f.
+ */
+static const unsigned int g_base64Conversion[] = {
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, 62,
+    INV, INV, INV, 63, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, INV, INV, INV, INV, INV, INV, INV, 0,
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22,
+    23, 24, 25, INV, INV, INV, INV, INV, INV, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38,
+    39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+    INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
+};
+
+/** Encode a UTF-16 character to UTF-8. The dest pointer gets incremented
+ * by however many bytes were needed for the conversion (1-4).
+ *
+ * @param character The UTF-16 character.
+ *
+ * @param dst Where to write the UTF-8 character.
+ *
+ * @return TTSDKJSON_OK if the encoding was successful.
+ */
+static int writeUTF8(unsigned int character, char **dst);
+
+/** Find the extent of a string value and step over it.
+ *
+ * @param context The decoding context, pointing at the opening quote.
+ *
+ * @param start Place to store a pointer to the string's contents.
+ *
+ * @param end Place to store a pointer to the closing quote.
+ *
+ * @param fastCopy Place to store whether the contents have no escape sequences.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int scanString(TTSDKJSONDecodeContext *context, const char **start, const char **end, bool *fastCopy);
+
+/** Copy the contents of a string value, unescaping it if needed.
+ *
+ * @param src The start of the string's contents (after the opening quote).
+ *
+ * @param srcEnd The end of the string's contents (the closing quote).
+ *
+ * @param fastCopy true if the contents have no escape sequences.
+ *
+ * @param dstBuffer Buffer to hold the decoded string.
+ *
+ * @param dstBufferLength Length of the destination buffer.
+ *
+ * @param dstLength Place to store the length of the decoded string (can be NULL).
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int copyString(const char *src, const char *srcEnd, bool fastCopy, char *dstBuffer, int dstBufferLength,
+                      int *dstLength);
+
+/** Pass a decoded string element to the callbacks.
+ *
+ * @param context The decoding context.
+ *
+ * @param name The element's name (or NULL if it has none).
+ *
+ * @param value The decoded string. It must be null terminated unless the
+ *              onStringElementSlice callback is set.
+ *
+ * @param length The length of the string.
+ *
+ * @return The callback's result.
+ */
+static int onDecodedString(TTSDKJSONDecodeContext *context, const char *name, const char *value, int length);
+
+/** Pass a string element to the callbacks, in place if possible.
+ *
+ * @param context The decoding context.
+ *
+ * @param name The element's name (or NULL if it has none).
+ *
+ * @param src The start of the string's contents.
+ *
+ * @param srcEnd The end of the string's contents.
+ *
+ * @param fastCopy true if the contents have no escape sequences.
+ *
+ * @return The callback's result, or an error if the string couldn't be decoded.
+ */
+static int onStringValue(TTSDKJSONDecodeContext *context, const char *name, const char *src, const char *srcEnd,
+                         bool fastCopy);
+
+/** Decode a JSON element.
+ *
+ * @param name This element's name (or NULL if it has none).
+ *
+ * @param context The decoding context.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeElement(const char *const name, TTSDKJSONDecodeContext *context);
+
+/** Decode a number, boolean or null element.
+ *
+ * @param name This element's name (or NULL if it has none).
+ *
+ * @param context The decoding context, pointing at the element's first character.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeScalar(const char *const name, TTSDKJSONDecodeContext *context);
+
+/** Decode a run of numbers and literals that ends at a token or whitespace.
+ * It's normally a single element, but decodeElement() would see "1true" as
+ * two, so a run in an array can hold more than one.
+ *
+ * @param name The elements' name (or NULL if they have none).
+ *
+ * @param context The decoding context, pointing at the run's first character.
+ *
+ * @param end The end of the run.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeScalarRun(const char *const name, TTSDKJSONDecodeContext *context, const char *const end);
+
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+/** Decode a whole JSON document by way of a structural index (see below).
+ * Short documents and lone scalar values go through decodeElement().
+ *
+ * @param context The decoding context.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeIndexed(TTSDKJSONDecodeContext *context);
+#endif
+
+/** Skip past any whitespace.
+ *
+ * @param CONTEXT The decoding context.
+ */
+#define SKIP_WHITESPACE(CONTEXT)                                                                     \
+    while (CONTEXT->bufferPtr < CONTEXT->bufferEnd && isspace((unsigned char)*CONTEXT->bufferPtr)) { \
+        CONTEXT->bufferPtr++;                                                                        \
+    }
+
+/** Check if a character is valid for representing part of a floating point
+ * number.
+ *
+ * @param ch The character to test.
+ *
+ * @return true if the character is valid for floating point.
+ */
+static inline bool isFPChar(char ch)
+{
+    switch (ch) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '.':
+        case 'e':
+        case 'E':
+        case '+':
+        case '-':
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Check if a character ends a number or literal.
+ *
+ * @param ch The character to test.
+ *
+ * @return true if the character is structural, a quote or whitespace.
+ */
+static inline bool isScalarDelimiter(const char ch)
+{
+    switch (ch) {
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+        case ',':
+        case ':':
+        case '\"':
+            return true;
+        default:
+            return isspace((unsigned char)ch);
+    }
+}
+
+static int writeUTF8(unsigned int character, char **dst)
+{
+    likely_if(character <= 0x7f)
+    {
+        **dst = (char)character;
+        (*dst)++;
+        return TTSDKJSON_OK;
+    }
+    if (character <= 0x7ff) {
+        (*dst)[0] = (char)(0xc0 | (character >> 6));
+        (*dst)[1] = (char)(0x80 | (character & 0x3f));
+        *dst += 2;
+        return TTSDKJSON_OK;
+    }
+    if (character <= 0xffff) {
+        (*dst)[0] = (char)(0xe0 | (character >> 12));
+        (*dst)[1] = (char)(0x80 | ((character >> 6) & 0x3f));
+        (*dst)[2] = (char)(0x80 | (character & 0x3f));
+        *dst += 3;
+        return TTSDKJSON_OK;
+    }
+    // RFC3629 restricts UTF-8 to end at 0x10ffff.
+    if (character <= 0x10ffff) {
+        (*dst)[0] = (char)(0xf0 | (character >> 18));
+        (*dst)[1] = (char)(0x80 | ((character >> 12) & 0x3f));
+        (*dst)[2] = (char)(0x80 | ((character >> 6) & 0x3f));
+        (*dst)[3] = (char)(0x80 | (character & 0x3f));
+        *dst += 4;
+        return TTSDKJSON_OK;
+    }
+
+    // If we get here, the character cannot be converted to valid UTF-8.
+    TTSDKLOG_DEBUG("Invalid unicode: 0x%04x", character);
+    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+}
+
+static int scanString(TTSDKJSONDecodeContext *context, const char **start, const char **end, bool *fastCopy)
+{
+    unlikely_if(*context->bufferPtr != '\"')
+    {
+        TTSDKLOG_DEBUG("Expected '\"' but got '%c'", *context->bufferPtr);
+        return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    }
+
+    const char *src = context->bufferPtr + 1;
+    *fastCopy = true;
+
+    for (;;) {
+        src = findEscapeCandidate(src, context->bufferEnd);
+        unlikely_if(src >= context->bufferEnd)
+        {
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        likely_if(*src == '\"') { break; }
+        // A backslash steps over the byte it escapes. A control character is
+        // left for copyString().
+        unlikely_if(*src == '\\')
+        {
+            *fastCopy = false;
+            src++;
+        }
+        src++;
+    }
+    *start = context->bufferPtr + 1;
+    *end = src;
+    context->bufferPtr = src + 1;
+    return TTSDKJSON_OK;
+}
+
+/** Convert the 4 hex digits of a unicode escape sequence.
+ *
+ * @return The UTF-16 code unit, or something > 0xffff if a digit isn't hex.
+ */
+static inline unsigned int decodeHexQuad(const char *const src)
+{
+    return g_hexConversion[(unsigned char)src[0]] << 12 | g_hexConversion[(unsigned char)src[1]] << 8 |
+           g_hexConversion[(unsigned char)src[2]] << 4 | g_hexConversion[(unsigned char)src[3]];
+}
+
+/** Decode a unicode escape sequence, or a surrogate pair of them, to UTF-8.
+ *
+ * @param src The backslash. Moved past the sequence (or pair).
+ *
+ * @param srcEnd The end of the string's contents.
+ *
+ * @param dst Where to write the UTF-8 bytes. Moved past them.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int unescapeUnicode(const char **const src, const char *const srcEnd, char **const dst)
+{
+    const char *const sequence = *src;
+    unlikely_if(srcEnd - sequence < 6)
+    {
+        TTSDKLOG_DEBUG("Premature end of data");
+        return TTSDKJSON_ERROR_INCOMPLETE;
+    }
+    const unsigned int character = decodeHexQuad(sequence + 2);
+    *src = sequence + 6;
+    unlikely_if(character > 0xffff)
+    {
+        TTSDKLOG_DEBUG("Invalid unicode sequence: %c%c%c%c", sequence[2], sequence[3], sequence[4], sequence[5]);
+        return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    }
+    likely_if(character - 0xd800 > 0x7ff) { return writeUTF8(character, dst); }
+
+    unlikely_if(character >= 0xdc00)
+    {
+        TTSDKLOG_DEBUG("Unexpected trail surrogate: 0x%04x", character);
+        return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    }
+    unlikely_if(srcEnd - *src < 6)
+    {
+        TTSDKLOG_DEBUG("Premature end of data");
+        return TTSDKJSON_ERROR_INCOMPLETE;
+    }
+    unlikely_if(sequence[6] != '\\' || sequence[7] != 'u')
+    {
+        TTSDKLOG_DEBUG("Expected \"\\u\" but got: \"%c%c\"", sequence[6], sequence[7]);
+        return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    }
+    const unsigned int trail = decodeHexQuad(sequence + 8);
+    unlikely_if(trail - 0xdc00 > 0x3ff)
+    {
+        TTSDKLOG_DEBUG("Invalid trail surrogate: 0x%04x", trail);
+        return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    }
+    *src = sequence + 12;
+
+    // A pair is always outside the BMP, so it's always 4 bytes of UTF-8.
+    const unsigned int codePoint = 0x10000 + ((character - 0xd800) << 10) + (trail - 0xdc00);
+    char *const out = *dst;
+    out[0] = (char)(0xf0 | (codePoint >> 18));
+    out[1] = (char)(0x80 | ((codePoint >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((codePoint >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (codePoint & 0x3f));
+    *dst = out + 4;
+    return TTSDKJSON_OK;
+}
+
+static int copyString(const char *src, const char *const srcEnd, const bool fastCopy, char *const dstBuffer,
+                      const int dstBufferLength, int *const dstLength)
+{
+    int length = (int)(srcEnd - src);
+    if (length >= dstBufferLength) {
+        TTSDKLOG_DEBUG("String is too long");
+        return TTSDKJSON_ERROR_DATA_TOO_LONG;
+    }
+
+    // If no escape characters were encountered, we can fast copy.
+    likely_if(fastCopy)
+    {
+        memcpy(dstBuffer, src, length);
+        dstBuffer[length] = 0;
+        likely_if(dstLength != NULL) { *dstLength = length; }
+        return TTSDKJSON_OK;
+    }
+
+    char *dst = dstBuffer;
+
+    for (;;) {
+        // Move everything up to the next escape sequence in one go. Control
+        // characters are passed through, so they don't end the run.
+        const char *escape = findEscapeCandidate(src, srcEnd);
+        while (escape < srcEnd && *escape != '\\') {
+            escape = findEscapeCandidate(escape + 1, srcEnd);
+        }
+        // The push decoder unescapes in place, so the run can overlap where it goes.
+        memmove(dst, src, (size_t)(escape - src));
+        dst += escape - src;
+        src = escape;
+        unlikely_if(src >= srcEnd) { break; }
+
+        unlikely_if(src + 1 >= srcEnd)
+        {
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        const char unescaped = g_simpleEscapes[(unsigned char)src[1]];
+        likely_if(unescaped != 0)
+        {
+            *dst++ = unescaped;
+            src += 2;
+            continue;
+        }
+        unlikely_if(src[1] != 'u')
+        {
+            TTSDKLOG_DEBUG("Invalid control character '%c'", src[1]);
+            return TTSDKJSON_ERROR_INVALID_CHARACTER;
+        }
+        const int result = unescapeUnicode(&src, srcEnd, &dst);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+    }
+
+    *dst = 0;
+    likely_if(dstLength != NULL) { *dstLength = (int)(dst - dstBuffer); }
+    return TTSDKJSON_OK;
+}
+
+static int onDecodedString(TTSDKJSONDecodeContext *context, const char *const name, const char *const value,
+                           const int length)
+{
+    const TTSDKJSONDecodeCallbacks *const callbacks = context->callbacks;
+    likely_if(callbacks->onStringElementSlice == NULL)
+    {
+        return callbacks->onStringElement(name, value, context->userData);
+    }
+    const int nameLength = name != NULL ? (int)strlen(name) : 0;
+    return callbacks->onStringElementSlice(name, nameLength, value, length, context->userData);
+}
+
+static int onStringValue(TTSDKJSONDecodeContext *context, const char *const name, const char *const src,
+                         const char *const srcEnd, const bool fastCopy)
+{
+    likely_if(fastCopy && context->callbacks->onStringElementSlice != NULL)
+    {
+        return onDecodedString(context, name, src, (int)(srcEnd - src));
+    }
+    int length;
+    int result = copyString(src, srcEnd, fastCopy, context->stringBuffer, context->stringBufferLength, &length);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    return onDecodedString(context, name, context->stringBuffer, length);
+}
+
+/** Get the name to pass to the callbacks for a decoded member name: the key
+ * dictionary's copy if it's one of its keys, or else the name itself.
+ */
+static inline const char *internName(const TTSDKJSONDecodeContext *const context, const char *const name,
+                                     const int length)
+{
+    const TTSDKJSONKeyDictionary *const dictionary = context->callbacks->keyDictionary;
+    likely_if(dictionary == NULL) { return name; }
+    const int key = ttsdkjson_findKey(dictionary, name, length);
+    return key == TTSDKJSON_KEY_UNKNOWN ? name : dictionary->keys + dictionary->keyOffsets[key];
+}
+
+/** Decode a member name into the name buffer, unless it's a key dictionary
+ * key without escape sequences, which is looked up in place instead.
+ *
+ * @param context The decoding context.
+ *
+ * @param src The start of the name (after the opening quote).
+ *
+ * @param srcEnd The end of the name (the closing quote).
+ *
+ * @param fastCopy true if the name has no escape sequences.
+ *
+ * @param name Place to store the name to pass to the callbacks.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeMemberName(TTSDKJSONDecodeContext *const context, const char *const src, const char *const srcEnd,
+                            const bool fastCopy, const char **const name)
+{
+    const TTSDKJSONKeyDictionary *const dictionary = context->callbacks->keyDictionary;
+    *name = context->nameBuffer;
+    unlikely_if(dictionary != NULL && fastCopy)
+    {
+        const int key = ttsdkjson_findKey(dictionary, src, (int)(srcEnd - src));
+        likely_if(key != TTSDKJSON_KEY_UNKNOWN)
+        {
+            *name = dictionary->keys + dictionary->keyOffsets[key];
+            return TTSDKJSON_OK;
+        }
+    }
+    int length;
+    const int result = copyString(src, srcEnd, fastCopy, context->nameBuffer, context->nameBufferLength, &length);
+    unlikely_if(result != TTSDKJSON_OK || fastCopy) { return result; }
+    *name = internName(context, context->nameBuffer, length);
+    return TTSDKJSON_OK;
+}
+
+static int decodeElement(const char *const name, TTSDKJSONDecodeContext *context)
+{
+    SKIP_WHITESPACE(context);
+    unlikely_if(context->bufferPtr >= context->bufferEnd)
+    {
+        TTSDKLOG_DEBUG("Premature end of data");
+        return TTSDKJSON_ERROR_INCOMPLETE;
+    }
+
+    int result;
+
+    switch (*context->bufferPtr) {
+        case '[': {
+            context->bufferPtr++;
+            result = context->callbacks->onBeginArray(name, context->userData);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            while (context->bufferPtr < context->bufferEnd) {
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                unlikely_if(*context->bufferPtr == ']')
+                {
+                    context->bufferPtr++;
+                    return context->callbacks->onEndContainer(context->userData);
+                }
+                result = decodeElement(NULL, context);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                likely_if(*context->bufferPtr == ',') { context->bufferPtr++; }
+            }
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        case '{': {
+            context->bufferPtr++;
+            result = context->callbacks->onBeginObject(name, context->userData);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            while (context->bufferPtr < context->bufferEnd) {
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                unlikely_if(*context->bufferPtr == '}')
+                {
+                    context->bufferPtr++;
+                    return context->callbacks->onEndContainer(context->userData);
+                }
+                const char *src;
+                const char *srcEnd;
+                bool fastCopy;
+                result = scanString(context, &src, &srcEnd, &fastCopy);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                const char *memberName;
+                result = decodeMemberName(context, src, srcEnd, fastCopy, &memberName);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                unlikely_if(*context->bufferPtr != ':')
+                {
+                    TTSDKLOG_DEBUG("Expected ':' but got '%c'", *context->bufferPtr);
+                    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+                }
+                context->bufferPtr++;
+                SKIP_WHITESPACE(context);
+                result = decodeElement(memberName, context);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                likely_if(*context->bufferPtr == ',') { context->bufferPtr++; }
+            }
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        case '\"': {
+            const char *src;
+            const char *srcEnd;
+            bool fastCopy;
+            result = scanString(context, &src, &srcEnd, &fastCopy);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            return onStringValue(context, name, src, srcEnd, fastCopy);
+        }
+        default:
+            return decodeScalar(name, context);
+    }
+}
+
+static int decodeScalar(const char *const name, TTSDKJSONDecodeContext *context)
+{
+    switch (*context->bufferPtr) {
+        case 'f': {
+            unlikely_if(context->bufferEnd - context->bufferPtr < 5)
+            {
+                TTSDKLOG_DEBUG("Premature end of data");
+                return TTSDKJSON_ERROR_INCOMPLETE;
+            }
+            unlikely_if(!(context->bufferPtr[1] == 'a' && context->bufferPtr[2] == 'l' &&
+                          context->bufferPtr[3] == 's' && context->bufferPtr[4] == 'e'))
+            {
+                TTSDKLOG_DEBUG("Expected \"false\" but got \"f%c%c%c%c\"", context->bufferPtr[1], context->bufferPtr[2],
+                            context->bufferPtr[3], context->bufferPtr[4]);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            }
+            context->bufferPtr += 5;
+            return context->callbacks->onBooleanElement(name, false, context->userData);
+        }
+        case 't': {
+            unlikely_if(context->bufferEnd - context->bufferPtr < 4)
+            {
+                TTSDKLOG_DEBUG("Premature end of data");
+                return TTSDKJSON_ERROR_INCOMPLETE;
+            }
+            unlikely_if(!(context->bufferPtr[1] == 'r' && context->bufferPtr[2] == 'u' && context->bufferPtr[3] == 'e'))
+            {
+                TTSDKLOG_DEBUG("Expected \"true\" but got \"t%c%c%c\"", context->bufferPtr[1], context->bufferPtr[2],
+                            context->bufferPtr[3]);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            }
+            context->bufferPtr += 4;
+            return context->callbacks->onBooleanElement(name, true, context->userData);
+        }
+        case 'n': {
+            unlikely_if(context->bufferEnd - context->bufferPtr < 4)
+            {
+                TTSDKLOG_DEBUG("Premature end of data");
+                return TTSDKJSON_ERROR_INCOMPLETE;
+            }
+            unlikely_if(!(context->bufferPtr[1] == 'u' && context->bufferPtr[2] == 'l' && context->bufferPtr[3] == 'l'))
+            {
+                TTSDKLOG_DEBUG("Expected \"null\" but got \"n%c%c%c\"", context->bufferPtr[1], context->bufferPtr[2],
+                            context->bufferPtr[3]);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            }
+            context->bufferPtr += 4;
+            return context->callbacks->onNullElement(name, context->userData);
+        }
+        case '-':
+            unlikely_if(context->bufferEnd - context->bufferPtr < 2)
+            {
+                TTSDKLOG_DEBUG("Premature end of data");
+                return TTSDKJSON_ERROR_INCOMPLETE;
+            }
+            unlikely_if(!isdigit(context->bufferPtr[1]))
+            {
+                TTSDKLOG_DEBUG("Not a digit: '%c'", context->bufferPtr[1]);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            }
+            // Fall through
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9': {
+            TTSDKNumber number;
+            const char *const start = context->bufferPtr;
+            context->bufferPtr = ttsdknum_parse(start, context->bufferEnd, &number);
+
+            // The number could carry on past the end of the data.
+            unlikely_if(context->bufferPtr >= context->bufferEnd)
+            {
+                TTSDKLOG_DEBUG("Premature end of data");
+                return TTSDKJSON_ERROR_INCOMPLETE;
+            }
+
+            likely_if(number.type != TTSDKNumberTypeDouble && !isFPChar(*context->bufferPtr))
+            {
+                likely_if(number.type == TTSDKNumberTypeInt64)
+                {
+                    return context->callbacks->onIntegerElement(name, number.int64Value, context->userData);
+                }
+                // Positive number exceeding int64_t range, use unsigned
+                return context->callbacks->onUnsignedIntegerElement(name, number.uint64Value, context->userData);
+            }
+
+            double value = number.doubleValue;
+            if (number.type == TTSDKNumberTypeInt64) {
+                // Keep the sign of "-0".
+                value = *start == '-' ? -(double)((uint64_t)0 - (uint64_t)number.int64Value)
+                                      : (double)number.int64Value;
+            } else if (number.type == TTSDKNumberTypeUInt64) {
+                value = (double)number.uint64Value;
+            }
+
+            // Skip whatever is left of a number that ended early, as in "1.2.3" or "1e".
+            while (context->bufferPtr < context->bufferEnd && isFPChar(*context->bufferPtr)) {
+                context->bufferPtr++;
+            }
+
+            unlikely_if(context->bufferPtr >= context->bufferEnd)
+            {
+                TTSDKLOG_DEBUG("Premature end of data");
+                return TTSDKJSON_ERROR_INCOMPLETE;
+            }
+
+            return context->callbacks->onFloatingPointElement(name, value, context->userData);
+        }
+    }
+    TTSDKLOG_DEBUG("Invalid character '%c'", *context->bufferPtr);
+    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+}
+
+static int decodeScalarRun(const char *const name, TTSDKJSONDecodeContext *context, const char *const end)
+{
+    for (;;) {
+        int result = decodeScalar(name, context);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        SKIP_WHITESPACE(context);
+        likely_if(context->bufferPtr >= end) { return TTSDKJSON_OK; }
+        // Whatever is left over (as in "1true") is another element to
+        // decodeElement(), which is only allowed in an array.
+        unlikely_if(name != NULL)
+        {
+            TTSDKLOG_DEBUG("Expected '\"' but got '%c'", *context->bufferPtr);
+            return TTSDKJSON_ERROR_INVALID_CHARACTER;
+        }
+    }
+}
+
+/** Set up a context for decoding a whole document, giving 1/4 of the string buffer to names. */
+static inline TTSDKJSONDecodeContext newDecodeContext(const char *const data, const int length,
+                                                      char *const stringBuffer, const int stringBufferLength,
+                                                      TTSDKJSONDecodeCallbacks *const callbacks, void *const userData)
+{
+    const int nameBufferLength = stringBufferLength / 4;
+    return (TTSDKJSONDecodeContext) { .bufferPtr = data,
+                                      .bufferEnd = data + length,
+                                      .nameBuffer = stringBuffer,
+                                      .nameBufferLength = nameBufferLength,
+                                      .stringBuffer = stringBuffer + nameBufferLength,
+                                      .stringBufferLength = stringBufferLength - nameBufferLength,
+                                      .callbacks = callbacks,
+                                      .userData = userData };
+}
+
+int ttsdkjson_decode(const char *const data, int length, char *stringBuffer, int stringBufferLength,
+                  TTSDKJSONDecodeCallbacks *const callbacks, void *const userData, int *const errorOffset)
+{
+    TTSDKJSONDecodeContext context =
+        newDecodeContext(data, length, stringBuffer, stringBufferLength, callbacks, userData);
+
+    const char *ptr = data;
+
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+    int result = decodeIndexed(&context);
+#else
+    int result = decodeElement(NULL, &context);
+#endif
+    likely_if(result == TTSDKJSON_OK) { result = callbacks->onEndData(userData); }
+
+    unlikely_if(result != TTSDKJSON_OK && errorOffset != NULL) { *errorOffset = (int)(ptr - data); }
+    return result;
+}
+
+int ttsdkjson_decodeDataElement(const char *const string, const int length, const TTSDKJSONDataEncoding encoding,
+                                char *const dst, int *const dstLength)
+{
+    const unsigned char *src = (const unsigned char *)string;
+    const unsigned char *const srcEnd = src + length;
+    unsigned char *out = (unsigned char *)dst;
+
+    if (encoding == TTSDKJSONDataEncodingHex) {
+        unlikely_if(length % 2 != 0) { return TTSDKJSON_ERROR_INVALID_CHARACTER; }
+        unlikely_if(length / 2 > *dstLength) { return TTSDKJSON_ERROR_DATA_TOO_LONG; }
+        for (; src < srcEnd; src += 2) {
+            const unsigned int value = g_hexConversion[src[0]] << 4 | g_hexConversion[src[1]];
+            unlikely_if(value > 0xff) { return TTSDKJSON_ERROR_INVALID_CHARACTER; }
+            *out++ = (unsigned char)value;
+        }
+        *dstLength = (int)(out - (unsigned char *)dst);
+        return TTSDKJSON_OK;
+    }
+
+    unlikely_if(length % 4 != 0) { return TTSDKJSON_ERROR_INVALID_CHARACTER; }
+    const int padding = length == 0 ? 0 : (srcEnd[-1] == '=') + (srcEnd[-2] == '=');
+    unlikely_if(length / 4 * 3 - padding > *dstLength) { return TTSDKJSON_ERROR_DATA_TOO_LONG; }
+    for (; src < srcEnd; src += 4) {
+        const bool isLast = src + 4 == srcEnd;
+        const unsigned int c0 = g_base64Conversion[src[0]];
+        const unsigned int c1 = g_base64Conversion[src[1]];
+        const unsigned int c2 = isLast && padding == 2 ? 0 : g_base64Conversion[src[2]];
+        const unsigned int c3 = isLast && padding > 0 ? 0 : g_base64Conversion[src[3]];
+        unlikely_if((c0 | c1 | c2 | c3) > 0x3f) { return TTSDKJSON_ERROR_INVALID_CHARACTER; }
+        const unsigned int group = c0 << 18 | c1 << 12 | c2 << 6 | c3;
+        *out++ = (unsigned char)(group >> 16);
+        likely_if(!isLast || padding < 2) { *out++ = (unsigned char)(group >> 8); }
+        likely_if(!isLast || padding < 1) { *out++ = (unsigned char)group; }
+    }
+    *dstLength = (int)(out - (unsigned char *)dst);
+    return TTSDKJSON_OK;
+}
+
+// ============================================================================
+#pragma mark - Structural Index -
+// ============================================================================
+
+/* Decoding in two stages, after simdjson: stage 1 classifies 64 bytes at a
+ * time with vector compares and records where every token starts (brackets,
+ * braces, colons, commas, both quotes of every string, and the first byte of
+ * every number or literal). Stage 2 walks those positions instead of the
+ * bytes, so whitespace and string contents are never looked at one by one.
+ *
+ * The index is filled a window at a time so that it lives on the stack.
+ */
+
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+
+/** How many token positions the index holds at a time. */
+#define kStructuralIndexCapacity 512
+
+/** Documents shorter than this are decoded byte by byte. */
+#define kStructuralIndexMinLength 64
+
+/** Bytes classified per step. */
+#define kStructuralBlockSize 64
+
+typedef struct {
+    /** The start of the document. Positions are relative to this. */
+    const char *data;
+    /** The next block to index. */
+    const char *scanPtr;
+    /** The end of the document. */
+    const char *end;
+    /** All ones if the last block ended inside a string. */
+    uint64_t isInString;
+    /** 1 if the first byte of the next block is escaped by a backslash. */
+    uint64_t isEscaped;
+    /** 1 if the last block ended in the middle of a number or literal. */
+    uint64_t isInScalar;
+    /** Number of positions in the window. */
+    int count;
+    /** The next position to hand out. */
+    int next;
+    uint32_t positions[kStructuralIndexCapacity];
+} StructuralIndex;
+
+/** Bitmasks of the interesting characters in a block, one bit per byte. */
+typedef struct {
+    uint64_t quotes;
+    uint64_t backslashes;
+    uint64_t operators;
+    uint64_t whitespace;
+} BlockMasks;
+
+/** Bitmasks of the characters that matter when skipping over a block. */
+typedef struct {
+    uint64_t quotes;
+    uint64_t backslashes;
+    /** '[' and '{'. */
+    uint64_t opens;
+    /** ']' and '}'. */
+    uint64_t closes;
+} BracketMasks;
+
+#if TTSDKJSONCODEC_SSE2
+static inline uint64_t movemask128(const __m128i hits, const int shift)
+{
+    return (uint64_t)(uint32_t)_mm_movemask_epi8(hits) << shift;
+}
+
+static inline void classifyBlock(const char *const block, BlockMasks *const masks)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    // '[' | 0x20 == '{' and ']' | 0x20 == '}'.
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    // '\t' to '\r' are the other characters isspace() accepts.
+    const __m128i controlSpaceRange = _mm_set1_epi8('\r' - '\t');
+
+    *masks = (BlockMasks) { 0 };
+    for (int i = 0; i < kStructuralBlockSize / 16; i++) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *)(const void *)(block + i * 16));
+        const __m128i folded = _mm_or_si128(chunk, caseBit);
+        const __m128i operators =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+                         _mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)));
+        const __m128i fromTab = _mm_sub_epi8(chunk, tab);
+        const __m128i whitespace = _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                                _mm_cmpeq_epi8(_mm_min_epu8(fromTab, controlSpaceRange), fromTab));
+        masks->quotes |= movemask128(_mm_cmpeq_epi8(chunk, quote), i * 16);
+        masks->backslashes |= movemask128(_mm_cmpeq_epi8(chunk, backslash), i * 16);
+        masks->operators |= movemask128(operators, i * 16);
+        masks->whitespace |= movemask128(whitespace, i * 16);
+    }
+}
+
+static inline void classifyBrackets(const char *const block, BracketMasks *const masks)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+
+    *masks = (BracketMasks) { 0 };
+    for (int i = 0; i < kStructuralBlockSize / 16; i++) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i *)(const void *)(block + i * 16));
+        const __m128i folded = _mm_or_si128(chunk, caseBit);
+        masks->quotes |= movemask128(_mm_cmpeq_epi8(chunk, quote), i * 16);
+        masks->backslashes |= movemask128(_mm_cmpeq_epi8(chunk, backslash), i * 16);
+        masks->opens |= movemask128(_mm_cmpeq_epi8(folded, openBrace), i * 16);
+        masks->closes |= movemask128(_mm_cmpeq_epi8(folded, closeBrace), i * 16);
+    }
+}
+#endif
+#if TTSDKJSONCODEC_NEON
+/** Collapse four comparison results (0xff or 0 per byte) into one bit per byte. */
+static inline uint64_t movemask64(const uint8x16_t hits0, const uint8x16_t hits1, const uint8x16_t hits2,
+                                  const uint8x16_t hits3)
+{
+    const uint8x16_t bits = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(hits0, bits), vandq_u8(hits1, bits));
+    const uint8x16_t sum1 = vpaddq_u8(vandq_u8(hits2, bits), vandq_u8(hits3, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+static inline void classifyBlock(const char *const block, BlockMasks *const masks)
+{
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t colon = vdupq_n_u8(':');
+    const uint8x16_t comma = vdupq_n_u8(',');
+    // '[' | 0x20 == '{' and ']' | 0x20 == '}'.
+    const uint8x16_t caseBit = vdupq_n_u8(0x20);
+    const uint8x16_t openBrace = vdupq_n_u8('{');
+    const uint8x16_t closeBrace = vdupq_n_u8('}');
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    // '\t' to '\r' are the other characters isspace() accepts.
+    const uint8x16_t controlSpaceRange = vdupq_n_u8('\r' - '\t');
+
+    uint8x16_t quotes[4];
+    uint8x16_t backslashes[4];
+    uint8x16_t operators[4];
+    uint8x16_t whitespace[4];
+    for (int i = 0; i < 4; i++) {
+        const uint8x16_t chunk = vld1q_u8((const uint8_t *)block + i * 16);
+        const uint8x16_t folded = vorrq_u8(chunk, caseBit);
+        quotes[i] = vceqq_u8(chunk, quote);
+        backslashes[i] = vceqq_u8(chunk, backslash);
+        operators[i] = vorrq_u8(vorrq_u8(vceqq_u8(folded, openBrace), vceqq_u8(folded, closeBrace)),
+                                vorrq_u8(vceqq_u8(chunk, colon), vceqq_u8(chunk, comma)));
+        whitespace[i] =
+            vorrq_u8(vceqq_u8(chunk, space), vcleq_u8(vsubq_u8(chunk, tab), controlSpaceRange));
+    }
+    masks->quotes = movemask64(quotes[0], quotes[1], quotes[2], quotes[3]);
+    masks->backslashes = movemask64(backslashes[0], backslashes[1], backslashes[2], backslashes[3]);
+    masks->operators = movemask64(operators[0], operators[1], operators[2], operators[3]);
+    masks->whitespace = movemask64(whitespace[0], whitespace[1], whitespace[2], whitespace[3]);
+}
+
+static inline void classifyBrackets(const char *const block, BracketMasks *const masks)
+{
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t caseBit = vdupq_n_u8(0x20);
+    const uint8x16_t openBrace = vdupq_n_u8('{');
+    const uint8x16_t closeBrace = vdupq_n_u8('}');
+
+    uint8x16_t quotes[4];
+    uint8x16_t backslashes[4];
+    uint8x16_t opens[4];
+    uint8x16_t closes[4];
+    for (int i = 0; i < 4; i++) {
+        const uint8x16_t chunk = vld1q_u8((const uint8_t *)block + i * 16);
+        const uint8x16_t folded = vorrq_u8(chunk, caseBit);
+        quotes[i] = vceqq_u8(chunk, quote);
+        backslashes[i] = vceqq_u8(chunk, backslash);
+        opens[i] = vceqq_u8(folded, openBrace);
+        closes[i] = vceqq_u8(folded, closeBrace);
+    }
+    masks->quotes = movemask64(quotes[0], quotes[1], quotes[2], quotes[3]);
+    masks->backslashes = movemask64(backslashes[0], backslashes[1], backslashes[2], backslashes[3]);
+    masks->opens = movemask64(opens[0], opens[1], opens[2], opens[3]);
+    masks->closes = movemask64(closes[0], closes[1], closes[2], closes[3]);
+}
+#endif
+
+/** Find the bytes that are escaped by a backslash: the byte after every odd
+ * length run of backslashes.
+ *
+ * @param backslashes The block's backslashes.
+ *
+ * @param isEscaped In: 1 if the first byte is escaped. Out: the same for the next block.
+ *
+ * @return The escaped bytes.
+ */
+static inline uint64_t findEscapedBytes(const uint64_t backslashes, uint64_t *const isEscaped)
+{
+    likely_if(backslashes == 0)
+    {
+        const uint64_t escaped = *isEscaped;
+        *isEscaped = 0;
+        return escaped;
+    }
+    const uint64_t oddBits = 0xaaaaaaaaaaaaaaaaull;
+    // A backslash that is itself escaped can't start an escape.
+    const uint64_t potentialEscapes = backslashes & ~*isEscaped;
+    // Adding a run's first bit carries through the run, leaving a 1 just past it.
+    // Against the odd bit positions, that tells whether the run was odd or even.
+    const uint64_t escapeAndTerminalCode = (((potentialEscapes << 1) | oddBits) - potentialEscapes) ^ oddBits;
+    const uint64_t escaped = escapeAndTerminalCode ^ (backslashes | *isEscaped);
+    *isEscaped = (escapeAndTerminalCode & backslashes) >> 63;
+    return escaped;
+}
+
+/** Turn every bit into the parity of itself and all lower bits, so that the
+ * bits between a pair of quotes end up set.
+ */
+static inline uint64_t prefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/** Index one block of the document.
+ *
+ * @param index The index, with room for at least kStructuralBlockSize positions.
+ *
+ * @param block The block's bytes.
+ *
+ * @param offset The block's offset in the document.
+ */
+static inline void indexBlock(StructuralIndex *const index, const char *const block, const uint32_t offset)
+{
+    BlockMasks masks;
+    classifyBlock(block, &masks);
+
+    const uint64_t quotes = masks.quotes & ~findEscapedBytes(masks.backslashes, &index->isEscaped);
+    // Set from each opening quote up to (not including) its closing quote.
+    const uint64_t inString = prefixXor(quotes) ^ index->isInString;
+    index->isInString = (uint64_t)((int64_t)inString >> 63);
+
+    const uint64_t scalars = ~(masks.whitespace | masks.operators | quotes | inString);
+    const uint64_t scalarStarts = scalars & ~((scalars << 1) | index->isInScalar);
+    index->isInScalar = scalars >> 63;
+
+    uint64_t tokens = (masks.operators & ~inString) | quotes | scalarStarts;
+    uint32_t *positions = index->positions + index->count;
+    while (tokens != 0) {
+        *positions++ = offset + (uint32_t)__builtin_ctzll(tokens);
+        tokens &= tokens - 1;
+    }
+    index->count = (int)(positions - index->positions);
+}
+
+/** Index as much of the rest of the document as will fit.
+ *
+ * @param index The index. All of its positions must have been used.
+ *
+ * @return true if there are any new positions.
+ */
+static bool refillStructuralIndex(StructuralIndex *const index)
+{
+    index->count = 0;
+    index->next = 0;
+    while (index->scanPtr < index->end && index->count <= kStructuralIndexCapacity - kStructuralBlockSize) {
+        const uint32_t offset = (uint32_t)(index->scanPtr - index->data);
+        likely_if(index->end - index->scanPtr >= kStructuralBlockSize) { indexBlock(index, index->scanPtr, offset); }
+        else
+        {
+            // Pad the last partial block with whitespace.
+            char block[kStructuralBlockSize];
+            const size_t length = (size_t)(index->end - index->scanPtr);
+            memcpy(block, index->scanPtr, length);
+            memset(block + length, ' ', sizeof(block) - length);
+            indexBlock(index, block, offset);
+        }
+        index->scanPtr += kStructuralBlockSize;
+    }
+    return index->count > 0;
+}
+
+/** Get the next token without consuming it.
+ *
+ * @return A pointer to the token, or NULL at the end of the document.
+ */
+static inline const char *peekToken(StructuralIndex *const index)
+{
+    unlikely_if(index->next == index->count && !refillStructuralIndex(index)) { return NULL; }
+    return index->data + index->positions[index->next];
+}
+
+/** Get and consume the next token.
+ *
+ * @return A pointer to the token, or NULL at the end of the document.
+ */
+static inline const char *nextToken(StructuralIndex *const index)
+{
+    const char *const token = peekToken(index);
+    likely_if(token != NULL) { index->next++; }
+    return token;
+}
+
+/** Find the extent of a string whose opening quote was just consumed from the index.
+ *
+ * @param index The index. The string's closing quote is its next token.
+ *
+ * @param quote The opening quote.
+ *
+ * @param end Place to store a pointer to the closing quote.
+ *
+ * @param fastCopy Place to store whether the contents have no escape sequences.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static inline int scanIndexedString(StructuralIndex *const index, const char *const quote, const char **const end,
+                                    bool *const fastCopy)
+{
+    const char *const closingQuote = nextToken(index);
+    unlikely_if(closingQuote == NULL)
+    {
+        TTSDKLOG_DEBUG("Premature end of data");
+        return TTSDKJSON_ERROR_INCOMPLETE;
+    }
+    *end = closingQuote;
+    *fastCopy = memchr(quote + 1, '\\', (size_t)(closingQuote - quote - 1)) == NULL;
+    return TTSDKJSON_OK;
+}
+
+/** Decode a JSON element inside a container, the way decodeElement() does.
+ *
+ * @param name This element's name (or NULL if it has none).
+ *
+ * @param context The decoding context.
+ *
+ * @param index The index, with the element as its next token.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeIndexedElement(const char *const name, TTSDKJSONDecodeContext *const context,
+                                StructuralIndex *const index)
+{
+    const char *token = nextToken(index);
+    unlikely_if(token == NULL)
+    {
+        TTSDKLOG_DEBUG("Premature end of data");
+        return TTSDKJSON_ERROR_INCOMPLETE;
+    }
+
+    int result;
+
+    switch (*token) {
+        case '[': {
+            result = context->callbacks->onBeginArray(name, context->userData);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            while ((token = peekToken(index)) != NULL) {
+                unlikely_if(*token == ']')
+                {
+                    index->next++;
+                    return context->callbacks->onEndContainer(context->userData);
+                }
+                result = decodeIndexedElement(NULL, context, index);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                token = peekToken(index);
+                likely_if(token != NULL && *token == ',') { index->next++; }
+            }
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        case '{': {
+            result = context->callbacks->onBeginObject(name, context->userData);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            while ((token = nextToken(index)) != NULL) {
+                unlikely_if(*token == '}') { return context->callbacks->onEndContainer(context->userData); }
+                unlikely_if(*token != '\"')
+                {
+                    TTSDKLOG_DEBUG("Expected '\"' but got '%c'", *token);
+                    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+                }
+                const char *nameEnd;
+                bool fastCopy;
+                result = scanIndexedString(index, token, &nameEnd, &fastCopy);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                const char *memberName;
+                result = decodeMemberName(context, token + 1, nameEnd, fastCopy, &memberName);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                token = nextToken(index);
+                unlikely_if(token == NULL) { break; }
+                unlikely_if(*token != ':')
+                {
+                    TTSDKLOG_DEBUG("Expected ':' but got '%c'", *token);
+                    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+                }
+                result = decodeIndexedElement(memberName, context, index);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                token = peekToken(index);
+                likely_if(token != NULL && *token == ',') { index->next++; }
+            }
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        case '\"': {
+            const char *end;
+            bool fastCopy;
+            result = scanIndexedString(index, token, &end, &fastCopy);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            return onStringValue(context, name, token + 1, end, fastCopy);
+        }
+        default: {
+            const char *const next = peekToken(index);
+            context->bufferPtr = token;
+            return decodeScalarRun(name, context, next != NULL ? next : context->bufferEnd);
+        }
+    }
+}
+
+static int decodeIndexed(TTSDKJSONDecodeContext *context)
+{
+    unlikely_if(context->bufferEnd - context->bufferPtr < kStructuralIndexMinLength)
+    {
+        return decodeElement(NULL, context);
+    }
+
+    StructuralIndex index = {
+        .data = context->bufferPtr,
+        .scanPtr = context->bufferPtr,
+        .end = context->bufferEnd,
+    };
+    const char *const token = peekToken(&index);
+    unlikely_if(token == NULL || (*token != '{' && *token != '[')) { return decodeElement(NULL, context); }
+    return decodeIndexedElement(NULL, context, &index);
+}
+
+#endif  // TTSDKJSONCODEC_STRUCTURAL_INDEX
+
+// ============================================================================
+#pragma mark - Selective Decode -
+// ============================================================================
+
+/* A path filter is a trie of path segments whose root node stands for the
+ * top-level element. While decoding, each open container carries the set of
+ * nodes that it matches as a bitmask (wildcards can make it match more than
+ * one). A member or element that matches a node where a path ends is decoded
+ * in full, one that matches only nodes partway along a path is walked into,
+ * and anything else is stepped over by matching brackets and quotes, without
+ * unescaping strings, converting numbers or calling back.
+ */
+
+#define kPathFilterRoot 0
+
+/** Find or add the node for a path segment.
+ *
+ * @param filter The filter.
+ *
+ * @param parent The node for the segment before it.
+ *
+ * @param kind The filter's set of nodes of this kind.
+ *
+ * @param key The member name (NULL if the segment isn't a named member).
+ *
+ * @param keyLength The length of the member name.
+ *
+ * @param arrayIndex The array index (0 if the segment isn't an indexed element).
+ *
+ * @return The node, or -1 if the filter is full.
+ */
+static int addPathNode(TTSDKJSONPathFilter *const filter, const int parent, uint64_t *const kind,
+                       const char *const key, const int keyLength, const int32_t arrayIndex)
+{
+    // Paths that begin the same way share nodes.
+    for (uint64_t siblings = filter->children[parent] & *kind; siblings != 0; siblings &= siblings - 1) {
+        const int node = __builtin_ctzll(siblings);
+        if (key == NULL ? filter->values[node] == arrayIndex
+                        : filter->keyLengths[node] == keyLength &&
+                              memcmp(filter->keys + filter->values[node], key, (size_t)keyLength) == 0) {
+            return node;
+        }
+    }
+
+    unlikely_if(filter->nodeCount > TTSDKJSON_PATH_FILTER_MAX_SEGMENTS) { return -1; }
+    unlikely_if(filter->keysLength + keyLength > TTSDKJSON_PATH_FILTER_MAX_KEY_BYTES) { return -1; }
+    const int node = filter->nodeCount++;
+    if (key != NULL) {
+        memcpy(filter->keys + filter->keysLength, key, (size_t)keyLength);
+        filter->values[node] = filter->keysLength;
+        filter->keysLength += keyLength;
+    } else {
+        filter->values[node] = arrayIndex;
+    }
+    filter->keyLengths[node] = (int16_t)keyLength;
+    filter->children[node] = 0;
+    filter->children[parent] |= 1ull << node;
+    *kind |= 1ull << node;
+    return node;
+}
+
+/** Add one path to a filter.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int compilePath(TTSDKJSONPathFilter *const filter, const char *path)
+{
+    int node = kPathFilterRoot;
+    for (;;) {
+        if (*path == '[') {
+            path++;
+            if (path[0] == '*' && path[1] == ']') {
+                node = addPathNode(filter, node, &filter->anyElements, NULL, 0, 0);
+                path += 2;
+            } else {
+                const char *const digits = path;
+                int32_t arrayIndex = 0;
+                for (; *path >= '0' && *path <= '9'; path++) {
+                    unlikely_if(path - digits >= 9) { return TTSDKJSON_ERROR_INVALID_DATA; }
+                    arrayIndex = arrayIndex * 10 + (*path - '0');
+                }
+                unlikely_if(path == digits || *path != ']') { return TTSDKJSON_ERROR_INVALID_DATA; }
+                node = addPathNode(filter, node, &filter->elements, NULL, 0, arrayIndex);
+                path++;
+            }
+            unlikely_if(*path != '\0' && *path != '.' && *path != '[') { return TTSDKJSON_ERROR_INVALID_DATA; }
+        } else {
+            const char *const key = path;
+            while (*path != '\0' && *path != '.' && *path != '[') {
+                path++;
+            }
+            const int keyLength = (int)(path - key);
+            unlikely_if(keyLength == 0 || keyLength > INT16_MAX) { return TTSDKJSON_ERROR_INVALID_DATA; }
+            node = keyLength == 1 && *key == '*' ? addPathNode(filter, node, &filter->anyMembers, NULL, 0, 0)
+                                                 : addPathNode(filter, node, &filter->members, key, keyLength, 0);
+        }
+        unlikely_if(node < 0) { return TTSDKJSON_ERROR_DATA_TOO_LONG; }
+
+        if (*path == '\0') {
+            break;
+        }
+        if (*path == '.') {
+            path++;
+            unlikely_if(*path == '\0' || *path == '[') { return TTSDKJSON_ERROR_INVALID_DATA; }
+        }
+    }
+    filter->selected |= 1ull << node;
+    return TTSDKJSON_OK;
+}
+
+int ttsdkjson_compilePathFilter(TTSDKJSONPathFilter *const filter, const char *const *const paths, const int pathCount)
+{
+    *filter = (TTSDKJSONPathFilter) { .nodeCount = 1 };
+    for (int i = 0; i < pathCount; i++) {
+        const int result = compilePath(filter, paths[i]);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+    }
+    return TTSDKJSON_OK;
+}
+
+/** Get the nodes that can match the children of a container.
+ *
+ * @param nodes The nodes that the container matches.
+ */
+static inline uint64_t childNodes(const TTSDKJSONPathFilter *const filter, uint64_t nodes)
+{
+    uint64_t children = 0;
+    for (; nodes != 0; nodes &= nodes - 1) {
+        children |= filter->children[__builtin_ctzll(nodes)];
+    }
+    return children;
+}
+
+/** Get the nodes that an object member matches.
+ *
+ * @param candidates The nodes that can match the object's children.
+ */
+static inline uint64_t matchMember(const TTSDKJSONPathFilter *const filter, const uint64_t candidates,
+                                   const char *const key, const int keyLength)
+{
+    uint64_t matched = candidates & filter->anyMembers;
+    for (uint64_t members = candidates & filter->members; members != 0; members &= members - 1) {
+        const int node = __builtin_ctzll(members);
+        likely_if(filter->keyLengths[node] == keyLength &&
+                  memcmp(filter->keys + filter->values[node], key, (size_t)keyLength) == 0)
+        {
+            matched |= 1ull << node;
+        }
+    }
+    return matched;
+}
+
+/** Get the nodes that an array element matches.
+ *
+ * @param candidates The nodes that can match the array's children.
+ */
+static inline uint64_t matchElement(const TTSDKJSONPathFilter *const filter, const uint64_t candidates,
+                                    const int32_t arrayIndex)
+{
+    uint64_t matched = candidates & filter->anyElements;
+    for (uint64_t elements = candidates & filter->elements; elements != 0; elements &= elements - 1) {
+        const int node = __builtin_ctzll(elements);
+        likely_if(filter->values[node] == arrayIndex) { matched |= 1ull << node; }
+    }
+    return matched;
+}
+
+/** Match a member's name, which is decoded if it's wanted (or if it has to
+ * be unescaped to be matched).
+ *
+ * @param context The decoding context.
+ *
+ * @param candidates The nodes that can match the object's children.
+ *
+ * @param src The start of the name.
+ *
+ * @param srcEnd The end of the name.
+ *
+ * @param fastCopy true if the name has no escape sequences.
+ *
+ * @param name Place to store the name to pass to the callbacks.
+ *
+ * @param matched Place to store the nodes that the member matches.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int matchMemberName(TTSDKJSONDecodeContext *const context, const TTSDKJSONPathFilter *const filter,
+                           const uint64_t candidates, const char *const src, const char *const srcEnd,
+                           const bool fastCopy, const char **const name, uint64_t *const matched)
+{
+    likely_if(fastCopy)
+    {
+        *name = context->nameBuffer;
+        *matched = matchMember(filter, candidates, src, (int)(srcEnd - src));
+        likely_if(*matched == 0) { return TTSDKJSON_OK; }
+        return decodeMemberName(context, src, srcEnd, true, name);
+    }
+    int length;
+    const int result = copyString(src, srcEnd, false, context->nameBuffer, context->nameBufferLength, &length);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    *matched = matchMember(filter, candidates, context->nameBuffer, length);
+    *name = internName(context, context->nameBuffer, length);
+    return TTSDKJSON_OK;
+}
+
+/** Step over the rest of a string.
+ *
+ * @param src Just past the opening quote.
+ *
+ * @param end The end of the data.
+ *
+ * @return Just past the closing quote, or NULL if it isn't in the data.
+ */
+static inline const char *skipString(const char *src, const char *const end)
+{
+    for (;;) {
+        src = findEscapeCandidate(src, end);
+        unlikely_if(src == end) { return NULL; }
+        likely_if(*src == '\"') { return src + 1; }
+        // A backslash steps over the byte it escapes. A control character is
+        // left for whoever decodes the string.
+        src += *src == '\\' ? 2 : 1;
+        unlikely_if(src > end) { return NULL; }
+    }
+}
+
+/** Step over an element without decoding it.
+ *
+ * @param context The decoding context.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int skipElement(TTSDKJSONDecodeContext *const context)
+{
+    SKIP_WHITESPACE(context);
+    const char *src = context->bufferPtr;
+    const char *const end = context->bufferEnd;
+    int depth = 0;
+    while (src < end) {
+        switch (*src) {
+            case '\"':
+                src = skipString(src + 1, end);
+                unlikely_if(src == NULL) { goto incomplete; }
+                break;
+            case '[':
+            case '{':
+                depth++;
+                src++;
+                continue;
+            case ']':
+            case '}':
+                unlikely_if(depth == 0) { goto invalid; }
+                depth--;
+                src++;
+                break;
+            default:
+                likely_if(depth > 0)
+                {
+                    src++;
+                    continue;
+                }
+                const char *const scalar = src;
+                while (src < end && !isScalarDelimiter(*src)) {
+                    src++;
+                }
+                unlikely_if(src == scalar) { goto invalid; }
+                break;
+        }
+        likely_if(depth == 0)
+        {
+            context->bufferPtr = src;
+            return TTSDKJSON_OK;
+        }
+    }
+
+incomplete:
+    TTSDKLOG_DEBUG("Premature end of data");
+    return TTSDKJSON_ERROR_INCOMPLETE;
+
+invalid:
+    TTSDKLOG_DEBUG("Invalid character '%c'", *src);
+    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+}
+
+static int decodeFilteredContainer(const char *name, TTSDKJSONDecodeContext *context,
+                                   const TTSDKJSONPathFilter *filter, uint64_t nodes);
+
+/** Decode, walk into or skip an element, depending on the nodes it matches.
+ *
+ * @param name This element's name (or NULL if it has none).
+ *
+ * @param context The decoding context.
+ *
+ * @param filter The path filter.
+ *
+ * @param matched The nodes that the element matches.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static inline int decodeFilteredElement(const char *const name, TTSDKJSONDecodeContext *const context,
+                                        const TTSDKJSONPathFilter *const filter, const uint64_t matched)
+{
+    likely_if(matched == 0) { return skipElement(context); }
+    unlikely_if((matched & filter->selected) != 0) { return decodeElement(name, context); }
+    return decodeFilteredContainer(name, context, filter, matched);
+}
+
+/** Decode the parts of a container that a path filter selects, the way
+ * decodeElement() does. Anything other than a container is skipped.
+ *
+ * @param name This element's name (or NULL if it has none).
+ *
+ * @param context The decoding context.
+ *
+ * @param filter The path filter.
+ *
+ * @param nodes The nodes that the container matches, none of which end a path.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeFilteredContainer(const char *const name, TTSDKJSONDecodeContext *const context,
+                                   const TTSDKJSONPathFilter *const filter, const uint64_t nodes)
+{
+    SKIP_WHITESPACE(context);
+    unlikely_if(context->bufferPtr >= context->bufferEnd)
+    {
+        TTSDKLOG_DEBUG("Premature end of data");
+        return TTSDKJSON_ERROR_INCOMPLETE;
+    }
+
+    const uint64_t candidates = childNodes(filter, nodes);
+    int result;
+
+    switch (*context->bufferPtr) {
+        case '[': {
+            context->bufferPtr++;
+            result = context->callbacks->onBeginArray(name, context->userData);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            for (int32_t arrayIndex = 0; context->bufferPtr < context->bufferEnd; arrayIndex++) {
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                unlikely_if(*context->bufferPtr == ']')
+                {
+                    context->bufferPtr++;
+                    return context->callbacks->onEndContainer(context->userData);
+                }
+                result = decodeFilteredElement(NULL, context, filter, matchElement(filter, candidates, arrayIndex));
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                likely_if(*context->bufferPtr == ',') { context->bufferPtr++; }
+            }
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        case '{': {
+            context->bufferPtr++;
+            result = context->callbacks->onBeginObject(name, context->userData);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            while (context->bufferPtr < context->bufferEnd) {
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                unlikely_if(*context->bufferPtr == '}')
+                {
+                    context->bufferPtr++;
+                    return context->callbacks->onEndContainer(context->userData);
+                }
+                const char *src;
+                const char *srcEnd;
+                bool fastCopy;
+                result = scanString(context, &src, &srcEnd, &fastCopy);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                const char *memberName;
+                uint64_t matched;
+                result = matchMemberName(context, filter, candidates, src, srcEnd, fastCopy, &memberName, &matched);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                unlikely_if(*context->bufferPtr != ':')
+                {
+                    TTSDKLOG_DEBUG("Expected ':' but got '%c'", *context->bufferPtr);
+                    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+                }
+                context->bufferPtr++;
+                result = decodeFilteredElement(memberName, context, filter, matched);
+                unlikely_if(result != TTSDKJSON_OK) return result;
+                SKIP_WHITESPACE(context);
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
+                likely_if(*context->bufferPtr == ',') { context->bufferPtr++; }
+            }
+            TTSDKLOG_DEBUG("Premature end of data");
+            return TTSDKJSON_ERROR_INCOMPLETE;
+        }
+        default:
+            return skipElement(context);
+    }
+}
+
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+/** Step over the rest of a container whose positions have all been used,
+ * without indexing it. Each block only has its strings and brackets found,
+ * and the brackets are counted rather than listed, so that a large subtree
+ * costs little more than reading it. The index is then refilled from the
+ * block where the container ends.
+ *
+ * @param index The index. All of its positions must have been used.
+ *
+ * @param depth How many containers are open.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int skipIndexedBlocks(StructuralIndex *const index, int depth)
+{
+    for (; index->scanPtr < index->end; index->scanPtr += kStructuralBlockSize) {
+        const char *block = index->scanPtr;
+        char paddedBlock[kStructuralBlockSize];
+        unlikely_if(index->end - index->scanPtr < kStructuralBlockSize)
+        {
+            const size_t length = (size_t)(index->end - index->scanPtr);
+            memcpy(paddedBlock, index->scanPtr, length);
+            memset(paddedBlock + length, ' ', sizeof(paddedBlock) - length);
+            block = paddedBlock;
+        }
+        const uint64_t wasInString = index->isInString;
+        const uint64_t wasEscaped = index->isEscaped;
+
+        BracketMasks masks;
+        classifyBrackets(block, &masks);
+        const uint64_t quotes = masks.quotes & ~findEscapedBytes(masks.backslashes, &index->isEscaped);
+        const uint64_t inString = prefixXor(quotes) ^ index->isInString;
+        index->isInString = (uint64_t)((int64_t)inString >> 63);
+        const uint64_t opens = masks.opens & ~inString;
+        const uint64_t closes = masks.closes & ~inString;
+
+        // The container can't end here if there aren't enough closing brackets.
+        likely_if(depth > __builtin_popcountll(closes))
+        {
+            depth += __builtin_popcountll(opens) - __builtin_popcountll(closes);
+            continue;
+        }
+        for (uint64_t brackets = opens | closes; brackets != 0; brackets &= brackets - 1) {
+            const uint64_t bracket = brackets & (~brackets + 1);
+            if ((opens & bracket) != 0) {
+                depth++;
+            } else if (--depth == 0) {
+                const uint32_t end = (uint32_t)(index->scanPtr - index->data) + (uint32_t)__builtin_ctzll(bracket);
+                // Anything that carries over into the block is before the bracket, so it doesn't matter
+                // whether the block starts in the middle of a number or literal.
+                index->isInString = wasInString;
+                index->isEscaped = wasEscaped;
+                index->isInScalar = 0;
+                refillStructuralIndex(index);
+                while (index->next < index->count && index->positions[index->next] <= end) {
+                    index->next++;
+                }
+                return TTSDKJSON_OK;
+            }
+        }
+    }
+    TTSDKLOG_DEBUG("Premature end of data");
+    return TTSDKJSON_ERROR_INCOMPLETE;
+}
+
+/** Step over an element without decoding it, the way skipElement() does.
+ * Brackets inside strings aren't in the index, so it's enough to count the
+ * brackets among the tokens.
+ *
+ * @param index The index, with the element as its next token.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int skipIndexedElement(StructuralIndex *const index)
+{
+    const char *token = nextToken(index);
+    unlikely_if(token == NULL) { goto incomplete; }
+    switch (*token) {
+        case '\"':
+            unlikely_if(nextToken(index) == NULL) { goto incomplete; }
+            return TTSDKJSON_OK;
+        case '[':
+        case '{': {
+            int depth = 1;
+            for (; index->next < index->count; index->next++) {
+                const char ch = index->data[index->positions[index->next]];
+                if (ch == '[' || ch == '{') {
+                    depth++;
+                } else if ((ch == ']' || ch == '}') && --depth == 0) {
+                    index->next++;
+                    return TTSDKJSON_OK;
+                }
+            }
+            return skipIndexedBlocks(index, depth);
+        }
+        case ']':
+        case '}':
+        case ',':
+        case ':':
+            TTSDKLOG_DEBUG("Invalid character '%c'", *token);
+            return TTSDKJSON_ERROR_INVALID_CHARACTER;
+        default:
+            // A number or literal is a single token.
+            return TTSDKJSON_OK;
+    }
+
+incomplete:
+    TTSDKLOG_DEBUG("Premature end of data");
+    return TTSDKJSON_ERROR_INCOMPLETE;
+}
+
+static int decodeIndexedFilteredContainer(const char *name, TTSDKJSONDecodeContext *context,
+                                          StructuralIndex *index, const TTSDKJSONPathFilter *filter, uint64_t nodes);
+
+/** Decode, walk into or skip an element, the way decodeFilteredElement() does.
+ *
+ * @param index The index, with the element as its next token.
+ */
+static inline int decodeIndexedFilteredElement(const char *const name, TTSDKJSONDecodeContext *const context,
+                                               StructuralIndex *const index, const TTSDKJSONPathFilter *const filter,
+                                               const uint64_t matched)
+{
+    likely_if(matched == 0) { return skipIndexedElement(index); }
+    unlikely_if((matched & filter->selected) != 0) { return decodeIndexedElement(name, context, index); }
+    return decodeIndexedFilteredContainer(name, context, index, filter, matched);
+}
+
+/** Decode the parts of a container that a path filter selects, the way
+ * decodeFilteredContainer() does.
+ *
+ * @param index The index, with the container as its next token.
+ */
+static int decodeIndexedFilteredContainer(const char *const name, TTSDKJSONDecodeContext *const context,
+                                          StructuralIndex *const index, const TTSDKJSONPathFilter *const filter,
+                                          const uint64_t nodes)
+{
+    const char *token = peekToken(index);
+    unlikely_if(token == NULL || (*token != '[' && *token != '{')) { return skipIndexedElement(index); }
+    index->next++;
+
+    const uint64_t candidates = childNodes(filter, nodes);
+    int result;
+
+    if (*token == '[') {
+        result = context->callbacks->onBeginArray(name, context->userData);
+        unlikely_if(result != TTSDKJSON_OK) return result;
+        for (int32_t arrayIndex = 0; (token = peekToken(index)) != NULL; arrayIndex++) {
+            unlikely_if(*token == ']')
+            {
+                index->next++;
+                return context->callbacks->onEndContainer(context->userData);
+            }
+            result = decodeIndexedFilteredElement(NULL, context, index, filter,
+                                                  matchElement(filter, candidates, arrayIndex));
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            token = peekToken(index);
+            likely_if(token != NULL && *token == ',') { index->next++; }
+        }
+    } else {
+        result = context->callbacks->onBeginObject(name, context->userData);
+        unlikely_if(result != TTSDKJSON_OK) return result;
+        while ((token = nextToken(index)) != NULL) {
+            unlikely_if(*token == '}') { return context->callbacks->onEndContainer(context->userData); }
+            unlikely_if(*token != '\"')
+            {
+                TTSDKLOG_DEBUG("Expected '\"' but got '%c'", *token);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            }
+            const char *nameEnd;
+            bool fastCopy;
+            result = scanIndexedString(index, token, &nameEnd, &fastCopy);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            const char *memberName;
+            uint64_t matched;
+            result = matchMemberName(context, filter, candidates, token + 1, nameEnd, fastCopy, &memberName, &matched);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            token = nextToken(index);
+            unlikely_if(token == NULL) { break; }
+            unlikely_if(*token != ':')
+            {
+                TTSDKLOG_DEBUG("Expected ':' but got '%c'", *token);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            }
+            result = decodeIndexedFilteredElement(memberName, context, index, filter, matched);
+            unlikely_if(result != TTSDKJSON_OK) return result;
+            token = peekToken(index);
+            likely_if(token != NULL && *token == ',') { index->next++; }
+        }
+    }
+    TTSDKLOG_DEBUG("Premature end of data");
+    return TTSDKJSON_ERROR_INCOMPLETE;
+}
+#endif  // TTSDKJSONCODEC_STRUCTURAL_INDEX
+
+int ttsdkjson_decodeFiltered(const char *const data, const int length, char *const stringBuffer,
+                             const int stringBufferLength, const TTSDKJSONPathFilter *const filter,
+                             TTSDKJSONDecodeCallbacks *const callbacks, void *const userData, int *const errorOffset)
+{
+    TTSDKJSONDecodeContext context =
+        newDecodeContext(data, length, stringBuffer, stringBufferLength, callbacks, userData);
+    const uint64_t root = 1ull << kPathFilterRoot;
+
+    int result;
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+    likely_if(length >= kStructuralIndexMinLength)
+    {
+        StructuralIndex index = {
+            .data = data,
+            .scanPtr = data,
+            .end = data + length,
+        };
+        result = decodeIndexedFilteredContainer(NULL, &context, &index, filter, root);
+    }
+    else
+    {
+        result = decodeFilteredContainer(NULL, &context, filter, root);
+    }
+#else
+    result = decodeFilteredContainer(NULL, &context, filter, root);
+#endif
+    likely_if(result == TTSDKJSON_OK) { result = callbacks->onEndData(userData); }
+
+    unlikely_if(result != TTSDKJSON_OK && errorOffset != NULL) { *errorOffset = (int)(context.bufferPtr - data); }
+    return result;
+}
+
+// ============================================================================
+#pragma mark - Parallel Decode -
+// ============================================================================
+
+/** Arrays with fewer than this many bytes per worker are given to fewer workers. */
+#define kParallelMinBytesPerWorker 16384
+
+/** A worker's run of consecutive elements. */
+typedef struct {
+    TTSDKJSONArrayWorker *worker;
+    /** The start of the document, for error offsets. */
+    const char *data;
+    /** The run's first element. */
+    const char *start;
+    /** Just past the separator after the run's last element (a comma or the
+     * closing bracket), so that a number at the end of the run isn't cut short.
+     */
+    const char *end;
+    pthread_t thread;
+    bool hasThread;
+} ArrayRun;
+
+/** The state of dividing an array into runs. */
+typedef struct {
+    ArrayRun *runs;
+    int runCount;
+    /** The run being filled, or -1 before the first element. */
+    int current;
+    /** Number of elements so far. */
+    int elementCount;
+    const char *data;
+    int length;
+} ArraySplit;
+
+/** Give an element to a run, starting the next run (or runs) once the
+ * element is far enough into the document.
+ *
+ * @param split The split.
+ *
+ * @param start The element's first byte.
+ *
+ * @param separator The comma before the element (NULL for the first element).
+ */
+static void addElementToRun(ArraySplit *const split, const char *const start, const char *const separator)
+{
+    int run = (int)((int64_t)(start - split->data) * split->runCount / split->length);
+    if (run >= split->runCount) {
+        run = split->runCount - 1;
+    }
+    if (run < split->current) {
+        run = split->current;
+    }
+    while (split->current < run) {
+        if (split->current >= 0) {
+            split->runs[split->current].end = separator + 1;
+        }
+        split->current++;
+        split->runs[split->current].start = start;
+        split->runs[split->current].worker->firstElement = split->elementCount;
+    }
+    split->runs[split->current].worker->elementCount++;
+    split->elementCount++;
+}
+
+/** Finish the last run at the closing bracket, and start any runs that got no elements after it. */
+static void finishArrayRuns(ArraySplit *const split, const char *const closingBracket)
+{
+    if (split->current >= 0) {
+        split->runs[split->current].end = closingBracket + 1;
+    }
+    for (int i = split->current + 1; i < split->runCount; i++) {
+        split->runs[i].worker->firstElement = split->elementCount;
+    }
+}
+
+/** Step over the elements of a top-level array, dividing them into runs.
+ *
+ * @param context The decoding context.
+ *
+ * @param split The split.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int splitArray(TTSDKJSONDecodeContext *const context, ArraySplit *const split)
+{
+    SKIP_WHITESPACE(context);
+    unlikely_if(context->bufferPtr >= context->bufferEnd) { goto incomplete; }
+    unlikely_if(*context->bufferPtr != '[')
+    {
+        TTSDKLOG_DEBUG("Top-level element is not an array");
+        return TTSDKJSON_ERROR_INVALID_DATA;
+    }
+    context->bufferPtr++;
+    SKIP_WHITESPACE(context);
+    unlikely_if(context->bufferPtr >= context->bufferEnd) { goto incomplete; }
+    unlikely_if(*context->bufferPtr == ']')
+    {
+        finishArrayRuns(split, context->bufferPtr);
+        return TTSDKJSON_OK;
+    }
+
+    const char *separator = NULL;
+    for (;;) {
+        SKIP_WHITESPACE(context);
+        unlikely_if(context->bufferPtr >= context->bufferEnd) { goto incomplete; }
+        addElementToRun(split, context->bufferPtr, separator);
+        const int result = skipElement(context);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        SKIP_WHITESPACE(context);
+        unlikely_if(context->bufferPtr >= context->bufferEnd) { goto incomplete; }
+        separator = context->bufferPtr;
+        likely_if(*separator == ',')
+        {
+            context->bufferPtr++;
+            continue;
+        }
+        unlikely_if(*separator != ']')
+        {
+            TTSDKLOG_DEBUG("Expected ',' or ']' but got '%c'", *separator);
+            return TTSDKJSON_ERROR_INVALID_CHARACTER;
+        }
+        finishArrayRuns(split, separator);
+        return TTSDKJSON_OK;
+    }
+
+incomplete:
+    TTSDKLOG_DEBUG("Premature end of data");
+    return TTSDKJSON_ERROR_INCOMPLETE;
+}
+
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+/** Step over the elements of a top-level array the way splitArray() does.
+ *
+ * @param index The index of the document.
+ *
+ * @param split The split.
+ *
+ * @param position Place to store the last token looked at, for error offsets.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int splitIndexedArray(StructuralIndex *const index, ArraySplit *const split, const char **const position)
+{
+    const char *token = nextToken(index);
+    unlikely_if(token == NULL) { goto incomplete; }
+    *position = token;
+    unlikely_if(*token != '[')
+    {
+        TTSDKLOG_DEBUG("Top-level element is not an array");
+        return TTSDKJSON_ERROR_INVALID_DATA;
+    }
+    token = peekToken(index);
+    unlikely_if(token == NULL) { goto incomplete; }
+    unlikely_if(*token == ']')
+    {
+        finishArrayRuns(split, token);
+        return TTSDKJSON_OK;
+    }
+
+    const char *separator = NULL;
+    for (;;) {
+        token = peekToken(index);
+        unlikely_if(token == NULL) { goto incomplete; }
+        *position = token;
+        addElementToRun(split, token, separator);
+        const int result = skipIndexedElement(index);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        separator = nextToken(index);
+        unlikely_if(separator == NULL) { goto incomplete; }
+        *position = separator;
+        likely_if(*separator == ',') { continue; }
+        unlikely_if(*separator != ']')
+        {
+            TTSDKLOG_DEBUG("Expected ',' or ']' but got '%c'", *separator);
+            return TTSDKJSON_ERROR_INVALID_CHARACTER;
+        }
+        finishArrayRuns(split, separator);
+        return TTSDKJSON_OK;
+    }
+
+incomplete:
+    TTSDKLOG_DEBUG("Premature end of data");
+    return TTSDKJSON_ERROR_INCOMPLETE;
+}
+#endif
+
+/** Decode a run of elements, each as a document of its own.
+ *
+ * @param context The decoding context, covering the run.
+ *
+ * @param elementCount The number of elements in the run.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int decodeArrayRunElements(TTSDKJSONDecodeContext *const context, const int elementCount)
+{
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+    likely_if(context->bufferEnd - context->bufferPtr >= kStructuralIndexMinLength)
+    {
+        StructuralIndex index = {
+            .data = context->bufferPtr,
+            .scanPtr = context->bufferPtr,
+            .end = context->bufferEnd,
+        };
+        for (int i = 0; i < elementCount; i++) {
+            if (i > 0) {
+                const char *const separator = nextToken(&index);
+                unlikely_if(separator == NULL) { return TTSDKJSON_ERROR_INCOMPLETE; }
+                context->bufferPtr = separator;
+                unlikely_if(*separator != ',') { return TTSDKJSON_ERROR_INVALID_CHARACTER; }
+            }
+            const char *const element = peekToken(&index);
+            if (element != NULL) {
+                context->bufferPtr = element;
+            }
+            int result = decodeIndexedElement(NULL, context, &index);
+            likely_if(result == TTSDKJSON_OK) { result = context->callbacks->onEndData(context->userData); }
+            unlikely_if(result != TTSDKJSON_OK) { return result; }
+        }
+        return TTSDKJSON_OK;
+    }
+#endif
+    for (int i = 0; i < elementCount; i++) {
+        if (i > 0) {
+            SKIP_WHITESPACE(context);
+            unlikely_if(context->bufferPtr >= context->bufferEnd) { return TTSDKJSON_ERROR_INCOMPLETE; }
+            unlikely_if(*context->bufferPtr != ',') { return TTSDKJSON_ERROR_INVALID_CHARACTER; }
+            context->bufferPtr++;
+        }
+        int result = decodeElement(NULL, context);
+        likely_if(result == TTSDKJSON_OK) { result = context->callbacks->onEndData(context->userData); }
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+    }
+    return TTSDKJSON_OK;
+}
+
+static void *decodeArrayRun(void *const userData)
+{
+    ArrayRun *const run = (ArrayRun *)userData;
+    TTSDKJSONArrayWorker *const worker = run->worker;
+    TTSDKJSONDecodeContext context = newDecodeContext(run->start, (int)(run->end - run->start), worker->stringBuffer,
+                                                      worker->stringBufferLength, worker->callbacks, worker->userData);
+    worker->result = decodeArrayRunElements(&context, worker->elementCount);
+    unlikely_if(worker->result != TTSDKJSON_OK) { worker->errorOffset = (int)(context.bufferPtr - run->data); }
+    return NULL;
+}
+
+int ttsdkjson_decodeArrayInParallel(const char *const data, const int length, TTSDKJSONArrayWorker *const workers,
+                                    const int workerCount, int *const errorOffset)
+{
+    unlikely_if(workerCount < 1 || workerCount > TTSDKJSON_MAX_ARRAY_WORKERS)
+    {
+        TTSDKLOG_ERROR("Invalid worker count %d", workerCount);
+        return TTSDKJSON_ERROR_INVALID_DATA;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        workers[i].firstElement = 0;
+        workers[i].elementCount = 0;
+        workers[i].result = TTSDKJSON_OK;
+        workers[i].errorOffset = 0;
+    }
+
+    int runCount = length / kParallelMinBytesPerWorker;
+    if (runCount > workerCount) {
+        runCount = workerCount;
+    }
+    if (runCount < 1) {
+        runCount = 1;
+    }
+    ArrayRun runs[TTSDKJSON_MAX_ARRAY_WORKERS];
+    for (int i = 0; i < runCount; i++) {
+        runs[i] = (ArrayRun) { .worker = &workers[i], .data = data };
+    }
+    ArraySplit split = { .runs = runs, .runCount = runCount, .current = -1, .data = data, .length = length };
+
+    // Stepping over elements doesn't touch the string buffer or callbacks.
+    TTSDKJSONDecodeContext context = newDecodeContext(data, length, NULL, 0, NULL, NULL);
+    int result;
+#if TTSDKJSONCODEC_STRUCTURAL_INDEX
+    likely_if(length >= kStructuralIndexMinLength)
+    {
+        StructuralIndex index = {
+            .data = data,
+            .scanPtr = data,
+            .end = data + length,
+        };
+        result = splitIndexedArray(&index, &split, &context.bufferPtr);
+    }
+    else
+    {
+        result = splitArray(&context, &split);
+    }
+#else
+    result = splitArray(&context, &split);
+#endif
+    unlikely_if(result != TTSDKJSON_OK)
+    {
+        if (errorOffset != NULL) {
+            *errorOffset = (int)(context.bufferPtr - data);
+        }
+        return result;
+    }
+    for (int i = runCount; i < workerCount; i++) {
+        workers[i].firstElement = split.elementCount;
+    }
+
+    for (int i = 1; i < runCount; i++) {
+        if (workers[i].elementCount > 0) {
+            runs[i].hasThread = pthread_create(&runs[i].thread, NULL, decodeArrayRun, &runs[i]) == 0;
+        }
+    }
+    for (int i = 0; i < runCount; i++) {
+        if (runs[i].hasThread) {
+            pthread_join(runs[i].thread, NULL);
+        } else if (workers[i].elementCount > 0) {
+            // The first run, or one whose thread couldn't be started.
+            decodeArrayRun(&runs[i]);
+        }
+    }
+
+    for (int i = 0; i < runCount; i++) {
+        unlikely_if(workers[i].result != TTSDKJSON_OK)
         {
-            fastCopy = false;
+            if (errorOffset != NULL) {
+                *errorOffset = workers[i].errorOffset;
+            }
+            return workers[i].result;
+        }
+    }
+    return TTSDKJSON_OK;
+}
+
+// ============================================================================
+#pragma mark - Push Decode -
+// ============================================================================
+
+typedef enum {
+    /** Expecting a value: the top-level element, or a member's value after its ':'. */
+    DecoderStateValue,
+    /** Expecting an element of the current container, or its end. */
+    DecoderStateElement,
+    /** Just after an element, where a ',' may follow. */
+    DecoderStateAfterElement,
+    /** Expecting the ':' after a member's name. */
+    DecoderStateColon,
+    /** In the middle of a member's name. */
+    DecoderStateName,
+    /** In the middle of a string value. */
+    DecoderStateString,
+    /** In the middle of a number or literal. */
+    DecoderStateScalar,
+    /** The top-level element is complete. */
+    DecoderStateDone,
+} DecoderState;
+
+/** A decoding context for a chunk of data, for the functions shared with ttsdkjson_decode(). */
+static inline TTSDKJSONDecodeContext decoderContext(TTSDKJSONDecoder *const decoder, const char *const data,
+                                                    const char *const end)
+{
+    return (TTSDKJSONDecodeContext) {
+        .bufferPtr = data,
+        .bufferEnd = end,
+        .nameBuffer = decoder->nameBuffer,
+        .nameBufferLength = decoder->nameBufferLength,
+        .stringBuffer = decoder->stringBuffer,
+        .stringBufferLength = decoder->stringBufferLength,
+        .callbacks = decoder->callbacks,
+        .userData = decoder->userData,
+    };
+}
+
+static inline bool isInObject(const TTSDKJSONDecoder *const decoder)
+{
+    const int level = decoder->depth - 1;
+    return (decoder->isObject[level / 8] >> (level % 8)) & 1;
+}
+
+/** The name of the element that is about to be decoded. */
+static inline const char *currentName(const TTSDKJSONDecoder *const decoder)
+{
+    unlikely_if(decoder->depth == 0) { return decoder->rootName; }
+    return isInObject(decoder) ? decoder->memberName : NULL;
+}
+
+static inline void endDecoderElement(TTSDKJSONDecoder *const decoder)
+{
+    decoder->state = decoder->depth == 0 ? DecoderStateDone : DecoderStateAfterElement;
+}
+
+/** Find the closing quote of a string.
+ *
+ * @param src Where to start looking, just past the opening quote or an escaped byte.
+ *
+ * @param end The end of the data.
+ *
+ * @param decoder Where to note escape sequences, and a backslash at the very end.
+ *
+ * @return The closing quote, or end if it isn't in the data.
+ */
+static const char *findClosingQuote(const char *src, const char *const end, TTSDKJSONDecoder *const decoder)
+{
+    for (;;) {
+        src = findEscapeCandidate(src, end);
+        unlikely_if(src == end) { return end; }
+        likely_if(*src == '\"') { return src; }
+        if (*src == '\\') {
+            decoder->hasEscapes = true;
+            unlikely_if(src + 1 == end)
+            {
+                decoder->isEscaped = true;
+                return end;
+            }
+            src += 2;
+        } else {
+            // A control character, which is left for whoever gets the string.
             src++;
         }
     }
-    unlikely_if(src >= context->bufferEnd)
+}
+
+/** Add part of a string, name or scalar to what was gathered from earlier chunks.
+ *
+ * @param buffer Where it's gathered.
+ *
+ * @param bufferLength The buffer's length, which must leave room for a terminator.
+ */
+static int gatherPending(TTSDKJSONDecoder *const decoder, char *const buffer, const int bufferLength,
+                         const char *const src, const char *const srcEnd)
+{
+    const int length = (int)(srcEnd - src);
+    unlikely_if(decoder->pendingLength + length >= bufferLength)
+    {
+        TTSDKLOG_DEBUG("String is too long");
+        return TTSDKJSON_ERROR_DATA_TOO_LONG;
+    }
+    memcpy(buffer + decoder->pendingLength, src, (size_t)length);
+    decoder->pendingLength += length;
+    return TTSDKJSON_OK;
+}
+
+/** Unescape a gathered string where it is, and null terminate it.
+ *
+ * @return TTSDKJSON_OK if successful.
+ */
+static int finishPending(TTSDKJSONDecoder *const decoder, char *const buffer, int *const length)
+{
+    *length = decoder->pendingLength;
+    decoder->pendingLength = 0;
+    likely_if(!decoder->hasEscapes)
     {
-        TTSDKLOG_DEBUG("Premature end of data");
-        return TTSDKJSON_ERROR_INCOMPLETE;
+        buffer[*length] = '\0';
+        return TTSDKJSON_OK;
+    }
+    // Unescaping never makes a string longer, so it can be done in place.
+    return copyString(buffer, buffer + *length, false, buffer, *length + 1, length);
+}
+
+/** How much of a gathered string can be unescaped on its own: everything up
+ * to an escape sequence or UTF-8 character that is cut off at the end.
+ */
+static int completeStringLength(const char *const buffer, const int length)
+{
+    const char *const end = buffer + length;
+    const char *src = buffer;
+    for (;;) {
+        const char *const backslash = memchr(src, '\\', (size_t)(end - src));
+        unlikely_if(backslash == NULL) { break; }
+        int sequenceLength = 2;
+        unlikely_if(backslash + 1 < end && backslash[1] == 'u')
+        {
+            sequenceLength = 6;
+            // A lead surrogate needs its trail surrogate too.
+            likely_if(end - backslash >= 6 && decodeHexQuad(backslash + 2) - 0xd800 < 0x400) { sequenceLength = 12; }
+        }
+        unlikely_if(end - backslash < sequenceLength) { return (int)(backslash - buffer); }
+        src = backslash + sequenceLength;
+    }
+
+    // Step back over the start of a multibyte character whose continuation bytes are missing.
+    const char *start = end;
+    while (start > buffer && end - start < 4 && ((unsigned char)start[-1] & 0xc0) == 0x80) {
+        start--;
+    }
+    unlikely_if(start > buffer && (unsigned char)start[-1] >= 0xc0)
+    {
+        const unsigned char lead = (unsigned char)start[-1];
+        const int characterLength = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : 2;
+        unlikely_if(end - (start - 1) < characterLength) { return (int)(start - 1 - buffer); }
+    }
+    return length;
+}
+
+/** Pass on the complete part of a gathered string value, keeping the rest.
+ *
+ * @param isLastPart true if the gathered string is the end of the value.
+ */
+static int passStringPart(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context,
+                          const bool isLastPart)
+{
+    char *const buffer = decoder->stringBuffer;
+    const int gathered = decoder->pendingLength;
+    const int partLength = isLastPart ? gathered : completeStringLength(buffer, gathered);
+    unlikely_if(partLength == 0 && !isLastPart)
+    {
+        TTSDKLOG_DEBUG("String buffer is too small");
+        return TTSDKJSON_ERROR_DATA_TOO_LONG;
+    }
+
+    // Unescaping writes a terminator, which mustn't clobber what's kept.
+    const char firstKept = buffer[partLength];
+    int length;
+    int result = copyString(buffer, buffer + partLength, false, buffer, partLength + 1, &length);
+    buffer[partLength] = firstKept;
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+
+    const bool isFirstPart = !decoder->isStringInParts;
+    decoder->isStringInParts = !isLastPart;
+    result = context->callbacks->onStringElementPart(currentName(decoder), buffer, length, isFirstPart, isLastPart,
+                                                     context->userData);
+    memmove(buffer, buffer + partLength, (size_t)(gathered - partLength));
+    decoder->pendingLength = gathered - partLength;
+    return result;
+}
+
+/** Gather more of a string value, passing it on in parts whenever the string buffer fills. */
+static int gatherStringValue(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context,
+                             const char *src, const char *const srcEnd)
+{
+    // Leave room for a terminator.
+    const int capacity = decoder->stringBufferLength - 1;
+    for (;;) {
+        const int room = capacity - decoder->pendingLength;
+        const int count = srcEnd - src < room ? (int)(srcEnd - src) : room;
+        memcpy(decoder->stringBuffer + decoder->pendingLength, src, (size_t)count);
+        decoder->pendingLength += count;
+        src += count;
+        likely_if(src == srcEnd) { return TTSDKJSON_OK; }
+        const int result = passStringPart(decoder, context, false);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+    }
+}
+
+/** Continue with the string or name that was open at the start of this chunk,
+ * or that begins with the opening quote just consumed.
+ */
+static int decodeStringPart(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context)
+{
+    const bool isName = decoder->state == DecoderStateName;
+    char *const buffer = isName ? decoder->nameBuffer : decoder->stringBuffer;
+    const int bufferLength = isName ? decoder->nameBufferLength : decoder->stringBufferLength;
+    const char *const src = context->bufferPtr;
+    const char *scanFrom = src;
+    unlikely_if(decoder->isEscaped)
+    {
+        decoder->isEscaped = false;
+        scanFrom++;
     }
-    const char *srcEnd = src;
-    src = context->bufferPtr + 1;
-    int length = (int)(srcEnd - src);
-    if (length >= dstBufferLength) {
-        TTSDKLOG_DEBUG("String is too long");
-        return TTSDKJSON_ERROR_DATA_TOO_LONG;
+    const char *const closingQuote = findClosingQuote(scanFrom, context->bufferEnd, decoder);
+    const bool inParts = !isName && decoder->callbacks->onStringElementPart != NULL;
+    unlikely_if(closingQuote == context->bufferEnd)
+    {
+        context->bufferPtr = context->bufferEnd;
+        unlikely_if(inParts) { return gatherStringValue(decoder, context, src, closingQuote); }
+        return gatherPending(decoder, buffer, bufferLength, src, closingQuote);
     }
+    context->bufferPtr = closingQuote + 1;
 
-    context->bufferPtr = srcEnd + 1;
-
-    // If no escape characters were encountered, we can fast copy.
-    likely_if(fastCopy)
+    int result;
+    // A long string value that would have to be copied goes in parts if it can.
+    const bool isTooLong = inParts && closingQuote - src >= decoder->stringBufferLength &&
+                           (decoder->hasEscapes || decoder->callbacks->onStringElementSlice == NULL);
+    likely_if(decoder->pendingLength == 0 && !decoder->isStringInParts && !isTooLong)
     {
-        memcpy(dstBuffer, src, length);
-        dstBuffer[length] = 0;
-        return TTSDKJSON_OK;
+        // The whole string is in this chunk.
+        const bool fastCopy = !decoder->hasEscapes;
+        decoder->hasEscapes = false;
+        if (isName) {
+            decoder->state = DecoderStateColon;
+            return decodeMemberName(context, src, closingQuote, fastCopy, &decoder->memberName);
+        }
+        result = onStringValue(context, currentName(decoder), src, closingQuote, fastCopy);
+        endDecoderElement(decoder);
+        return result;
     }
 
-    char *dst = dstBuffer;
-
-    for (; src < srcEnd; src++) {
-        likely_if(*src != '\\') { *dst++ = *src; }
-        else
+    unlikely_if(inParts)
+    {
+        result = gatherStringValue(decoder, context, src, closingQuote);
+        unlikely_if(result == TTSDKJSON_OK && decoder->isStringInParts)
         {
-            src++;
-            switch (*src) {
-                case '"':
-                    *dst++ = '\"';
-                    continue;
-                case '\\':
-                    *dst++ = '\\';
-                    continue;
-                case 'n':
-                    *dst++ = '\n';
-                    continue;
-                case 'r':
-                    *dst++ = '\r';
-                    continue;
-                case '/':
-                    *dst++ = '/';
-                    continue;
-                case 't':
-                    *dst++ = '\t';
-                    continue;
-                case 'b':
-                    *dst++ = '\b';
-                    continue;
-                case 'f':
-                    *dst++ = '\f';
-                    continue;
-                case 'u': {
-                    unlikely_if(src + 5 > srcEnd)
-                    {
-                        TTSDKLOG_DEBUG("Premature end of data");
-                        return TTSDKJSON_ERROR_INCOMPLETE;
-                    }
-                    unsigned int accum = g_hexConversion[src[1]] << 12 | g_hexConversion[src[2]] << 8 |
-                                         g_hexConversion[src[3]] << 4 | g_hexConversion[src[4]];
-                    unlikely_if(accum > 0xffff)
-                    {
-                        TTSDKLOG_DEBUG("Invalid unicode sequence: %c%c%c%c", src[1], src[2], src[3], src[4]);
-                        return TTSDKJSON_ERROR_INVALID_CHARACTER;
-                    }
+            decoder->hasEscapes = false;
+            result = passStringPart(decoder, context, true);
+            endDecoderElement(decoder);
+            return result;
+        }
+    }
+    else
+    {
+        result = gatherPending(decoder, buffer, bufferLength, src, closingQuote);
+    }
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    int length;
+    result = finishPending(decoder, buffer, &length);
+    decoder->hasEscapes = false;
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    if (isName) {
+        decoder->memberName = internName(context, buffer, length);
+        decoder->state = DecoderStateColon;
+        return TTSDKJSON_OK;
+    }
+    result = onDecodedString(context, currentName(decoder), buffer, length);
+    endDecoderElement(decoder);
+    return result;
+}
 
-                    // UTF-16 Trail surrogate on its own.
-                    unlikely_if(accum >= 0xdc00 && accum <= 0xdfff)
-                    {
-                        TTSDKLOG_DEBUG("Unexpected trail surrogate: 0x%04x", accum);
-                        return TTSDKJSON_ERROR_INVALID_CHARACTER;
-                    }
+/** Decode the number or literal that runs up to end.
+ *
+ * At the top level, only the first is decoded and anything after it is
+ * ignored, as it is by ttsdkjson_decode().
+ */
+static inline int decodeDecoderScalar(TTSDKJSONDecoder *const decoder, const char *const name,
+                                      TTSDKJSONDecodeContext *const context, const char *const end)
+{
+    unlikely_if(decoder->depth == 0) { return decodeScalar(name, context); }
+    return decodeScalarRun(name, context, end);
+}
 
-                    // UTF-16 Lead surrogate.
-                    unlikely_if(accum >= 0xd800 && accum <= 0xdbff)
-                    {
-                        // Fetch trail surrogate.
-                        unlikely_if(src + 11 > srcEnd)
-                        {
-                            TTSDKLOG_DEBUG("Premature end of data");
-                            return TTSDKJSON_ERROR_INCOMPLETE;
-                        }
-                        unlikely_if(src[5] != '\\' || src[6] != 'u')
-                        {
-                            TTSDKLOG_DEBUG("Expected \"\\u\" but got: \"%c%c\"", src[5], src[6]);
-                            return TTSDKJSON_ERROR_INVALID_CHARACTER;
-                        }
-                        src += 6;
-                        unsigned int accum2 = g_hexConversion[src[1]] << 12 | g_hexConversion[src[2]] << 8 |
-                                              g_hexConversion[src[3]] << 4 | g_hexConversion[src[4]];
-                        unlikely_if(accum2 < 0xdc00 || accum2 > 0xdfff)
-                        {
-                            TTSDKLOG_DEBUG("Invalid trail surrogate: 0x%04x", accum2);
-                            return TTSDKJSON_ERROR_INVALID_CHARACTER;
-                        }
-                        // And combine 20 bit result.
-                        accum = ((accum - 0xd800) << 10) | (accum2 - 0xdc00);
-                    }
+/** Decode a number or literal that was gathered from more than one chunk.
+ *
+ * @param name The element's name.
+ */
+static int finishDecoderScalar(TTSDKJSONDecoder *const decoder, const char *const name)
+{
+    char *const buffer = decoder->scalarBuffer;
+    const int length = decoder->pendingLength;
+    decoder->pendingLength = 0;
+    // Follow it with whitespace so that it doesn't look cut off.
+    buffer[length] = ' ';
+    TTSDKJSONDecodeContext context = decoderContext(decoder, buffer, buffer + length + 1);
+    return decodeDecoderScalar(decoder, name, &context, buffer + length);
+}
 
-                    int result = writeUTF8(accum, &dst);
-                    unlikely_if(result != TTSDKJSON_OK) { return result; }
-                    src += 4;
-                    continue;
-                }
-                default:
-                    TTSDKLOG_DEBUG("Invalid control character '%c'", *src);
-                    return TTSDKJSON_ERROR_INVALID_CHARACTER;
-            }
-        }
+/** Continue with the number or literal that was open at the start of this
+ * chunk, or that begins at the current position.
+ */
+static int decodeScalarPart(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context)
+{
+    const char *const src = context->bufferPtr;
+    const char *delimiter = src;
+    while (delimiter < context->bufferEnd && !isScalarDelimiter(*delimiter)) {
+        delimiter++;
+    }
+    unlikely_if(delimiter == context->bufferEnd)
+    {
+        context->bufferPtr = context->bufferEnd;
+        decoder->state = DecoderStateScalar;
+        return gatherPending(decoder, decoder->scalarBuffer, sizeof(decoder->scalarBuffer) - 1, src, delimiter);
     }
 
-    *dst = 0;
-    return TTSDKJSON_OK;
+    const char *const name = currentName(decoder);
+    int result;
+    likely_if(decoder->pendingLength == 0)
+    {
+        result = decodeDecoderScalar(decoder, name, context, delimiter);
+    } else {
+        result = gatherPending(decoder, decoder->scalarBuffer, sizeof(decoder->scalarBuffer) - 1, src, delimiter);
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+        result = finishDecoderScalar(decoder, name);
+        context->bufferPtr = delimiter;
+    }
+    endDecoderElement(decoder);
+    return result;
 }
 
-static int decodeElement(const char *const name, TTSDKJSONDecodeContext *context)
+static int beginDecoderContainer(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context,
+                                 const bool isObject)
 {
-    SKIP_WHITESPACE(context);
-    unlikely_if(context->bufferPtr >= context->bufferEnd)
+    unlikely_if(decoder->depth >= TTSDKJSON_DECODER_MAX_DEPTH)
     {
-        TTSDKLOG_DEBUG("Premature end of data");
-        return TTSDKJSON_ERROR_INCOMPLETE;
+        TTSDKLOG_DEBUG("Containers are nested too deeply");
+        return TTSDKJSON_ERROR_DATA_TOO_LONG;
     }
+    const char *const name = currentName(decoder);
+    const int level = decoder->depth++;
+    if (isObject) {
+        decoder->isObject[level / 8] |= (uint8_t)(1 << (level % 8));
+    } else {
+        decoder->isObject[level / 8] &= (uint8_t) ~(1 << (level % 8));
+    }
+    decoder->state = DecoderStateElement;
+    context->bufferPtr++;
+    return isObject ? decoder->callbacks->onBeginObject(name, decoder->userData)
+                    : decoder->callbacks->onBeginArray(name, decoder->userData);
+}
 
-    int sign = 1;
-    int result;
+static int endDecoderContainer(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context)
+{
+    context->bufferPtr++;
+    decoder->depth--;
+    endDecoderElement(decoder);
+    return decoder->callbacks->onEndContainer(decoder->userData);
+}
 
+static int decodeValueStart(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context)
+{
     switch (*context->bufferPtr) {
-        case '[': {
+        case '[':
+            return beginDecoderContainer(decoder, context, false);
+        case '{':
+            return beginDecoderContainer(decoder, context, true);
+        case '\"':
             context->bufferPtr++;
-            result = context->callbacks->onBeginArray(name, context->userData);
-            unlikely_if(result != TTSDKJSON_OK) return result;
-            while (context->bufferPtr < context->bufferEnd) {
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
-                unlikely_if(*context->bufferPtr == ']')
-                {
-                    context->bufferPtr++;
-                    return context->callbacks->onEndContainer(context->userData);
-                }
-                result = decodeElement(NULL, context);
-                unlikely_if(result != TTSDKJSON_OK) return result;
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
-                likely_if(*context->bufferPtr == ',') { context->bufferPtr++; }
+            decoder->state = DecoderStateString;
+            return decodeStringPart(decoder, context);
+        default:
+            return decodeScalarPart(decoder, context);
+    }
+}
+
+/** Handle the next non-whitespace byte between elements.
+ *
+ * The same leniency as decodeElement() applies: commas between elements
+ * are optional, and one may follow the last element.
+ */
+static int decodeStructure(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context)
+{
+    const char ch = *context->bufferPtr;
+    switch (decoder->state) {
+        case DecoderStateAfterElement:
+            likely_if(ch == ',') { context->bufferPtr++; }
+            decoder->state = DecoderStateElement;
+            return TTSDKJSON_OK;
+        case DecoderStateColon:
+            unlikely_if(ch != ':')
+            {
+                TTSDKLOG_DEBUG("Expected ':' but got '%c'", ch);
+                return TTSDKJSON_ERROR_INVALID_CHARACTER;
             }
-            TTSDKLOG_DEBUG("Premature end of data");
-            return TTSDKJSON_ERROR_INCOMPLETE;
-        }
-        case '{': {
             context->bufferPtr++;
-            result = context->callbacks->onBeginObject(name, context->userData);
-            unlikely_if(result != TTSDKJSON_OK) return result;
-            while (context->bufferPtr < context->bufferEnd) {
-                SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
-                unlikely_if(*context->bufferPtr == '}')
+            decoder->state = DecoderStateValue;
+            return TTSDKJSON_OK;
+        case DecoderStateElement:
+            if (isInObject(decoder)) {
+                unlikely_if(ch == '}') { return endDecoderContainer(decoder, context); }
+                unlikely_if(ch != '\"')
                 {
-                    context->bufferPtr++;
-                    return context->callbacks->onEndContainer(context->userData);
+                    TTSDKLOG_DEBUG("Expected '\"' but got '%c'", ch);
+                    return TTSDKJSON_ERROR_INVALID_CHARACTER;
                 }
-                result = decodeString(context, context->nameBuffer, context->nameBufferLength);
-                unlikely_if(result != TTSDKJSON_OK) return result;
+                context->bufferPtr++;
+                decoder->state = DecoderStateName;
+                return decodeStringPart(decoder, context);
+            }
+            unlikely_if(ch == ']') { return endDecoderContainer(decoder, context); }
+            return decodeValueStart(decoder, context);
+        default:
+            return decodeValueStart(decoder, context);
+    }
+}
+
+static int feedDecoder(TTSDKJSONDecoder *const decoder, TTSDKJSONDecodeContext *const context)
+{
+    while (context->bufferPtr < context->bufferEnd) {
+        int result;
+        switch (decoder->state) {
+            case DecoderStateName:
+            case DecoderStateString:
+                result = decodeStringPart(decoder, context);
+                break;
+            case DecoderStateScalar:
+                result = decodeScalarPart(decoder, context);
+                break;
+            case DecoderStateDone:
+                // Anything after the top-level element is ignored, as it is by ttsdkjson_decode().
+                likely_if(!decoder->rejectsTrailingData) { return TTSDKJSON_OK; }
                 SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
-                unlikely_if(*context->bufferPtr != ':')
+                unlikely_if(context->bufferPtr < context->bufferEnd)
                 {
-                    TTSDKLOG_DEBUG("Expected ':' but got '%c'", *context->bufferPtr);
+                    TTSDKLOG_DEBUG("Unexpected data after the top-level element: %c", *context->bufferPtr);
                     return TTSDKJSON_ERROR_INVALID_CHARACTER;
                 }
-                context->bufferPtr++;
-                SKIP_WHITESPACE(context);
-                result = decodeElement(context->nameBuffer, context);
-                unlikely_if(result != TTSDKJSON_OK) return result;
+                return TTSDKJSON_OK;
+            default:
                 SKIP_WHITESPACE(context);
-                unlikely_if(context->bufferPtr >= context->bufferEnd) { break; }
-                likely_if(*context->bufferPtr == ',') { context->bufferPtr++; }
-            }
-            TTSDKLOG_DEBUG("Premature end of data");
-            return TTSDKJSON_ERROR_INCOMPLETE;
+                unlikely_if(context->bufferPtr >= context->bufferEnd) { return TTSDKJSON_OK; }
+                result = decodeStructure(decoder, context);
+                break;
         }
-        case '\"': {
-            result = decodeString(context, context->stringBuffer, context->stringBufferLength);
-            unlikely_if(result != TTSDKJSON_OK) return result;
-            result = context->callbacks->onStringElement(name, context->stringBuffer, context->userData);
-            return result;
+        unlikely_if(result != TTSDKJSON_OK) { return result; }
+    }
+    return TTSDKJSON_OK;
+}
+
+void ttsdkjson_decoderInit(TTSDKJSONDecoder *const decoder, char *const stringBuffer, const int stringBufferLength,
+                           TTSDKJSONDecodeCallbacks *const callbacks, void *const userData)
+{
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->callbacks = callbacks;
+    decoder->userData = userData;
+    decoder->nameBuffer = stringBuffer;
+    decoder->nameBufferLength = stringBufferLength / 4;
+    decoder->stringBuffer = stringBuffer + decoder->nameBufferLength;
+    decoder->stringBufferLength = stringBufferLength - decoder->nameBufferLength;
+    decoder->state = DecoderStateValue;
+}
+
+int ttsdkjson_decoderFeed(TTSDKJSONDecoder *const decoder, const char *const data, const int length)
+{
+    unlikely_if(decoder->result != TTSDKJSON_OK) { return decoder->result; }
+    TTSDKJSONDecodeContext context = decoderContext(decoder, data, data + length);
+    decoder->result = feedDecoder(decoder, &context);
+    return decoder->result;
+}
+
+int ttsdkjson_decoderFinish(TTSDKJSONDecoder *const decoder)
+{
+    unlikely_if(decoder->result != TTSDKJSON_OK) { return decoder->result; }
+    if (decoder->state == DecoderStateScalar && decoder->depth == 0) {
+        decoder->result = finishDecoderScalar(decoder, decoder->rootName);
+        unlikely_if(decoder->result != TTSDKJSON_OK) { return decoder->result; }
+        decoder->state = DecoderStateDone;
+    }
+    unlikely_if(decoder->state != DecoderStateDone)
+    {
+        TTSDKLOG_DEBUG("Premature end of data");
+        decoder->result = TTSDKJSON_ERROR_INCOMPLETE;
+        return decoder->result;
+    }
+    decoder->result = decoder->callbacks->onEndData(decoder->userData);
+    return decoder->result;
+}
+
+// ============================================================================
+#pragma mark - Records -
+// ============================================================================
+
+/** Read more of the file into the reader's buffer, replacing what was there.
+ *
+ * @return true if there's more data.
+ */
+static bool refillRecordReader(TTSDKJSONRecordReader *const reader)
+{
+    reader->readPosition = 0;
+    reader->readLength = 0;
+    unlikely_if(reader->isAtEnd) { return false; }
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(reader->fd, reader->readBuffer, (size_t)reader->readBufferLength);
+    } while (bytesRead < 0 && errno == EINTR);
+    unlikely_if(bytesRead <= 0)
+    {
+        unlikely_if(bytesRead < 0) { TTSDKLOG_ERROR("Could not read records: %s", strerror(errno)); }
+        reader->isAtEnd = true;
+        return false;
+    }
+    reader->readLength = (int)bytesRead;
+    return true;
+}
+
+void ttsdkjson_beginRecordReader(TTSDKJSONRecordReader *const reader, const int fd, char *const readBuffer,
+                                 const int readBufferLength, char *const stringBuffer, const int stringBufferLength,
+                                 TTSDKJSONDecodeCallbacks *const callbacks, void *const userData)
+{
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = fd;
+    reader->readBuffer = readBuffer;
+    reader->readBufferLength = readBufferLength;
+    reader->lineNumber = 1;
+    reader->stringBuffer = stringBuffer;
+    reader->stringBufferLength = stringBufferLength;
+    reader->callbacks = callbacks;
+    reader->userData = userData;
+}
+
+bool ttsdkjson_readRecord(TTSDKJSONRecordReader *const reader, int *const result, int *const lineNumber)
+{
+    // Skip blank lines.
+    for (;;) {
+        unlikely_if(reader->readPosition >= reader->readLength && !refillRecordReader(reader)) { return false; }
+        const char ch = reader->readBuffer[reader->readPosition];
+        likely_if(!isspace((unsigned char)ch)) { break; }
+        if (ch == '\n') {
+            reader->lineNumber++;
         }
-        case 'f': {
-            unlikely_if(context->bufferEnd - context->bufferPtr < 5)
-            {
-                TTSDKLOG_DEBUG("Premature end of data");
-                return TTSDKJSON_ERROR_INCOMPLETE;
-            }
-            unlikely_if(!(context->bufferPtr[1] == 'a' && context->bufferPtr[2] == 'l' &&
-                          context->bufferPtr[3] == 's' && context->bufferPtr[4] == 'e'))
-            {
-                TTSDKLOG_DEBUG("Expected \"false\" but got \"f%c%c%c%c\"", context->bufferPtr[1], context->bufferPtr[2],
-                            context->bufferPtr[3], context->bufferPtr[4]);
-                return TTSDKJSON_ERROR_INVALID_CHARACTER;
-            }
-            context->bufferPtr += 5;
-            return context->callbacks->onBooleanElement(name, false, context->userData);
+        reader->readPosition++;
+    }
+
+    if (lineNumber != NULL) {
+        *lineNumber = reader->lineNumber;
+    }
+    ttsdkjson_decoderInit(&reader->decoder, reader->stringBuffer, reader->stringBufferLength, reader->callbacks,
+                          reader->userData);
+    reader->decoder.rejectsTrailingData = true;
+    for (;;) {
+        const char *const start = reader->readBuffer + reader->readPosition;
+        const int length = reader->readLength - reader->readPosition;
+        const char *const newline = memchr(start, '\n', (size_t)length);
+        const int pieceLength = newline != NULL ? (int)(newline - start) : length;
+        // Once the decoder has failed, the rest of the line is only stepped over.
+        likely_if(reader->decoder.result == TTSDKJSON_OK) { ttsdkjson_decoderFeed(&reader->decoder, start, pieceLength); }
+        if (newline != NULL) {
+            reader->readPosition += pieceLength + 1;
+            reader->lineNumber++;
+            break;
         }
-        case 't': {
-            unlikely_if(context->bufferEnd - context->bufferPtr < 4)
-            {
-                TTSDKLOG_DEBUG("Premature end of data");
-                return TTSDKJSON_ERROR_INCOMPLETE;
-            }
-            unlikely_if(!(context->bufferPtr[1] == 'r' && context->bufferPtr[2] == 'u' && context->bufferPtr[3] == 'e'))
-            {
-                TTSDKLOG_DEBUG("Expected \"true\" but got \"t%c%c%c\"", context->bufferPtr[1], context->bufferPtr[2],
-                            context->bufferPtr[3]);
-                return TTSDKJSON_ERROR_INVALID_CHARACTER;
-            }
-            context->bufferPtr += 4;
-            return context->callbacks->onBooleanElement(name, true, context->userData);
+        reader->readPosition = reader->readLength;
+        unlikely_if(!refillRecordReader(reader)) { break; }
+    }
+    *result = ttsdkjson_decoderFinish(&reader->decoder);
+    return true;
+}
+
+// ============================================================================
+#pragma mark - Splice -
+// ============================================================================
+
+/* Embedded JSON that is valid gets copied straight to the output instead of
+ * being decoded and re-encoded. A first pass checks structure and UTF-8, and a
+ * second pass copies the bytes, only rewriting the whitespace between tokens
+ * to match the encoder's formatting.
+ */
+
+/** The size of the buffer used to read files when splicing. */
+#define kSpliceReadBufferSize 1024
+
+/** The most containers an embedded element may nest. */
+#define kSpliceMaxDepth 200
+
+typedef enum {
+    SpliceStateValue,
+    SpliceStateValueOrEnd,
+    SpliceStateKey,
+    SpliceStateKeyOrEnd,
+    SpliceStateColon,
+    SpliceStateCommaOrEnd,
+    SpliceStateString,
+    SpliceStateStringEscape,
+    SpliceStateStringUnicode,
+    SpliceStateNumberMinus,
+    SpliceStateNumberZero,
+    SpliceStateNumberInteger,
+    SpliceStateNumberFractionStart,
+    SpliceStateNumberFraction,
+    SpliceStateNumberExponentStart,
+    SpliceStateNumberExponentSign,
+    SpliceStateNumberExponent,
+    SpliceStateLiteral,
+} SpliceState;
+
+typedef enum {
+    SpliceResultNeedMore,
+    SpliceResultComplete,
+    SpliceResultInvalid,
+} SpliceResult;
+
+typedef struct {
+    SpliceState state;
+    /** How many containers are open. */
+    int depth;
+    /** The most containers allowed to be open. */
+    int maxDepth;
+    /** One bit per open container: set for objects. */
+    uint64_t isObject[(kSpliceMaxDepth + 63) / 64];
+    /** true if the current string is an object key. */
+    bool isKey;
+    /** Hex digits left in a \u escape, and the value so far. */
+    int hexDigitsRemaining;
+    unsigned int escapedCharacter;
+    /** true after a \u escape of a high surrogate, which must be followed by a low one. */
+    bool needsLowSurrogate;
+    /** Continuation bytes left in a UTF-8 sequence, and the range the next one must be in. */
+    int utf8Remaining;
+    unsigned char utf8Lower;
+    unsigned char utf8Upper;
+    /** The rest of the literal (true, false, null) being matched. */
+    const char *literal;
+    /** Bytes validated before the current chunk. */
+    int64_t offset;
+    /** The length of the element, including leading whitespace, once it's complete. */
+    int64_t elementLength;
+    /** true if the element is an object or array. */
+    bool isContainer;
+    /** true if the last container to close was empty. */
+    bool wasEmptyContainer;
+} SpliceValidator;
+
+static void initSpliceValidator(SpliceValidator *const validator, const int maxDepth)
+{
+    memset(validator, 0, sizeof(*validator));
+    validator->state = SpliceStateValue;
+    validator->maxDepth = maxDepth < kSpliceMaxDepth ? maxDepth : kSpliceMaxDepth;
+}
+
+static inline bool isSpliceWhitespace(const unsigned char ch)
+{
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+/** Skip whitespace, checking 8 spaces at a time for pretty printed indentation. */
+static inline const char *skipSpliceWhitespace(const char *src, const char *const end)
+{
+    while (src < end && isSpliceWhitespace((unsigned char)*src)) {
+        src++;
+        while (end - src >= 8) {
+            uint64_t word;
+            memcpy(&word, src, sizeof(word));
+            likely_if(word != 0x2020202020202020ull) { break; }
+            src += 8;
         }
-        case 'n': {
-            unlikely_if(context->bufferEnd - context->bufferPtr < 4)
-            {
-                TTSDKLOG_DEBUG("Premature end of data");
-                return TTSDKJSON_ERROR_INCOMPLETE;
-            }
-            unlikely_if(!(context->bufferPtr[1] == 'u' && context->bufferPtr[2] == 'l' && context->bufferPtr[3] == 'l'))
-            {
-                TTSDKLOG_DEBUG("Expected \"null\" but got \"n%c%c%c\"", context->bufferPtr[1], context->bufferPtr[2],
-                            context->bufferPtr[3]);
-                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    }
+    return src;
+}
+
+static inline const unsigned char *skipSpliceDigits(const unsigned char *src, const unsigned char *const end)
+{
+    while (src < end && *src >= '0' && *src <= '9') {
+        src++;
+    }
+    return src;
+}
+
+static inline bool spliceIsInObject(const SpliceValidator *const validator)
+{
+    const int index = validator->depth - 1;
+    return (validator->isObject[index / 64] >> (index % 64)) & 1;
+}
+
+/** Check that a run of string contents is valid UTF-8. Sequences may
+ * continue into the next run.
+ */
+static bool validateUTF8(SpliceValidator *const validator, const unsigned char *src, const unsigned char *const end)
+{
+    while (src < end) {
+        likely_if(validator->utf8Remaining == 0)
+        {
+            while (end - src >= 8) {
+                uint64_t word;
+                memcpy(&word, src, sizeof(word));
+                unlikely_if(word & 0x8080808080808080ull) { break; }
+                src += 8;
             }
-            context->bufferPtr += 4;
-            return context->callbacks->onNullElement(name, context->userData);
-        }
-        case '-':
-            sign = -1;
-            context->bufferPtr++;
-            unlikely_if(!isdigit(*context->bufferPtr))
-            {
-                TTSDKLOG_DEBUG("Not a digit: '%c'", *context->bufferPtr);
-                return TTSDKJSON_ERROR_INVALID_CHARACTER;
+            while (src < end && *src < 0x80) {
+                src++;
             }
-            // Fall through
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9': {
-            // Try integer conversion.
-            uint64_t accum = 0;
-            bool isOverflow = false;
-            const char *const start = context->bufferPtr;
+            unlikely_if(src >= end) { break; }
 
-            for (; context->bufferPtr < context->bufferEnd && isdigit(*context->bufferPtr); context->bufferPtr++) {
-                unlikely_if((isOverflow = accum > (ULLONG_MAX / 10))) { break; }
-                accum *= 10;
-                uint64_t nextDigit = (uint64_t)(*context->bufferPtr - '0');
-                unlikely_if((isOverflow = accum > (ULLONG_MAX - nextDigit))) { break; }
-                accum += nextDigit;
+            // Reject overlong forms, surrogates and anything past U+10FFFF (RFC 3629).
+            const unsigned char ch = *src++;
+            validator->utf8Lower = 0x80;
+            validator->utf8Upper = 0xbf;
+            if (ch >= 0xc2 && ch <= 0xdf) {
+                validator->utf8Remaining = 1;
+            } else if (ch >= 0xe0 && ch <= 0xef) {
+                validator->utf8Remaining = 2;
+                if (ch == 0xe0) {
+                    validator->utf8Lower = 0xa0;
+                } else if (ch == 0xed) {
+                    validator->utf8Upper = 0x9f;
+                }
+            } else if (ch >= 0xf0 && ch <= 0xf4) {
+                validator->utf8Remaining = 3;
+                if (ch == 0xf0) {
+                    validator->utf8Lower = 0x90;
+                } else if (ch == 0xf4) {
+                    validator->utf8Upper = 0x8f;
+                }
+            } else {
+                return false;
             }
+        }
+        else
+        {
+            const unsigned char ch = *src++;
+            unlikely_if(ch < validator->utf8Lower || ch > validator->utf8Upper) { return false; }
+            validator->utf8Lower = 0x80;
+            validator->utf8Upper = 0xbf;
+            validator->utf8Remaining--;
+        }
+    }
+    return true;
+}
 
-            unlikely_if(context->bufferPtr >= context->bufferEnd)
-            {
-                TTSDKLOG_DEBUG("Premature end of data");
-                return TTSDKJSON_ERROR_INCOMPLETE;
+/** Called when a value is complete, to decide what comes next. */
+static inline SpliceResult endSpliceValue(SpliceValidator *const validator, const int64_t position)
+{
+    unlikely_if(validator->depth == 0)
+    {
+        validator->elementLength = validator->offset + position;
+        return SpliceResultComplete;
+    }
+    validator->state = SpliceStateCommaOrEnd;
+    return SpliceResultNeedMore;
+}
+
+/** Validate the next chunk of an element.
+ *
+ * @param validator The validator.
+ *
+ * @param data The chunk.
+ *
+ * @param length The length of the chunk.
+ *
+ * @return SpliceResultComplete once the element has ended (see elementLength).
+ */
+static SpliceResult validateSpliceChunk(SpliceValidator *const validator, const char *const data, const int length)
+{
+    const unsigned char *const start = (const unsigned char *)data;
+    const unsigned char *const end = start + length;
+    const unsigned char *src = start;
+    SpliceResult result = SpliceResultNeedMore;
+
+    while (src < end) {
+        const unsigned char ch = *src;
+        switch (validator->state) {
+            case SpliceStateString: {
+                unlikely_if(validator->needsLowSurrogate && ch != '\\') { return SpliceResultInvalid; }
+                const unsigned char *special =
+                    (const unsigned char *)findEscapeCandidate((const char *)src, (const char *)end);
+                unlikely_if(!validateUTF8(validator, src, special)) { return SpliceResultInvalid; }
+                src = special;
+                unlikely_if(src >= end) { break; }
+                unlikely_if(*src != '\"' && *src != '\\') { return SpliceResultInvalid; }
+                unlikely_if(validator->utf8Remaining > 0) { return SpliceResultInvalid; }
+                src++;
+                if (src[-1] == '\\') {
+                    validator->state = SpliceStateStringEscape;
+                } else if (validator->isKey) {
+                    validator->state = SpliceStateColon;
+                } else {
+                    result = endSpliceValue(validator, src - start);
+                }
+                break;
             }
+            case SpliceStateStringEscape:
+                unlikely_if(validator->needsLowSurrogate && ch != 'u') { return SpliceResultInvalid; }
+                switch (ch) {
+                    case '\"':
+                    case '\\':
+                    case '/':
+                    case 'b':
+                    case 'f':
+                    case 'n':
+                    case 'r':
+                    case 't':
+                        validator->state = SpliceStateString;
+                        break;
+                    case 'u':
+                        validator->state = SpliceStateStringUnicode;
+                        validator->hexDigitsRemaining = 4;
+                        validator->escapedCharacter = 0;
+                        break;
+                    default:
+                        return SpliceResultInvalid;
+                }
+                src++;
+                break;
+            case SpliceStateStringUnicode:
+                unlikely_if(g_hexConversion[ch] == INV) { return SpliceResultInvalid; }
+                validator->escapedCharacter = validator->escapedCharacter << 4 | g_hexConversion[ch];
+                src++;
+                unlikely_if(--validator->hexDigitsRemaining == 0)
+                {
+                    // Surrogates must come in pairs.
+                    const unsigned int character = validator->escapedCharacter;
+                    const bool isHighSurrogate = character >= 0xd800 && character <= 0xdbff;
+                    const bool isLowSurrogate = character >= 0xdc00 && character <= 0xdfff;
+                    unlikely_if(isLowSurrogate != validator->needsLowSurrogate) { return SpliceResultInvalid; }
+                    validator->needsLowSurrogate = isHighSurrogate;
+                    validator->state = SpliceStateString;
+                }
+                break;
+            case SpliceStateValue:
+            case SpliceStateValueOrEnd:
+            case SpliceStateKey:
+            case SpliceStateKeyOrEnd:
+            case SpliceStateColon:
+            case SpliceStateCommaOrEnd:
+                likely_if(isSpliceWhitespace(ch))
+                {
+                    src = (const unsigned char *)skipSpliceWhitespace((const char *)src, (const char *)end);
+                    break;
+                }
+                if (validator->state == SpliceStateColon) {
+                    unlikely_if(ch != ':') { return SpliceResultInvalid; }
+                    validator->state = SpliceStateValue;
+                    src++;
+                    break;
+                }
+                if (validator->state == SpliceStateCommaOrEnd) {
+                    if (ch == ',') {
+                        validator->state = spliceIsInObject(validator) ? SpliceStateKey : SpliceStateValue;
+                        src++;
+                        break;
+                    }
+                    unlikely_if(ch != (spliceIsInObject(validator) ? '}' : ']')) { return SpliceResultInvalid; }
+                    validator->wasEmptyContainer = false;
+                    validator->depth--;
+                    src++;
+                    result = endSpliceValue(validator, src - start);
+                    break;
+                }
+                if (validator->state == SpliceStateKey || validator->state == SpliceStateKeyOrEnd) {
+                    if (ch == '}' && validator->state == SpliceStateKeyOrEnd) {
+                        validator->wasEmptyContainer = true;
+                        validator->depth--;
+                        src++;
+                        result = endSpliceValue(validator, src - start);
+                        break;
+                    }
+                    unlikely_if(ch != '\"') { return SpliceResultInvalid; }
+                    validator->state = SpliceStateString;
+                    validator->isKey = true;
+                    src++;
+                    break;
+                }
+                if (ch == ']' && validator->state == SpliceStateValueOrEnd) {
+                    validator->wasEmptyContainer = true;
+                    validator->depth--;
+                    src++;
+                    result = endSpliceValue(validator, src - start);
+                    break;
+                }
 
-            if (!isFPChar(*context->bufferPtr) && !isOverflow) {
-                if (sign > 0) {
-                    if (accum <= (uint64_t)LLONG_MAX) {
-                        // Positive number within int64_t range
-                        return context->callbacks->onIntegerElement(name, (int64_t)accum, context->userData);
-                    } else {
-                        // Positive number exceeding int64_t range, use unsigned
-                        return context->callbacks->onUnsignedIntegerElement(name, accum, context->userData);
+                // The start of a value.
+                src++;
+                switch (ch) {
+                    case '{':
+                    case '[': {
+                        unlikely_if(validator->depth >= validator->maxDepth) { return SpliceResultInvalid; }
+                        unlikely_if(validator->depth == 0) { validator->isContainer = true; }
+                        const int index = validator->depth++;
+                        const uint64_t bit = 1ull << (index % 64);
+                        if (ch == '{') {
+                            validator->isObject[index / 64] |= bit;
+                            validator->state = SpliceStateKeyOrEnd;
+                        } else {
+                            validator->isObject[index / 64] &= ~bit;
+                            validator->state = SpliceStateValueOrEnd;
+                        }
+                        break;
                     }
+                    case '\"':
+                        validator->state = SpliceStateString;
+                        validator->isKey = false;
+                        break;
+                    case '-':
+                        validator->state = SpliceStateNumberMinus;
+                        break;
+                    case '0':
+                        validator->state = SpliceStateNumberZero;
+                        break;
+                    case '1':
+                    case '2':
+                    case '3':
+                    case '4':
+                    case '5':
+                    case '6':
+                    case '7':
+                    case '8':
+                    case '9':
+                        validator->state = SpliceStateNumberInteger;
+                        break;
+                    case 't':
+                        validator->state = SpliceStateLiteral;
+                        validator->literal = "rue";
+                        break;
+                    case 'f':
+                        validator->state = SpliceStateLiteral;
+                        validator->literal = "alse";
+                        break;
+                    case 'n':
+                        validator->state = SpliceStateLiteral;
+                        validator->literal = "ull";
+                        break;
+                    default:
+                        return SpliceResultInvalid;
+                }
+                break;
+            case SpliceStateLiteral:
+                unlikely_if(ch != (unsigned char)*validator->literal) { return SpliceResultInvalid; }
+                src++;
+                if (*++validator->literal == '\0') {
+                    result = endSpliceValue(validator, src - start);
+                }
+                break;
+            case SpliceStateNumberMinus:
+                unlikely_if(ch < '0' || ch > '9') { return SpliceResultInvalid; }
+                validator->state = ch == '0' ? SpliceStateNumberZero : SpliceStateNumberInteger;
+                src++;
+                break;
+            case SpliceStateNumberFractionStart:
+            case SpliceStateNumberExponentSign:
+                unlikely_if(ch < '0' || ch > '9') { return SpliceResultInvalid; }
+                validator->state = validator->state == SpliceStateNumberFractionStart ? SpliceStateNumberFraction
+                                                                                      : SpliceStateNumberExponent;
+                src++;
+                break;
+            case SpliceStateNumberExponentStart:
+                if (ch == '+' || ch == '-') {
+                    validator->state = SpliceStateNumberExponentSign;
                 } else {
-                    if (accum <= ((uint64_t)LLONG_MAX + 1)) {
-                        // Negative number within int64_t range
-                        int64_t signedAccum = -(int64_t)accum;
-                        return context->callbacks->onIntegerElement(name, signedAccum, context->userData);
-                    }
-                    // If negative and exceeding int64_t range, fall through to floating point
+                    unlikely_if(ch < '0' || ch > '9') { return SpliceResultInvalid; }
+                    validator->state = SpliceStateNumberExponent;
                 }
-            }
+                src++;
+                break;
+            case SpliceStateNumberZero:
+            case SpliceStateNumberInteger:
+            case SpliceStateNumberFraction:
+            case SpliceStateNumberExponent:
+                if (ch >= '0' && ch <= '9') {
+                    // No leading zeros.
+                    unlikely_if(validator->state == SpliceStateNumberZero) { return SpliceResultInvalid; }
+                    src = skipSpliceDigits(src + 1, end);
+                } else if (ch == '.' &&
+                           (validator->state == SpliceStateNumberZero || validator->state == SpliceStateNumberInteger)) {
+                    validator->state = SpliceStateNumberFractionStart;
+                    src++;
+                } else if ((ch == 'e' || ch == 'E') && validator->state != SpliceStateNumberExponent) {
+                    validator->state = SpliceStateNumberExponentStart;
+                    src++;
+                } else {
+                    // This character isn't part of the number, so look at it again.
+                    result = endSpliceValue(validator, src - start);
+                }
+                break;
+        }
+        unlikely_if(result != SpliceResultNeedMore) { return result; }
+    }
+    validator->offset += length;
+    return SpliceResultNeedMore;
+}
 
-            while (context->bufferPtr < context->bufferEnd && isFPChar(*context->bufferPtr)) {
-                context->bufferPtr++;
-            }
+/** Finish validating once there's no more input.
+ *
+ * @return SpliceResultComplete if the input was a single number (which has no terminator).
+ */
+static SpliceResult finishSpliceValidation(SpliceValidator *const validator)
+{
+    if (validator->depth == 0) {
+        switch (validator->state) {
+            case SpliceStateNumberZero:
+            case SpliceStateNumberInteger:
+            case SpliceStateNumberFraction:
+            case SpliceStateNumberExponent:
+                validator->elementLength = validator->offset;
+                return SpliceResultComplete;
+            default:
+                break;
+        }
+    }
+    return SpliceResultInvalid;
+}
 
-            unlikely_if(context->bufferPtr >= context->bufferEnd)
-            {
-                TTSDKLOG_DEBUG("Premature end of data");
-                return TTSDKJSON_ERROR_INCOMPLETE;
-            }
+typedef struct {
+    TTSDKJSONEncodeContext *context;
+    /** The encoder's container level when the element was started. */
+    int baseLevel;
+    /** How many containers are open. */
+    int depth;
+    /** Bytes of the element left to copy. */
+    int64_t remaining;
+    bool isInString;
+    bool isEscaped;
+    /** true right after a container opens, until something goes in it. */
+    bool isOpenPending;
+    /** The element's name, for the section index. */
+    const char *name;
+    /** Where the element starts in the output, for the section index. */
+    int64_t startOffset;
+} Splicer;
 
-            // our buffer is not necessarily NULL-terminated, so
-            // it would be undefined to call sscanf/sttod etc. directly.
-            // instead we create a temporary string.
-            double value;
-            int len = (int)(context->bufferPtr - start);
-            if (len >= context->stringBufferLength) {
-                TTSDKLOG_DEBUG("Number is too long.");
-                return TTSDKJSON_ERROR_DATA_TOO_LONG;
-            }
-            strncpy(context->stringBuffer, start, len);
-            context->stringBuffer[len] = '\0';
+static int addSpliceIndentation(Splicer *const splicer, const int level)
+{
+    int result = addJSONData(splicer->context, "\n", 1);
+    for (int i = 0; i < level && result == TTSDKJSON_OK; i++) {
+        result = addJSONData(splicer->context, "    ", 4);
+    }
+    return result;
+}
 
-            sscanf(context->stringBuffer, "%lg", &value);
+/** Send a run of an element's bytes to the encoder. */
+static inline int addSpliceRun(TTSDKJSONEncodeContext *const context, const char *const run, const char *const runEnd)
+{
+    likely_if(runEnd > run) { return addJSONData(context, run, (int)(runEnd - run)); }
+    return TTSDKJSON_OK;
+}
 
-            value *= sign;
-            return context->callbacks->onFloatingPointElement(name, value, context->userData);
+/** Skip to the closing quote or next escape of a string that's being spliced.
+ *
+ * @return The position after the string, or end if it continues past end.
+ */
+static inline const char *skipSpliceString(Splicer *const splicer, const char *src, const char *const end)
+{
+    while (src < end) {
+        if (splicer->isEscaped) {
+            splicer->isEscaped = false;
+            src++;
+            continue;
+        }
+        // The element is valid, so this finds the closing quote or a backslash.
+        src = findEscapeCandidate(src, end);
+        unlikely_if(src >= end) { break; }
+        splicer->isEscaped = *src++ == '\\';
+        likely_if(!splicer->isEscaped)
+        {
+            splicer->isInString = false;
+            break;
         }
     }
-    TTSDKLOG_DEBUG("Invalid character '%c'", *context->bufferPtr);
-    return TTSDKJSON_ERROR_INVALID_CHARACTER;
+    return src;
 }
 
-int ttsdkjson_decode(const char *const data, int length, char *stringBuffer, int stringBufferLength,
-                  TTSDKJSONDecodeCallbacks *const callbacks, void *const userData, int *const errorOffset)
+/** Copy the next chunk of a validated element to a compact encoder, dropping
+ * whitespace between tokens.
+ */
+static int spliceCompactChunk(Splicer *const splicer, const char *const data, const int length)
 {
-    char *nameBuffer = stringBuffer;
-    int nameBufferLength = stringBufferLength / 4;
-    stringBuffer = nameBuffer + nameBufferLength;
-    stringBufferLength -= nameBufferLength;
-    TTSDKJSONDecodeContext context = { .bufferPtr = (char *)data,
-                                    .bufferEnd = (char *)data + length,
-                                    .nameBuffer = nameBuffer,
-                                    .nameBufferLength = nameBufferLength,
-                                    .stringBuffer = stringBuffer,
-                                    .stringBufferLength = (int)stringBufferLength,
-                                    .callbacks = callbacks,
-                                    .userData = userData };
+    TTSDKJSONEncodeContext *const context = splicer->context;
+    const char *const end = data + length;
+    const char *src = data;
+    const char *run = data;
+    int result = TTSDKJSON_OK;
 
-    const char *ptr = data;
+    while (src < end) {
+        if (splicer->isInString) {
+            src = skipSpliceString(splicer, src, end);
+            continue;
+        }
+        // Outside of strings, whitespace is the only thing at or below ' '.
+        while (src < end && *src != '\"' && (unsigned char)*src > ' ') {
+            src++;
+        }
+        unlikely_if(src >= end) { break; }
+        if (*src == '\"') {
+            splicer->isInString = true;
+            src++;
+            continue;
+        }
+        unlikely_if((result = addSpliceRun(context, run, src)) != TTSDKJSON_OK) { return result; }
+        run = src = skipSpliceWhitespace(src, end);
+    }
+    return addSpliceRun(context, run, src);
+}
 
-    int result = decodeElement(NULL, &context);
-    likely_if(result == TTSDKJSON_OK) { result = callbacks->onEndData(userData); }
+/** Copy the next chunk of a validated element to a pretty printing encoder,
+ * replacing whitespace between tokens with the encoder's indentation.
+ */
+static int splicePrettyChunk(Splicer *const splicer, const char *const data, const int length)
+{
+    TTSDKJSONEncodeContext *const context = splicer->context;
+    const char *const end = data + length;
+    const char *src = data;
+    const char *run = data;
+    int result = TTSDKJSON_OK;
 
-    unlikely_if(result != TTSDKJSON_OK && errorOffset != NULL) { *errorOffset = (int)(ptr - data); }
+    while (src < end) {
+        if (splicer->isInString) {
+            src = skipSpliceString(splicer, src, end);
+            continue;
+        }
+
+        const char ch = *src;
+        switch (ch) {
+            case ' ':
+            case '\n':
+            case '\r':
+            case '\t':
+                unlikely_if((result = addSpliceRun(context, run, src)) != TTSDKJSON_OK) { return result; }
+                run = src = skipSpliceWhitespace(src, end);
+                continue;
+            case '}':
+            case ']':
+                if (!splicer->isOpenPending) {
+                    unlikely_if((result = addSpliceRun(context, run, src)) != TTSDKJSON_OK) { return result; }
+                    const int level = splicer->baseLevel + splicer->depth - 1;
+                    unlikely_if((result = addSpliceIndentation(splicer, level)) != TTSDKJSON_OK) { return result; }
+                    run = src;
+                }
+                splicer->isOpenPending = false;
+                splicer->depth--;
+                src++;
+                continue;
+            case ',':
+            case ':':
+                src++;
+                unlikely_if((result = addSpliceRun(context, run, src)) != TTSDKJSON_OK) { return result; }
+                if (ch == ',') {
+                    result = addSpliceIndentation(splicer, splicer->baseLevel + splicer->depth);
+                } else {
+                    result = addJSONData(context, " ", 1);
+                }
+                unlikely_if(result != TTSDKJSON_OK) { return result; }
+                run = src;
+                continue;
+            default:
+                break;
+        }
+
+        // Something that starts a key or value.
+        unlikely_if(splicer->isOpenPending)
+        {
+            splicer->isOpenPending = false;
+            unlikely_if((result = addSpliceRun(context, run, src)) != TTSDKJSON_OK) { return result; }
+            const int level = splicer->baseLevel + splicer->depth;
+            unlikely_if((result = addSpliceIndentation(splicer, level)) != TTSDKJSON_OK) { return result; }
+            run = src;
+        }
+        src++;
+        if (ch == '{' || ch == '[') {
+            splicer->depth++;
+            splicer->isOpenPending = true;
+        } else if (ch == '\"') {
+            splicer->isInString = true;
+        } else {
+            // The rest of a number or literal.
+            while (src < end && (unsigned char)*src > ' ' && *src != ',' && *src != '}' && *src != ']') {
+                src++;
+            }
+        }
+    }
+    return addSpliceRun(context, run, src);
+}
+
+/** Copy the next chunk of a validated element to the encoder. */
+static int spliceChunk(Splicer *const splicer, const char *const data, int length)
+{
+    unlikely_if(length > splicer->remaining) { length = (int)splicer->remaining; }
+    splicer->remaining -= length;
+    likely_if(!splicer->context->prettyPrint) { return spliceCompactChunk(splicer, data, length); }
+    return splicePrettyChunk(splicer, data, length);
+}
+
+/** Decide whether an element can be spliced into the encoder's output.
+ *
+ * @param context The encoding context.
+ *
+ * @param closeLastContainer The caller's closeLastContainer argument.
+ *
+ * @param leaveOpen Set to true if a top container must be left open.
+ *
+ * @return true if the element can be spliced.
+ */
+static bool canSplice(const TTSDKJSONEncodeContext *const context, const bool closeLastContainer,
+                      bool *const leaveOpen)
+{
+    unlikely_if(isCBOR(context) || context->containerLevel < 0) { return false; }
+    // Match the decoding path, which leaves containers at levels 1 and 2 open (see addJSONFromFile_onEndContainer).
+    *leaveOpen = !closeLastContainer && context->containerLevel + 1 <= 2;
+    return !*leaveOpen || context->containerLevel == 1;
+}
+
+static int spliceMaxDepth(const TTSDKJSONEncodeContext *const context)
+{
+    return (int)(sizeof(context->isObject) / sizeof(*context->isObject)) - 1 - context->containerLevel;
+}
+
+/** Start splicing a validated element.
+ *
+ * @return TTSDKJSON_OK if the element was begun.
+ */
+static int beginSplice(Splicer *const splicer, TTSDKJSONEncodeContext *const context, const char *const name,
+                       const SpliceValidator *const validator, const bool leaveOpen)
+{
+    memset(splicer, 0, sizeof(*splicer));
+    splicer->context = context;
+    splicer->baseLevel = context->containerLevel;
+    splicer->remaining = validator->elementLength;
+    // A container ends with its closing bracket, so leaving it open means stopping just before that.
+    unlikely_if(leaveOpen && validator->isContainer) { splicer->remaining--; }
+    splicer->name = name;
+    const int result = ttsdkjson_beginElement(context, name);
+    splicer->startOffset = ttsdkjson_getOutputPosition(context);
     return result;
 }
 
-struct JSONFromFileContext;
-typedef void (*UpdateDecoderCallback)(struct JSONFromFileContext *context);
+/** Bring the encoder's state in line with what was spliced. */
+static void endSplice(const Splicer *const splicer, const SpliceValidator *const validator, const bool leaveOpen)
+{
+    TTSDKJSONEncodeContext *const context = splicer->context;
+    context->containerFirstEntry = false;
+    likely_if(!validator->isContainer) { return; }
 
-typedef struct JSONFromFileContext {
-    TTSDKJSONEncodeContext *encodeContext;
-    TTSDKJSONDecodeContext *decodeContext;
-    char *bufferStart;
-    const char *sourceFilename;
-    int fd;
-    bool isEOF;
-    bool closeLastContainer;
-    UpdateDecoderCallback updateDecoderCallback;
-} JSONFromFileContext;
+    context->containerLevel++;
+    context->isObject[context->containerLevel] = validator->isObject[0] & 1;
+    unlikely_if(context->sectionIndex != NULL)
+    {
+        beginIndexedContainer(context, splicer->name, splicer->startOffset);
+        unlikely_if(!leaveOpen) { endIndexedContainer(context, context->containerLevel); }
+    }
+    if (leaveOpen) {
+        context->containerFirstEntry = validator->wasEmptyContainer;
+    } else {
+        context->containerLevel--;
+    }
+}
+
+/** Splice a JSON element from memory if it's valid.
+ *
+ * @param result Set to the result of splicing, if the element was spliced.
+ *
+ * @return false if the element must be decoded instead (nothing was written).
+ */
+static bool spliceJSONElement(TTSDKJSONEncodeContext *const context, const char *const name, const char *const data,
+                              const int length, const bool closeLastContainer, int *const result)
+{
+    bool leaveOpen = false;
+    unlikely_if(!canSplice(context, closeLastContainer, &leaveOpen)) { return false; }
+
+    SpliceValidator validator;
+    initSpliceValidator(&validator, spliceMaxDepth(context));
+    SpliceResult validation = validateSpliceChunk(&validator, data, length);
+    if (validation == SpliceResultNeedMore) {
+        validation = finishSpliceValidation(&validator);
+    }
+    unlikely_if(validation != SpliceResultComplete) { return false; }
 
-static void updateDecoder_doNothing(__unused struct JSONFromFileContext *context) {}
+    Splicer splicer;
+    unlikely_if((*result = beginSplice(&splicer, context, name, &validator, leaveOpen)) != TTSDKJSON_OK) { return true; }
+    *result = spliceChunk(&splicer, data, (int)validator.elementLength);
+    endSplice(&splicer, &validator, leaveOpen);
+    return true;
+}
 
-static void updateDecoder_readFile(struct JSONFromFileContext *context)
+/** Splice a JSON element from a file if it's valid. The file is read twice:
+ * once to validate, and once to copy.
+ *
+ * @param result Set to the result of splicing, if the element was spliced.
+ *
+ * @return false if the element must be decoded instead (nothing was written,
+ *         and the file is rewound).
+ */
+static bool spliceJSONFromFile(TTSDKJSONEncodeContext *const context, const char *const name, const int fd,
+                               const bool closeLastContainer, int *const result)
 {
-    likely_if(!context->isEOF)
+    bool leaveOpen = false;
+    unlikely_if(!canSplice(context, closeLastContainer, &leaveOpen)) { return false; }
+
+    char buffer[kSpliceReadBufferSize];
+    SpliceValidator validator;
+    initSpliceValidator(&validator, spliceMaxDepth(context));
+    SpliceResult validation = SpliceResultNeedMore;
+    while (validation == SpliceResultNeedMore) {
+        const ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+        unlikely_if(bytesRead < 0) { break; }
+        validation = bytesRead == 0 ? finishSpliceValidation(&validator)
+                                    : validateSpliceChunk(&validator, buffer, (int)bytesRead);
+    }
+    unlikely_if(lseek(fd, 0, SEEK_SET) < 0)
     {
-        const char *end = context->decodeContext->bufferEnd;
-        char *start = context->bufferStart;
-        const char *ptr = context->decodeContext->bufferPtr;
-        int bufferLength = (int)(end - start);
-        int remainingLength = (int)(end - ptr);
-        unlikely_if(remainingLength < bufferLength / 2)
+        *result = TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+        return true;
+    }
+    unlikely_if(validation != SpliceResultComplete) { return false; }
+
+    Splicer splicer;
+    unlikely_if((*result = beginSplice(&splicer, context, name, &validator, leaveOpen)) != TTSDKJSON_OK) { return true; }
+    while (*result == TTSDKJSON_OK && splicer.remaining > 0) {
+        const ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+        unlikely_if(bytesRead <= 0)
         {
-            int fillLength = bufferLength - remainingLength;
-            memcpy(start, ptr, remainingLength);
-            context->decodeContext->bufferPtr = start;
-            int bytesRead = (int)read(context->fd, start + remainingLength, (unsigned)fillLength);
-            unlikely_if(bytesRead < fillLength)
-            {
-                if (bytesRead < 0) {
-                    TTSDKLOG_ERROR("Error reading file %s: %s", context->sourceFilename, strerror(errno));
-                }
-                context->isEOF = true;
-            }
+            *result = TTSDKJSON_ERROR_INCOMPLETE;
+            break;
         }
+        *result = spliceChunk(&splicer, buffer, (int)bytesRead);
     }
+    endSplice(&splicer, &validator, leaveOpen);
+    return true;
 }
 
+// ============================================================================
+#pragma mark - Embedded JSON -
+// ============================================================================
+
+typedef struct JSONFromFileContext {
+    TTSDKJSONEncodeContext *encodeContext;
+    bool closeLastContainer;
+} JSONFromFileContext;
+
 static int addJSONFromFile_onBooleanElement(const char *const name, const bool value, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_addBooleanElement(context->encodeContext, name, value);
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_addBooleanElement(context->encodeContext, name, value);
 }
 
 static int addJSONFromFile_onFloatingPointElement(const char *const name, const double value, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_addFloatingPointElement(context->encodeContext, name, value);
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_addFloatingPointElement(context->encodeContext, name, value);
 }
 
 static int addJSONFromFile_onIntegerElement(const char *const name, const int64_t value, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_addIntegerElement(context->encodeContext, name, value);
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_addIntegerElement(context->encodeContext, name, value);
 }
 
 static int addJSONFromFile_onUnsignedIntegerElement(const char *const name, const uint64_t value, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_addUIntegerElement(context->encodeContext, name, value);
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_addUIntegerElement(context->encodeContext, name, value);
 }
 
 static int addJSONFromFile_onNullElement(const char *const name, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_addNullElement(context->encodeContext, name);
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_addNullElement(context->encodeContext, name);
 }
 
 static int addJSONFromFile_onStringElement(const char *const name, const char *const value, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_addStringElement(context->encodeContext, name, value, (int)strlen(value));
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_addStringElement(context->encodeContext, name, value, (int)strlen(value));
+}
+
+static int addJSONFromFile_onStringElementSlice(const char *const name, __unused const int nameLength,
+                                                const char *const value, const int valueLength, void *const userData)
+{
+    JSONFromFileContext *context = (JSONFromFileContext *)userData;
+    return ttsdkjson_addStringElement(context->encodeContext, name, value, valueLength);
 }
 
 static int addJSONFromFile_onBeginObject(const char *const name, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_beginObject(context->encodeContext, name);
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_beginObject(context->encodeContext, name);
 }
 
 static int addJSONFromFile_onBeginArray(const char *const name, void *const userData)
 {
     JSONFromFileContext *context = (JSONFromFileContext *)userData;
-    int result = ttsdkjson_beginArray(context->encodeContext, name);
-    context->updateDecoderCallback(context);
-    return result;
+    return ttsdkjson_beginArray(context->encodeContext, name);
 }
 
 static int addJSONFromFile_onEndContainer(void *const userData)
@@ -1184,60 +5110,63 @@ static int addJSONFromFile_onEndContainer(void *const userData)
     if (context->closeLastContainer || context->encodeContext->containerLevel > 2) {
         result = ttsdkjson_endContainer(context->encodeContext);
     }
-    context->updateDecoderCallback(context);
     return result;
 }
 
 static int addJSONFromFile_onEndData(__unused void *const userData) { return TTSDKJSON_OK; }
 
+static const TTSDKJSONDecodeCallbacks g_addJSONCallbacks = {
+    .onBeginArray = addJSONFromFile_onBeginArray,
+    .onBeginObject = addJSONFromFile_onBeginObject,
+    .onBooleanElement = addJSONFromFile_onBooleanElement,
+    .onEndContainer = addJSONFromFile_onEndContainer,
+    .onEndData = addJSONFromFile_onEndData,
+    .onFloatingPointElement = addJSONFromFile_onFloatingPointElement,
+    .onIntegerElement = addJSONFromFile_onIntegerElement,
+    .onUnsignedIntegerElement = addJSONFromFile_onUnsignedIntegerElement,
+    .onNullElement = addJSONFromFile_onNullElement,
+    .onStringElement = addJSONFromFile_onStringElement,
+    .onStringElementSlice = addJSONFromFile_onStringElementSlice,
+};
+
 int ttsdkjson_addJSONFromFile(TTSDKJSONEncodeContext *const encodeContext, const char *restrict const name,
                            const char *restrict const filename, const bool closeLastContainer)
 {
-    TTSDKJSONDecodeCallbacks callbacks = {
-        .onBeginArray = addJSONFromFile_onBeginArray,
-        .onBeginObject = addJSONFromFile_onBeginObject,
-        .onBooleanElement = addJSONFromFile_onBooleanElement,
-        .onEndContainer = addJSONFromFile_onEndContainer,
-        .onEndData = addJSONFromFile_onEndData,
-        .onFloatingPointElement = addJSONFromFile_onFloatingPointElement,
-        .onIntegerElement = addJSONFromFile_onIntegerElement,
-        .onUnsignedIntegerElement = addJSONFromFile_onUnsignedIntegerElement,
-        .onNullElement = addJSONFromFile_onNullElement,
-        .onStringElement = addJSONFromFile_onStringElement,
-    };
-    char nameBuffer[100] = { 0 };
-    char stringBuffer[500] = { 0 };
-    char fileBuffer[1000] = { 0 };
-    TTSDKJSONDecodeContext decodeContext = {
-        .bufferPtr = fileBuffer,
-        .bufferEnd = fileBuffer + sizeof(fileBuffer),
-        .nameBuffer = nameBuffer,
-        .nameBufferLength = sizeof(nameBuffer),
-        .stringBuffer = stringBuffer,
-        .stringBufferLength = sizeof(stringBuffer),
-        .callbacks = &callbacks,
-        .userData = NULL,
-    };
-
     int fd = open(filename, O_RDONLY);
+#if TTSDKJSONCODEC_SpliceEmbeddedJSON
+    int spliceResult;
+    likely_if(fd >= 0 && spliceJSONFromFile(encodeContext, name, fd, closeLastContainer, &spliceResult))
+    {
+        close(fd);
+        return spliceResult;
+    }
+#endif
     JSONFromFileContext jsonContext = {
         .encodeContext = encodeContext,
-        .decodeContext = &decodeContext,
-        .bufferStart = fileBuffer,
-        .sourceFilename = filename,
-        .fd = fd,
         .closeLastContainer = closeLastContainer,
-        .isEOF = false,
-        .updateDecoderCallback = updateDecoder_readFile,
     };
-    decodeContext.userData = &jsonContext;
+    TTSDKJSONDecodeCallbacks callbacks = g_addJSONCallbacks;
+    char stringBuffer[800];
+    char fileBuffer[1000];
+    TTSDKJSONDecoder decoder;
+    ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &callbacks, &jsonContext);
+    decoder.rootName = name;
     int containerLevel = encodeContext->containerLevel;
 
-    // Manually trigger a data load.
-    decodeContext.bufferPtr = decodeContext.bufferEnd;
-    jsonContext.updateDecoderCallback(&jsonContext);
-
-    int result = decodeElement(name, &decodeContext);
+    int result = TTSDKJSON_OK;
+    for (;;) {
+        int bytesRead = (int)read(fd, fileBuffer, sizeof(fileBuffer));
+        unlikely_if(bytesRead <= 0)
+        {
+            if (bytesRead < 0) {
+                TTSDKLOG_ERROR("Error reading file %s: %s", filename, strerror(errno));
+            }
+            result = ttsdkjson_decoderFinish(&decoder);
+            break;
+        }
+        result = ttsdkjson_decoderFeed(&decoder, fileBuffer, bytesRead);
+        unlikely_if(result != TTSDKJSON_OK) { break; }
+    }
     close(fd);
     while (closeLastContainer && encodeContext->containerLevel > containerLevel) {
         ttsdkjson_endContainer(encodeContext);
@@ -1249,48 +5178,65 @@ int ttsdkjson_addJSONFromFile(TTSDKJSONEncodeContext *const encodeContext, const
 int ttsdkjson_addJSONElement(TTSDKJSONEncodeContext *const encodeContext, const char *restrict const name,
                           const char *restrict const jsonData, const int jsonDataLength, const bool closeLastContainer)
 {
-    TTSDKJSONDecodeCallbacks callbacks = {
-        .onBeginArray = addJSONFromFile_onBeginArray,
-        .onBeginObject = addJSONFromFile_onBeginObject,
-        .onBooleanElement = addJSONFromFile_onBooleanElement,
-        .onEndContainer = addJSONFromFile_onEndContainer,
-        .onEndData = addJSONFromFile_onEndData,
-        .onFloatingPointElement = addJSONFromFile_onFloatingPointElement,
-        .onIntegerElement = addJSONFromFile_onIntegerElement,
-        .onUnsignedIntegerElement = addJSONFromFile_onUnsignedIntegerElement,
-        .onNullElement = addJSONFromFile_onNullElement,
-        .onStringElement = addJSONFromFile_onStringElement,
-    };
-    char nameBuffer[100] = { 0 };
-    char stringBuffer[5000] = { 0 };
-    TTSDKJSONDecodeContext decodeContext = {
-        .bufferPtr = jsonData,
-        .bufferEnd = jsonData + jsonDataLength,
-        .nameBuffer = nameBuffer,
-        .nameBufferLength = sizeof(nameBuffer),
-        .stringBuffer = stringBuffer,
-        .stringBufferLength = sizeof(stringBuffer),
-        .callbacks = &callbacks,
-        .userData = NULL,
-    };
-
+#if TTSDKJSONCODEC_SpliceEmbeddedJSON
+    int spliceResult;
+    likely_if(spliceJSONElement(encodeContext, name, jsonData, jsonDataLength, closeLastContainer, &spliceResult))
+    {
+        return spliceResult;
+    }
+#endif
     JSONFromFileContext jsonContext = {
         .encodeContext = encodeContext,
-        .decodeContext = &decodeContext,
-        .bufferStart = (char *)jsonData,
-        .sourceFilename = NULL,
-        .fd = 0,
         .closeLastContainer = closeLastContainer,
-        .isEOF = false,
-        .updateDecoderCallback = updateDecoder_doNothing,
     };
-    decodeContext.userData = &jsonContext;
+    TTSDKJSONDecodeCallbacks callbacks = g_addJSONCallbacks;
+    // The decoder gives a quarter of this to names, which leaves strings at least 5000 bytes.
+    char stringBuffer[6700];
+    TTSDKJSONDecoder decoder;
+    ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &callbacks, &jsonContext);
+    decoder.rootName = name;
     int containerLevel = encodeContext->containerLevel;
 
-    int result = decodeElement(name, &decodeContext);
+    int result = ttsdkjson_decoderFeed(&decoder, jsonData, jsonDataLength);
+    likely_if(result == TTSDKJSON_OK) { result = ttsdkjson_decoderFinish(&decoder); }
     while (closeLastContainer && encodeContext->containerLevel > containerLevel) {
         ttsdkjson_endContainer(encodeContext);
     }
 
     return result;
 }
+
+// ============================================================================
+#pragma mark - Reindent -
+// ============================================================================
+
+void ttsdkjson_beginReindent(TTSDKJSONReindentContext *const context, const TTSDKJSONAddDataFunc addJSONData,
+                             void *const userData)
+{
+    memset(context, 0, sizeof(*context));
+    ttsdkjson_beginEncode(&context->encodeContext, true, addJSONData, userData);
+}
+
+int ttsdkjson_reindent(TTSDKJSONReindentContext *const context, const char *const data, const int length)
+{
+    Splicer splicer = {
+        .context = &context->encodeContext,
+        .baseLevel = 0,
+        .depth = context->depth,
+        .remaining = length,
+        .isInString = context->isInString,
+        .isEscaped = context->isEscaped,
+        .isOpenPending = context->isOpenPending,
+    };
+    const int result = splicePrettyChunk(&splicer, data, length);
+    context->depth = splicer.depth;
+    context->isInString = splicer.isInString;
+    context->isEscaped = splicer.isEscaped;
+    context->isOpenPending = splicer.isOpenPending;
+    return result;
+}
+
+int ttsdkjson_endReindent(TTSDKJSONReindentContext *const context)
+{
+    return ttsdkjson_flushOutputBuffer(&context->encodeContext);
+}
@@ -28,8 +28,214 @@
 
 #import "TTSDKDate.h"
 #import "TTSDKJSONCodec.h"
+#import "TTSDKJSONTape.h"
 #import "TTSDKNSErrorHelper.h"
 
+#pragma mark Lazy Containers
+
+/** Owns the tape that lazy containers read from. */
+@interface TTSDKJSONTapeDocument : NSObject {
+   @public
+    TTSDKJSONTape _tape;
+}
+@end
+
+@implementation TTSDKJSONTapeDocument
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        ttsdktape_init(&_tape);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    ttsdktape_free(&_tape);
+}
+
+@end
+
+/** An immutable dictionary backed by an object in a tape. */
+@interface TTSDKJSONLazyDictionary : NSDictionary {
+    TTSDKJSONTapeDocument *_document;
+    int _value;
+    NSInteger _count;
+}
+- (instancetype)initWithDocument:(TTSDKJSONTapeDocument *)document value:(int)value;
+@end
+
+/** An immutable array backed by an array in a tape. */
+@interface TTSDKJSONLazyArray : NSArray {
+    TTSDKJSONTapeDocument *_document;
+    int _value;
+}
+- (instancetype)initWithDocument:(TTSDKJSONTapeDocument *)document value:(int)value;
+@end
+
+/** Make a string from tape bytes, or nil if they aren't valid UTF-8. */
+static NSString *stringFromTapeBytes(const char *bytes, int length)
+{
+    return [[NSString alloc] initWithBytes:bytes length:(NSUInteger)length encoding:NSUTF8StringEncoding];
+}
+
+static id objectForTapeValue(TTSDKJSONTapeDocument *document, int value)
+{
+    const TTSDKJSONTape *tape = &document->_tape;
+    switch (ttsdktape_type(tape, value)) {
+        case TTSDKJSONTapeTypeObject:
+            return [[TTSDKJSONLazyDictionary alloc] initWithDocument:document value:value];
+        case TTSDKJSONTapeTypeArray:
+            return [[TTSDKJSONLazyArray alloc] initWithDocument:document value:value];
+        case TTSDKJSONTapeTypeString: {
+            int length = 0;
+            const char *string = ttsdktape_string(tape, value, &length);
+            return stringFromTapeBytes(string, length);
+        }
+        case TTSDKJSONTapeTypeInteger:
+            return [NSNumber numberWithLongLong:ttsdktape_integer(tape, value)];
+        case TTSDKJSONTapeTypeUnsignedInteger:
+            return [NSNumber numberWithUnsignedLongLong:ttsdktape_unsignedInteger(tape, value)];
+        case TTSDKJSONTapeTypeFloatingPoint:
+            return [NSNumber numberWithDouble:ttsdktape_floatingPoint(tape, value)];
+        case TTSDKJSONTapeTypeBoolean:
+            return [NSNumber numberWithBool:ttsdktape_boolean(tape, value)];
+        case TTSDKJSONTapeTypeNull:
+            return [NSNull null];
+        case TTSDKJSONTapeTypeNone:
+            break;
+    }
+    return nil;
+}
+
+@implementation TTSDKJSONLazyDictionary
+
+- (instancetype)initWithDocument:(TTSDKJSONTapeDocument *)document value:(int)value
+{
+    if ((self = [super init])) {
+        _document = document;
+        _value = value;
+        _count = -1;
+    }
+    return self;
+}
+
+/** Check whether a member shows up in the dictionary: it must be the one that its key
+ * finds (a repeated key only counts once), and its key and value must convert.
+ * Like the eager decoder, strings that aren't valid UTF-8 leave their member out.
+ *
+ * @param key Receives the member's key as a string if it shows up.
+ */
+static bool isVisibleMember(const TTSDKJSONTape *tape, int object, int index, NSString **key)
+{
+    const char *cKey = NULL;
+    int keyLength = 0;
+    const int member = ttsdktape_memberAt(tape, object, index, &cKey, &keyLength);
+    if (ttsdktape_member(tape, object, cKey, keyLength) != member) {
+        return false;
+    }
+    if (ttsdktape_type(tape, member) == TTSDKJSONTapeTypeString) {
+        int length = 0;
+        const char *string = ttsdktape_string(tape, member, &length);
+        if (stringFromTapeBytes(string, length) == nil) {
+            return false;
+        }
+    }
+    *key = stringFromTapeBytes(cKey, keyLength);
+    return *key != nil;
+}
+
+- (NSUInteger)count
+{
+    if (_count < 0) {
+        const TTSDKJSONTape *tape = &_document->_tape;
+        const int memberCount = ttsdktape_count(tape, _value);
+        NSInteger count = 0;
+        for (int i = 0; i < memberCount; i++) {
+            NSString *key = nil;
+            if (isVisibleMember(tape, _value, i, &key)) {
+                count++;
+            }
+        }
+        _count = count;
+    }
+    return (NSUInteger)_count;
+}
+
+- (id)objectForKey:(id)key
+{
+    if (![key isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    // Measure the whole key, since it can contain NUL.
+    const char *cKey = [(NSString *)key UTF8String];
+    if (cKey == NULL) {
+        return nil;
+    }
+    const int keyLength = (int)[(NSString *)key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    const int member = ttsdktape_member(&_document->_tape, _value, cKey, keyLength);
+    return member == TTSDKJSON_TAPE_NONE ? nil : objectForTapeValue(_document, member);
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    const TTSDKJSONTape *tape = &_document->_tape;
+    const int memberCount = ttsdktape_count(tape, _value);
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:(NSUInteger)memberCount];
+    for (int i = 0; i < memberCount; i++) {
+        NSString *key = nil;
+        if (isVisibleMember(tape, _value, i, &key)) {
+            [keys addObject:key];
+        }
+    }
+    return [keys objectEnumerator];
+}
+
+- (id)copyWithZone:(__unused NSZone *)zone
+{
+    return self;
+}
+
+@end
+
+@implementation TTSDKJSONLazyArray
+
+- (instancetype)initWithDocument:(TTSDKJSONTapeDocument *)document value:(int)value
+{
+    if ((self = [super init])) {
+        _document = document;
+        _value = value;
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return (NSUInteger)ttsdktape_count(&_document->_tape, _value);
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    const int element = index < (NSUInteger)INT_MAX ? ttsdktape_element(&_document->_tape, _value, (int)index)
+                                                     : TTSDKJSON_TAPE_NONE;
+    if (element == TTSDKJSON_TAPE_NONE) {
+        [NSException raise:NSRangeException format:@"Index %lu beyond bounds", (unsigned long)index];
+    }
+    // Arrays can't hold nil, so a string that isn't valid UTF-8 reads as null.
+    id object = objectForTapeValue(_document, element);
+    return object != nil ? object : [NSNull null];
+}
+
+- (id)copyWithZone:(__unused NSZone *)zone
+{
+    return self;
+}
+
+@end
+
+#pragma mark -
+
 @interface TTSDKJSONCodec ()
 
 #pragma mark Properties
@@ -106,7 +312,8 @@
 {
     if ((self = [super init])) {
         _containerStack = [NSMutableArray array];
-        _callbacks = malloc(sizeof(*self.callbacks));
+        // Zeroed, so that the callbacks it doesn't use are NULL.
+        _callbacks = calloc(1, sizeof(*self.callbacks));
         _callbacks->onBeginArray = onBeginArray;
         _callbacks->onBeginObject = onBeginObject;
         _callbacks->onBooleanElement = onBooleanElement;
@@ -117,6 +324,7 @@
         _callbacks->onUnsignedIntegerElement = onUnsignedIntegerElement;
         _callbacks->onNullElement = onNullElement;
         _callbacks->onStringElement = onStringElement;
+        _callbacks->onStringElementSlice = onStringElementSlice;
         _prettyPrint = (encodeOptions & TTSDKJSONEncodeOptionPretty) != 0;
         _sorted = (encodeOptions & TTSDKJSONEncodeOptionSorted) != 0;
         _ignoreNullsInArrays = (decodeOptions & TTSDKJSONDecodeOptionIgnoreNullInArray) != 0;
@@ -227,6 +435,15 @@ static int onStringElement(const char *const cName, const char *const value, voi
     return onElement(codec, name, element);
 }
 
+static int onStringElementSlice(const char *const cName, __unused const int nameLength, const char *const value,
+                                const int valueLength, void *const userData)
+{
+    NSString *name = stringFromCString(cName);
+    id element = [[NSString alloc] initWithBytes:value length:(NSUInteger)valueLength encoding:NSUTF8StringEncoding];
+    TTSDKJSONCodec *codec = (__bridge TTSDKJSONCodec *)userData;
+    return onElement(codec, name, element);
+}
+
 static int onBeginObject(const char *const cName, void *const userData)
 {
     NSString *name = stringFromCString(cName);
@@ -393,19 +610,71 @@ static int encodeObject(TTSDKJSONCodec *codec, id object, NSString *name, TTSDKJ
 + (NSData *)encode:(id)object options:(TTSDKJSONEncodeOption)encodeOptions error:(NSError *__autoreleasing *)error
 {
     NSMutableData *data = [NSMutableData data];
+    char buffer[1024];
     TTSDKJSONEncodeContext JSONContext;
     ttsdkjson_beginEncode(&JSONContext, encodeOptions & TTSDKJSONEncodeOptionPretty, addJSONData, (__bridge void *)data);
+    ttsdkjson_setOutputBuffer(&JSONContext, buffer, sizeof(buffer));
     TTSDKJSONCodec *codec = [self codecWithEncodeOptions:encodeOptions decodeOptions:TTSDKJSONDecodeOptionNone];
 
     int result = encodeObject(codec, object, NULL, &JSONContext);
+    if (result == TTSDKJSON_OK) {
+        result = ttsdkjson_flushOutputBuffer(&JSONContext);
+    }
     if (error != NULL) {
         *error = codec.error;
     }
     return result == TTSDKJSON_OK ? data : nil;
 }
 
+/** Decode JSON data into lazy containers (see TTSDKJSONDecodeOptionLazy). */
++ (id)decodeLazily:(NSData *)JSONData options:(TTSDKJSONDecodeOption)decodeOptions error:(NSError *__autoreleasing *)error
+{
+    TTSDKJSONTapeDocument *document = [TTSDKJSONTapeDocument new];
+    TTSDKJSONTape *tape = &document->_tape;
+    int tapeOptions = TTSDKJSONTapeOptionNone;
+    if (decodeOptions & TTSDKJSONDecodeOptionIgnoreNullInArray) {
+        tapeOptions |= TTSDKJSONTapeOptionIgnoreNullInArray;
+    }
+    if (decodeOptions & TTSDKJSONDecodeOptionIgnoreNullInObject) {
+        tapeOptions |= TTSDKJSONTapeOptionIgnoreNullInObject;
+    }
+    int errorOffset = 0;
+    int result = ttsdktape_parse(tape, JSONData.bytes, (int)JSONData.length, NULL, tapeOptions, &errorOffset);
+    NSError *decodeError = nil;
+    if (result != TTSDKJSON_OK) {
+        decodeError = [TTSDKNSErrorHelper errorWithDomain:@"TTSDKJSONCodecObjC"
+                                                     code:0
+                                              description:@"%s (offset %d)", ttsdkjson_stringForError(result),
+                                                          errorOffset];
+    }
+
+    id root = nil;
+    const int rootValue = ttsdktape_root(tape);
+    const TTSDKJSONTapeType rootType = ttsdktape_type(tape, rootValue);
+    if (rootType == TTSDKJSONTapeTypeObject || rootType == TTSDKJSONTapeTypeArray) {
+        root = objectForTapeValue(document, rootValue);
+    } else if (rootType != TTSDKJSONTapeTypeNone) {
+        result = TTSDKJSON_ERROR_INVALID_DATA;
+        decodeError = [TTSDKNSErrorHelper errorWithDomain:@"TTSDKJSONCodecObjC"
+                                                     code:0
+                                              description:@"Type %@ not allowed as top level container",
+                                                          [objectForTapeValue(document, rootValue) class]];
+    }
+    if (error != NULL) {
+        *error = decodeError;
+    }
+
+    if (result != TTSDKJSON_OK && !(decodeOptions & TTSDKJSONDecodeOptionKeepPartialObject)) {
+        return nil;
+    }
+    return root;
+}
+
 + (id)decode:(NSData *)JSONData options:(TTSDKJSONDecodeOption)decodeOptions error:(NSError *__autoreleasing *)error
 {
+    if (decodeOptions & TTSDKJSONDecodeOptionLazy) {
+        return [self decodeLazily:JSONData options:decodeOptions error:error];
+    }
     TTSDKJSONCodec *codec = [self codecWithEncodeOptions:0 decodeOptions:decodeOptions];
     NSMutableData *stringData = [NSMutableData dataWithLength:10001];
     int errorOffset;
@@ -426,4 +695,16 @@ static int encodeObject(TTSDKJSONCodec *codec, id object, NSString *name, TTSDKJ
     return codec.topLevelContainer;
 }
 
++ (NSData *)prettyPrint:(NSData *)JSONData
+{
+    NSMutableData *data = [NSMutableData dataWithCapacity:JSONData.length * 2];
+    char buffer[1024];
+    TTSDKJSONReindentContext context;
+    ttsdkjson_beginReindent(&context, addJSONData, (__bridge void *)data);
+    ttsdkjson_setOutputBuffer(&context.encodeContext, buffer, sizeof(buffer));
+    ttsdkjson_reindent(&context, JSONData.bytes, (int)JSONData.length);
+    ttsdkjson_endReindent(&context);
+    return data;
+}
+
 @end
@@ -0,0 +1,637 @@
+//
+//  TTSDKJSONTape.c
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "TTSDKJSONTape.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// #define TTSDKLogger_LocalLevel TRACE
+#include "TTSDKLogger.h"
+
+#ifdef __GNUC__
+#define likely_if(x) if (__builtin_expect(x, 1))
+#define unlikely_if(x) if (__builtin_expect(x, 0))
+#else
+#define likely_if(x) if (x)
+#define unlikely_if(x) if (x)
+#endif
+
+// ============================================================================
+#pragma mark - Entries -
+// ============================================================================
+
+/* An entry is a tag in the top byte, a 24-bit field and a 32-bit field:
+ *
+ *   '{' '['  count of children | position of the end entry
+ *   '}' ']'  unused            | offset of the children table in tables
+ *   '"' ':'  length            | offset of the string (or key) in strings
+ *   'l' 'u' 'd'                  followed by an entry holding the bits of the
+ *                                int64, uint64 or double
+ *   'n' 't' 'f'                  nothing else
+ *
+ * A children table holds the position of each element of an array, or the
+ * key of each member of an object. Objects with more than
+ * kLinearSearchMaxMembers members have an open addressing hash table after
+ * that, with twice as many slots (rounded up to a power of 2) as members,
+ * each holding 1 + the index of a member, or 0.
+ */
+
+#define kTagObject '{'
+#define kTagArray '['
+#define kTagEndObject '}'
+#define kTagEndArray ']'
+#define kTagString '"'
+#define kTagKey ':'
+#define kTagInteger 'l'
+#define kTagUnsignedInteger 'u'
+#define kTagFloatingPoint 'd'
+#define kTagNull 'n'
+#define kTagTrue 't'
+#define kTagFalse 'f'
+
+/** Objects with at most this many members are searched without a hash table. */
+#define kLinearSearchMaxMembers 8
+
+/** The most that the 24-bit field of an entry can hold. */
+#define kMaxFieldValue 0xffffff
+
+static inline uint64_t makeEntry(const char tag, const uint32_t field, const uint32_t offset)
+{
+    return (uint64_t)(uint8_t)tag << 56 | (uint64_t)field << 32 | offset;
+}
+
+static inline char entryTag(const uint64_t entry) { return (char)(entry >> 56); }
+
+static inline uint32_t entryField(const uint64_t entry) { return (uint32_t)(entry >> 32) & kMaxFieldValue; }
+
+static inline uint32_t entryOffset(const uint64_t entry) { return (uint32_t)entry; }
+
+static inline uint32_t hashKey(const char *const key, const int length)
+{
+    // FNV-1a
+    uint32_t hash = 0x811c9dc5;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+static inline int hashSlotCount(const int memberCount)
+{
+    int slotCount = 16;
+    while (slotCount < memberCount * 2) {
+        slotCount *= 2;
+    }
+    return slotCount;
+}
+
+// ============================================================================
+#pragma mark - Building -
+// ============================================================================
+
+/** Make room for more items in one of the tape's arrays.
+ *
+ * @return true if there's room.
+ */
+static bool reserve(void **const items, int *const capacity, const int used, const int needed, const size_t itemSize)
+{
+    likely_if(*capacity - used >= needed) { return true; }
+    unlikely_if(needed > INT32_MAX / 2 - used) { return false; }
+    int newCapacity = *capacity > 0 ? *capacity : 256;
+    while (newCapacity - used < needed) {
+        newCapacity *= 2;
+    }
+    void *const newItems = realloc(*items, (size_t)newCapacity * itemSize);
+    unlikely_if(newItems == NULL) { return false; }
+    *items = newItems;
+    *capacity = newCapacity;
+    return true;
+}
+
+static inline bool reserveEntries(TTSDKJSONTape *const tape, const int needed)
+{
+    return reserve((void **)&tape->entries, &tape->entryCapacity, tape->entryCount, needed, sizeof(*tape->entries));
+}
+
+/** Copy a string into the arena, with a null terminator.
+ *
+ * @return The string's entry, or 0 if there's no room.
+ */
+static uint64_t addString(TTSDKJSONTape *const tape, const char tag, const char *const string, const int length)
+{
+    unlikely_if(length > kMaxFieldValue)
+    {
+        TTSDKLOG_DEBUG("String is too long: %d", length);
+        tape->result = TTSDKJSON_ERROR_DATA_TOO_LONG;
+        return 0;
+    }
+    unlikely_if(!reserve((void **)&tape->strings, &tape->stringsCapacity, tape->stringsLength, length + 1, 1))
+    {
+        tape->result = TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+        return 0;
+    }
+    const int offset = tape->stringsLength;
+    memcpy(tape->strings + offset, string, (size_t)length);
+    tape->strings[offset + length] = '\0';
+    tape->stringsLength += length + 1;
+    return makeEntry(tag, (uint32_t)length, (uint32_t)offset);
+}
+
+/** Start a value: note it as a child of the open container, and add its key
+ * if the container is an object.
+ *
+ * @param name The name passed to the callback.
+ *
+ * @param nameLength The name's length, or -1 to measure it.
+ *
+ * @param entryCount The number of entries the value needs.
+ *
+ * @return TTSDKJSON_OK if the value's entries can be added.
+ */
+static int beginValue(TTSDKJSONTape *const tape, const char *const name, int nameLength, const int entryCount)
+{
+    unlikely_if(!reserveEntries(tape, entryCount + 1))
+    {
+        tape->result = TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+        return tape->result;
+    }
+    likely_if(tape->depth > 0)
+    {
+        unlikely_if(!reserve((void **)&tape->pending, &tape->pendingCapacity, tape->pendingLength, 1,
+                             sizeof(*tape->pending)))
+        {
+            tape->result = TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+            return tape->result;
+        }
+        tape->pending[tape->pendingLength++] = (uint32_t)tape->entryCount;
+        const uint64_t container = tape->entries[tape->containers[tape->depth - 1]];
+        likely_if(entryTag(container) == kTagObject)
+        {
+            if (nameLength < 0) {
+                nameLength = (int)strlen(name);
+            }
+            const uint64_t key = addString(tape, kTagKey, name, nameLength);
+            unlikely_if(key == 0)
+            {
+                tape->pendingLength--;
+                return tape->result;
+            }
+            tape->entries[tape->entryCount++] = key;
+        }
+    }
+    return TTSDKJSON_OK;
+}
+
+static int addNumber(TTSDKJSONTape *const tape, const char *const name, const char tag, const uint64_t bits)
+{
+    const int result = beginValue(tape, name, -1, 2);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    tape->entries[tape->entryCount++] = makeEntry(tag, 0, 0);
+    tape->entries[tape->entryCount++] = bits;
+    return TTSDKJSON_OK;
+}
+
+static int addLiteral(TTSDKJSONTape *const tape, const char *const name, const char tag)
+{
+    const int result = beginValue(tape, name, -1, 1);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    tape->entries[tape->entryCount++] = makeEntry(tag, 0, 0);
+    return TTSDKJSON_OK;
+}
+
+static int beginContainer(TTSDKJSONTape *const tape, const char *const name, const char tag)
+{
+    unlikely_if(tape->depth >= TTSDKJSON_TAPE_MAX_DEPTH)
+    {
+        TTSDKLOG_DEBUG("Too deeply nested");
+        tape->result = TTSDKJSON_ERROR_DATA_TOO_LONG;
+        return tape->result;
+    }
+    const int result = beginValue(tape, name, -1, 1);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    tape->containers[tape->depth] = tape->entryCount;
+    tape->pendingStarts[tape->depth] = tape->pendingLength;
+    tape->depth++;
+    tape->entries[tape->entryCount++] = makeEntry(tag, 0, 0);
+    return TTSDKJSON_OK;
+}
+
+/** Add the end entry of the innermost open container, and move its children
+ * from pending into its table.
+ */
+static int endContainer(TTSDKJSONTape *const tape)
+{
+    unlikely_if(tape->depth == 0) { return TTSDKJSON_ERROR_INVALID_DATA; }
+    const int begin = tape->containers[tape->depth - 1];
+    const int pendingStart = tape->pendingStarts[tape->depth - 1];
+    const int count = tape->pendingLength - pendingStart;
+    const bool isObject = entryTag(tape->entries[begin]) == kTagObject;
+    const int slotCount = isObject && count > kLinearSearchMaxMembers ? hashSlotCount(count) : 0;
+    unlikely_if(count > kMaxFieldValue)
+    {
+        TTSDKLOG_DEBUG("Container has too many children: %d", count);
+        return TTSDKJSON_ERROR_DATA_TOO_LONG;
+    }
+    unlikely_if(!reserveEntries(tape, 1) || !reserve((void **)&tape->tables, &tape->tablesCapacity, tape->tablesLength,
+                                                     count + slotCount, sizeof(*tape->tables)))
+    {
+        return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+    }
+
+    if (count > 0) {
+        memcpy(tape->tables + tape->tablesLength, tape->pending + pendingStart, (size_t)count * sizeof(*tape->tables));
+    }
+    if (slotCount > 0) {
+        uint32_t *const table = tape->tables + tape->tablesLength;
+        uint32_t *const slots = table + count;
+        memset(slots, 0, (size_t)slotCount * sizeof(*slots));
+        for (int i = 0; i < count; i++) {
+            const uint64_t key = tape->entries[table[i]];
+            const char *const name = tape->strings + entryOffset(key);
+            const int nameLength = (int)entryField(key);
+            uint32_t slot = hashKey(name, nameLength) & (uint32_t)(slotCount - 1);
+            for (;; slot = (slot + 1) & (uint32_t)(slotCount - 1)) {
+                if (slots[slot] == 0) {
+                    break;
+                }
+                // A later member with the same key replaces the earlier one.
+                const uint64_t other = tape->entries[table[slots[slot] - 1]];
+                if (entryField(other) == (uint32_t)nameLength &&
+                    memcmp(tape->strings + entryOffset(other), name, (size_t)nameLength) == 0) {
+                    break;
+                }
+            }
+            slots[slot] = (uint32_t)i + 1;
+        }
+    }
+
+    const int end = tape->entryCount++;
+    tape->entries[end] = makeEntry(isObject ? kTagEndObject : kTagEndArray, 0, (uint32_t)tape->tablesLength);
+    tape->entries[begin] = makeEntry(isObject ? kTagObject : kTagArray, (uint32_t)count, (uint32_t)end);
+    tape->tablesLength += count + slotCount;
+    tape->pendingLength = pendingStart;
+    tape->depth--;
+    return TTSDKJSON_OK;
+}
+
+static inline bool isInArray(const TTSDKJSONTape *const tape)
+{
+    return tape->depth > 0 && entryTag(tape->entries[tape->containers[tape->depth - 1]]) == kTagArray;
+}
+
+// ============================================================================
+#pragma mark - Callbacks -
+// ============================================================================
+
+static int onBooleanElement(const char *const name, const bool value, void *const userData)
+{
+    return addLiteral((TTSDKJSONTape *)userData, name, value ? kTagTrue : kTagFalse);
+}
+
+static int onFloatingPointElement(const char *const name, const double value, void *const userData)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return addNumber((TTSDKJSONTape *)userData, name, kTagFloatingPoint, bits);
+}
+
+static int onIntegerElement(const char *const name, const int64_t value, void *const userData)
+{
+    return addNumber((TTSDKJSONTape *)userData, name, kTagInteger, (uint64_t)value);
+}
+
+static int onUnsignedIntegerElement(const char *const name, const uint64_t value, void *const userData)
+{
+    return addNumber((TTSDKJSONTape *)userData, name, kTagUnsignedInteger, value);
+}
+
+static int onNullElement(const char *const name, void *const userData)
+{
+    TTSDKJSONTape *const tape = (TTSDKJSONTape *)userData;
+    if (tape->depth > 0) {
+        const int ignored = isInArray(tape) ? TTSDKJSONTapeOptionIgnoreNullInArray : TTSDKJSONTapeOptionIgnoreNullInObject;
+        if (tape->options & ignored) {
+            return TTSDKJSON_OK;
+        }
+    }
+    return addLiteral(tape, name, kTagNull);
+}
+
+static int onStringElementSlice(const char *const name, const int nameLength, const char *const value,
+                                const int valueLength, void *const userData)
+{
+    TTSDKJSONTape *const tape = (TTSDKJSONTape *)userData;
+    // Add the value to the arena first, so that a failure can't leave a key without a value.
+    const uint64_t entry = addString(tape, kTagString, value, valueLength);
+    unlikely_if(entry == 0) { return tape->result; }
+    const int result = beginValue(tape, name, nameLength, 1);
+    unlikely_if(result != TTSDKJSON_OK) { return result; }
+    tape->entries[tape->entryCount++] = entry;
+    return TTSDKJSON_OK;
+}
+
+static int onStringElement(const char *const name, const char *const value, void *const userData)
+{
+    return onStringElementSlice(name, -1, value, (int)strlen(value), userData);
+}
+
+static int onBeginObject(const char *const name, void *const userData)
+{
+    return beginContainer((TTSDKJSONTape *)userData, name, kTagObject);
+}
+
+static int onBeginArray(const char *const name, void *const userData)
+{
+    return beginContainer((TTSDKJSONTape *)userData, name, kTagArray);
+}
+
+static int onEndContainer(void *const userData) { return endContainer((TTSDKJSONTape *)userData); }
+
+static int onEndData(__unused void *const userData) { return TTSDKJSON_OK; }
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+void ttsdktape_init(TTSDKJSONTape *const tape) { memset(tape, 0, sizeof(*tape)); }
+
+void ttsdktape_free(TTSDKJSONTape *const tape)
+{
+    free(tape->entries);
+    free(tape->strings);
+    free(tape->tables);
+    free(tape->pending);
+    free(tape->stringBuffer);
+    ttsdktape_init(tape);
+}
+
+int ttsdktape_parse(TTSDKJSONTape *const tape, const char *const data, const int length,
+                    const TTSDKJSONPathFilter *const filter, const int options, int *const errorOffset)
+{
+    tape->entryCount = 0;
+    tape->stringsLength = 0;
+    tape->tablesLength = 0;
+    tape->pendingLength = 0;
+    tape->depth = 0;
+    tape->options = options;
+    tape->result = TTSDKJSON_OK;
+    if (tape->stringBuffer == NULL) {
+        tape->stringBuffer = malloc(TTSDKJSON_TAPE_STRING_BUFFER_LENGTH);
+        unlikely_if(tape->stringBuffer == NULL) { return TTSDKJSON_ERROR_CANNOT_ADD_DATA; }
+    }
+    // Start big enough for a typical document, so that the arrays rarely grow while parsing.
+    if (!reserveEntries(tape, length / 8) ||
+        !reserve((void **)&tape->strings, &tape->stringsCapacity, 0, length / 2, 1)) {
+        return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+    }
+
+    TTSDKJSONDecodeCallbacks callbacks = {
+        .onBooleanElement = onBooleanElement,
+        .onFloatingPointElement = onFloatingPointElement,
+        .onIntegerElement = onIntegerElement,
+        .onUnsignedIntegerElement = onUnsignedIntegerElement,
+        .onNullElement = onNullElement,
+        .onStringElement = onStringElement,
+        .onStringElementSlice = onStringElementSlice,
+        .onBeginObject = onBeginObject,
+        .onBeginArray = onBeginArray,
+        .onEndContainer = onEndContainer,
+        .onEndData = onEndData,
+    };
+    int result;
+    if (filter != NULL) {
+        result = ttsdkjson_decodeFiltered(data, length, tape->stringBuffer, TTSDKJSON_TAPE_STRING_BUFFER_LENGTH,
+                                          filter, &callbacks, tape, errorOffset);
+    } else {
+        result = ttsdkjson_decode(data, length, tape->stringBuffer, TTSDKJSON_TAPE_STRING_BUFFER_LENGTH, &callbacks,
+                                  tape, errorOffset);
+    }
+
+    // Close whatever was left open so that what was decoded can still be used.
+    while (tape->depth > 0) {
+        unlikely_if(endContainer(tape) != TTSDKJSON_OK)
+        {
+            tape->entryCount = 0;
+            tape->depth = 0;
+        }
+    }
+    return result;
+}
+
+int ttsdktape_root(const TTSDKJSONTape *const tape) { return tape->entryCount > 0 ? 0 : TTSDKJSON_TAPE_NONE; }
+
+TTSDKJSONTapeType ttsdktape_type(const TTSDKJSONTape *const tape, const int value)
+{
+    unlikely_if(value < 0 || value >= tape->entryCount) { return TTSDKJSONTapeTypeNone; }
+    switch (entryTag(tape->entries[value])) {
+        case kTagObject:
+            return TTSDKJSONTapeTypeObject;
+        case kTagArray:
+            return TTSDKJSONTapeTypeArray;
+        case kTagString:
+            return TTSDKJSONTapeTypeString;
+        case kTagInteger:
+            return TTSDKJSONTapeTypeInteger;
+        case kTagUnsignedInteger:
+            return TTSDKJSONTapeTypeUnsignedInteger;
+        case kTagFloatingPoint:
+            return TTSDKJSONTapeTypeFloatingPoint;
+        case kTagTrue:
+        case kTagFalse:
+            return TTSDKJSONTapeTypeBoolean;
+        case kTagNull:
+            return TTSDKJSONTapeTypeNull;
+        default:
+            return TTSDKJSONTapeTypeNone;
+    }
+}
+
+int ttsdktape_next(const TTSDKJSONTape *const tape, const int value)
+{
+    unlikely_if(value < 0 || value >= tape->entryCount) { return TTSDKJSON_TAPE_NONE; }
+    const uint64_t entry = tape->entries[value];
+    switch (entryTag(entry)) {
+        case kTagObject:
+        case kTagArray:
+            return (int)entryOffset(entry) + 1;
+        case kTagInteger:
+        case kTagUnsignedInteger:
+        case kTagFloatingPoint:
+            return value + 2;
+        default:
+            return value + 1;
+    }
+}
+
+int ttsdktape_count(const TTSDKJSONTape *const tape, const int container)
+{
+    const TTSDKJSONTapeType type = ttsdktape_type(tape, container);
+    unlikely_if(type != TTSDKJSONTapeTypeArray && type != TTSDKJSONTapeTypeObject) { return 0; }
+    return (int)entryField(tape->entries[container]);
+}
+
+/** Get a container's table of children, or NULL if it isn't a container of the given kind. */
+static inline const uint32_t *childTable(const TTSDKJSONTape *const tape, const int container, const char tag)
+{
+    unlikely_if(container < 0 || container >= tape->entryCount) { return NULL; }
+    const uint64_t entry = tape->entries[container];
+    unlikely_if(entryTag(entry) != tag) { return NULL; }
+    return tape->tables + entryOffset(tape->entries[entryOffset(entry)]);
+}
+
+int ttsdktape_element(const TTSDKJSONTape *const tape, const int array, const int index)
+{
+    const uint32_t *const table = childTable(tape, array, kTagArray);
+    unlikely_if(table == NULL || index < 0 || index >= ttsdktape_count(tape, array)) { return TTSDKJSON_TAPE_NONE; }
+    return (int)table[index];
+}
+
+int ttsdktape_memberAt(const TTSDKJSONTape *const tape, const int object, const int index, const char **const key,
+                       int *const keyLength)
+{
+    const uint32_t *const table = childTable(tape, object, kTagObject);
+    unlikely_if(table == NULL || index < 0 || index >= ttsdktape_count(tape, object)) { return TTSDKJSON_TAPE_NONE; }
+    const uint64_t entry = tape->entries[table[index]];
+    if (key != NULL) {
+        *key = tape->strings + entryOffset(entry);
+    }
+    if (keyLength != NULL) {
+        *keyLength = (int)entryField(entry);
+    }
+    return (int)table[index] + 1;
+}
+
+static inline bool keyMatches(const TTSDKJSONTape *const tape, const uint32_t position, const char *const key,
+                              const int keyLength)
+{
+    const uint64_t entry = tape->entries[position];
+    return entryField(entry) == (uint32_t)keyLength &&
+           memcmp(tape->strings + entryOffset(entry), key, (size_t)keyLength) == 0;
+}
+
+int ttsdktape_member(const TTSDKJSONTape *const tape, const int object, const char *const key, const int keyLength)
+{
+    const uint32_t *const table = childTable(tape, object, kTagObject);
+    unlikely_if(table == NULL) { return TTSDKJSON_TAPE_NONE; }
+    const int count = (int)entryField(tape->entries[object]);
+    if (count <= kLinearSearchMaxMembers) {
+        for (int i = count - 1; i >= 0; i--) {
+            if (keyMatches(tape, table[i], key, keyLength)) {
+                return (int)table[i] + 1;
+            }
+        }
+        return TTSDKJSON_TAPE_NONE;
+    }
+
+    const uint32_t *const slots = table + count;
+    const uint32_t mask = (uint32_t)hashSlotCount(count) - 1;
+    for (uint32_t slot = hashKey(key, keyLength) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+        const uint32_t position = table[slots[slot] - 1];
+        if (keyMatches(tape, position, key, keyLength)) {
+            return (int)position + 1;
+        }
+    }
+    return TTSDKJSON_TAPE_NONE;
+}
+
+bool ttsdktape_boolean(const TTSDKJSONTape *const tape, const int value)
+{
+    return ttsdktape_type(tape, value) == TTSDKJSONTapeTypeBoolean && entryTag(tape->entries[value]) == kTagTrue;
+}
+
+/** Convert a double to an integer, saturating instead of casting values that don't fit
+ * (which is undefined). NaN converts to 0.
+ */
+static int64_t doubleToInteger(const double value)
+{
+    unlikely_if(isnan(value)) { return 0; }
+    unlikely_if(value >= 9223372036854775808.0) { return INT64_MAX; }
+    unlikely_if(value < -9223372036854775808.0) { return INT64_MIN; }
+    return (int64_t)value;
+}
+
+/** Convert a double to an unsigned integer, saturating like doubleToInteger(). */
+static uint64_t doubleToUnsignedInteger(const double value)
+{
+    unlikely_if(!(value > -1.0)) { return 0; }
+    unlikely_if(value >= 18446744073709551616.0) { return UINT64_MAX; }
+    return (uint64_t)value;
+}
+
+int64_t ttsdktape_integer(const TTSDKJSONTape *const tape, const int value)
+{
+    switch (ttsdktape_type(tape, value)) {
+        case TTSDKJSONTapeTypeInteger:
+        case TTSDKJSONTapeTypeUnsignedInteger:
+            return (int64_t)tape->entries[value + 1];
+        case TTSDKJSONTapeTypeFloatingPoint:
+            return doubleToInteger(ttsdktape_floatingPoint(tape, value));
+        default:
+            return 0;
+    }
+}
+
+uint64_t ttsdktape_unsignedInteger(const TTSDKJSONTape *const tape, const int value)
+{
+    switch (ttsdktape_type(tape, value)) {
+        case TTSDKJSONTapeTypeInteger:
+        case TTSDKJSONTapeTypeUnsignedInteger:
+            return tape->entries[value + 1];
+        case TTSDKJSONTapeTypeFloatingPoint:
+            return doubleToUnsignedInteger(ttsdktape_floatingPoint(tape, value));
+        default:
+            return 0;
+    }
+}
+
+double ttsdktape_floatingPoint(const TTSDKJSONTape *const tape, const int value)
+{
+    switch (ttsdktape_type(tape, value)) {
+        case TTSDKJSONTapeTypeInteger:
+            return (double)(int64_t)tape->entries[value + 1];
+        case TTSDKJSONTapeTypeUnsignedInteger:
+            return (double)tape->entries[value + 1];
+        case TTSDKJSONTapeTypeFloatingPoint: {
+            double result;
+            memcpy(&result, &tape->entries[value + 1], sizeof(result));
+            return result;
+        }
+        default:
+            return 0;
+    }
+}
+
+const char *ttsdktape_string(const TTSDKJSONTape *const tape, const int value, int *const length)
+{
+    unlikely_if(ttsdktape_type(tape, value) != TTSDKJSONTapeTypeString) { return NULL; }
+    const uint64_t entry = tape->entries[value];
+    if (length != NULL) {
+        *length = (int)entryField(entry);
+    }
+    return tape->strings + entryOffset(entry);
+}
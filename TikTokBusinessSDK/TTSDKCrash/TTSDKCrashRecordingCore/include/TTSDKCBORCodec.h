@@ -0,0 +1,101 @@
+//
+//  TTSDKCBORCodec.h
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Reading CBOR written by the JSON encoder's CBOR mode (see ttsdkjson_setEncodeFormat()).
+ *
+ * CBOR is decoded item by item and replayed into an encode context, so the same
+ * code turns a CBOR report into JSON, or splices it into another report.
+ */
+
+#ifndef HDR_TTSDKCBORCodec_h
+#define HDR_TTSDKCBORCodec_h
+
+#include <stdbool.h>
+
+#include "TTSDKJSONCodec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Check whether data starts with the CBOR self-describe tag that the encoder
+ * writes in CBOR mode.
+ *
+ * @param data The data to check.
+ *
+ * @param length The length of the data.
+ *
+ * @return true if the data is CBOR.
+ */
+bool ttsdkcbor_isCBOR(const char *data, int length);
+
+/** Check whether a file starts with the CBOR self-describe tag.
+ *
+ * @param path The file to check.
+ *
+ * @return true if the file is CBOR.
+ */
+bool ttsdkcbor_isCBORFile(const char *path);
+
+/** Decode CBOR data and re-encode it as an element of an encode context.
+ *
+ * Byte strings become data elements, and NaN or infinite floats are handled
+ * as the encoder always handles them. If the data is truncated or invalid,
+ * everything up to that point is written and any containers it opened are closed.
+ *
+ * @param data The CBOR data.
+ *
+ * @param length The length of the data.
+ *
+ * @param name The name to give the element.
+ *
+ * @param encodeContext The context to encode into (JSON or CBOR).
+ *
+ * @return TTSDKJSON_OK if the process was successful,
+ *         TTSDKJSON_ERROR_INCOMPLETE if the data was truncated, or
+ *         TTSDKJSON_ERROR_INVALID_DATA if it isn't CBOR that can be transcoded.
+ */
+int ttsdkcbor_transcode(const char *data, int length, const char *name, TTSDKJSONEncodeContext *encodeContext);
+
+/** Like ttsdkcbor_transcode(), but stream the CBOR from a file through a
+ * small stack buffer. No memory is allocated.
+ *
+ * @param path The CBOR file.
+ *
+ * @param name The name to give the element.
+ *
+ * @param encodeContext The context to encode into (JSON or CBOR).
+ *
+ * @return TTSDKJSON_OK if the process was successful,
+ *         TTSDKJSON_ERROR_INCOMPLETE if the file was truncated.
+ */
+int ttsdkcbor_transcodeFile(const char *path, const char *name, TTSDKJSONEncodeContext *encodeContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HDR_TTSDKCBORCodec_h
@@ -157,6 +157,24 @@ bool ttsdkfu_removeFile(const char *path, bool mustExist);
  */
 bool ttsdkfu_deleteContentsOfPath(const char *path);
 
+/** Flush a file's contents to storage, so that they survive a power loss.
+ * On Darwin this uses F_FULLFSYNC, since fsync() only hands the data to the drive.
+ *
+ * @param fd The file descriptor.
+ *
+ * @return true if successful.
+ */
+bool ttsdkfu_syncFD(const int fd);
+
+/** Flush a directory's entries to storage, so that files created, renamed or
+ * removed in it stay that way after a power loss.
+ *
+ * @param path The path of the directory.
+ *
+ * @return true if successful.
+ */
+bool ttsdkfu_syncDirectory(const char *path);
+
 /** Buffered writer structure. Everything inside should be considered internal use only. */
 typedef struct {
     char *buffer;
@@ -0,0 +1,200 @@
+//
+//  TTSDKGZip.h
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Writing gzip files from a crash handler, and reading them back.
+ *
+ * The writer deflates into a TTSDKBufferedWriter's fixed buffer, and zlib's
+ * state comes out of caller-provided memory, so nothing is allocated while
+ * writing.
+ */
+
+#ifndef HDR_TTSDKGZip_h
+#define HDR_TTSDKGZip_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#include "TTSDKFileUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Window size (log2) used by the writer. Larger windows compress better but need more memory. */
+#ifndef TTSDKGZ_WINDOW_BITS
+#define TTSDKGZ_WINDOW_BITS 14
+#endif
+
+/** zlib memLevel used by the writer. */
+#ifndef TTSDKGZ_MEM_LEVEL
+#define TTSDKGZ_MEM_LEVEL 7
+#endif
+
+/** Memory needed for a writer's zlib state (see deflateInit2() in zlib's deflate.c). */
+#define TTSDKGZ_DEFLATE_MEMORY_SIZE \
+    ((4 << TTSDKGZ_WINDOW_BITS) + (2 << (TTSDKGZ_MEM_LEVEL + 7)) + (5 << (TTSDKGZ_MEM_LEVEL + 6)) + 8192)
+
+/** Memory needed for ttsdkgz_inflateFile()'s zlib state (see inflateInit2() in zlib's inflate.c). */
+#define TTSDKGZ_INFLATE_MEMORY_SIZE ((1 << TTSDKGZ_WINDOW_BITS) + 12288)
+
+/** Memory that zlib allocates from. Everything inside should be considered internal use only. */
+typedef struct {
+    char *memory;
+    int size;
+    int used;
+} TTSDKGZipArena;
+
+/** Gzip writer structure. Everything inside should be considered internal use only. */
+typedef struct {
+    z_stream stream;
+    TTSDKBufferedWriter *output;
+} TTSDKGZipWriter;
+
+/** Prepare an arena. Allocations are never freed individually; reset the
+ * arena with ttsdkgz_resetArena() once nothing is using it.
+ *
+ * @param arena The arena to initialize.
+ *
+ * @param memory The memory to allocate from.
+ *
+ * @param size The size of the memory.
+ */
+void ttsdkgz_initArena(TTSDKGZipArena *arena, char *memory, int size);
+
+/** Make all of an arena's memory available again.
+ *
+ * @param arena The arena to reset.
+ */
+void ttsdkgz_resetArena(TTSDKGZipArena *arena);
+
+/** Start writing gzip data to a buffered writer.
+ *
+ * @param writer The writer to initialize.
+ *
+ * @param output Where the compressed data goes. Its write buffer is used as
+ *               deflate's output buffer.
+ *
+ * @param arena Where zlib's state is allocated (TTSDKGZ_DEFLATE_MEMORY_SIZE bytes),
+ *              or NULL to use malloc.
+ *
+ * @return true if successful.
+ */
+bool ttsdkgz_openWriter(TTSDKGZipWriter *writer, TTSDKBufferedWriter *output, TTSDKGZipArena *arena);
+
+/** Compress data.
+ *
+ * @param writer The writer.
+ *
+ * @param data The data to compress.
+ *
+ * @param length The length of the data.
+ *
+ * @return true if successful.
+ */
+bool ttsdkgz_write(TTSDKGZipWriter *writer, const char *data, int length);
+
+/** Flush all data written so far to disk, so that it can be decompressed even
+ * if the stream is never finished. Compression continues to use the history.
+ *
+ * @param writer The writer.
+ *
+ * @return true if successful.
+ */
+bool ttsdkgz_flush(TTSDKGZipWriter *writer);
+
+/** Finish the gzip stream and flush it to disk. The buffered writer stays open.
+ *
+ * @param writer The writer.
+ *
+ * @return true if successful.
+ */
+bool ttsdkgz_closeWriter(TTSDKGZipWriter *writer);
+
+/** Check whether data starts with the gzip magic number.
+ *
+ * @param data The data to check.
+ *
+ * @param length The length of the data.
+ *
+ * @return true if the data is gzip compressed.
+ */
+bool ttsdkgz_isGZip(const char *data, int length);
+
+/** Check whether a file starts with the gzip magic number.
+ *
+ * @param path The file to check.
+ *
+ * @return true if the file is gzip compressed.
+ */
+bool ttsdkgz_isGZipFile(const char *path);
+
+/** Get a gzip file's uncompressed size from its trailer, without decompressing it.
+ * The trailer only holds the size modulo 2^32, and a truncated file has no
+ * trailer, so this can only rule a size out.
+ *
+ * @param path The gzip file.
+ *
+ * @param size Place to store the uncompressed size, modulo 2^32.
+ *
+ * @return true if the file could be read.
+ */
+bool ttsdkgz_getUncompressedSize(const char *path, uint32_t *size);
+
+/** Decompress a file written by a TTSDKGZipWriter into another file.
+ * A truncated file is decompressed up to its last flush point.
+ *
+ * @param srcPath The gzip file.
+ *
+ * @param dstPath The file to write. It must not exist.
+ *
+ * @param arena Where zlib's state is allocated (TTSDKGZ_INFLATE_MEMORY_SIZE bytes),
+ *              or NULL to use malloc.
+ *
+ * @return true if anything was decompressed.
+ */
+bool ttsdkgz_inflateFile(const char *srcPath, const char *dstPath, TTSDKGZipArena *arena);
+
+/** Read and decompress an entire gzip file.
+ *
+ * @param path The gzip file.
+ *
+ * @param data Place to store a pointer to the NULL terminated contents.
+ *             The caller is responsible for freeing it.
+ *
+ * @param length Place to store the length of the contents (can be NULL).
+ *
+ * @param maxLength The most that will be decompressed.
+ *
+ * @return true if anything was decompressed. A truncated file is not an error.
+ */
+bool ttsdkgz_readEntireFile(const char *path, char **data, int *length, int maxLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HDR_TTSDKGZip_h
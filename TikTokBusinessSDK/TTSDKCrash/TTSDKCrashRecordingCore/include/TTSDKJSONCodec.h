@@ -94,6 +94,63 @@ const char *ttsdkjson_stringForError(const int error);
  */
 typedef int (*TTSDKJSONAddDataFunc)(const char *data, int length, void *userData);
 
+/** The format that an encode context writes. */
+typedef enum {
+    /** JSON text. */
+    TTSDKJSONEncodeFormatJSON = 0,
+
+    /** CBOR (RFC 8949). Containers and streamed strings use indefinite lengths,
+     * data elements become byte strings, and the output starts with the CBOR
+     * self-describe tag (0xd9d9f7).
+     */
+    TTSDKJSONEncodeFormatCBOR = 1,
+} TTSDKJSONEncodeFormat;
+
+/** How data elements are written to JSON. */
+typedef enum {
+    /** Uppercase hex, two characters per byte. */
+    TTSDKJSONDataEncodingHex = 0,
+
+    /** Standard base64 (RFC 4648) with padding, four characters per three bytes. */
+    TTSDKJSONDataEncodingBase64 = 1,
+} TTSDKJSONDataEncoding;
+
+/** The longest section path, including the terminator. Containers with longer paths aren't indexed. */
+#define TTSDKJSON_SECTION_PATH_LENGTH 48
+
+/** How many levels below the top container the section index looks. */
+#define TTSDKJSON_SECTION_INDEX_DEPTH 3
+
+/** Where a container was written in the encoder's output. */
+typedef struct {
+    /** The container's path, such as "crash.error" or "crash.threads[2]". */
+    char path[TTSDKJSON_SECTION_PATH_LENGTH];
+
+    /** The offset of the container's opening bracket. */
+    int64_t offset;
+
+    /** The length of the container, up to and including its closing bracket,
+     * or 0 if it was never closed.
+     */
+    int64_t length;
+} TTSDKJSONSectionIndexEntry;
+
+/** Section index state. Everything inside should be considered internal use only. */
+typedef struct {
+    TTSDKJSONSectionIndexEntry *entries;
+    int capacity;
+    int count;
+    /** The encoder's container level when indexing started. */
+    int baseLevel;
+    /** The entry of each open container, or -1 if it isn't indexed. */
+    int openEntries[TTSDKJSON_SECTION_INDEX_DEPTH + 1];
+    /** How many containers each open container holds so far. */
+    int containerCounts[TTSDKJSON_SECTION_INDEX_DEPTH + 1];
+    /** The length of each open container's path. */
+    int pathLengths[TTSDKJSON_SECTION_INDEX_DEPTH + 1];
+    char path[TTSDKJSON_SECTION_PATH_LENGTH];
+} TTSDKJSONSectionIndex;
+
 typedef struct {
     /** Function to call to add more encoded JSON data. */
     TTSDKJSONAddDataFunc addJSONData;
@@ -112,6 +169,42 @@ typedef struct {
 
     bool prettyPrint;
 
+    /** Optional buffer where output is assembled before being passed to addJSONData. */
+    char *outputBuffer;
+
+    /** The size of the output buffer. */
+    int outputBufferLength;
+
+    /** How many bytes of the output buffer are in use. */
+    int outputBufferPosition;
+
+    /** The key token that a ttsdkjson_*Literal() function is adding an element under, or NULL.
+     * It's only set for the duration of that call.
+     */
+    const char *literalKey;
+    int literalKeyLength;
+
+    /** true between ttsdkjson_beginElementName() and the element that the name belongs to. */
+    bool isNameOpen;
+
+    /** The output format. */
+    TTSDKJSONEncodeFormat format;
+
+    /** How data elements are written. */
+    TTSDKJSONDataEncoding dataEncoding;
+
+    /** Bytes of an incrementally-built base64 data element that don't yet make up a full group. */
+    unsigned char pendingData[2];
+
+    /** How many bytes of pendingData are in use. */
+    int pendingDataLength;
+
+    /** How many bytes have been passed to addJSONData. */
+    int64_t bytesFlushed;
+
+    /** Where container offsets are recorded, if anywhere. */
+    TTSDKJSONSectionIndex *sectionIndex;
+
 } TTSDKJSONEncodeContext;
 
 /** Begin a new encoding process.
@@ -127,11 +220,108 @@ typedef struct {
 void ttsdkjson_beginEncode(TTSDKJSONEncodeContext *context, bool prettyPrint, TTSDKJSONAddDataFunc addJSONData, void *userData);
 
 /** End the encoding process, ending any remaining open containers.
+ * Anything remaining in the output buffer gets flushed.
  *
  * @return TTSDKJSON_OK if the process was successful.
  */
 int ttsdkjson_endEncode(TTSDKJSONEncodeContext *context);
 
+/** End a record of a newline-delimited JSON (NDJSON) stream: end any
+ * remaining open containers, write a newline and flush the output buffer.
+ * The next top-level element starts the next record, so a stream of records
+ * can be appended to one open context without beginning it again.
+ *
+ * Records must be encoded without pretty printing, which would spread them
+ * over several lines. CBOR records are written back to back, with no newline
+ * (a CBOR sequence).
+ *
+ * Does nothing if no element was added since the last record.
+ *
+ * @param context The encoding context.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+int ttsdkjson_endRecord(TTSDKJSONEncodeContext *context);
+
+/** Have the encoder coalesce its output in a caller-supplied buffer.
+ *
+ * Without a buffer, every token (commas, quotes, names, values, indentation)
+ * is passed to addJSONData separately. With a buffer, addJSONData is only
+ * called when the buffer fills up, when data too large for the buffer is
+ * added, or when the buffer is flushed.
+ *
+ * No memory is allocated, so this is safe to use in a signal handler.
+ *
+ * Note: Must be called after ttsdkjson_beginEncode().
+ *
+ * @param context The encoding context.
+ *
+ * @param buffer The buffer to use, or NULL to stop buffering.
+ *
+ * @param length The length of the buffer.
+ */
+void ttsdkjson_setOutputBuffer(TTSDKJSONEncodeContext *context, char *buffer, int length);
+
+/** Select the output format. The encoding API is the same for every format.
+ *
+ * Note: Must be called after ttsdkjson_beginEncode() and before adding any elements.
+ *
+ * @param context The encoding context.
+ *
+ * @param format The format to write.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+int ttsdkjson_setEncodeFormat(TTSDKJSONEncodeContext *context, TTSDKJSONEncodeFormat format);
+
+/** Select how data elements are written. The default is hex.
+ * Has no effect on CBOR output, which stores data as byte strings.
+ *
+ * Note: Must not be called while a data element is being built.
+ *
+ * @param context The encoding context.
+ *
+ * @param encoding The data encoding to use.
+ */
+void ttsdkjson_setDataEncoding(TTSDKJSONEncodeContext *context, TTSDKJSONDataEncoding encoding);
+
+/** Record where the containers near the top of the document are written.
+ *
+ * Containers one and two levels below the current one are indexed when they
+ * are object members, as are containers in the arrays two levels down (such
+ * as each thread in crash.threads). Elements of arrays one level down (such as
+ * binary_images) are not indexed individually. Offsets count every byte passed
+ * to addJSONData, so they are offsets into the uncompressed output.
+ *
+ * No memory is allocated, so this is safe to use in a signal handler.
+ *
+ * @param context The encoding context.
+ *
+ * @param index The index state to initialize.
+ *
+ * @param entries Where to store entries. Containers past the capacity aren't indexed.
+ *
+ * @param capacity The number of entries.
+ */
+void ttsdkjson_beginSectionIndex(TTSDKJSONEncodeContext *context, TTSDKJSONSectionIndex *index,
+                                 TTSDKJSONSectionIndexEntry *entries, int capacity);
+
+/** Get the offset in the output that the next byte will be written to.
+ *
+ * @param context The encoding context.
+ *
+ * @return The number of bytes encoded so far.
+ */
+int64_t ttsdkjson_getOutputPosition(const TTSDKJSONEncodeContext *context);
+
+/** Pass anything held in the output buffer to addJSONData.
+ *
+ * @param context The encoding context.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+int ttsdkjson_flushOutputBuffer(TTSDKJSONEncodeContext *context);
+
 /** Add a boolean element.
  *
  * @param context The encoding context.
@@ -236,7 +426,33 @@ int ttsdkjson_appendStringElement(TTSDKJSONEncodeContext *context, const char *v
  */
 int ttsdkjson_endStringElement(TTSDKJSONEncodeContext *context);
 
-/** Add a string element. The element will be converted to string-coded hex.
+/** Start the name of an element that is passed in fragments, for names too
+ * long to hold in memory at once.
+ *
+ * Pass the fragments to ttsdkjson_appendElementName(), and then add the
+ * element itself with a NULL name. Nothing else may be added in between.
+ * Outside of an object the name is ignored, as with any other element.
+ *
+ * @param context The encoding context.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+int ttsdkjson_beginElementName(TTSDKJSONEncodeContext *context);
+
+/** Add a fragment to a name begun with ttsdkjson_beginElementName().
+ *
+ * @param context The encoding context.
+ *
+ * @param name The name fragment.
+ *
+ * @param length The length of the name fragment.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+int ttsdkjson_appendElementName(TTSDKJSONEncodeContext *context, const char *name, int length);
+
+/** Add a data element. The element will be converted to string-coded hex
+ * or base64, depending on the context's data encoding.
  *
  * @param context The encoding context.
  *
@@ -251,7 +467,7 @@ int ttsdkjson_endStringElement(TTSDKJSONEncodeContext *context);
 int ttsdkjson_addDataElement(TTSDKJSONEncodeContext *const context, const char *name, const char *value, int length);
 
 /** Start an incrementally-built data element. The element will be converted
- * to string-coded hex.
+ * to string-coded hex or base64, depending on the context's data encoding.
  *
  * Use this for constructing very large data elements.
  *
@@ -330,8 +546,53 @@ int ttsdkjson_beginArray(TTSDKJSONEncodeContext *context, const char *name);
  */
 int ttsdkjson_beginElement(TTSDKJSONEncodeContext *const context, const char *const name);
 
+/** Build a pre-escaped, pre-quoted key token for the ttsdkjson_*Literal() functions
+ * out of a string literal at compile time. The name must not need escaping.
+ */
+#define TTSDKJSON_KEY_LITERAL(NAME) "\"" NAME "\":"
+
+/* The ttsdkjson_*Literal() functions add an element like their named counterparts,
+ * but copy a key token that was quoted and escaped at compile time instead of
+ * escaping the name at runtime. The token is only used if the parent is an object.
+ *
+ * literalKey is the key token, as made by TTSDKJSON_KEY_LITERAL(), and length is its
+ * length, not counting the terminator. They return TTSDKJSON_OK if the process was
+ * successful.
+ */
+
+/** Like ttsdkjson_addBooleanElement(), but under a literal key. */
+int ttsdkjson_addBooleanElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, int length,
+                                      bool value);
+
+/** Like ttsdkjson_addFloatingPointElement(), but under a literal key. */
+int ttsdkjson_addFloatingPointElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey,
+                                            int length, double value);
+
+/** Like ttsdkjson_addIntegerElement(), but under a literal key. */
+int ttsdkjson_addIntegerElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, int length,
+                                      int64_t value);
+
+/** Like ttsdkjson_addUIntegerElement(), but under a literal key. */
+int ttsdkjson_addUIntegerElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, int length,
+                                       uint64_t value);
+
+/** Like ttsdkjson_addStringElement(), but under a literal key. */
+int ttsdkjson_addStringElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, int length,
+                                     const char *value, int valueLength);
+
+/** Like ttsdkjson_addDataElement(), but under a literal key. */
+int ttsdkjson_addDataElementLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, int length,
+                                   const char *value, int valueLength);
+
+/** Like ttsdkjson_beginObject(), but under a literal key. */
+int ttsdkjson_beginObjectLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, int length);
+
+/** Like ttsdkjson_beginArray(), but under a literal key. */
+int ttsdkjson_beginArrayLiteral(TTSDKJSONEncodeContext *const context, const char *const literalKey, int length);
+
 /** Add JSON data manually.
  * This function just passes your data directly through, even if it's malforned.
+ * Not supported when writing CBOR.
  *
  * @param context The encoding context.
  *
@@ -364,13 +625,144 @@ int ttsdkjson_endContainer(TTSDKJSONEncodeContext *context);
 int ttsdkjson_addJSONFromFile(TTSDKJSONEncodeContext *const context, const char *restrict const name,
                            const char *restrict const filename, const bool closeLastContainer);
 
+// ============================================================================
+// Reindent
+// ============================================================================
+
+/** Re-indentation context. Everything inside should be considered internal use only. */
+typedef struct {
+    /** Where the re-indented JSON goes. */
+    TTSDKJSONEncodeContext encodeContext;
+
+    /** How many containers are open. */
+    int depth;
+
+    bool isInString;
+
+    bool isEscaped;
+
+    /** true right after a container opens, until something goes in it. */
+    bool isOpenPending;
+} TTSDKJSONReindentContext;
+
+/** Begin pretty printing JSON that was written compactly, without decoding it.
+ * The output is laid out exactly as the encoder lays out pretty printed JSON.
+ *
+ * @param context The context to initialize.
+ *
+ * @param addJSONData Function to handle adding data.
+ *
+ * @param userData User-specified data which gets passed to addJSONData.
+ */
+void ttsdkjson_beginReindent(TTSDKJSONReindentContext *context, TTSDKJSONAddDataFunc addJSONData, void *userData);
+
+/** Re-indent the next part of a JSON document. The document may be split
+ * anywhere, and must be well formed; whitespace between tokens is replaced.
+ *
+ * Call ttsdkjson_setOutputBuffer() on the context's encodeContext to batch output.
+ *
+ * @param context The re-indentation context.
+ *
+ * @param data The next part of the document.
+ *
+ * @param length The length of the data.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+int ttsdkjson_reindent(TTSDKJSONReindentContext *context, const char *data, int length);
+
+/** End re-indenting and flush any buffered output.
+ *
+ * @param context The re-indentation context.
+ *
+ * @return TTSDKJSON_OK if the process was successful.
+ */
+int ttsdkjson_endReindent(TTSDKJSONReindentContext *context);
+
 // ============================================================================
 // Decode
 // ============================================================================
 
+/** The most keys a TTSDKJSONKeyDictionary can hold. */
+#define TTSDKJSON_KEY_DICTIONARY_MAX_KEYS 128
+
+/** The most bytes of key names a TTSDKJSONKeyDictionary can hold, including
+ * one byte of overhead before and after each name.
+ */
+#define TTSDKJSON_KEY_DICTIONARY_MAX_KEY_BYTES 2048
+
+/** The key ID of a name that isn't in a key dictionary. */
+#define TTSDKJSON_KEY_UNKNOWN (-1)
+
+/** A compiled set of object keys, looked up with a perfect hash.
+ * Everything inside should be considered internal use only.
+ */
+typedef struct TTSDKJSONKeyDictionary {
+    /** Number of keys. */
+    int keyCount;
+    /** Hash seed that places every key in a slot of its own. */
+    uint32_t seed;
+    /** Number of buckets - 1. */
+    uint32_t bucketMask;
+    /** Number of slots - 1. */
+    uint32_t slotMask;
+    /** For each bucket, how far its keys are displaced to reach free slots. */
+    uint8_t displacements[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS];
+    /** For each slot, 1 + the ID of the key in it, or 0 if it's empty. */
+    uint8_t slots[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS * 2];
+    /** For each key, the offset of its name in keys. */
+    uint16_t keyOffsets[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS];
+    /** For each key, the length of its name. */
+    uint16_t keyLengths[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS];
+    /** Each key's ID byte, followed by its null terminated name. */
+    char keys[TTSDKJSON_KEY_DICTIONARY_MAX_KEY_BYTES];
+} TTSDKJSONKeyDictionary;
+
+/** Compile a set of object keys into a dictionary, so that the decoder can
+ * tell callbacks which key a member has (see TTSDKJSONDecodeCallbacks.keyDictionary).
+ *
+ * @param dictionary The dictionary to compile into. It does not refer to the
+ *                   keys once compiled.
+ *
+ * @param keys The keys. Each key's ID is its index in this array.
+ *
+ * @param keyCount The number of keys.
+ *
+ * @return TTSDKJSON_OK if successful, TTSDKJSON_ERROR_INVALID_DATA if a key
+ *         appears twice, or TTSDKJSON_ERROR_DATA_TOO_LONG if the keys don't fit.
+ */
+int ttsdkjson_compileKeyDictionary(TTSDKJSONKeyDictionary *dictionary, const char *const *keys, int keyCount);
+
+/** Get the ID of a name that the decoder passed to a callback.
+ *
+ * This doesn't look at the name's contents: the decoder passes names that
+ * are in the dictionary as the dictionary's own copy, and the ID is stored
+ * just before it. Any other name (including NULL) is unknown.
+ *
+ * @param dictionary The dictionary that was set in the decode callbacks.
+ *
+ * @param name A name passed to a callback.
+ *
+ * @return The key's ID, or TTSDKJSON_KEY_UNKNOWN.
+ */
+int ttsdkjson_keyID(const TTSDKJSONKeyDictionary *dictionary, const char *name);
+
+/** Look up a name in a key dictionary by its contents.
+ *
+ * @param dictionary The dictionary.
+ *
+ * @param name The name. It doesn't need to be null terminated.
+ *
+ * @param length The length of the name.
+ *
+ * @return The key's ID, or TTSDKJSON_KEY_UNKNOWN.
+ */
+int ttsdkjson_findKey(const TTSDKJSONKeyDictionary *dictionary, const char *name, int length);
+
 /**
  * Callbacks called during a JSON decode process.
- * All function pointers must point to valid functions.
+ * All function pointers must point to valid functions, except for
+ * onStringElementSlice and onStringElementPart, which may be NULL.
  */
 typedef struct TTSDKJSONDecodeCallbacks {
     /** Called when a boolean element is decoded.
@@ -480,6 +872,59 @@ typedef struct TTSDKJSONDecodeCallbacks {
      */
     int (*onEndData)(void *userData);
 
+    /** If set, called instead of onStringElement() when a string element is decoded.
+     *
+     * A string with no escape sequences is passed in place, pointing into the
+     * data being decoded, so it isn't copied and isn't limited by the size of
+     * the string buffer. Other strings are unescaped into the string buffer.
+     *
+     * @param name The element's name.
+     *
+     * @param nameLength The length of the name (0 if name is NULL).
+     *
+     * @param value The element's value. It is NOT null terminated.
+     *
+     * @param valueLength The length of the value.
+     *
+     * @param userData Data that was specified when calling ttsdkjson_decode().
+     *
+     * @return TTSDKJSON_OK if decoding should continue.
+     */
+    int (*onStringElementSlice)(const char *name, int nameLength, const char *value, int valueLength,
+                                void *userData);
+
+    /** If set, a push decoder (see ttsdkjson_decoderInit()) calls this with
+     * the pieces of a string element that doesn't fit in its string buffer,
+     * instead of failing with TTSDKJSON_ERROR_DATA_TOO_LONG. Strings that fit
+     * are passed to onStringElement() or onStringElementSlice() as usual.
+     *
+     * Each piece is unescaped, and pieces never end partway through an escape
+     * sequence or a UTF-8 character. Not used by ttsdkjson_decode().
+     *
+     * @param name The element's name.
+     *
+     * @param value This piece of the element's value. It is NOT null terminated.
+     *
+     * @param valueLength The length of this piece.
+     *
+     * @param isFirstPart true for the first piece of the element.
+     *
+     * @param isLastPart true for the last piece of the element.
+     *
+     * @param userData Data that was specified when calling ttsdkjson_decoderInit().
+     *
+     * @return TTSDKJSON_OK if decoding should continue.
+     */
+    int (*onStringElementPart)(const char *name, const char *value, int valueLength, bool isFirstPart,
+                               bool isLastPart, void *userData);
+
+    /** If set, member names that are keys in this dictionary are passed to
+     * the callbacks as the dictionary's copy of the name, so that
+     * ttsdkjson_keyID() can tell which key it is without comparing strings.
+     * Other names are passed as usual. May be NULL.
+     */
+    const TTSDKJSONKeyDictionary *keyDictionary;
+
 } TTSDKJSONDecodeCallbacks;
 
 /** Read a JSON encoded file from the specified FD.
@@ -505,6 +950,341 @@ typedef struct TTSDKJSONDecodeCallbacks {
 int ttsdkjson_decode(const char *data, int length, char *stringBuffer, int stringBufferLength,
                   TTSDKJSONDecodeCallbacks *callbacks, void *userData, int *errorOffset);
 
+/** The most path segments a TTSDKJSONPathFilter can hold, counting segments
+ * that paths share only once.
+ */
+#define TTSDKJSON_PATH_FILTER_MAX_SEGMENTS 63
+
+/** The most bytes of member names a TTSDKJSONPathFilter can hold. */
+#define TTSDKJSON_PATH_FILTER_MAX_KEY_BYTES 512
+
+/** A compiled set of key paths. Everything inside should be considered internal use only. */
+typedef struct {
+    /** Number of nodes in use. Node 0 is the top-level element. */
+    int nodeCount;
+    /** Number of bytes of keys in use. */
+    int keysLength;
+    /** The nodes where a path ends. */
+    uint64_t selected;
+    /** The nodes that match a named member. */
+    uint64_t members;
+    /** The nodes that match any member ("*"). */
+    uint64_t anyMembers;
+    /** The nodes that match an array element by index ("[3]"). */
+    uint64_t elements;
+    /** The nodes that match any array element ("[*]"). */
+    uint64_t anyElements;
+    /** For each node, the nodes that match its children. */
+    uint64_t children[TTSDKJSON_PATH_FILTER_MAX_SEGMENTS + 1];
+    /** For each node, the offset of its member name in keys, or the array index it matches. */
+    int32_t values[TTSDKJSON_PATH_FILTER_MAX_SEGMENTS + 1];
+    /** For each node, the length of its member name. */
+    int16_t keyLengths[TTSDKJSON_PATH_FILTER_MAX_SEGMENTS + 1];
+    char keys[TTSDKJSON_PATH_FILTER_MAX_KEY_BYTES];
+} TTSDKJSONPathFilter;
+
+/** Compile a set of key paths for ttsdkjson_decodeFiltered().
+ *
+ * A path is a series of member names separated by '.', with "[N]" for the
+ * element at index N of an array, "[*]" for every element of an array and
+ * "*" for every member of an object, as in
+ * "crash.threads[*].backtrace.contents[*].instruction_addr".
+ * The first segment applies to the members (or elements) of the top-level
+ * element. Member names can't contain '.' or '[', and are compared after
+ * unescaping.
+ *
+ * @param filter The filter to compile into. It does not refer to the paths
+ *               once compiled.
+ *
+ * @param paths The paths.
+ *
+ * @param pathCount The number of paths.
+ *
+ * @return TTSDKJSON_OK if successful, TTSDKJSON_ERROR_INVALID_DATA if a path
+ *         is malformed, or TTSDKJSON_ERROR_DATA_TOO_LONG if the paths don't fit.
+ */
+int ttsdkjson_compilePathFilter(TTSDKJSONPathFilter *filter, const char *const *paths, int pathCount);
+
+/** Decode only the parts of a JSON document that a path filter selects.
+ *
+ * A value at the end of a path is passed to the callbacks whole, including
+ * everything inside it. The containers on the way to it are passed too (their
+ * begin and end callbacks), so the callbacks see the document as if
+ * everything else had been removed from it. Everything else is skipped over by
+ * matching brackets and quotes: it isn't decoded, and it's only checked for
+ * being balanced.
+ *
+ * @param data UTF-8 encoded JSON data.
+ *
+ * @param length Length of the data.
+ *
+ * @param stringBuffer A buffer to use for decoding strings.
+ *                     Note: 1/4 of this buffer will be used for dictionary name decoding.
+ *
+ * @param stringBufferLength The length of the string buffer.
+ *
+ * @param filter The paths to decode, from ttsdkjson_compilePathFilter().
+ *
+ * @param callbacks The callbacks to call while decoding.
+ *
+ * @param userData Any data you would like passed to the callbacks.
+ *
+ * @param errorOffset If not null, will contain the offset into the data
+ *                    where the error (if any) occurred.
+ *
+ * @return TTSDKJSON_OK if succesful. An error code otherwise.
+ */
+int ttsdkjson_decodeFiltered(const char *data, int length, char *stringBuffer, int stringBufferLength,
+                             const TTSDKJSONPathFilter *filter, TTSDKJSONDecodeCallbacks *callbacks, void *userData,
+                             int *errorOffset);
+
+/** The most workers that ttsdkjson_decodeArrayInParallel() will use. */
+#ifndef TTSDKJSON_MAX_ARRAY_WORKERS
+#define TTSDKJSON_MAX_ARRAY_WORKERS 16
+#endif
+
+/** One worker's share of a top-level array being decoded by
+ * ttsdkjson_decodeArrayInParallel().
+ *
+ * The caller fills in callbacks, userData and stringBuffer for each worker.
+ * Each worker decodes a run of consecutive elements, each element as a
+ * document of its own (with a NULL name, followed by onEndData()), so
+ * worker 0's elements come first, then worker 1's, and so on.
+ */
+typedef struct {
+    /** The callbacks to call for this worker's elements. */
+    TTSDKJSONDecodeCallbacks *callbacks;
+    /** Data passed to this worker's callbacks. */
+    void *userData;
+    /** A buffer for decoding strings, used only by this worker. */
+    char *stringBuffer;
+    /** The length of the string buffer. */
+    int stringBufferLength;
+    /** Set by the decode: the index of this worker's first element. */
+    int firstElement;
+    /** Set by the decode: the number of elements given to this worker. */
+    int elementCount;
+    /** Set by the decode: TTSDKJSON_OK, or the error that stopped this worker. */
+    int result;
+    /** Set by the decode: where in the data this worker's error occurred. */
+    int errorOffset;
+} TTSDKJSONArrayWorker;
+
+/** Decode the elements of a top-level array on several threads at once.
+ *
+ * The element boundaries are found first, by stepping over the elements
+ * without decoding them. The elements are then divided into runs of about
+ * the same number of bytes, and each run is decoded by one worker on a
+ * thread of its own (the first on the calling thread). Small arrays use
+ * fewer workers, in which case the rest are given no elements.
+ *
+ * Not async-safe.
+ *
+ * @param data UTF-8 encoded JSON data whose top-level element is an array.
+ *
+ * @param length Length of the data.
+ *
+ * @param workers The workers.
+ *
+ * @param workerCount The number of workers (at most TTSDKJSON_MAX_ARRAY_WORKERS).
+ *
+ * @param errorOffset If not null, will contain the offset into the data
+ *                    where the error (if any) occurred.
+ *
+ * @return TTSDKJSON_OK if every element was decoded. Otherwise the first
+ *         error, in element order.
+ */
+int ttsdkjson_decodeArrayInParallel(const char *data, int length, TTSDKJSONArrayWorker *workers, int workerCount,
+                                    int *errorOffset);
+
+/** The deepest nesting of containers that a TTSDKJSONDecoder accepts. */
+#ifndef TTSDKJSON_DECODER_MAX_DEPTH
+#define TTSDKJSON_DECODER_MAX_DEPTH 200
+#endif
+
+/** The longest number or literal that a TTSDKJSONDecoder can piece together
+ * when it's split between two calls to ttsdkjson_decoderFeed().
+ */
+#define TTSDKJSON_DECODER_MAX_SCALAR_LENGTH 63
+
+/** Push decoder. Everything inside should be considered internal use only. */
+typedef struct {
+    TTSDKJSONDecodeCallbacks *callbacks;
+    void *userData;
+    char *nameBuffer;
+    int nameBufferLength;
+    char *stringBuffer;
+    int stringBufferLength;
+    /** Name passed with the top-level element. May be set after ttsdkjson_decoderInit(). */
+    const char *rootName;
+    /** true if anything but whitespace after the top-level element is an error.
+     * May be set after ttsdkjson_decoderInit().
+     */
+    bool rejectsTrailingData;
+    /** Name of the member being decoded: the name buffer, or a key dictionary's copy. */
+    const char *memberName;
+    /** What the decoder expects next. */
+    int state;
+    /** Number of open containers. */
+    int depth;
+    /** One bit per open container, set for objects. */
+    uint8_t isObject[(TTSDKJSON_DECODER_MAX_DEPTH + 7) / 8];
+    /** Bytes of a string, name or scalar gathered from earlier chunks. */
+    int pendingLength;
+    /** true if the gathered string has escape sequences. */
+    bool hasEscapes;
+    /** true if the gathered string ends in a backslash that escapes the next byte. */
+    bool isEscaped;
+    /** true once pieces of the current string have gone to onStringElementPart(). */
+    bool isStringInParts;
+    /** The first error encountered. Once set, decoding stops. */
+    int result;
+    char scalarBuffer[TTSDKJSON_DECODER_MAX_SCALAR_LENGTH + 2];
+} TTSDKJSONDecoder;
+
+/** Begin decoding JSON that arrives in pieces.
+ *
+ * Elements are passed to the callbacks as soon as they are complete. The
+ * decoder keeps its place anywhere in the document, including in the middle
+ * of a string or number, so the pieces can be split at any byte. It never
+ * allocates memory.
+ *
+ * Strings must fit in the string buffer, except that strings without escape
+ * sequences are passed in place when onStringElementSlice is set and the
+ * whole string is in one piece, and that longer string elements are passed
+ * in pieces when onStringElementPart is set.
+ *
+ * @param decoder The decoder to initialize.
+ *
+ * @param stringBuffer A buffer to use for decoding strings. It must remain
+ *                     valid until decoding is finished.
+ *                     Note: 1/4 of this buffer will be used for dictionary name decoding.
+ *
+ * @param stringBufferLength The length of the string buffer.
+ *
+ * @param callbacks The callbacks to call while decoding.
+ *
+ * @param userData Any data you would like passed to the callbacks.
+ */
+void ttsdkjson_decoderInit(TTSDKJSONDecoder *decoder, char *stringBuffer, int stringBufferLength,
+                           TTSDKJSONDecodeCallbacks *callbacks, void *userData);
+
+/** Decode the next piece of a JSON document.
+ *
+ * Anything after the end of the top-level element is ignored, unless
+ * rejectsTrailingData is set and it isn't whitespace.
+ *
+ * @param decoder The decoder.
+ *
+ * @param data The next piece of UTF-8 encoded JSON data.
+ *
+ * @param length The length of the data.
+ *
+ * @return TTSDKJSON_OK if successful. An error code otherwise, which is also
+ *         returned by all further calls.
+ */
+int ttsdkjson_decoderFeed(TTSDKJSONDecoder *decoder, const char *data, int length);
+
+/** Finish decoding, calling onEndData() if the document was complete.
+ *
+ * @param decoder The decoder.
+ *
+ * @return TTSDKJSON_OK if successful, TTSDKJSON_ERROR_INCOMPLETE if the document
+ *         ended early, or the error that stopped decoding.
+ */
+int ttsdkjson_decoderFinish(TTSDKJSONDecoder *decoder);
+
+/** Reader of newline-delimited JSON (NDJSON) records from a file.
+ * Everything inside should be considered internal use only.
+ */
+typedef struct {
+    int fd;
+    char *readBuffer;
+    int readBufferLength;
+    /** The next unread byte in the read buffer. */
+    int readPosition;
+    /** How many bytes of the read buffer hold data. */
+    int readLength;
+    /** true once the file has no more data. */
+    bool isAtEnd;
+    /** The line that the next unread byte is on, counting from 1. */
+    int lineNumber;
+    char *stringBuffer;
+    int stringBufferLength;
+    TTSDKJSONDecodeCallbacks *callbacks;
+    void *userData;
+    TTSDKJSONDecoder decoder;
+} TTSDKJSONRecordReader;
+
+/** Begin reading the records of a newline-delimited JSON file, one record per line.
+ *
+ * The file is read a buffer at a time and each record goes through a push
+ * decoder, so a record can be longer than the read buffer. Nothing is
+ * allocated.
+ *
+ * @param reader The reader to initialize.
+ *
+ * @param fd The file to read from, positioned at the first record.
+ *
+ * @param readBuffer A buffer to read the file into.
+ *
+ * @param readBufferLength The length of the read buffer.
+ *
+ * @param stringBuffer A buffer to use for decoding strings (see ttsdkjson_decoderInit()).
+ *
+ * @param stringBufferLength The length of the string buffer.
+ *
+ * @param callbacks The callbacks to call for each record. onEndData() is
+ *                  called at the end of each record that decodes successfully.
+ *
+ * @param userData Any data you would like passed to the callbacks.
+ */
+void ttsdkjson_beginRecordReader(TTSDKJSONRecordReader *reader, int fd, char *readBuffer, int readBufferLength,
+                                 char *stringBuffer, int stringBufferLength, TTSDKJSONDecodeCallbacks *callbacks,
+                                 void *userData);
+
+/** Decode the next record, skipping blank lines.
+ *
+ * Anything but whitespace after the record's value on the same line makes the
+ * record fail to decode.
+ *
+ * A record that doesn't decode doesn't end the stream: the rest of its line
+ * is skipped, and the next call carries on from the line after it. The
+ * callbacks may already have been called for the part of the record before
+ * the error.
+ *
+ * @param reader The reader.
+ *
+ * @param result Place to store TTSDKJSON_OK if the record was decoded, or
+ *               the error that stopped it.
+ *
+ * @param lineNumber If not NULL, place to store the line that the record is on,
+ *                   counting from 1.
+ *
+ * @return true if a record was read, false if there are no more.
+ */
+bool ttsdkjson_readRecord(TTSDKJSONRecordReader *reader, int *result, int *lineNumber);
+
+/** Convert the string value of a decoded data element back to bytes.
+ *
+ * @param string The string value (hex or base64).
+ *
+ * @param length The length of the string.
+ *
+ * @param encoding The encoding the element was written with.
+ *
+ * @param dst The buffer to write the bytes to.
+ *
+ * @param dstLength In: The size of dst. Out: The number of bytes written.
+ *                  Hex needs length / 2 bytes and base64 needs length / 4 * 3 bytes.
+ *
+ * @return TTSDKJSON_OK if succesful,
+ *         TTSDKJSON_ERROR_INVALID_CHARACTER if the string isn't valid in that encoding,
+ *         TTSDKJSON_ERROR_DATA_TOO_LONG if dst is too small.
+ */
+int ttsdkjson_decodeDataElement(const char *string, int length, TTSDKJSONDataEncoding encoding, char *dst,
+                                int *dstLength);
+
 #ifdef __cplusplus
 }
 #endif
@@ -56,6 +56,12 @@ typedef NS_ENUM(NSInteger, TTSDKJSONDecodeOption) {
 
     /** Return the partially decoded object if an error is encountered */
     TTSDKJSONDecodeOptionKeepPartialObject = 4,
+
+    /** Decode into a TTSDKJSONTape and return immutable dictionaries and
+     * arrays that build their contents on access. The whole document stays
+     * in memory until the last of them is released.
+     */
+    TTSDKJSONDecodeOptionLazy = 8,
 } NS_SWIFT_NAME(JSONDecodeOption);
 
 /**
@@ -90,6 +96,15 @@ typedef NS_ENUM(NSInteger, TTSDKJSONDecodeOption) {
  */
 + (id)decode:(NSData *)JSONData options:(TTSDKJSONDecodeOption)options error:(NSError **)error;
 
+/** Pretty print JSON data without decoding it.
+ *
+ * @param JSONData Well formed UTF-8 JSON data, compact or not.
+ *
+ * @return The pretty printed data, laid out the same way as encode:options:error:
+ *         lays out data with TTSDKJSONEncodeOptionPretty.
+ */
++ (NSData *)prettyPrint:(NSData *)JSONData;
+
 @end
 
 #endif
@@ -0,0 +1,228 @@
+//
+//  TTSDKJSONTape.h
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* A decoded JSON document in one flat array of tagged 64-bit entries, with
+ * its strings in one arena.
+ *
+ * Every value is an entry (numbers take a second entry for their bits), and
+ * an object's members are a key entry followed by the value. A container's
+ * begin entry records where it ends, and its end entry records where its
+ * table of children is, so stepping over a value, indexing an array and
+ * finding a member (by hash, for larger objects) don't depend on the size of
+ * what's being stepped over. The memory belongs to the tape and is kept
+ * between documents, so parsing many documents with one tape settles into
+ * no allocations at all.
+ */
+
+#ifndef HDR_TTSDKJSONTape_h
+#define HDR_TTSDKJSONTape_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "TTSDKJSONCodec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The deepest nesting of containers that a tape accepts. */
+#ifndef TTSDKJSON_TAPE_MAX_DEPTH
+#define TTSDKJSON_TAPE_MAX_DEPTH 200
+#endif
+
+/** The size of the buffer used for unescaping strings while parsing. Strings
+ * without escape sequences can be any length.
+ */
+#ifndef TTSDKJSON_TAPE_STRING_BUFFER_LENGTH
+#define TTSDKJSON_TAPE_STRING_BUFFER_LENGTH 65536
+#endif
+
+/** The position of a value that doesn't exist. */
+#define TTSDKJSON_TAPE_NONE (-1)
+
+typedef enum {
+    TTSDKJSONTapeTypeNone,
+    TTSDKJSONTapeTypeNull,
+    TTSDKJSONTapeTypeBoolean,
+    TTSDKJSONTapeTypeInteger,
+    TTSDKJSONTapeTypeUnsignedInteger,
+    TTSDKJSONTapeTypeFloatingPoint,
+    TTSDKJSONTapeTypeString,
+    TTSDKJSONTapeTypeArray,
+    TTSDKJSONTapeTypeObject,
+} TTSDKJSONTapeType;
+
+typedef enum {
+    TTSDKJSONTapeOptionNone = 0,
+    /** Leave out null elements of arrays. */
+    TTSDKJSONTapeOptionIgnoreNullInArray = 1,
+    /** Leave out members of objects whose value is null. */
+    TTSDKJSONTapeOptionIgnoreNullInObject = 2,
+} TTSDKJSONTapeOption;
+
+/** A decoded document. Everything inside should be considered internal use only. */
+typedef struct {
+    /** The document's entries. */
+    uint64_t *entries;
+    int entryCount;
+    int entryCapacity;
+    /** Null terminated strings and keys. */
+    char *strings;
+    int stringsLength;
+    int stringsCapacity;
+    /** Each container's child positions, followed by a hash table for larger objects. */
+    uint32_t *tables;
+    int tablesLength;
+    int tablesCapacity;
+    /** Child positions of the containers still being parsed. */
+    uint32_t *pending;
+    int pendingLength;
+    int pendingCapacity;
+    /** Buffer for unescaping strings while parsing. */
+    char *stringBuffer;
+    /** Options for the parse in progress. */
+    int options;
+    /** The first error while parsing. */
+    int result;
+    /** Number of containers still being parsed. */
+    int depth;
+    /** For each container being parsed, the position of its begin entry. */
+    int containers[TTSDKJSON_TAPE_MAX_DEPTH];
+    /** For each container being parsed, where its children start in pending. */
+    int pendingStarts[TTSDKJSON_TAPE_MAX_DEPTH];
+} TTSDKJSONTape;
+
+/** Initialize an empty tape.
+ *
+ * @param tape The tape.
+ */
+void ttsdktape_init(TTSDKJSONTape *tape);
+
+/** Free the memory that a tape holds. The tape is left empty and can still be used.
+ *
+ * @param tape The tape.
+ */
+void ttsdktape_free(TTSDKJSONTape *tape);
+
+/** Decode a JSON document into a tape, replacing whatever it held.
+ *
+ * If decoding fails part way, the tape holds what was decoded up to that
+ * point, with any open containers closed.
+ *
+ * @param tape The tape.
+ *
+ * @param data UTF-8 encoded JSON data.
+ *
+ * @param length Length of the data.
+ *
+ * @param filter If not NULL, only the parts of the document that it selects
+ *               are decoded (see ttsdkjson_decodeFiltered()).
+ *
+ * @param options A combination of TTSDKJSONTapeOption values.
+ *
+ * @param errorOffset If not null, will contain the offset into the data
+ *                    where the error (if any) occurred.
+ *
+ * @return TTSDKJSON_OK if successful, TTSDKJSON_ERROR_CANNOT_ADD_DATA if
+ *         memory ran out, or a decoding error.
+ */
+int ttsdktape_parse(TTSDKJSONTape *tape, const char *data, int length, const TTSDKJSONPathFilter *filter, int options,
+                    int *errorOffset);
+
+/** Get the position of the top-level value.
+ *
+ * @return The position, or TTSDKJSON_TAPE_NONE if the tape is empty.
+ */
+int ttsdktape_root(const TTSDKJSONTape *tape);
+
+/** Get the type of a value.
+ *
+ * @param value The value's position (TTSDKJSON_TAPE_NONE gives TTSDKJSONTapeTypeNone).
+ */
+TTSDKJSONTapeType ttsdktape_type(const TTSDKJSONTape *tape, int value);
+
+/** Get the position just past a value, which is its next sibling (or in an
+ * object, its next sibling's key) or the end of its container.
+ */
+int ttsdktape_next(const TTSDKJSONTape *tape, int value);
+
+/** Get the number of elements or members in a container (0 for other values). */
+int ttsdktape_count(const TTSDKJSONTape *tape, int container);
+
+/** Get an element of an array.
+ *
+ * @return The element's position, or TTSDKJSON_TAPE_NONE if there's no such element.
+ */
+int ttsdktape_element(const TTSDKJSONTape *tape, int array, int index);
+
+/** Get a member of an object by position.
+ *
+ * @param key If not NULL, place to store the member's null terminated key.
+ *
+ * @param keyLength If not NULL, place to store the length of the key.
+ *
+ * @return The member's value, or TTSDKJSON_TAPE_NONE if there's no such member.
+ */
+int ttsdktape_memberAt(const TTSDKJSONTape *tape, int object, int index, const char **key, int *keyLength);
+
+/** Get a member of an object by key. If the key appears more than once, the
+ * last one is found.
+ *
+ * @return The member's value, or TTSDKJSON_TAPE_NONE if there's no such member.
+ */
+int ttsdktape_member(const TTSDKJSONTape *tape, int object, const char *key, int keyLength);
+
+/** Get a boolean (false for other values). */
+bool ttsdktape_boolean(const TTSDKJSONTape *tape, int value);
+
+/** Get a number as a signed integer, converting it if needed (0 for other values).
+ * Floating point values beyond the range saturate to INT64_MIN or INT64_MAX.
+ */
+int64_t ttsdktape_integer(const TTSDKJSONTape *tape, int value);
+
+/** Get a number as an unsigned integer, converting it if needed (0 for other values).
+ * Floating point values beyond the range saturate to 0 or UINT64_MAX.
+ */
+uint64_t ttsdktape_unsignedInteger(const TTSDKJSONTape *tape, int value);
+
+/** Get a number as a double, converting it if needed (0 for other values). */
+double ttsdktape_floatingPoint(const TTSDKJSONTape *tape, int value);
+
+/** Get a string.
+ *
+ * @param length If not NULL, place to store the string's length.
+ *
+ * @return The null terminated string, which lives as long as the tape's
+ *         contents, or NULL if the value isn't a string.
+ */
+const char *ttsdktape_string(const TTSDKJSONTape *tape, int value, int *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HDR_TTSDKJSONTape_h
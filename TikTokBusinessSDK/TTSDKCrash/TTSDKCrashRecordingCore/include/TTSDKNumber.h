@@ -0,0 +1,124 @@
+//
+//  TTSDKNumber.h
+//
+//  Created by TikTok on 2026-10-16.
+//
+//  Copyright (c) 2026 TikTok. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Async-signal-safe number formatting and parsing.
+ *
+ * These functions don't allocate, lock or consult the locale, so they can be
+ * used while writing a crash report.
+ */
+
+#ifndef HDR_TTSDKNumber_h
+#define HDR_TTSDKNumber_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Buffer size that is large enough for any formatted 64-bit integer, including the terminator. */
+#define TTSDKNUM_INTEGER_BUFFER_SIZE 21
+
+/** Buffer size that is large enough for any formatted double, including the terminator. */
+#define TTSDKNUM_DOUBLE_BUFFER_SIZE 32
+
+/** Format an unsigned integer in decimal. Output is the same as printf("%llu").
+ *
+ * @param value The value to format.
+ *
+ * @param dst Buffer of at least TTSDKNUM_INTEGER_BUFFER_SIZE bytes.
+ *
+ * @return The number of characters written, not counting the null terminator.
+ */
+int ttsdknum_formatUInt64(uint64_t value, char *dst);
+
+/** Format a signed integer in decimal. Output is the same as printf("%lld").
+ *
+ * @param value The value to format.
+ *
+ * @param dst Buffer of at least TTSDKNUM_INTEGER_BUFFER_SIZE bytes.
+ *
+ * @return The number of characters written, not counting the null terminator.
+ */
+int ttsdknum_formatInt64(int64_t value, char *dst);
+
+/** Format a finite double using the fewest digits that still parse back to
+ * exactly the same value (Grisu2).
+ *
+ * Values with a decimal exponent from -4 to 14 are written in fixed notation
+ * (with a trailing ".0" if integral), others as "1.2345e+20".
+ *
+ * @param value The value to format. Must not be NaN or infinite.
+ *
+ * @param dst Buffer of at least TTSDKNUM_DOUBLE_BUFFER_SIZE bytes.
+ *
+ * @return The number of characters written, not counting the null terminator.
+ */
+int ttsdknum_formatDouble(double value, char *dst);
+
+/** The kind of value that ttsdknum_parse() found. */
+typedef enum {
+    /** An integer that fits in an int64_t. */
+    TTSDKNumberTypeInt64,
+    /** A positive integer that only fits in a uint64_t. */
+    TTSDKNumberTypeUInt64,
+    /** A number with a fraction or exponent, or an integer too large for either. */
+    TTSDKNumberTypeDouble,
+} TTSDKNumberType;
+
+typedef struct {
+    TTSDKNumberType type;
+    union {
+        int64_t int64Value;
+        uint64_t uint64Value;
+        double doubleValue;
+    };
+} TTSDKNumber;
+
+/** Parse a decimal number: an optional '-', digits, then an optional
+ * fraction and exponent.
+ *
+ * Parsing stops at the first character that can't continue the number, the
+ * way strtod() does, so "1e" is the integer 1, ending at the 'e'. Doubles are
+ * correctly rounded, giving the same result as strtod() in the "C" locale.
+ * Numbers with more digits than a double needs are rounded using all of them,
+ * up to the 768th significant digit.
+ *
+ * @param src The text to parse.
+ *
+ * @param end The end of the text.
+ *
+ * @param number Receives the value.
+ *
+ * @return The end of the number, or NULL if the text doesn't start with a number.
+ */
+const char *ttsdknum_parse(const char *src, const char *end, TTSDKNumber *number);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HDR_TTSDKNumber_h
@@ -0,0 +1,213 @@
+//
+//  TTSDKCrashReportLogTests.m
+//  TikTokBusinessSDKTests
+//
+//  Created by TikTok on 2026/10/16.
+//  Copyright © 2026 TikTok. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TTSDKCrashReportLog.h"
+
+@interface TTSDKCrashReportLogTests : XCTestCase
+@property (nonatomic, copy) NSString *directory;
+@end
+
+@implementation TTSDKCrashReportLogTests {
+    TTSDKCrashReportLog _log;
+}
+
+- (void)setUp {
+    [super setUp];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+    XCTAssertTrue(ttsdkcrl_open(&_log, self.directory.fileSystemRepresentation, "App"));
+}
+
+- (void)tearDown {
+    ttsdkcrl_close(&_log);
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+/** Close the log and open it again from its segments, as the next launch would. */
+- (void)reopen {
+    ttsdkcrl_close(&_log);
+    XCTAssertTrue(ttsdkcrl_open(&_log, self.directory.fileSystemRepresentation, "App"));
+}
+
+- (NSArray<NSString *> *)segments {
+    NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil];
+    return [files sortedArrayUsingSelector:@selector(compare:)];
+}
+
+- (NSString *)segmentPath:(NSUInteger)index {
+    return [self.directory stringByAppendingPathComponent:self.segments[index]];
+}
+
+- (void)append:(int64_t)reportID report:(NSString *)report fixed:(BOOL)isFixed {
+    XCTAssertTrue(ttsdkcrl_appendReport(&_log, reportID, report.UTF8String, (int)strlen(report.UTF8String), isFixed));
+}
+
+- (NSString *)read:(int64_t)reportID {
+    const TTSDKCrashReportLogEntry *entry = ttsdkcrl_findEntry(&_log, reportID);
+    if (entry == NULL) {
+        return nil;
+    }
+    char *report = ttsdkcrl_readReport(&_log, entry);
+    if (report == NULL) {
+        return nil;
+    }
+    NSString *string = @(report);
+    free(report);
+    return string;
+}
+
+/** The log's reports, by ID. */
+- (NSDictionary<NSNumber *, NSString *> *)reports {
+    NSMutableDictionary *reports = [NSMutableDictionary dictionary];
+    for (int i = 0; i < _log.count; i++) {
+        const int64_t reportID = _log.entries[i].reportID;
+        reports[@(reportID)] = [self read:reportID] ?: [NSNull null];
+    }
+    return reports;
+}
+
+- (void)testReopeningReplaysRecords {
+    [self append:1 report:@"{\"a\":1}" fixed:NO];
+    [self append:2 report:@"{\"b\":2}" fixed:YES];
+    [self append:3 report:@"{\"c\":3}" fixed:NO];
+    XCTAssertTrue(ttsdkcrl_deleteReport(&_log, 1));
+    XCTAssertFalse(ttsdkcrl_deleteReport(&_log, 1));
+    [self append:3 report:@"{\"c\":33}" fixed:YES];
+    NSDictionary *expected = @{ @2 : @"{\"b\":2}", @3 : @"{\"c\":33}" };
+    XCTAssertEqualObjects([self reports], expected);
+    const int64_t deadSize = _log.segments[0].deadSize;
+    XCTAssertGreaterThan(deadSize, 0);
+
+    [self reopen];
+    XCTAssertEqualObjects([self reports], expected);
+    XCTAssertTrue(ttsdkcrl_findEntry(&_log, 1) == NULL);
+    XCTAssertTrue(ttsdkcrl_findEntry(&_log, 2)->isFixed);
+    XCTAssertTrue(ttsdkcrl_findEntry(&_log, 3)->isFixed);
+    XCTAssertEqual(_log.segmentCount, 1);
+    XCTAssertEqual(_log.segments[0].deadSize, deadSize);
+}
+
+- (void)testTornRecordIsCutOff {
+    [self append:1 report:@"{\"a\":1}" fixed:NO];
+    const int64_t goodSize = _log.segments[0].size;
+    [self append:2 report:@"{\"b\":2}" fixed:NO];
+    ttsdkcrl_close(&_log);
+    // The app died part way through writing the second record.
+    XCTAssertEqual(truncate([self segmentPath:0].fileSystemRepresentation, (off_t)goodSize + 10), 0);
+
+    [self reopen];
+    XCTAssertEqualObjects([self reports], @{ @1 : @"{\"a\":1}" });
+    XCTAssertEqual(_log.segments[0].size, goodSize);
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[self segmentPath:0] error:nil];
+    XCTAssertEqual(attributes.fileSize, (unsigned long long)goodSize);
+
+    // Records appended after the cut are read back.
+    [self append:3 report:@"{\"c\":3}" fixed:NO];
+    [self reopen];
+    XCTAssertEqualObjects([self reports], (@{ @1 : @"{\"a\":1}", @3 : @"{\"c\":3}" }));
+
+    // So is a record whose report doesn't match its checksum.
+    ttsdkcrl_close(&_log);
+    NSFileHandle *file = [NSFileHandle fileHandleForUpdatingAtPath:[self segmentPath:0]];
+    [file seekToFileOffset:file.seekToEndOfFile - 2];
+    [file writeData:[@"!" dataUsingEncoding:NSUTF8StringEncoding]];
+    [file closeFile];
+    [self reopen];
+    XCTAssertEqualObjects([self reports], @{ @1 : @"{\"a\":1}" });
+    XCTAssertEqual(_log.segments[0].size, goodSize);
+}
+
+- (void)testCompactionKeepsChangesMadeMeanwhile {
+    for (int64_t reportID = 1; reportID <= 4; reportID++) {
+        [self append:reportID report:[NSString stringWithFormat:@"{\"id\":%lld}", reportID] fixed:NO];
+    }
+    XCTAssertTrue(ttsdkcrl_deleteReport(&_log, 1));
+    NSArray *oldSegments = [self segments];
+
+    TTSDKCrashReportLogCompaction compaction;
+    XCTAssertTrue(ttsdkcrl_beginCompaction(&_log, &compaction));
+    [self append:2 report:@"{\"id\":22}" fixed:YES];
+    [self append:5 report:@"{\"id\":5}" fixed:NO];
+    XCTAssertTrue(ttsdkcrl_copyCompaction(&compaction));
+    XCTAssertTrue(ttsdkcrl_deleteReport(&_log, 3));
+    [self append:6 report:@"{\"id\":6}" fixed:NO];
+    XCTAssertTrue(ttsdkcrl_endCompaction(&_log, &compaction));
+
+    NSDictionary *expected =
+        @{ @2 : @"{\"id\":22}", @4 : @"{\"id\":4}", @5 : @"{\"id\":5}", @6 : @"{\"id\":6}" };
+    XCTAssertEqualObjects([self reports], expected);
+    for (NSString *segment in oldSegments) {
+        XCTAssertFalse([[self segments] containsObject:segment], @"%@ wasn't removed", segment);
+    }
+    XCTAssertTrue(ttsdkcrl_findEntry(&_log, 2)->isFixed);
+
+    [self reopen];
+    XCTAssertEqualObjects([self reports], expected);
+    XCTAssertTrue(ttsdkcrl_findEntry(&_log, 2)->isFixed);
+
+    // The copies of the reports that changed meanwhile are dead, so compacting again leaves only live reports.
+    XCTAssertTrue(ttsdkcrl_compact(&_log));
+    int64_t deadSize = 0;
+    for (int i = 0; i < _log.segmentCount; i++) {
+        deadSize += _log.segments[i].deadSize;
+    }
+    XCTAssertEqual(deadSize, 0);
+    [self reopen];
+    XCTAssertEqualObjects([self reports], expected);
+}
+
+- (void)testCompactionAbandonedAfterCopyingIsReplayed {
+    for (int64_t reportID = 1; reportID <= 3; reportID++) {
+        [self append:reportID report:[NSString stringWithFormat:@"{\"id\":%lld}", reportID] fixed:NO];
+    }
+    XCTAssertTrue(ttsdkcrl_deleteReport(&_log, 1));
+
+    TTSDKCrashReportLogCompaction compaction;
+    XCTAssertTrue(ttsdkcrl_beginCompaction(&_log, &compaction));
+    XCTAssertTrue(ttsdkcrl_deleteReport(&_log, 2));
+    XCTAssertTrue(ttsdkcrl_copyCompaction(&compaction));
+    [self append:3 report:@"{\"id\":33}" fixed:NO];
+    // The app dies before the compaction ends, leaving both the old segments and the copies.
+    ttsdkcrl_close(&compaction.snapshot);
+    ttsdkcrl_close(&compaction.compacted);
+
+    [self reopen];
+    NSDictionary *expected = @{ @3 : @"{\"id\":33}" };
+    XCTAssertEqualObjects([self reports], expected);
+    XCTAssertTrue(ttsdkcrl_compact(&_log));
+    XCTAssertEqualObjects([self reports], expected);
+    [self reopen];
+    XCTAssertEqualObjects([self reports], expected);
+}
+
+- (void)testFailedCompactionRemovesCopies {
+    [self append:1 report:@"{\"id\":1}" fixed:NO];
+    [self append:2 report:@"{\"id\":2}" fixed:NO];
+    XCTAssertTrue(ttsdkcrl_deleteReport(&_log, 1));
+    NSArray *oldSegments = [self segments];
+
+    TTSDKCrashReportLogCompaction compaction;
+    XCTAssertTrue(ttsdkcrl_beginCompaction(&_log, &compaction));
+    XCTAssertTrue(ttsdkcrl_copyCompaction(&compaction));
+    // As if the copies couldn't be synced to disk.
+    compaction.isCopied = false;
+    XCTAssertFalse(ttsdkcrl_endCompaction(&_log, &compaction));
+
+    XCTAssertEqualObjects([self segments], oldSegments);
+    XCTAssertEqualObjects([self reports], @{ @2 : @"{\"id\":2}" });
+    [self append:3 report:@"{\"id\":3}" fixed:NO];
+    [self reopen];
+    XCTAssertEqualObjects([self reports], (@{ @2 : @"{\"id\":2}", @3 : @"{\"id\":3}" }));
+}
+
+@end
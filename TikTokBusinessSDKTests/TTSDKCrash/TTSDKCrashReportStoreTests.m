@@ -0,0 +1,205 @@
+//
+//  TTSDKCrashReportStoreTests.m
+//  TikTokBusinessSDKTests
+//
+//  Created by TikTok on 2026/10/16.
+//  Copyright © 2026 TikTok. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TTSDKCrashReportStoreC.h"
+
+@interface TTSDKCrashReportStoreTests : XCTestCase
+@property (nonatomic, copy) NSString *directory;
+@end
+
+@implementation TTSDKCrashReportStoreTests {
+    TTSDKCrashReportStoreCConfiguration _config;
+    char _reportsPath[PATH_MAX];
+}
+
+- (void)setUp {
+    [super setUp];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    strlcpy(_reportsPath, self.directory.fileSystemRepresentation, sizeof(_reportsPath));
+    _config = (TTSDKCrashReportStoreCConfiguration) {
+        .appName = "App",
+        .reportsPath = _reportsPath,
+        .maxReportCount = 5,
+    };
+    XCTAssertEqual(ttsdkcrs_initialize(&_config), TTSDKCrashInstallErrorNone);
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (NSString *)manifestPath {
+    return [self.directory stringByAppendingPathComponent:@"App-reports.manifest"];
+}
+
+- (NSArray<NSString *> *)files {
+    NSMutableArray *files =
+        [[[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil] mutableCopy];
+    [files removeObject:self.manifestPath.lastPathComponent];
+    return [files sortedArrayUsingSelector:@selector(compare:)];
+}
+
+- (NSString *)fileNameForID:(int64_t)reportID extension:(NSString *)extension {
+    return [NSString stringWithFormat:@"App-report-%016llx%@", reportID, extension];
+}
+
+- (int64_t)addReport {
+    const char *report = "{\"report\":{\"timestamp\":1700000000,\"version\":\"3.2.0\"},\"crash\":{\"error\":{}}}";
+    return ttsdkcrs_addUserReport(report, (int)strlen(report), &_config);
+}
+
+- (NSString *)readReport:(int64_t)reportID {
+    char *report = ttsdkcrs_readReport(reportID, &_config);
+    if (report == NULL) {
+        return nil;
+    }
+    NSString *string = @(report);
+    free(report);
+    return string;
+}
+
+- (void)testReadKeepsFixedUpReport {
+    int64_t reportID = [self addReport];
+    NSString *report = [self readReport:reportID];
+    XCTAssertTrue([report containsString:@"\"timestamp\":\"2023-11-14T22:13:20Z\""]);
+    XCTAssertEqualObjects([self files], @[ [self fileNameForID:reportID extension:@".fixed.json"] ]);
+
+    NSString *fixedPath = [self.directory stringByAppendingPathComponent:[self fileNameForID:reportID
+                                                                                  extension:@".fixed.json"]];
+    NSString *fixedReport = [NSString stringWithContentsOfFile:fixedPath encoding:NSUTF8StringEncoding error:nil];
+    XCTAssertEqualObjects(fixedReport, report);
+    XCTAssertEqualObjects([self readReport:reportID], report);
+    XCTAssertEqual(ttsdkcrs_getReportCount(&_config), 1);
+}
+
+- (void)testFixedUpReportStaysCompressed {
+    _config.compressReports = true;
+    int64_t reportID = [self addReport];
+    NSString *report = [self readReport:reportID];
+    XCTAssertNotNil(report);
+    XCTAssertEqualObjects([self files], @[ [self fileNameForID:reportID extension:@".fixed.json.gz"] ]);
+    XCTAssertEqualObjects([self readReport:reportID], report);
+}
+
+- (void)testLeftoverRawReportIsListedOnce {
+    int64_t reportID = [self addReport];
+    NSString *report = [self readReport:reportID];
+    // As if the app died between keeping the fixed up report and removing the raw one.
+    NSString *rawPath = [self.directory stringByAppendingPathComponent:[self fileNameForID:reportID
+                                                                                extension:@".json"]];
+    [@"{}" writeToFile:rawPath atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+    int64_t reportIDs[4];
+    XCTAssertEqual(ttsdkcrs_getReportIDs(reportIDs, 4, &_config), 1);
+    XCTAssertEqual(reportIDs[0], reportID);
+    XCTAssertEqualObjects([self readReport:reportID], report);
+
+    ttsdkcrs_deleteReportWithID(reportID, &_config);
+    XCTAssertEqualObjects([self files], @[]);
+}
+
+- (void)testReadAtPathLeavesFileAlone {
+    NSString *path = [self.directory stringByAppendingPathComponent:@"breadcrumb.json"];
+    [@"{\"report\":{\"timestamp\":1700000000,\"version\":\"3.2.0\"}}" writeToFile:path
+                                                                      atomically:YES
+                                                                        encoding:NSUTF8StringEncoding
+                                                                           error:nil];
+    char *report = ttsdkcrs_readReportAtPath(path.fileSystemRepresentation);
+    XCTAssertTrue(report != NULL && strstr(report, "2023-11-14T22:13:20Z") != NULL);
+    free(report);
+    XCTAssertEqualObjects([self files], @[ @"breadcrumb.json" ]);
+}
+
+- (void)testPartlyInvalidCBORReportIsKept {
+    // {"report":{"timestamp":1700000000},"a":<an item with a reserved head>}
+    const uint8_t cbor[] = { 0xd9, 0xd9, 0xf7, 0xbf, 0x66, 'r',  'e',  'p',  'o',  'r',  't',  0xbf, 0x69, 't', 'i', 'm',
+                             'e',  's',  't',  'a',  'm',  'p',  0x1a, 0x65, 0x53, 0xf1, 0x00, 0xff, 0x61, 'a', 0x1c };
+    NSString *path = [self.directory stringByAppendingPathComponent:@"cbor.json"];
+    [[NSData dataWithBytes:cbor length:sizeof(cbor)] writeToFile:path atomically:YES];
+    char *report = ttsdkcrs_readReportAtPath(path.fileSystemRepresentation);
+    XCTAssertTrue(report != NULL && strcmp(report, "{\"report\":{\"timestamp\":\"2023-11-14T22:13:20Z\"}}") == 0);
+    free(report);
+}
+
+- (void)testReadFixesOnlyReportTimestamps {
+    NSString *path = [self.directory stringByAppendingPathComponent:@"recrash.json"];
+    [@"{\"recrash_report\":{\"x\":{\"report\":{\"timestamp\":1}},\"report\":{\"timestamp\":1700000000}},"
+     @"\"report\":[{\"timestamp\":1700000000}]}" writeToFile:path
+                                                   atomically:YES
+                                                     encoding:NSUTF8StringEncoding
+                                                        error:nil];
+    char *report = ttsdkcrs_readReportAtPath(path.fileSystemRepresentation);
+    XCTAssertTrue(report != NULL);
+    NSString *string = report != NULL ? @(report) : nil;
+    free(report);
+    XCTAssertTrue([string containsString:@"\"timestamp\":\"2023-11-14T22:13:20Z\""]);
+    XCTAssertTrue([string containsString:@"\"timestamp\":1}"]);
+    XCTAssertTrue([string containsString:@"\"timestamp\":1700000000}"]);
+}
+
+- (void)testReportWrittenOutsideStoreIsCounted {
+    int64_t reportID = [self addReport];
+    XCTAssertEqual(ttsdkcrs_getReportCount(&_config), 1);
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:self.manifestPath]);
+
+    // As if the crash handler wrote it.
+    NSString *crashPath = [self.directory stringByAppendingPathComponent:[self fileNameForID:reportID + 1
+                                                                                  extension:@".json"]];
+    [@"{}" writeToFile:crashPath atomically:NO encoding:NSUTF8StringEncoding error:nil];
+    int64_t reportIDs[4];
+    XCTAssertEqual(ttsdkcrs_getReportIDs(reportIDs, 4, &_config), 2);
+    XCTAssertEqual(reportIDs[0], reportID);
+    XCTAssertEqual(reportIDs[1], reportID + 1);
+
+    ttsdkcrs_deleteReportWithID(reportID, &_config);
+    XCTAssertEqual(ttsdkcrs_getReportCount(&_config), 1);
+}
+
+- (void)testCorruptManifestIsRebuilt {
+    for (int i = 0; i < 7; i++) {
+        [self addReport];
+    }
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:self.manifestPath];
+    [handle seekToFileOffset:48];
+    [handle writeData:[@"garbage" dataUsingEncoding:NSUTF8StringEncoding]];
+    [handle closeFile];
+
+    // Reads the manifest again, and prunes down to maxReportCount.
+    XCTAssertEqual(ttsdkcrs_initialize(&_config), TTSDKCrashInstallErrorNone);
+    XCTAssertEqual(ttsdkcrs_getReportCount(&_config), 5);
+    XCTAssertEqual([self files].count, 5);
+}
+
+- (void)testUserReportsShareLogSegment {
+    _config.logUserReports = true;
+    int64_t reportIDs[3];
+    for (int i = 0; i < 3; i++) {
+        reportIDs[i] = [self addReport];
+    }
+    XCTAssertEqualObjects([self files], @[ @"App-log-00000000.seg" ]);
+    XCTAssertEqual(ttsdkcrs_getReportCount(&_config), 3);
+    NSString *report = [self readReport:reportIDs[1]];
+    XCTAssertTrue([report containsString:@"\"timestamp\":\"2023-11-14T22:13:20Z\""]);
+    XCTAssertEqualObjects([self readReport:reportIDs[1]], report);
+
+    for (int i = 0; i < 3; i++) {
+        ttsdkcrs_deleteReportWithID(reportIDs[i], &_config);
+    }
+    XCTAssertEqual(ttsdkcrs_getReportCount(&_config), 0);
+    XCTAssertNil([self readReport:reportIDs[1]]);
+    // The emptied log is removed on a background thread.
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    while ([self files].count > 0 && [deadline timeIntervalSinceNow] > 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+    XCTAssertEqualObjects([self files], @[]);
+}
+
+@end
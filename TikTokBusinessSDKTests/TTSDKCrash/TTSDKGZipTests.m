@@ -0,0 +1,113 @@
+//
+//  TTSDKGZipTests.m
+//  TikTokBusinessSDKTests
+//
+//  Created by TikTok on 2026/10/16.
+//  Copyright © 2026 TikTok. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TTSDKGZip.h"
+
+@interface TTSDKGZipTests : XCTestCase
+@property (nonatomic, copy) NSString *directory;
+@end
+
+@implementation TTSDKGZipTests
+
+- (void)setUp {
+    [super setUp];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (NSString *)pathFor:(NSString *)name {
+    return [self.directory stringByAppendingPathComponent:name];
+}
+
+- (NSData *)sampleReport {
+    NSMutableString *report = [NSMutableString stringWithString:@"{\"report\":{\"threads\":["];
+    for (int i = 0; i < 2000; i++) {
+        [report appendFormat:@"%@{\"index\":%d,\"address\":%u,\"name\":\"frame %d\"}", i == 0 ? @"" : @",", i,
+                             (unsigned)(i * 2654435761u), i % 37];
+    }
+    [report appendString:@"]}}"];
+    return [report dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+/** Write data in small pieces, the way the report writer does, flushing every so often. */
+- (void)writeCompressed:(NSData *)data toPath:(NSString *)path arena:(TTSDKGZipArena *)arena finish:(BOOL)finish {
+    char buffer[1024];
+    TTSDKBufferedWriter output;
+    TTSDKGZipWriter writer;
+    XCTAssertTrue(ttsdkfu_openBufferedWriter(&output, path.UTF8String, buffer, sizeof(buffer)));
+    XCTAssertTrue(ttsdkgz_openWriter(&writer, &output, arena));
+    const char *bytes = data.bytes;
+    int length = (int)data.length;
+    for (int offset = 0; offset < length; offset += 100) {
+        int chunk = MIN(100, length - offset);
+        XCTAssertTrue(ttsdkgz_write(&writer, bytes + offset, chunk));
+        if (offset % 10000 == 0) {
+            XCTAssertTrue(ttsdkgz_flush(&writer));
+        }
+    }
+    if (finish) {
+        XCTAssertTrue(ttsdkgz_closeWriter(&writer));
+    } else {
+        XCTAssertTrue(ttsdkgz_flush(&writer));
+    }
+    ttsdkfu_closeBufferedWriter(&output);
+}
+
+- (void)testRoundTrip {
+    NSData *report = [self sampleReport];
+    NSString *path = [self pathFor:@"report.json.gz"];
+    NSMutableData *memory = [NSMutableData dataWithLength:TTSDKGZ_DEFLATE_MEMORY_SIZE + 16];
+    TTSDKGZipArena arena;
+    ttsdkgz_initArena(&arena, memory.mutableBytes, (int)memory.length);
+    [self writeCompressed:report toPath:path arena:&arena finish:YES];
+
+    XCTAssertTrue(ttsdkgz_isGZipFile(path.UTF8String));
+    NSData *compressed = [NSData dataWithContentsOfFile:path];
+    XCTAssertLessThan(compressed.length, report.length / 2);
+
+    char *data = NULL;
+    int length = 0;
+    XCTAssertTrue(ttsdkgz_readEntireFile(path.UTF8String, &data, &length, 100000000));
+    XCTAssertEqualObjects([NSData dataWithBytes:data length:(NSUInteger)length], report);
+    free(data);
+
+    NSString *inflatedPath = [self pathFor:@"report.json"];
+    NSMutableData *inflateMemory = [NSMutableData dataWithLength:TTSDKGZ_INFLATE_MEMORY_SIZE + 16];
+    ttsdkgz_initArena(&arena, inflateMemory.mutableBytes, (int)inflateMemory.length);
+    XCTAssertTrue(ttsdkgz_inflateFile(path.UTF8String, inflatedPath.UTF8String, &arena));
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:inflatedPath], report);
+}
+
+- (void)testUnfinishedStreamIsReadable {
+    NSData *report = [self sampleReport];
+    NSString *path = [self pathFor:@"report.json.gz"];
+    [self writeCompressed:report toPath:path arena:NULL finish:NO];
+
+    char *data = NULL;
+    int length = 0;
+    XCTAssertTrue(ttsdkgz_readEntireFile(path.UTF8String, &data, &length, 100000000));
+    XCTAssertEqualObjects([NSData dataWithBytes:data length:(NSUInteger)length], report);
+    free(data);
+}
+
+- (void)testNotGZip {
+    XCTAssertFalse(ttsdkgz_isGZip("{}", 2));
+    XCTAssertFalse(ttsdkgz_isGZip("\x1f", 1));
+    XCTAssertTrue(ttsdkgz_isGZip("\x1f\x8b\x08", 3));
+}
+
+@end
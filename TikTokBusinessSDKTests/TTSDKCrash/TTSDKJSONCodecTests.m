@@ -0,0 +1,1314 @@
+//
+//  TTSDKJSONCodecTests.m
+//  TikTokBusinessSDKTests
+//
+//  Created by TikTok on 2026/10/16.
+//  Copyright © 2026 TikTok. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <fcntl.h>
+#import "TTSDKCBORCodec.h"
+#import "TTSDKJSONCodec.h"
+#import "TTSDKJSONCodecObjC.h"
+
+typedef struct {
+    char *buffer;
+    int length;
+    int capacity;
+    int callCount;
+} TestSink;
+
+static int addToTestSink(const char *data, int length, void *userData)
+{
+    TestSink *sink = (TestSink *)userData;
+    if (sink->length + length > sink->capacity) {
+        return TTSDKJSON_ERROR_CANNOT_ADD_DATA;
+    }
+    memcpy(sink->buffer + sink->length, data, (size_t)length);
+    sink->length += length;
+    sink->callCount++;
+    return TTSDKJSON_OK;
+}
+
+static int reencode_onBooleanElement(const char *name, bool value, void *userData)
+{
+    return ttsdkjson_addBooleanElement((TTSDKJSONEncodeContext *)userData, name, value);
+}
+
+static int reencode_onFloatingPointElement(const char *name, double value, void *userData)
+{
+    return ttsdkjson_addFloatingPointElement((TTSDKJSONEncodeContext *)userData, name, value);
+}
+
+static int reencode_onIntegerElement(const char *name, int64_t value, void *userData)
+{
+    return ttsdkjson_addIntegerElement((TTSDKJSONEncodeContext *)userData, name, value);
+}
+
+static int reencode_onUnsignedIntegerElement(const char *name, uint64_t value, void *userData)
+{
+    return ttsdkjson_addUIntegerElement((TTSDKJSONEncodeContext *)userData, name, value);
+}
+
+static int reencode_onNullElement(const char *name, void *userData)
+{
+    return ttsdkjson_addNullElement((TTSDKJSONEncodeContext *)userData, name);
+}
+
+static int reencode_onStringElement(const char *name, const char *value, void *userData)
+{
+    return ttsdkjson_addStringElement((TTSDKJSONEncodeContext *)userData, name, value, TTSDKJSON_SIZE_AUTOMATIC);
+}
+
+static int reencode_onStringElementPart(const char *name, const char *value, int valueLength, bool isFirstPart,
+                                       bool isLastPart, void *userData)
+{
+    TTSDKJSONEncodeContext *context = (TTSDKJSONEncodeContext *)userData;
+    int result = TTSDKJSON_OK;
+    if (isFirstPart) {
+        result = ttsdkjson_beginStringElement(context, name);
+    }
+    if (result == TTSDKJSON_OK) {
+        result = ttsdkjson_appendStringElement(context, value, valueLength);
+    }
+    if (result == TTSDKJSON_OK && isLastPart) {
+        result = ttsdkjson_endStringElement(context);
+    }
+    return result;
+}
+
+static int reencode_onBeginObject(const char *name, void *userData)
+{
+    return ttsdkjson_beginObject((TTSDKJSONEncodeContext *)userData, name);
+}
+
+static int reencode_onBeginArray(const char *name, void *userData)
+{
+    return ttsdkjson_beginArray((TTSDKJSONEncodeContext *)userData, name);
+}
+
+static int reencode_onEndContainer(void *userData) { return ttsdkjson_endContainer((TTSDKJSONEncodeContext *)userData); }
+
+static int reencode_onEndData(void *userData) { return ttsdkjson_endEncode((TTSDKJSONEncodeContext *)userData); }
+
+static TTSDKJSONDecodeCallbacks g_reencodeCallbacks = {
+    .onBooleanElement = reencode_onBooleanElement,
+    .onFloatingPointElement = reencode_onFloatingPointElement,
+    .onIntegerElement = reencode_onIntegerElement,
+    .onUnsignedIntegerElement = reencode_onUnsignedIntegerElement,
+    .onNullElement = reencode_onNullElement,
+    .onStringElement = reencode_onStringElement,
+    .onBeginObject = reencode_onBeginObject,
+    .onBeginArray = reencode_onBeginArray,
+    .onEndContainer = reencode_onEndContainer,
+    .onEndData = reencode_onEndData,
+};
+
+typedef struct {
+    const TTSDKJSONKeyDictionary *dictionary;
+    /** The key ID that each integer element's name had, indexed by the element's value. */
+    int keyIDs[8];
+} KeyIDRecorder;
+
+static int recordKeyID_onIntegerElement(const char *name, int64_t value, void *userData)
+{
+    KeyIDRecorder *recorder = (KeyIDRecorder *)userData;
+    recorder->keyIDs[value] = ttsdkjson_keyID(recorder->dictionary, name);
+    return TTSDKJSON_OK;
+}
+
+static int recordKeyID_onName(__unused const char *name, __unused void *userData) { return TTSDKJSON_OK; }
+
+static int recordKeyID_onEnd(__unused void *userData) { return TTSDKJSON_OK; }
+
+typedef struct {
+    int64_t ids[2000];
+    int idCount;
+    int documentCount;
+} ElementRecorder;
+
+static int recordElement_onIntegerElement(const char *name, int64_t value, void *userData)
+{
+    ElementRecorder *recorder = (ElementRecorder *)userData;
+    if (name != NULL && strcmp(name, "id") == 0) {
+        recorder->ids[recorder->idCount++] = value;
+    }
+    return TTSDKJSON_OK;
+}
+
+static int recordElement_onOther(__unused const char *name, __unused void *userData) { return TTSDKJSON_OK; }
+
+static int recordElement_onString(__unused const char *name, __unused const char *value, __unused void *userData)
+{
+    return TTSDKJSON_OK;
+}
+
+static int recordElement_onEndContainer(__unused void *userData) { return TTSDKJSON_OK; }
+
+static int recordElement_onEndData(void *userData)
+{
+    ((ElementRecorder *)userData)->documentCount++;
+    return TTSDKJSON_OK;
+}
+
+/** A key token and its length, for the ttsdkjson_*Literal() functions. */
+#define testKey(NAME) TTSDKJSON_KEY_LITERAL(NAME), (int)sizeof(TTSDKJSON_KEY_LITERAL(NAME)) - 1
+
+@interface TTSDKJSONCodecTests : XCTestCase
+
+@property (nonatomic, strong) NSMutableData *output;
+@property (nonatomic, assign) TestSink sink;
+
+@end
+
+@implementation TTSDKJSONCodecTests
+
+- (void)setUp {
+    [super setUp];
+    self.output = [NSMutableData dataWithLength:16 * 1024 * 1024];
+    _sink = (TestSink){ .buffer = self.output.mutableBytes, .length = 0, .capacity = (int)self.output.length };
+}
+
+- (void)tearDown {
+    self.output = nil;
+    [super tearDown];
+}
+
+- (NSString *)encodedString {
+    return [[NSString alloc] initWithBytes:_sink.buffer length:(NSUInteger)_sink.length encoding:NSUTF8StringEncoding];
+}
+
+- (NSData *)consoleLogLikeTextOfLength:(NSUInteger)length {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    char *bytes = data.mutableBytes;
+    const char *line = "2026-10-16 12:00:00.000 App[123:4567] -[ViewController viewDidLoad] loaded 42 items\n";
+    size_t lineLength = strlen(line);
+    for (NSUInteger i = 0; i < length; i++) {
+        bytes[i] = line[i % lineLength];
+    }
+    return data;
+}
+
+- (void)encodeSyntheticReport:(TTSDKJSONEncodeContext *)context {
+    ttsdkjson_beginObject(context, NULL);
+    ttsdkjson_beginArray(context, "threads");
+    for (int thread = 0; thread < 40; thread++) {
+        ttsdkjson_beginObject(context, NULL);
+        ttsdkjson_addIntegerElement(context, "index", thread);
+        ttsdkjson_addStringElement(context, "name", "com.apple.main-thread", TTSDKJSON_SIZE_AUTOMATIC);
+        ttsdkjson_beginObject(context, "backtrace");
+        ttsdkjson_beginArray(context, "contents");
+        for (int frame = 0; frame < 60; frame++) {
+            ttsdkjson_beginObject(context, NULL);
+            ttsdkjson_addUIntegerElement(context, "instruction_addr", 0x100000000ull + (uint64_t)frame * 16);
+            ttsdkjson_addUIntegerElement(context, "symbol_addr", 0x100000000ull + (uint64_t)frame * 8);
+            ttsdkjson_addStringElement(context, "object_name", "UIKitCore", TTSDKJSON_SIZE_AUTOMATIC);
+            ttsdkjson_addStringElement(context, "symbol_name", "-[UIApplication _run]", TTSDKJSON_SIZE_AUTOMATIC);
+            ttsdkjson_endContainer(context);
+        }
+        ttsdkjson_endContainer(context);
+        ttsdkjson_addIntegerElement(context, "skipped", 0);
+        ttsdkjson_endContainer(context);
+        ttsdkjson_endContainer(context);
+    }
+    ttsdkjson_endEncode(context);
+}
+
+- (void)testEscapesSpecialCharacters {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    const char *value = "plain \"quoted\" back\\slash\b\f\n\r\t end";
+    XCTAssertEqual(ttsdkjson_addStringElement(&context, NULL, value, TTSDKJSON_SIZE_AUTOMATIC), TTSDKJSON_OK);
+    XCTAssertEqualObjects([self encodedString], @"\"plain \\\"quoted\\\" back\\\\slash\\b\\f\\n\\r\\t end\"");
+}
+
+- (void)testEscapesAcrossVectorBoundaries {
+    // Put a special character at every offset of a long run so that each lane of the scanner gets hit.
+    for (int offset = 0; offset < 70; offset++) {
+        char value[80];
+        memset(value, 'a', sizeof(value));
+        value[offset] = '\n';
+        _sink.length = 0;
+        TTSDKJSONEncodeContext context;
+        ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+        XCTAssertEqual(ttsdkjson_addStringElement(&context, NULL, value, (int)sizeof(value)), TTSDKJSON_OK);
+        XCTAssertEqual(_sink.length, (int)sizeof(value) + 3);
+        XCTAssertEqual(_sink.buffer[offset + 1], '\\');
+        XCTAssertEqual(_sink.buffer[offset + 2], 'n');
+    }
+}
+
+- (void)testPassesThroughUTF8 {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    NSString *value = @"日本語のテキストと絵文字 😀 を含む長い文字列です。日本語のテキストと絵文字 😀";
+    XCTAssertEqual(ttsdkjson_addStringElement(&context, NULL, value.UTF8String, TTSDKJSON_SIZE_AUTOMATIC),
+                   TTSDKJSON_OK);
+    XCTAssertEqualObjects([self encodedString], ([NSString stringWithFormat:@"\"%@\"", value]));
+}
+
+- (void)testRejectsUnescapableControlCharacter {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    const char value[] = { 'a', 'b', 0x01, 'c' };
+    XCTAssertEqual(ttsdkjson_addStringElement(&context, NULL, value, (int)sizeof(value)),
+                   TTSDKJSON_ERROR_INVALID_CHARACTER);
+}
+
+- (void)testOutputBufferProducesIdenticalOutput {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+    [self encodeSyntheticReport:&context];
+    NSString *unbuffered = [self encodedString];
+    int unbufferedCalls = _sink.callCount;
+
+    _sink.length = 0;
+    _sink.callCount = 0;
+    char buffer[1024];
+    ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+    ttsdkjson_setOutputBuffer(&context, buffer, sizeof(buffer));
+    [self encodeSyntheticReport:&context];
+    XCTAssertEqualObjects([self encodedString], unbuffered);
+    XCTAssertLessThanOrEqual(_sink.callCount, _sink.length / (int)sizeof(buffer) + 1);
+    XCTAssertLessThan(_sink.callCount * 100, unbufferedCalls);
+}
+
+- (void)testOutputBufferHoldsDataUntilFlushed {
+    char buffer[64];
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setOutputBuffer(&context, buffer, sizeof(buffer));
+    XCTAssertEqual(ttsdkjson_beginObject(&context, NULL), TTSDKJSON_OK);
+    XCTAssertEqual(ttsdkjson_addIntegerElement(&context, "a", 1), TTSDKJSON_OK);
+    XCTAssertEqual(_sink.length, 0);
+    XCTAssertEqual(ttsdkjson_flushOutputBuffer(&context), TTSDKJSON_OK);
+    XCTAssertEqualObjects([self encodedString], @"{\"a\":1");
+    XCTAssertEqual(ttsdkjson_endEncode(&context), TTSDKJSON_OK);
+    XCTAssertEqualObjects([self encodedString], @"{\"a\":1}");
+    XCTAssertEqual(_sink.callCount, 2);
+}
+
+- (void)testOutputBufferPassesLargeDataStraightThrough {
+    char buffer[16];
+    NSData *text = [self consoleLogLikeTextOfLength:1000];
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setOutputBuffer(&context, buffer, sizeof(buffer));
+    ttsdkjson_beginStringElement(&context, NULL);
+    ttsdkjson_appendStringElement(&context, text.bytes, (int)text.length);
+    ttsdkjson_endStringElement(&context);
+    XCTAssertEqual(ttsdkjson_endEncode(&context), TTSDKJSON_OK);
+    XCTAssertEqual(_sink.length, 1002);
+    XCTAssertEqual(_sink.buffer[0], '"');
+    XCTAssertEqual(_sink.buffer[1001], '"');
+}
+
+- (void)testOutputBufferReducesSinkCalls {
+    const int iterations = 20;
+    char buffer[1024];
+    int unbufferedCalls = 0;
+    int bufferedCalls = 0;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < iterations; i++) {
+        _sink.length = 0;
+        _sink.callCount = 0;
+        TTSDKJSONEncodeContext context;
+        ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+        [self encodeSyntheticReport:&context];
+        unbufferedCalls = _sink.callCount;
+    }
+    CFTimeInterval unbufferedTime = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < iterations; i++) {
+        _sink.length = 0;
+        _sink.callCount = 0;
+        TTSDKJSONEncodeContext context;
+        ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+        ttsdkjson_setOutputBuffer(&context, buffer, sizeof(buffer));
+        [self encodeSyntheticReport:&context];
+        bufferedCalls = _sink.callCount;
+    }
+    CFTimeInterval bufferedTime = CFAbsoluteTimeGetCurrent() - start;
+    NSLog(@"JSON encode of %d byte report: %d sink calls in %.2f ms unbuffered, %d sink calls in %.2f ms buffered",
+          _sink.length, unbufferedCalls, unbufferedTime * 1000 / iterations, bufferedCalls,
+          bufferedTime * 1000 / iterations);
+    XCTAssertLessThan(bufferedCalls, unbufferedCalls);
+}
+
+- (void)testLiteralKeyMatchesEscapedKey {
+    const TTSDKJSONEncodeFormat formats[] = { TTSDKJSONEncodeFormatJSON, TTSDKJSONEncodeFormatJSON,
+                                              TTSDKJSONEncodeFormatCBOR };
+    for (int format = 0; format < 3; format++) {
+        const bool pretty = format == 1;
+        _sink.length = 0;
+        TTSDKJSONEncodeContext context;
+        ttsdkjson_beginEncode(&context, pretty, addToTestSink, &_sink);
+        ttsdkjson_setEncodeFormat(&context, formats[format]);
+        ttsdkjson_beginObject(&context, NULL);
+        ttsdkjson_addBooleanElement(&context, "flag", true);
+        ttsdkjson_addFloatingPointElement(&context, "ratio", 0.5);
+        ttsdkjson_addIntegerElement(&context, "index", -1);
+        ttsdkjson_addUIntegerElement(&context, "address", UINT64_MAX);
+        ttsdkjson_addStringElement(&context, "name", "a", TTSDKJSON_SIZE_AUTOMATIC);
+        ttsdkjson_addStringElement(&context, "missing", NULL, 0);
+        ttsdkjson_addDataElement(&context, "contents", "\x01\x02", 2);
+        ttsdkjson_beginObject(&context, "registers");
+        ttsdkjson_endContainer(&context);
+        ttsdkjson_beginArray(&context, "frames");
+        ttsdkjson_addIntegerElement(&context, NULL, 1);
+        ttsdkjson_endContainer(&context);
+        ttsdkjson_addIntegerElement(&context, "after", 2);
+        ttsdkjson_endEncode(&context);
+        NSData *expected = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+
+        _sink.length = 0;
+        ttsdkjson_beginEncode(&context, pretty, addToTestSink, &_sink);
+        ttsdkjson_setEncodeFormat(&context, formats[format]);
+        ttsdkjson_beginObject(&context, NULL);
+        XCTAssertEqual(ttsdkjson_addBooleanElementLiteral(&context, testKey("flag"), true), TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_addFloatingPointElementLiteral(&context, testKey("ratio"), 0.5), TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_addIntegerElementLiteral(&context, testKey("index"), -1), TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_addUIntegerElementLiteral(&context, testKey("address"), UINT64_MAX), TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_addStringElementLiteral(&context, testKey("name"), "a", TTSDKJSON_SIZE_AUTOMATIC),
+                       TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_addStringElementLiteral(&context, testKey("missing"), NULL, 0), TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_addDataElementLiteral(&context, testKey("contents"), "\x01\x02", 2), TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_beginObjectLiteral(&context, testKey("registers")), TTSDKJSON_OK);
+        ttsdkjson_endContainer(&context);
+        XCTAssertEqual(ttsdkjson_beginArrayLiteral(&context, testKey("frames")), TTSDKJSON_OK);
+        // Keys are ignored inside arrays, as names are.
+        ttsdkjson_addIntegerElementLiteral(&context, testKey("index"), 1);
+        ttsdkjson_endContainer(&context);
+        // The key doesn't carry over to the next element.
+        XCTAssertEqual(ttsdkjson_addIntegerElement(&context, "after", 2), TTSDKJSON_OK);
+        ttsdkjson_endEncode(&context);
+        XCTAssertEqualObjects([NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length], expected,
+                              @"format %d", format);
+    }
+
+    // A key is dropped when adding its element fails, too.
+    TTSDKJSONEncodeContext context;
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_beginObject(&context, NULL);
+    const int capacity = _sink.capacity;
+    _sink.capacity = _sink.length;
+    XCTAssertEqual(ttsdkjson_beginObjectLiteral(&context, testKey("registers")), TTSDKJSON_ERROR_CANNOT_ADD_DATA);
+    _sink.capacity = capacity;
+    XCTAssertTrue(context.literalKey == NULL);
+}
+
+- (void)testBase64DataMatchesFoundation {
+    NSMutableData *data = [NSMutableData dataWithLength:300];
+    arc4random_buf(data.mutableBytes, data.length);
+    // Every length, split into fragments of every size, so that both partial groups and each vector path get hit.
+    for (int length = 0; length <= 200; length++) {
+        NSData *value = [data subdataWithRange:NSMakeRange(0, (NSUInteger)length)];
+        NSString *expected = [NSString stringWithFormat:@"\"%@\"", [value base64EncodedStringWithOptions:0]];
+        for (int fragment = 1; fragment <= 64; fragment += 7) {
+            _sink.length = 0;
+            TTSDKJSONEncodeContext context;
+            ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+            ttsdkjson_setDataEncoding(&context, TTSDKJSONDataEncodingBase64);
+            ttsdkjson_beginDataElement(&context, NULL);
+            for (int offset = 0; offset < length; offset += fragment) {
+                ttsdkjson_appendDataElement(&context, (const char *)value.bytes + offset, MIN(fragment, length - offset));
+            }
+            XCTAssertEqual(ttsdkjson_endDataElement(&context), TTSDKJSON_OK);
+            XCTAssertEqualObjects([self encodedString], expected);
+        }
+    }
+}
+
+- (void)testDecodesDataElements {
+    const char bytes[] = { 0x00, 0x7f, (char)0x80, (char)0xff, 0x10 };
+    for (int encoding = TTSDKJSONDataEncodingHex; encoding <= TTSDKJSONDataEncodingBase64; encoding++) {
+        for (int length = 0; length <= (int)sizeof(bytes); length++) {
+            _sink.length = 0;
+            TTSDKJSONEncodeContext context;
+            ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+            ttsdkjson_setDataEncoding(&context, (TTSDKJSONDataEncoding)encoding);
+            ttsdkjson_addDataElement(&context, NULL, bytes, length);
+            char decoded[sizeof(bytes)];
+            int decodedLength = sizeof(decoded);
+            XCTAssertEqual(ttsdkjson_decodeDataElement(_sink.buffer + 1, _sink.length - 2,
+                                                       (TTSDKJSONDataEncoding)encoding, decoded, &decodedLength),
+                           TTSDKJSON_OK);
+            XCTAssertEqual(decodedLength, length);
+            XCTAssertEqual(memcmp(decoded, bytes, (size_t)length), 0);
+        }
+    }
+    char decoded[8];
+    int decodedLength = sizeof(decoded);
+    XCTAssertEqual(ttsdkjson_decodeDataElement("QU$D", 4, TTSDKJSONDataEncodingBase64, decoded, &decodedLength),
+                   TTSDKJSON_ERROR_INVALID_CHARACTER);
+    XCTAssertEqual(ttsdkjson_decodeDataElement("0G", 2, TTSDKJSONDataEncodingHex, decoded, &decodedLength),
+                   TTSDKJSON_ERROR_INVALID_CHARACTER);
+    decodedLength = 2;
+    XCTAssertEqual(ttsdkjson_decodeDataElement("QUJD", 4, TTSDKJSONDataEncodingBase64, decoded, &decodedLength),
+                   TTSDKJSON_ERROR_DATA_TOO_LONG);
+}
+
+- (NSData *)encodeSyntheticReportAsCBOR {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setEncodeFormat(&context, TTSDKJSONEncodeFormatCBOR);
+    [self encodeSyntheticReport:&context];
+    NSData *cbor = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+    _sink.length = 0;
+    return cbor;
+}
+
+- (void)testCBORTranscodesToIdenticalJSON {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+    [self encodeSyntheticReport:&context];
+    NSString *json = [self encodedString];
+    int jsonLength = _sink.length;
+    _sink.length = 0;
+
+    NSData *cbor = [self encodeSyntheticReportAsCBOR];
+    XCTAssertTrue(ttsdkcbor_isCBOR(cbor.bytes, (int)cbor.length));
+    XCTAssertLessThan((int)cbor.length, jsonLength);
+
+    ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqualObjects([self encodedString], json);
+}
+
+- (void)testCBORTranscodesScalars {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setEncodeFormat(&context, TTSDKJSONEncodeFormatCBOR);
+    ttsdkjson_beginObject(&context, NULL);
+    ttsdkjson_addIntegerElement(&context, "negative", -1234567890123);
+    ttsdkjson_addUIntegerElement(&context, "unsigned", UINT64_MAX);
+    ttsdkjson_addFloatingPointElement(&context, "float", 0.5);
+    ttsdkjson_addFloatingPointElement(&context, "double", 0.1);
+    ttsdkjson_addBooleanElement(&context, "bool", true);
+    ttsdkjson_addNullElement(&context, "null");
+    ttsdkjson_addDataElement(&context, "data", "\x01\xab", 2);
+    ttsdkjson_beginStringElement(&context, "string");
+    ttsdkjson_appendStringElement(&context, "a\"b", 3);
+    ttsdkjson_appendStringElement(&context, "\n", 1);
+    ttsdkjson_endStringElement(&context);
+    ttsdkjson_endEncode(&context);
+    NSData *cbor = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqualObjects([self encodedString],
+                          @"{\"negative\":-1234567890123,\"unsigned\":18446744073709551615,\"float\":0.5,"
+                          @"\"double\":0.1,\"bool\":true,\"null\":null,\"data\":\"01AB\",\"string\":\"a\\\"b\\n\"}");
+}
+
+- (void)testCBORTranscodeClosesContainersOfTruncatedData {
+    NSData *cbor = [self encodeSyntheticReportAsCBOR];
+    for (int length = 4; length < (int)cbor.length; length += 997) {
+        _sink.length = 0;
+        TTSDKJSONEncodeContext context;
+        ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+        XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, length, NULL, &context), TTSDKJSON_ERROR_INCOMPLETE);
+        ttsdkjson_endEncode(&context);
+        NSData *json = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+        XCTAssertNotNil([NSJSONSerialization JSONObjectWithData:json options:0 error:nil]);
+    }
+}
+
+- (void)testCBORTranscodeRejectsDeeplyNestedTags {
+    NSMutableData *cbor = [NSMutableData data];
+    for (int i = 0; i < 100000; i++) {
+        [cbor appendBytes:"\xc6" length:1];
+    }
+    [cbor appendBytes:"\x01" length:1];
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context), TTSDKJSON_ERROR_INVALID_DATA);
+    ttsdkjson_endEncode(&context);
+}
+
+- (void)testCBORTranscodesLongKeys {
+    // Longer than the transcoder's name buffer, and than the buffer it reads files through.
+    const char *key = [@"a\"b\\" stringByPaddingToLength:2000 withString:@"k" startingAtIndex:0].UTF8String;
+    NSString *json = nil;
+    NSData *cbor = nil;
+    for (int isCBOR = 0; isCBOR <= 1; isCBOR++) {
+        _sink.length = 0;
+        TTSDKJSONEncodeContext context;
+        ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+        ttsdkjson_setEncodeFormat(&context, isCBOR ? TTSDKJSONEncodeFormatCBOR : TTSDKJSONEncodeFormatJSON);
+        ttsdkjson_beginObject(&context, NULL);
+        ttsdkjson_beginObject(&context, key);
+        ttsdkjson_addIntegerElement(&context, key, 1);
+        ttsdkjson_endContainer(&context);
+        ttsdkjson_addIntegerElement(&context, "after", 2);
+        ttsdkjson_endEncode(&context);
+        if (isCBOR) {
+            cbor = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+        } else {
+            json = [self encodedString];
+        }
+    }
+
+    _sink.length = 0;
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqualObjects([self encodedString], json);
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"TTSDKCBORLongKeys.json"];
+    [cbor writeToFile:path atomically:YES];
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcodeFile(path.fileSystemRepresentation, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqualObjects([self encodedString], json);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testCBORTranscodesAsDeepAsTheEncoderWrites {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setEncodeFormat(&context, TTSDKJSONEncodeFormatCBOR);
+    for (int i = 0; i < 150; i++) {
+        ttsdkjson_beginArray(&context, NULL);
+    }
+    ttsdkjson_endEncode(&context);
+    NSData *cbor = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqual(_sink.length, 300);
+}
+
+- (void)testCBORKeepsDoublesOutsideFloatRange {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setEncodeFormat(&context, TTSDKJSONEncodeFormatCBOR);
+    ttsdkjson_beginArray(&context, NULL);
+    ttsdkjson_addFloatingPointElement(&context, NULL, 1e300);
+    ttsdkjson_addFloatingPointElement(&context, NULL, -1e300);
+    ttsdkjson_addFloatingPointElement(&context, NULL, 1e-300);
+    ttsdkjson_endEncode(&context);
+    NSData *cbor = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    NSArray *values = [NSJSONSerialization JSONObjectWithData:[[self encodedString] dataUsingEncoding:NSUTF8StringEncoding]
+                                                      options:0
+                                                        error:nil];
+    XCTAssertEqualObjects(values, (@[ @1e300, @-1e300, @1e-300 ]));
+}
+
+- (void)testCBORAddJSONElementKeepsLongEscapedStrings {
+    // CBOR output can't be spliced, so the element is decoded with a fixed string buffer.
+    NSString *string = [@"a\\n" stringByPaddingToLength:4900 withString:@"x" startingAtIndex:0];
+    NSString *json = [NSString stringWithFormat:@"[\"%@\"]", string];
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setEncodeFormat(&context, TTSDKJSONEncodeFormatCBOR);
+    ttsdkjson_beginObject(&context, NULL);
+    XCTAssertEqual(ttsdkjson_addJSONElement(&context, "user", json.UTF8String, (int)strlen(json.UTF8String), true),
+                   TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    NSData *cbor = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqualObjects([self encodedString], ([NSString stringWithFormat:@"{\"user\":%@}", json]));
+}
+
+- (void)testCBORTranscodesFromFile {
+    NSData *cbor = [self encodeSyntheticReportAsCBOR];
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"TTSDKCBORReport.json"];
+    [cbor writeToFile:path atomically:YES];
+    XCTAssertTrue(ttsdkcbor_isCBORFile(path.fileSystemRepresentation));
+
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    XCTAssertEqual(ttsdkcbor_transcodeFile(path.fileSystemRepresentation, NULL, &context), TTSDKJSON_OK);
+    ttsdkjson_endEncode(&context);
+    NSString *fromFile = [self encodedString];
+
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkcbor_transcode(cbor.bytes, (int)cbor.length, NULL, &context);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqualObjects(fromFile, [self encodedString]);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (NSString *)embedJSON:(NSString *)json prettyPrint:(bool)prettyPrint closeLastContainer:(bool)closeLastContainer {
+    _sink.length = 0;
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, prettyPrint, addToTestSink, &_sink);
+    ttsdkjson_beginObject(&context, NULL);
+    ttsdkjson_addIntegerElement(&context, "before", 1);
+    const char *data = json.UTF8String;
+    ttsdkjson_addJSONElement(&context, "user", data, (int)strlen(data), closeLastContainer);
+    ttsdkjson_addStringElement(&context, "after", "x", TTSDKJSON_SIZE_AUTOMATIC);
+    ttsdkjson_endEncode(&context);
+    return [self encodedString];
+}
+
+- (void)testSplicesEmbeddedJSONVerbatim {
+    NSString *json = @" { \"a\" : [ 1 , -0.5e10 , true , null , { } , [ ] ] ,\n \"s\" : \"\\u00e9\\uD83D\\uDE00 \\/\" } ";
+    XCTAssertEqualObjects([self embedJSON:json prettyPrint:false closeLastContainer:true],
+                          @"{\"before\":1,\"user\":{\"a\":[1,-0.5e10,true,null,{},[]],"
+                          @"\"s\":\"\\u00e9\\uD83D\\uDE00 \\/\"},\"after\":\"x\"}");
+    XCTAssertEqualObjects([self embedJSON:json prettyPrint:true closeLastContainer:true],
+                          @"{\n    \"before\": 1,\n    \"user\": {\n        \"a\": [\n            1,\n"
+                          @"            -0.5e10,\n            true,\n            null,\n            {},\n"
+                          @"            []\n        ],\n        \"s\": \"\\u00e9\\uD83D\\uDE00 \\/\"\n    },\n"
+                          @"    \"after\": \"x\"\n}");
+}
+
+- (void)testSplicedJSONLeavesLastContainerOpen {
+    XCTAssertEqualObjects([self embedJSON:@"{\"a\":[1,2]}" prettyPrint:false closeLastContainer:false],
+                          @"{\"before\":1,\"user\":{\"a\":[1,2],\"after\":\"x\"}}");
+    XCTAssertEqualObjects([self embedJSON:@"{ }" prettyPrint:false closeLastContainer:false],
+                          @"{\"before\":1,\"user\":{\"after\":\"x\"}}");
+}
+
+- (void)testInvalidEmbeddedJSONIsNotSpliced {
+    NSArray<NSString *> *invalid = @[ @"{\"a\":01}", @"[1,]", @"\"\\uD83D\"", @"{\"a\" 1}" ];
+    for (NSString *json in invalid) {
+        NSString *output = [self embedJSON:json prettyPrint:false closeLastContainer:true];
+        XCTAssertFalse([output containsString:json], @"%@ was spliced", json);
+    }
+}
+
+- (void)testReindentMatchesPrettyEncoding {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+    [self encodeSyntheticReport:&context];
+    NSString *pretty = [self encodedString];
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    [self encodeSyntheticReport:&context];
+    NSData *compact = [NSData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+
+    for (int chunkSize = 1; chunkSize < 100; chunkSize += 7) {
+        _sink.length = 0;
+        TTSDKJSONReindentContext reindentContext;
+        ttsdkjson_beginReindent(&reindentContext, addToTestSink, &_sink);
+        const char *bytes = compact.bytes;
+        int length = (int)compact.length;
+        for (int offset = 0; offset < length; offset += chunkSize) {
+            int chunk = MIN(chunkSize, length - offset);
+            XCTAssertEqual(ttsdkjson_reindent(&reindentContext, bytes + offset, chunk), TTSDKJSON_OK);
+        }
+        XCTAssertEqual(ttsdkjson_endReindent(&reindentContext), TTSDKJSON_OK);
+        XCTAssertEqualObjects([self encodedString], pretty);
+    }
+}
+
+- (void)testReindentKeepsStringContents {
+    NSData *json = [@"{\"a\":\"x, y: {z}\\\" [\\\\]\",\"b\":[],\"c\":{}}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *pretty = [TTSDKJSONCodec prettyPrint:json];
+    NSString *expected = @"{\n    \"a\": \"x, y: {z}\\\" [\\\\]\",\n    \"b\": [],\n    \"c\": {}\n}";
+    XCTAssertEqualObjects([[NSString alloc] initWithData:pretty encoding:NSUTF8StringEncoding], expected);
+}
+
+- (void)testSectionIndexRecordsSectionOffsets {
+    char outputBuffer[64];
+    TTSDKJSONSectionIndexEntry entries[16];
+    TTSDKJSONSectionIndex index;
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+    ttsdkjson_setOutputBuffer(&context, outputBuffer, sizeof(outputBuffer));
+    ttsdkjson_beginSectionIndex(&context, &index, entries, 16);
+    ttsdkjson_beginObject(&context, NULL);
+    ttsdkjson_beginObject(&context, "report");
+    ttsdkjson_addIntegerElement(&context, "timestamp", 12345);
+    ttsdkjson_endContainer(&context);
+    ttsdkjson_beginObject(&context, "crash");
+    ttsdkjson_beginArray(&context, "threads");
+    for (int thread = 0; thread < 3; thread++) {
+        ttsdkjson_beginObject(&context, NULL);
+        ttsdkjson_addIntegerElement(&context, "index", thread);
+        ttsdkjson_endContainer(&context);
+    }
+    ttsdkjson_endContainer(&context);
+    ttsdkjson_endContainer(&context);
+    ttsdkjson_endEncode(&context);
+    XCTAssertEqual(ttsdkjson_getOutputPosition(&context), _sink.length);
+
+    NSArray *expectedPaths = @[ @"report", @"crash", @"crash.threads", @"crash.threads[0]", @"crash.threads[1]",
+                                @"crash.threads[2]" ];
+    XCTAssertEqual(index.count, (int)expectedPaths.count);
+    NSDictionary *report = [NSJSONSerialization JSONObjectWithData:[NSData dataWithBytes:_sink.buffer
+                                                                                  length:(NSUInteger)_sink.length]
+                                                           options:0
+                                                             error:nil];
+    for (int i = 0; i < index.count; i++) {
+        XCTAssertEqualObjects(@(entries[i].path), expectedPaths[i]);
+        NSData *slice = [NSData dataWithBytes:_sink.buffer + entries[i].offset length:(NSUInteger)entries[i].length];
+        id section = [NSJSONSerialization JSONObjectWithData:slice options:0 error:nil];
+        id expected = [report valueForKeyPath:[expectedPaths[i] componentsSeparatedByString:@"["].firstObject];
+        if ([expectedPaths[i] hasSuffix:@"]"]) {
+            expected = expected[(NSUInteger)i - 3];
+        }
+        XCTAssertEqualObjects(section, expected);
+    }
+}
+
+- (void)testSectionIndexSkipsPathsThatDontFit {
+    TTSDKJSONSectionIndexEntry entries[16];
+    TTSDKJSONSectionIndex index;
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_beginSectionIndex(&context, &index, entries, 16);
+    ttsdkjson_beginObject(&context, NULL);
+    ttsdkjson_beginObject(&context, "crash");
+    NSString *longName = [@"" stringByPaddingToLength:TTSDKJSON_SECTION_PATH_LENGTH withString:@"x" startingAtIndex:0];
+    ttsdkjson_beginObject(&context, longName.UTF8String);
+    ttsdkjson_beginArray(&context, "threads");
+    ttsdkjson_endContainer(&context);
+    ttsdkjson_endContainer(&context);
+    ttsdkjson_beginObject(&context, "error");
+    ttsdkjson_endContainer(&context);
+    ttsdkjson_endContainer(&context);
+    ttsdkjson_endEncode(&context);
+
+    XCTAssertEqual(index.count, 2);
+    XCTAssertEqualObjects(@(entries[0].path), @"crash");
+    XCTAssertEqualObjects(@(entries[1].path), @"crash.error");
+}
+
+- (void)testDecodesStringsAcrossBlockBoundaries {
+    NSArray *strings = @[ @"plain", @"quote \" inside", @"backslash \\", @"two \\\\ backslashes \\\"", @"{[:,]}",
+                          @"tab\tnewline\n", @"é中" ];
+    for (NSUInteger padding = 0; padding < 70; padding++) {
+        NSDictionary *object = @{
+            @"padding" : [@"" stringByPaddingToLength:padding withString:@"x" startingAtIndex:0],
+            @"strings" : strings,
+            @"numbers" : @[ @0, @-1, @123456789, @1.5, @YES, [NSNull null] ],
+        };
+        NSData *json = [NSJSONSerialization dataWithJSONObject:object options:0 error:nil];
+        NSError *error = nil;
+        XCTAssertEqualObjects([TTSDKJSONCodec decode:json options:TTSDKJSONDecodeOptionNone error:&error], object);
+        XCTAssertNil(error);
+    }
+}
+
+- (void)testDecodesLeftoverScalarsLikeBytewiseDecoder {
+    // Numbers and literals are delimited by whatever follows them.
+    NSString *json = [NSString stringWithFormat:@"[%@1true, 2]", [@"" stringByPaddingToLength:80
+                                                                                  withString:@" "
+                                                                             startingAtIndex:0]];
+    id decoded = [TTSDKJSONCodec decode:[json dataUsingEncoding:NSUTF8StringEncoding]
+                                options:TTSDKJSONDecodeOptionNone
+                                  error:nil];
+    XCTAssertEqualObjects(decoded, (@[ @1, @YES, @2 ]));
+
+    json = [NSString stringWithFormat:@"{%@\"a\": 1true}", [@"" stringByPaddingToLength:80
+                                                                              withString:@" "
+                                                                         startingAtIndex:0]];
+    XCTAssertNil([TTSDKJSONCodec decode:[json dataUsingEncoding:NSUTF8StringEncoding]
+                                options:TTSDKJSONDecodeOptionNone
+                                  error:nil]);
+}
+
+- (void)testDecodesUnescapedStringsLongerThanStringBuffer {
+    NSString *longString = [@"" stringByPaddingToLength:50000 withString:@"/usr/lib/libfoo.dylib " startingAtIndex:0];
+    NSArray *object = @[ longString, @"escaped \"quote\"" ];
+    NSData *json = [NSJSONSerialization dataWithJSONObject:object options:0 error:nil];
+    NSError *error = nil;
+    XCTAssertEqualObjects([TTSDKJSONCodec decode:json options:TTSDKJSONDecodeOptionNone error:&error], object);
+    XCTAssertNil(error);
+}
+
+- (void)testUnescapesEscapesAtEveryOffset {
+    NSArray<NSString *> *escapes = @[ @"\\n", @"\\\"", @"\\\\", @"\\/", @"\\t", @"\\u00e9", @"\\u4E2D", @"\\uD83D\\uDE00" ];
+    NSArray<NSString *> *unescaped = @[ @"\n", @"\"", @"\\", @"/", @"\t", @"é", @"中", @"😀" ];
+    for (NSUInteger i = 0; i < escapes.count; i++) {
+        for (NSUInteger offset = 0; offset < 70; offset++) {
+            NSString *padding = [@"" stringByPaddingToLength:offset withString:@"x" startingAtIndex:0];
+            NSString *json = [NSString stringWithFormat:@"[\"%@%@%@end\"]", padding, escapes[i], padding];
+            NSString *expected = [NSString stringWithFormat:@"%@%@%@end", padding, unescaped[i], padding];
+            NSError *error = nil;
+            id decoded = [TTSDKJSONCodec decode:[json dataUsingEncoding:NSUTF8StringEncoding]
+                                        options:TTSDKJSONDecodeOptionNone
+                                          error:&error];
+            XCTAssertEqualObjects(decoded, @[ expected ], @"%@", json);
+            XCTAssertNil(error);
+        }
+    }
+}
+
+- (void)testRejectsInvalidUnicodeEscapes {
+    NSArray<NSString *> *invalid =
+        @[ @"[\"\\u12\"]", @"[\"\\u000g\"]", @"[\"\\uDE00\"]", @"[\"\\uD83D\"]", @"[\"\\uD83Dx\"]", @"[\"\\uD83D\\u0041\"]" ];
+    for (NSString *json in invalid) {
+        NSError *error = nil;
+        XCTAssertNil([TTSDKJSONCodec decode:[json dataUsingEncoding:NSUTF8StringEncoding]
+                                    options:TTSDKJSONDecodeOptionNone
+                                      error:&error],
+                     @"%@", json);
+        XCTAssertNotNil(error);
+    }
+}
+
+- (void)testPushDecoderMatchesWholeDocumentDecode {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    [self encodeSyntheticReport:&context];
+    NSMutableData *json = [NSMutableData dataWithBytes:_sink.buffer length:(NSUInteger)_sink.length];
+    json.length -= 1;
+    const char *tail = ",\"extra\":[\"tab\\there \\\"quoted\\\" \\u00e9\",-1.5e-3,true,false,null,"
+                       "18446744073709551615,-9223372036854775808,{}]}";
+    [json appendBytes:tail length:strlen(tail)];
+
+    char stringBuffer[1000];
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    int errorOffset = 0;
+    XCTAssertEqual(ttsdkjson_decode(json.bytes, (int)json.length, stringBuffer, sizeof(stringBuffer),
+                                    &g_reencodeCallbacks, &context, &errorOffset),
+                   TTSDKJSON_OK);
+    NSString *expected = [self encodedString];
+
+    const char *bytes = json.bytes;
+    const int length = (int)json.length;
+    for (int chunkSize = 1; chunkSize <= 130; chunkSize++) {
+        _sink.length = 0;
+        ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+        TTSDKJSONDecoder decoder;
+        ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &g_reencodeCallbacks, &context);
+        for (int offset = 0; offset < length; offset += chunkSize) {
+            XCTAssertEqual(ttsdkjson_decoderFeed(&decoder, bytes + offset, MIN(chunkSize, length - offset)),
+                           TTSDKJSON_OK);
+        }
+        XCTAssertEqual(ttsdkjson_decoderFinish(&decoder), TTSDKJSON_OK);
+        XCTAssertEqualObjects([self encodedString], expected, @"chunk size %d", chunkSize);
+    }
+}
+
+- (void)testPushDecoderReportsIncompleteDocuments {
+    char stringBuffer[100];
+    TTSDKJSONEncodeContext context;
+    NSArray<NSString *> *incomplete = @[ @"", @"{\"a\":[1,2", @"{\"a\"", @"[\"abc", @"[12" ];
+    for (NSString *json in incomplete) {
+        ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+        TTSDKJSONDecoder decoder;
+        ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &g_reencodeCallbacks, &context);
+        XCTAssertEqual(ttsdkjson_decoderFeed(&decoder, json.UTF8String, (int)strlen(json.UTF8String)), TTSDKJSON_OK);
+        XCTAssertEqual(ttsdkjson_decoderFinish(&decoder), TTSDKJSON_ERROR_INCOMPLETE, @"%@", json);
+    }
+
+    // A top-level number is complete once the data ends.
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    TTSDKJSONDecoder decoder;
+    ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &g_reencodeCallbacks, &context);
+    XCTAssertEqual(ttsdkjson_decoderFeed(&decoder, "-12", 3), TTSDKJSON_OK);
+    XCTAssertEqual(ttsdkjson_decoderFeed(&decoder, "34", 2), TTSDKJSON_OK);
+    XCTAssertEqual(ttsdkjson_decoderFinish(&decoder), TTSDKJSON_OK);
+    XCTAssertEqualObjects([self encodedString], @"-1234");
+}
+
+- (void)testPushDecoderPassesLongStringsInParts {
+    NSMutableString *longString = [NSMutableString string];
+    for (int i = 0; i < 200; i++) {
+        [longString appendFormat:@"line %d\\n\\t\\\"q\\\" \\u00e9\\ud83d\\ude00 \u00e9\u6f22 ", i];
+    }
+    NSString *json = [NSString stringWithFormat:@"{\"a\":\"%@\",\"b\":[\"%@\",1],\"c\":\"short\"}", longString, longString];
+    const char *bytes = json.UTF8String;
+    const int length = (int)strlen(bytes);
+
+    char largeBuffer[100000];
+    TTSDKJSONEncodeContext context;
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    int errorOffset = 0;
+    XCTAssertEqual(ttsdkjson_decode(bytes, length, largeBuffer, sizeof(largeBuffer), &g_reencodeCallbacks, &context,
+                                    &errorOffset),
+                   TTSDKJSON_OK);
+    NSString *expected = [self encodedString];
+
+    char stringBuffer[200];
+    TTSDKJSONDecoder decoder;
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &g_reencodeCallbacks, &context);
+    XCTAssertEqual(ttsdkjson_decoderFeed(&decoder, bytes, length), TTSDKJSON_ERROR_DATA_TOO_LONG);
+
+    TTSDKJSONDecodeCallbacks callbacks = g_reencodeCallbacks;
+    callbacks.onStringElementPart = reencode_onStringElementPart;
+    for (int chunkSize = 1; chunkSize <= 4096; chunkSize *= 4) {
+        _sink.length = 0;
+        ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+        ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &callbacks, &context);
+        for (int offset = 0; offset < length; offset += chunkSize) {
+            XCTAssertEqual(ttsdkjson_decoderFeed(&decoder, bytes + offset, MIN(chunkSize, length - offset)),
+                           TTSDKJSON_OK);
+        }
+        XCTAssertEqual(ttsdkjson_decoderFinish(&decoder), TTSDKJSON_OK);
+        XCTAssertEqualObjects([self encodedString], expected, @"chunk size %d", chunkSize);
+    }
+}
+
+- (NSString *)decodeFiltered:(NSString *)json paths:(NSArray<NSString *> *)paths result:(int *)result {
+    const char *cPaths[paths.count];
+    for (NSUInteger i = 0; i < paths.count; i++) {
+        cPaths[i] = paths[i].UTF8String;
+    }
+    TTSDKJSONPathFilter filter;
+    XCTAssertEqual(ttsdkjson_compilePathFilter(&filter, cPaths, (int)paths.count), TTSDKJSON_OK);
+
+    char stringBuffer[1000];
+    _sink.length = 0;
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    NSData *data = [json dataUsingEncoding:NSUTF8StringEncoding];
+    *result = ttsdkjson_decodeFiltered(data.bytes, (int)data.length, stringBuffer, sizeof(stringBuffer), &filter,
+                                       &g_reencodeCallbacks, &context, NULL);
+    return [self encodedString];
+}
+
+- (void)testFilteredDecodeKeepsOnlySelectedPaths {
+    NSString *json = @"{\"report\":{\"id\":\"A\",\"skip\":[1,{\"x\":\"]}\\\"\"}]},"
+                     @"\"crash\":{\"threads\":[{\"index\":0,\"crashed\":true,\"backtrace\":{\"contents\":["
+                     @"{\"instruction_addr\":16,\"symbol_name\":\"a\"},{\"instruction_addr\":32}]}},"
+                     @"{\"index\":1,\"backtrace\":{\"contents\":[{\"symbol_name\":\"b\",\"instruction_addr\":48}]}}],"
+                     @"\"error\":{\"type\":\"signal\",\"signal\":{\"name\":\"SIGSEGV\"}}},\"system\":{\"cpu\":\"arm64\"}}";
+    int result;
+    NSString *decoded = [self decodeFiltered:json
+                                       paths:@[
+                                           @"report.id", @"crash.threads[*].backtrace.contents[*].instruction_addr",
+                                           @"crash.error.signal", @"missing.path"
+                                       ]
+                                      result:&result];
+    XCTAssertEqual(result, TTSDKJSON_OK);
+    XCTAssertEqualObjects(decoded, @"{\"report\":{\"id\":\"A\"},\"crash\":{\"threads\":["
+                                   @"{\"backtrace\":{\"contents\":[{\"instruction_addr\":16},{\"instruction_addr\":32}]}},"
+                                   @"{\"backtrace\":{\"contents\":[{\"instruction_addr\":48}]}}],"
+                                   @"\"error\":{\"signal\":{\"name\":\"SIGSEGV\"}}}}");
+
+    decoded = [self decodeFiltered:json paths:@[ @"crash.threads[1].index", @"*.cpu" ] result:&result];
+    XCTAssertEqual(result, TTSDKJSON_OK);
+    // Containers on the way to a selected value are kept even if nothing in them is selected.
+    XCTAssertEqualObjects(decoded,
+                          @"{\"report\":{},\"crash\":{\"threads\":[{\"index\":1}]},\"system\":{\"cpu\":\"arm64\"}}");
+
+    // Skipped parts only need to be balanced, but the parts that are decoded are checked as usual.
+    [self decodeFiltered:@"{\"a\":[1,2,\"]\"],\"b\":" paths:@[ @"c" ] result:&result];
+    XCTAssertEqual(result, TTSDKJSON_ERROR_INCOMPLETE);
+    [self decodeFiltered:@"{\"a\":[1,2 3 x],\"b\":tru}" paths:@[ @"b" ] result:&result];
+    XCTAssertEqual(result, TTSDKJSON_ERROR_INVALID_CHARACTER);
+}
+
+- (void)testFilteredDecodeSkipsLargeSubtrees {
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, true, addToTestSink, &_sink);
+    [self encodeSyntheticReport:&context];
+    NSString *json = [self encodedString];
+
+    int result;
+    NSString *decoded = [self decodeFiltered:json
+                                       paths:@[ @"threads[39].index", @"threads[0].backtrace.contents[59].symbol_addr" ]
+                                      result:&result];
+    XCTAssertEqual(result, TTSDKJSON_OK);
+    XCTAssertEqualObjects(decoded, ([NSString stringWithFormat:@"{\"threads\":[{\"backtrace\":{\"contents\":"
+                                                               @"[{\"symbol_addr\":%llu}]}},{\"index\":39}]}",
+                                                               0x100000000ull + 59 * 8]));
+}
+
+- (void)testPathFilterRejectsMalformedPaths {
+    TTSDKJSONPathFilter filter;
+    NSArray<NSString *> *malformed = @[ @"", @"a..b", @"a.", @".a", @"a[", @"a[]", @"a[x]", @"a[1]b", @"a.[1]" ];
+    for (NSString *path in malformed) {
+        const char *paths[] = { path.UTF8String };
+        XCTAssertEqual(ttsdkjson_compilePathFilter(&filter, paths, 1), TTSDKJSON_ERROR_INVALID_DATA, @"%@", path);
+    }
+
+    const char *tooMany[TTSDKJSON_PATH_FILTER_MAX_SEGMENTS + 1];
+    char names[TTSDKJSON_PATH_FILTER_MAX_SEGMENTS + 1][8];
+    for (int i = 0; i <= TTSDKJSON_PATH_FILTER_MAX_SEGMENTS; i++) {
+        snprintf(names[i], sizeof(names[i]), "k%d", i);
+        tooMany[i] = names[i];
+    }
+    XCTAssertEqual(ttsdkjson_compilePathFilter(&filter, tooMany, TTSDKJSON_PATH_FILTER_MAX_SEGMENTS), TTSDKJSON_OK);
+    XCTAssertEqual(ttsdkjson_compilePathFilter(&filter, tooMany, TTSDKJSON_PATH_FILTER_MAX_SEGMENTS + 1),
+                   TTSDKJSON_ERROR_DATA_TOO_LONG);
+}
+
+- (void)testKeyDictionaryPassesKeyIDs {
+    const char *keys[] = { "index", "name", "a\"b" };
+    TTSDKJSONKeyDictionary dictionary;
+    XCTAssertEqual(ttsdkjson_compileKeyDictionary(&dictionary, keys, 3), TTSDKJSON_OK);
+    TTSDKJSONDecodeCallbacks callbacks = {
+        .onIntegerElement = recordKeyID_onIntegerElement,
+        .onBeginObject = recordKeyID_onName,
+        .onBeginArray = recordKeyID_onName,
+        .onEndContainer = recordKeyID_onEnd,
+        .onEndData = recordKeyID_onEnd,
+        .keyDictionary = &dictionary,
+    };
+    const char *json = "{\"index\":1,\"other\":2,\"a\\\"b\":3,\"nested\":{\"na\\u006de\":4,\"inde\":5},\"arr\":[6]}";
+    const int length = (int)strlen(json);
+    const int expected[] = { 0, 0, TTSDKJSON_KEY_UNKNOWN, 2, 1, TTSDKJSON_KEY_UNKNOWN, TTSDKJSON_KEY_UNKNOWN };
+    char stringBuffer[100];
+
+    KeyIDRecorder recorder = { .dictionary = &dictionary };
+    XCTAssertEqual(ttsdkjson_decode(json, length, stringBuffer, sizeof(stringBuffer), &callbacks, &recorder, NULL),
+                   TTSDKJSON_OK);
+    for (int i = 1; i <= 6; i++) {
+        XCTAssertEqual(recorder.keyIDs[i], expected[i], @"element %d", i);
+    }
+
+    recorder = (KeyIDRecorder) { .dictionary = &dictionary };
+    TTSDKJSONDecoder decoder;
+    ttsdkjson_decoderInit(&decoder, stringBuffer, sizeof(stringBuffer), &callbacks, &recorder);
+    for (int offset = 0; offset < length; offset++) {
+        XCTAssertEqual(ttsdkjson_decoderFeed(&decoder, json + offset, 1), TTSDKJSON_OK);
+    }
+    XCTAssertEqual(ttsdkjson_decoderFinish(&decoder), TTSDKJSON_OK);
+    for (int i = 1; i <= 6; i++) {
+        XCTAssertEqual(recorder.keyIDs[i], expected[i], @"element %d in pieces", i);
+    }
+
+    recorder = (KeyIDRecorder) { .dictionary = &dictionary };
+    const char *paths[] = { "index", "nested.name" };
+    TTSDKJSONPathFilter filter;
+    XCTAssertEqual(ttsdkjson_compilePathFilter(&filter, paths, 2), TTSDKJSON_OK);
+    XCTAssertEqual(ttsdkjson_decodeFiltered(json, length, stringBuffer, sizeof(stringBuffer), &filter, &callbacks,
+                                            &recorder, NULL),
+                   TTSDKJSON_OK);
+    XCTAssertEqual(recorder.keyIDs[1], 0);
+    XCTAssertEqual(recorder.keyIDs[4], 1);
+
+    // Names from anywhere else are unknown, even if they're spelled the same.
+    XCTAssertEqual(ttsdkjson_keyID(&dictionary, "index"), TTSDKJSON_KEY_UNKNOWN);
+    XCTAssertEqual(ttsdkjson_keyID(&dictionary, NULL), TTSDKJSON_KEY_UNKNOWN);
+    XCTAssertEqual(ttsdkjson_findKey(&dictionary, "index", 5), 0);
+    XCTAssertEqual(ttsdkjson_findKey(&dictionary, "indexes", 5), 0);
+    XCTAssertEqual(ttsdkjson_findKey(&dictionary, "inde", 4), TTSDKJSON_KEY_UNKNOWN);
+}
+
+- (void)testKeyDictionaryHoldsManyKeys {
+    char names[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS + 1][16];
+    const char *keys[TTSDKJSON_KEY_DICTIONARY_MAX_KEYS + 1];
+    for (int i = 0; i <= TTSDKJSON_KEY_DICTIONARY_MAX_KEYS; i++) {
+        snprintf(names[i], sizeof(names[i]), "key_%d", i);
+        keys[i] = names[i];
+    }
+    TTSDKJSONKeyDictionary dictionary;
+    XCTAssertEqual(ttsdkjson_compileKeyDictionary(&dictionary, keys, TTSDKJSON_KEY_DICTIONARY_MAX_KEYS), TTSDKJSON_OK);
+    for (int i = 0; i < TTSDKJSON_KEY_DICTIONARY_MAX_KEYS; i++) {
+        XCTAssertEqual(ttsdkjson_findKey(&dictionary, keys[i], (int)strlen(keys[i])), i);
+    }
+    XCTAssertEqual(ttsdkjson_findKey(&dictionary, "key_128", 7), TTSDKJSON_KEY_UNKNOWN);
+
+    XCTAssertEqual(ttsdkjson_compileKeyDictionary(&dictionary, keys, TTSDKJSON_KEY_DICTIONARY_MAX_KEYS + 1),
+                   TTSDKJSON_ERROR_DATA_TOO_LONG);
+    const char *duplicates[] = { "a", "b", "a" };
+    XCTAssertEqual(ttsdkjson_compileKeyDictionary(&dictionary, duplicates, 3), TTSDKJSON_ERROR_INVALID_DATA);
+}
+
+- (void)testParallelArrayDecodeKeepsElementOrder {
+    NSMutableString *json = [NSMutableString stringWithString:@"[ "];
+    for (int i = 0; i < 2000; i++) {
+        [json appendFormat:@"%@{\"id\":%d,\"text\":\"[%@\\\"]\",\"list\":[%d]}", i == 0 ? @"" : @",\n", i,
+                           [@"" stringByPaddingToLength:(NSUInteger)(i % 200) withString:@"{," startingAtIndex:0], i];
+    }
+    [json appendString:@" ]"];
+    NSData *data = [json dataUsingEncoding:NSUTF8StringEncoding];
+
+    TTSDKJSONDecodeCallbacks callbacks = {
+        .onIntegerElement = recordElement_onIntegerElement,
+        .onStringElement = recordElement_onString,
+        .onBeginObject = recordElement_onOther,
+        .onBeginArray = recordElement_onOther,
+        .onEndContainer = recordElement_onEndContainer,
+        .onEndData = recordElement_onEndData,
+    };
+    for (int workerCount = 1; workerCount <= 8; workerCount++) {
+        TTSDKJSONArrayWorker workers[8];
+        ElementRecorder *recorders = calloc((size_t)workerCount, sizeof(*recorders));
+        char stringBuffers[8][1000];
+        for (int i = 0; i < workerCount; i++) {
+            workers[i] = (TTSDKJSONArrayWorker) {
+                .callbacks = &callbacks,
+                .userData = &recorders[i],
+                .stringBuffer = stringBuffers[i],
+                .stringBufferLength = sizeof(stringBuffers[i]),
+            };
+        }
+        XCTAssertEqual(ttsdkjson_decodeArrayInParallel(data.bytes, (int)data.length, workers, workerCount, NULL),
+                       TTSDKJSON_OK);
+        int nextElement = 0;
+        for (int i = 0; i < workerCount; i++) {
+            XCTAssertEqual(workers[i].firstElement, nextElement, @"worker %d of %d", i, workerCount);
+            XCTAssertEqual(recorders[i].documentCount, workers[i].elementCount);
+            XCTAssertEqual(recorders[i].idCount, workers[i].elementCount);
+            for (int j = 0; j < recorders[i].idCount; j++) {
+                XCTAssertEqual(recorders[i].ids[j], nextElement + j);
+            }
+            nextElement += workers[i].elementCount;
+        }
+        XCTAssertEqual(nextElement, 2000);
+        if (workerCount > 1) {
+            XCTAssertGreaterThan(workers[1].elementCount, 0);
+        }
+        free(recorders);
+    }
+}
+
+- (void)testParallelArrayDecodeReportsErrors {
+    TTSDKJSONDecodeCallbacks callbacks = {
+        .onIntegerElement = recordElement_onIntegerElement,
+        .onStringElement = recordElement_onString,
+        .onBeginObject = recordElement_onOther,
+        .onBeginArray = recordElement_onOther,
+        .onEndContainer = recordElement_onEndContainer,
+        .onEndData = recordElement_onEndData,
+    };
+    ElementRecorder recorder = { 0 };
+    char stringBuffer[100];
+    TTSDKJSONArrayWorker worker = {
+        .callbacks = &callbacks,
+        .userData = &recorder,
+        .stringBuffer = stringBuffer,
+        .stringBufferLength = sizeof(stringBuffer),
+    };
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("[]", 2, &worker, 1, NULL), TTSDKJSON_OK);
+    XCTAssertEqual(worker.elementCount, 0);
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("[1,2]", 5, &worker, 1, NULL), TTSDKJSON_OK);
+    XCTAssertEqual(worker.elementCount, 2);
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("{\"id\":1}", 8, &worker, 1, NULL), TTSDKJSON_ERROR_INVALID_DATA);
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("[1,{\"a\":2}", 10, &worker, 1, NULL),
+                   TTSDKJSON_ERROR_INCOMPLETE);
+    const char *truncated[] = { "[", "[ ", "[1,", "[1, ", "" };
+    for (int i = 0; i < 5; i++) {
+        XCTAssertEqual(ttsdkjson_decodeArrayInParallel(truncated[i], (int)strlen(truncated[i]), &worker, 1, NULL),
+                       TTSDKJSON_ERROR_INCOMPLETE, @"%s", truncated[i]);
+    }
+    TTSDKJSONArrayWorker workers[3] = { worker, worker, worker };
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("[1,", 3, workers, 3, NULL), TTSDKJSON_ERROR_INCOMPLETE);
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("[ ]", 3, workers, 3, NULL), TTSDKJSON_OK);
+    int errorOffset = 0;
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("[1,{\"a\" 2}]", 12, &worker, 1, &errorOffset),
+                   TTSDKJSON_ERROR_INVALID_CHARACTER);
+    XCTAssertEqual(errorOffset, 8);
+    XCTAssertEqual(ttsdkjson_decodeArrayInParallel("[1]", 3, &worker, TTSDKJSON_MAX_ARRAY_WORKERS + 1, NULL),
+                   TTSDKJSON_ERROR_INVALID_DATA);
+}
+
+- (int)openTemporaryFileWithData:(NSData *)data {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"TTSDKRecords.ndjson"];
+    [data writeToFile:path atomically:YES];
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    return fd;
+}
+
+- (void)testRecordsRoundTripThroughFile {
+    char outputBuffer[16];
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    ttsdkjson_setOutputBuffer(&context, outputBuffer, sizeof(outputBuffer));
+    XCTAssertEqual(ttsdkjson_endRecord(&context), TTSDKJSON_OK);
+    XCTAssertEqual(_sink.length, 0);
+    ttsdkjson_beginObject(&context, NULL);
+    ttsdkjson_addIntegerElement(&context, "id", 1);
+    ttsdkjson_beginArray(&context, "lines");
+    ttsdkjson_addStringElement(&context, NULL, "first\nsecond", TTSDKJSON_SIZE_AUTOMATIC);
+    XCTAssertEqual(ttsdkjson_endRecord(&context), TTSDKJSON_OK);
+    XCTAssertEqual(ttsdkjson_endRecord(&context), TTSDKJSON_OK);
+    ttsdkjson_addIntegerElement(&context, NULL, 42);
+    XCTAssertEqual(ttsdkjson_endRecord(&context), TTSDKJSON_OK);
+    ttsdkjson_beginObject(&context, NULL);
+    ttsdkjson_addStringElement(&context, "name", "last", TTSDKJSON_SIZE_AUTOMATIC);
+    XCTAssertEqual(ttsdkjson_endRecord(&context), TTSDKJSON_OK);
+    NSString *records = [self encodedString];
+    XCTAssertEqualObjects(records, @"{\"id\":1,\"lines\":[\"first\\nsecond\"]}\n42\n{\"name\":\"last\"}\n");
+
+    int fd = [self openTemporaryFileWithData:[records dataUsingEncoding:NSUTF8StringEncoding]];
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    _sink.length = 0;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    char readBuffer[5];
+    char stringBuffer[100];
+    TTSDKJSONRecordReader reader;
+    ttsdkjson_beginRecordReader(&reader, fd, readBuffer, sizeof(readBuffer), stringBuffer, sizeof(stringBuffer),
+                                &g_reencodeCallbacks, &context);
+    int result = TTSDKJSON_OK;
+    int lineNumber = 0;
+    for (int expectedLine = 1; expectedLine <= 3; expectedLine++) {
+        XCTAssertTrue(ttsdkjson_readRecord(&reader, &result, &lineNumber));
+        XCTAssertEqual(result, TTSDKJSON_OK);
+        XCTAssertEqual(lineNumber, expectedLine);
+        ttsdkjson_endRecord(&context);
+    }
+    XCTAssertFalse(ttsdkjson_readRecord(&reader, &result, &lineNumber));
+    close(fd);
+    XCTAssertEqualObjects([self encodedString], records);
+}
+
+- (void)testRecordReaderSkipsBadRecords {
+    NSString *records = @"{\"a\":1} \r\n\n  \r\n{\"a\" 2}\n[1,2\n{} {}\n7 8\n  \"last\"";
+    int fd = [self openTemporaryFileWithData:[records dataUsingEncoding:NSUTF8StringEncoding]];
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    TTSDKJSONEncodeContext context;
+    ttsdkjson_beginEncode(&context, false, addToTestSink, &_sink);
+    char readBuffer[3];
+    char stringBuffer[100];
+    TTSDKJSONRecordReader reader;
+    ttsdkjson_beginRecordReader(&reader, fd, readBuffer, sizeof(readBuffer), stringBuffer, sizeof(stringBuffer),
+                                &g_reencodeCallbacks, &context);
+    const int expectedResults[] = { TTSDKJSON_OK,
+                                    TTSDKJSON_ERROR_INVALID_CHARACTER,
+                                    TTSDKJSON_ERROR_INCOMPLETE,
+                                    TTSDKJSON_ERROR_INVALID_CHARACTER,
+                                    TTSDKJSON_ERROR_INVALID_CHARACTER,
+                                    TTSDKJSON_OK };
+    const int expectedLines[] = { 1, 4, 5, 6, 7, 8 };
+    for (int i = 0; i < 6; i++) {
+        int result = TTSDKJSON_OK;
+        int lineNumber = 0;
+        XCTAssertTrue(ttsdkjson_readRecord(&reader, &result, &lineNumber));
+        XCTAssertEqual(result, expectedResults[i], @"record %d", i);
+        XCTAssertEqual(lineNumber, expectedLines[i], @"record %d", i);
+        ttsdkjson_endRecord(&context);
+    }
+    int result = TTSDKJSON_OK;
+    XCTAssertFalse(ttsdkjson_readRecord(&reader, &result, NULL));
+    close(fd);
+    XCTAssertTrue([[self encodedString] hasSuffix:@"\"last\"\n"]);
+}
+
+- (void)testEscapingThroughput {
+    const NSUInteger length = 4 * 1024 * 1024;
+    NSData *text = [self consoleLogLikeTextOfLength:length];
+    const int iterations = 10;
+    __block CFTimeInterval elapsed = 0;
+    [self measureBlock:^{
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (int i = 0; i < iterations; i++) {
+            self->_sink.length = 0;
+            TTSDKJSONEncodeContext context;
+            ttsdkjson_beginEncode(&context, false, addToTestSink, &self->_sink);
+            ttsdkjson_beginStringElement(&context, NULL);
+            ttsdkjson_appendStringElement(&context, text.bytes, (int)text.length);
+            ttsdkjson_endStringElement(&context);
+        }
+        elapsed += CFAbsoluteTimeGetCurrent() - start;
+    }];
+    double megabytes = (double)length * iterations * 10 / (1024 * 1024);
+    NSLog(@"JSON string escaping: %.1f MB/s", megabytes / elapsed);
+}
+
+@end
@@ -0,0 +1,193 @@
+//
+//  TTSDKJSONTapeTests.m
+//  TikTokBusinessSDKTests
+//
+//  Created by TikTok on 2026/10/16.
+//  Copyright © 2026 TikTok. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TTSDKJSONCodecObjC.h"
+#import "TTSDKJSONTape.h"
+
+@interface TTSDKJSONTapeTests : XCTestCase
+@end
+
+@implementation TTSDKJSONTapeTests {
+    TTSDKJSONTape _tape;
+}
+
+- (void)setUp {
+    [super setUp];
+    ttsdktape_init(&_tape);
+}
+
+- (void)tearDown {
+    ttsdktape_free(&_tape);
+    [super tearDown];
+}
+
+- (int)parse:(NSString *)json options:(int)options {
+    NSData *data = [json dataUsingEncoding:NSUTF8StringEncoding];
+    int errorOffset = 0;
+    return ttsdktape_parse(&_tape, data.bytes, (int)data.length, NULL, options, &errorOffset);
+}
+
+- (int)member:(int)object key:(const char *)key {
+    return ttsdktape_member(&_tape, object, key, (int)strlen(key));
+}
+
+- (void)testScalars {
+    XCTAssertEqual([self parse:@"[true,false,null,-5,18446744073709551615,1.5,\"a\\nb\"]" options:0], TTSDKJSON_OK);
+    int root = ttsdktape_root(&_tape);
+    XCTAssertEqual(ttsdktape_type(&_tape, root), TTSDKJSONTapeTypeArray);
+    XCTAssertEqual(ttsdktape_count(&_tape, root), 7);
+    XCTAssertTrue(ttsdktape_boolean(&_tape, ttsdktape_element(&_tape, root, 0)));
+    XCTAssertFalse(ttsdktape_boolean(&_tape, ttsdktape_element(&_tape, root, 1)));
+    XCTAssertEqual(ttsdktape_type(&_tape, ttsdktape_element(&_tape, root, 2)), TTSDKJSONTapeTypeNull);
+    XCTAssertEqual(ttsdktape_integer(&_tape, ttsdktape_element(&_tape, root, 3)), -5);
+    XCTAssertEqual(ttsdktape_unsignedInteger(&_tape, ttsdktape_element(&_tape, root, 4)), UINT64_MAX);
+    XCTAssertEqual(ttsdktape_floatingPoint(&_tape, ttsdktape_element(&_tape, root, 5)), 1.5);
+    XCTAssertEqual(ttsdktape_integer(&_tape, ttsdktape_element(&_tape, root, 5)), 1);
+    int length = 0;
+    const char *string = ttsdktape_string(&_tape, ttsdktape_element(&_tape, root, 6), &length);
+    XCTAssertEqual(length, 3);
+    XCTAssertEqual(strcmp(string, "a\nb"), 0);
+    XCTAssertEqual(ttsdktape_element(&_tape, root, 7), TTSDKJSON_TAPE_NONE);
+    XCTAssertEqual(ttsdktape_string(&_tape, ttsdktape_element(&_tape, root, 3), NULL), NULL);
+}
+
+- (void)testNextSkipsContainers {
+    XCTAssertEqual([self parse:@"[[1,[2,3],{\"a\":[4]}],\"x\"]" options:0], TTSDKJSON_OK);
+    int root = ttsdktape_root(&_tape);
+    int first = ttsdktape_element(&_tape, root, 0);
+    int second = ttsdktape_element(&_tape, root, 1);
+    XCTAssertEqual(ttsdktape_next(&_tape, first), second);
+    XCTAssertEqual(ttsdktape_type(&_tape, second), TTSDKJSONTapeTypeString);
+    XCTAssertEqual(ttsdktape_next(&_tape, root), _tape.entryCount);
+}
+
+- (void)testMembers {
+    for (int memberCount = 0; memberCount < 40; memberCount++) {
+        NSMutableString *json = [NSMutableString stringWithString:@"{"];
+        for (int i = 0; i < memberCount; i++) {
+            [json appendFormat:@"%@\"key%d\":%d", i == 0 ? @"" : @",", i, i];
+        }
+        [json appendString:@"}"];
+        XCTAssertEqual([self parse:json options:0], TTSDKJSON_OK);
+        int root = ttsdktape_root(&_tape);
+        XCTAssertEqual(ttsdktape_count(&_tape, root), memberCount);
+        for (int i = 0; i < memberCount; i++) {
+            char key[20];
+            snprintf(key, sizeof(key), "key%d", i);
+            int value = [self member:root key:key];
+            XCTAssertEqual(ttsdktape_integer(&_tape, value), i);
+            const char *name = NULL;
+            XCTAssertEqual(ttsdktape_memberAt(&_tape, root, i, &name, NULL), value);
+            XCTAssertEqual(strcmp(name, key), 0);
+        }
+        XCTAssertEqual([self member:root key:"key"], TTSDKJSON_TAPE_NONE);
+    }
+}
+
+- (void)testRepeatedKeyFindsLast {
+    XCTAssertEqual([self parse:@"{\"a\":1,\"b\":2,\"a\":3}" options:0], TTSDKJSON_OK);
+    XCTAssertEqual(ttsdktape_integer(&_tape, [self member:ttsdktape_root(&_tape) key:"a"]), 3);
+}
+
+- (void)testIgnoreNulls {
+    NSString *json = @"{\"a\":null,\"b\":[null,1,null]}";
+    XCTAssertEqual([self parse:json options:TTSDKJSONTapeOptionIgnoreNullInArray | TTSDKJSONTapeOptionIgnoreNullInObject],
+                   TTSDKJSON_OK);
+    int root = ttsdktape_root(&_tape);
+    XCTAssertEqual(ttsdktape_count(&_tape, root), 1);
+    XCTAssertEqual(ttsdktape_count(&_tape, [self member:root key:"b"]), 1);
+}
+
+- (void)testPartialDocumentIsClosed {
+    XCTAssertNotEqual([self parse:@"{\"a\":[1,{\"b\":\"c\"" options:0], TTSDKJSON_OK);
+    int root = ttsdktape_root(&_tape);
+    int array = [self member:root key:"a"];
+    XCTAssertEqual(ttsdktape_count(&_tape, array), 2);
+    int object = ttsdktape_element(&_tape, array, 1);
+    XCTAssertEqual(strcmp(ttsdktape_string(&_tape, [self member:object key:"b"], NULL), "c"), 0);
+    XCTAssertEqual(ttsdktape_next(&_tape, root), _tape.entryCount);
+}
+
+- (void)testReuseAndFree {
+    XCTAssertEqual([self parse:@"[1,2,3]" options:0], TTSDKJSON_OK);
+    XCTAssertEqual([self parse:@"{\"x\":true}" options:0], TTSDKJSON_OK);
+    XCTAssertTrue(ttsdktape_boolean(&_tape, [self member:ttsdktape_root(&_tape) key:"x"]));
+    ttsdktape_free(&_tape);
+    XCTAssertEqual(ttsdktape_root(&_tape), TTSDKJSON_TAPE_NONE);
+    XCTAssertEqual([self parse:@"[]" options:0], TTSDKJSON_OK);
+    XCTAssertEqual(ttsdktape_count(&_tape, ttsdktape_root(&_tape)), 0);
+}
+
+- (void)testLazyDecodeMatchesDecode {
+    NSString *json = @"{\"a\":[1,-2,3.5,true,null,\"s\"],\"b\":{\"c\":{\"d\":\"e\"}},\"f\":null,\"g\":18446744073709551615}";
+    NSData *data = [json dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error = nil;
+    id expected = [TTSDKJSONCodec decode:data options:TTSDKJSONDecodeOptionIgnoreNullInObject error:&error];
+    XCTAssertNil(error);
+    id actual = [TTSDKJSONCodec decode:data
+                               options:TTSDKJSONDecodeOptionIgnoreNullInObject | TTSDKJSONDecodeOptionLazy
+                                 error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(actual, expected);
+    XCTAssertEqualObjects(actual[@"b"][@"c"][@"d"], @"e");
+    XCTAssertNil(actual[@"f"]);
+    XCTAssertEqual([actual copy], actual);
+    NSMutableDictionary *mutableCopy = [actual mutableCopy];
+    mutableCopy[@"h"] = @1;
+    XCTAssertEqual(mutableCopy.count, 4u);
+}
+
+- (void)testLazyDecodeSkipsMembersThatArentUTF8 {
+    NSData *data = [NSData dataWithBytes:"{\"a\":\"\xff\",\"b\":1,\"\xfe\":2,\"c\":[\"\xff\"]}" length:31];
+    NSError *error = nil;
+    NSDictionary *lazy = [TTSDKJSONCodec decode:data options:TTSDKJSONDecodeOptionLazy error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqual(lazy.count, 2u);
+    XCTAssertEqualObjects(lazy.allKeys, (@[ @"b", @"c" ]));
+    XCTAssertEqualObjects(lazy, (@{@"b" : @1, @"c" : @[ [NSNull null] ]}));
+    NSMutableDictionary *mutableCopy = [lazy mutableCopy];
+    XCTAssertEqual(mutableCopy.count, 2u);
+}
+
+- (void)testLazyLookupUsesWholeKey {
+    NSData *data = [@"{\"a\":1}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error = nil;
+    NSDictionary *lazy = [TTSDKJSONCodec decode:data options:TTSDKJSONDecodeOptionLazy error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(lazy[@"a"], @1);
+    XCTAssertNil(lazy[@"a\0b"]);
+}
+
+- (void)testIntegerOfOutOfRangeDouble {
+    XCTAssertEqual([self parse:@"[1e300,-1e300,-5.5,2.5]" options:0], TTSDKJSON_OK);
+    int root = ttsdktape_root(&_tape);
+    XCTAssertEqual(ttsdktape_integer(&_tape, ttsdktape_element(&_tape, root, 0)), INT64_MAX);
+    XCTAssertEqual(ttsdktape_integer(&_tape, ttsdktape_element(&_tape, root, 1)), INT64_MIN);
+    XCTAssertEqual(ttsdktape_unsignedInteger(&_tape, ttsdktape_element(&_tape, root, 0)), UINT64_MAX);
+    XCTAssertEqual(ttsdktape_unsignedInteger(&_tape, ttsdktape_element(&_tape, root, 2)), 0u);
+    XCTAssertEqual(ttsdktape_integer(&_tape, ttsdktape_element(&_tape, root, 3)), 2);
+}
+
+- (void)testLazyDecodeErrors {
+    NSData *data = [@"{\"a\":[1,2" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error = nil;
+    XCTAssertNil([TTSDKJSONCodec decode:data options:TTSDKJSONDecodeOptionLazy error:&error]);
+    XCTAssertNotNil(error);
+    id partial = [TTSDKJSONCodec decode:data
+                                options:TTSDKJSONDecodeOptionLazy | TTSDKJSONDecodeOptionKeepPartialObject
+                                  error:&error];
+    XCTAssertNotNil(error);
+    XCTAssertEqualObjects(partial, (@{@"a" : @[ @1, @2 ]}));
+
+    data = [@"\"top level string\"" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertNil([TTSDKJSONCodec decode:data options:TTSDKJSONDecodeOptionLazy error:&error]);
+    XCTAssertNotNil(error);
+}
+
+@end
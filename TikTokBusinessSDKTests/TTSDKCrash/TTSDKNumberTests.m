@@ -0,0 +1,356 @@
+//
+//  TTSDKNumberTests.m
+//  TikTokBusinessSDKTests
+//
+//  Created by TikTok on 2026/10/16.
+//  Copyright © 2026 TikTok. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <inttypes.h>
+#import "TTSDKNumber.h"
+
+static uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/** Writes the point halfway between mantissa * 2^exponent and the next double up exactly, as
+ * "d.ddd...e<power>", and returns its length. */
+static int writeHalfway(char *buffer, uint64_t mantissa, int exponent)
+{
+    // (2 * mantissa + 1) * 2^(exponent - 1), or * 5^(1 - exponent) / 10^(1 - exponent), in
+    // little-endian decimal digits.
+    char digits[1200];
+    int count = 0;
+    for (uint64_t odd = 2 * mantissa + 1; odd != 0; odd /= 10) {
+        digits[count++] = (char)(odd % 10);
+    }
+    const int factor = exponent > 0 ? 2 : 5;
+    for (int i = 0; i < abs(exponent - 1); i++) {
+        int carry = 0;
+        for (int j = 0; j < count; j++) {
+            const int product = digits[j] * factor + carry;
+            digits[j] = (char)(product % 10);
+            carry = product / 10;
+        }
+        if (carry != 0) {
+            digits[count++] = (char)carry;
+        }
+    }
+    int length = 0;
+    for (int j = count - 1; j >= 0; j--) {
+        buffer[length++] = (char)('0' + digits[j]);
+        if (j == count - 1) {
+            buffer[length++] = '.';
+        }
+    }
+    return length + sprintf(buffer + length, "e%d", count - 1 + (exponent > 0 ? 0 : exponent - 1));
+}
+
+@interface TTSDKNumberTests : XCTestCase
+@end
+
+@implementation TTSDKNumberTests
+
+- (NSString *)formatDouble:(double)value {
+    char buffer[TTSDKNUM_DOUBLE_BUFFER_SIZE];
+    int length = ttsdknum_formatDouble(value, buffer);
+    XCTAssertEqual(length, (int)strlen(buffer));
+    return @(buffer);
+}
+
+- (void)testIntegersMatchPrintf {
+    const int64_t signedValues[] = { 0, 1, -1, 9, 10, -10, 99, 100, INT64_MAX, INT64_MIN, 1234567890123 };
+    char buffer[TTSDKNUM_INTEGER_BUFFER_SIZE];
+    char expected[32];
+    for (size_t i = 0; i < sizeof(signedValues) / sizeof(*signedValues); i++) {
+        ttsdknum_formatInt64(signedValues[i], buffer);
+        snprintf(expected, sizeof(expected), "%" PRId64, signedValues[i]);
+        XCTAssertEqual(strcmp(buffer, expected), 0, @"%s != %s", buffer, expected);
+    }
+
+    uint64_t state = 88172645463325252ull;
+    for (int i = 0; i < 200000; i++) {
+        uint64_t value = nextRandom(&state) >> (nextRandom(&state) % 64);
+        int length = ttsdknum_formatUInt64(value, buffer);
+        snprintf(expected, sizeof(expected), "%" PRIu64, value);
+        XCTAssertEqual(length, (int)strlen(expected));
+        XCTAssertEqual(strcmp(buffer, expected), 0, @"%s != %s", buffer, expected);
+    }
+}
+
+- (void)testDoubleLayout {
+    XCTAssertEqualObjects([self formatDouble:0.0], @"0.0");
+    XCTAssertEqualObjects([self formatDouble:-0.0], @"-0.0");
+    XCTAssertEqualObjects([self formatDouble:1.0], @"1.0");
+    XCTAssertEqualObjects([self formatDouble:0.1], @"0.1");
+    XCTAssertEqualObjects([self formatDouble:0.3], @"0.3");
+    XCTAssertEqualObjects([self formatDouble:123.456], @"123.456");
+    XCTAssertEqualObjects([self formatDouble:100.0], @"100.0");
+    XCTAssertEqualObjects([self formatDouble:0.0001], @"0.0001");
+    XCTAssertEqualObjects([self formatDouble:1e-5], @"1e-05");
+    XCTAssertEqualObjects([self formatDouble:-2.5e-7], @"-2.5e-07");
+    XCTAssertEqualObjects([self formatDouble:1e21], @"1e+21");
+    XCTAssertEqualObjects([self formatDouble:5e-324], @"5e-324");
+    XCTAssertEqualObjects([self formatDouble:1.7976931348623157e308], @"1.7976931348623157e+308");
+    XCTAssertEqualObjects([self formatDouble:1729591200.123], @"1729591200.123");
+}
+
+- (void)testDoublesRoundTripThroughStrtod {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    char buffer[TTSDKNUM_DOUBLE_BUFFER_SIZE];
+    int failures = 0;
+    for (int i = 0; i < 1000000 && failures < 10; i++) {
+        double value;
+        switch (i % 3) {
+            case 0: {
+                uint64_t bits = nextRandom(&state);
+                memcpy(&value, &bits, sizeof(value));
+                break;
+            }
+            case 1:
+                value = (double)(nextRandom(&state) % 100000000) / (double)(1 + nextRandom(&state) % 10000);
+                break;
+            default:
+                value = (double)(int64_t)(nextRandom(&state) >> (nextRandom(&state) % 64));
+                break;
+        }
+        if (!isfinite(value)) {
+            continue;
+        }
+        ttsdknum_formatDouble(value, buffer);
+        double parsed = strtod(buffer, NULL);
+        if (memcmp(&parsed, &value, sizeof(value)) != 0) {
+            XCTFail(@"%s does not round trip to %.17g", buffer, value);
+            failures++;
+        }
+    }
+}
+
+- (void)testFormattingThroughput {
+    const int count = 4096;
+    double values[count];
+    uint64_t state = 1;
+    for (int i = 0; i < count; i++) {
+        values[i] = 1729591200.0 + (double)(nextRandom(&state) % 1000000) / 1000.0;
+    }
+    char buffer[64];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < count; i++) {
+            ttsdknum_formatDouble(values[i], buffer);
+        }
+    }
+    CFTimeInterval builtIn = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < count; i++) {
+            snprintf(buffer, sizeof(buffer), "%.17g", values[i]);
+        }
+    }
+    CFTimeInterval snprintfTime = CFAbsoluteTimeGetCurrent() - start;
+    NSLog(@"Double formatting: %.1f ns built in, %.1f ns snprintf", builtIn * 1e9 / (count * 100),
+          snprintfTime * 1e9 / (count * 100));
+}
+
+/** Random number text: plain and long integers, fractions, exponents and %.17g output. */
+- (int)randomNumberText:(char *)buffer state:(uint64_t *)state {
+    int length = 0;
+    if (nextRandom(state) % 2) {
+        buffer[length++] = '-';
+    }
+    const int kind = (int)(nextRandom(state) % 8);
+    if (kind == 0) {
+        uint64_t bits = nextRandom(state);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return length + snprintf(buffer + length, 40, "%.17g", isfinite(value) ? fabs(value) : 1.5);
+    }
+    const int integerDigits = 1 + (int)(nextRandom(state) % (kind == 1 ? 40 : 20));
+    for (int i = 0; i < integerDigits; i++) {
+        buffer[length++] = (char)('0' + nextRandom(state) % 10);
+    }
+    if (kind >= 3) {
+        buffer[length++] = '.';
+        const int fractionDigits = (int)(nextRandom(state) % (kind == 3 ? 40 : 20));
+        for (int i = 0; i < fractionDigits; i++) {
+            buffer[length++] = (char)('0' + nextRandom(state) % 10);
+        }
+    }
+    if (kind >= 5) {
+        buffer[length++] = nextRandom(state) % 2 ? 'e' : 'E';
+        const int exponent = (int)(nextRandom(state) % (kind == 7 ? 700 : 40)) - (kind == 7 ? 350 : 20);
+        length += snprintf(buffer + length, 8, "%d", exponent);
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+- (void)testParsingMatchesStrtod {
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    char buffer[128];
+    int failures = 0;
+    for (int i = 0; i < 1000000 && failures < 10; i++) {
+        const int length = [self randomNumberText:buffer state:&state];
+        TTSDKNumber number;
+        const char *end = ttsdknum_parse(buffer, buffer + length, &number);
+        char *expectedEnd = NULL;
+        errno = 0;
+        BOOL matches;
+        if (number.type == TTSDKNumberTypeInt64) {
+            matches = strtoll(buffer, &expectedEnd, 10) == number.int64Value && errno == 0;
+        } else if (number.type == TTSDKNumberTypeUInt64) {
+            matches = strtoull(buffer, &expectedEnd, 10) == number.uint64Value && errno == 0 && buffer[0] != '-';
+        } else {
+            const double expected = strtod(buffer, &expectedEnd);
+            matches = memcmp(&expected, &number.doubleValue, sizeof(expected)) == 0;
+        }
+        if (!matches || end != expectedEnd) {
+            XCTFail(@"%s parsed wrongly", buffer);
+            failures++;
+        }
+    }
+}
+
+- (void)testParsingEdgeCases {
+    NSDictionary<NSString *, NSNumber *> *doubles = @{
+        @"0.1" : @0.1,
+        @"-0.0" : @-0.0,
+        @"1e-400" : @0.0,
+        @"1e400" : @(INFINITY),
+        @"4.9406564584124654e-324" : @5e-324,
+        @"2.4703282292062328e-324" : @5e-324,
+        @"2.2250738585072011e-308" : @2.2250738585072011e-308,
+        @"1.7976931348623157e308" : @1.7976931348623157e308,
+        @"9007199254740993.0" : @9007199254740992.0,
+        @"18446744073709551616" : @18446744073709551616.0,
+        @"-9223372036854775809" : @-9223372036854775808.0,
+        @"0.000000000000000000000000000001234567890123456789012345" : @1.234567890123456789012345e-30,
+        // Exactly halfway between two doubles: rounds to even.
+        @"9007199254740993.000000000000000000000" : @9007199254740992.0,
+        @"9007199254740995.000000000000000000000" : @9007199254740996.0,
+        @"9007199254740993.000000000000000000001" : @9007199254740994.0,
+    };
+    for (NSString *text in doubles) {
+        TTSDKNumber number;
+        XCTAssertTrue(ttsdknum_parse(text.UTF8String, text.UTF8String + text.length, &number) != NULL);
+        XCTAssertEqual(number.type, TTSDKNumberTypeDouble, @"%@", text);
+        const double expected = doubles[text].doubleValue;
+        XCTAssertEqual(memcmp(&number.doubleValue, &expected, sizeof(expected)), 0, @"%@ -> %.17g", text,
+                       number.doubleValue);
+    }
+
+    TTSDKNumber number;
+    const char *text = "-9223372036854775808";
+    XCTAssertEqual(ttsdknum_parse(text, text + strlen(text), &number), text + strlen(text));
+    XCTAssertEqual(number.type, TTSDKNumberTypeInt64);
+    XCTAssertEqual(number.int64Value, INT64_MIN);
+    text = "18446744073709551615";
+    ttsdknum_parse(text, text + strlen(text), &number);
+    XCTAssertEqual(number.type, TTSDKNumberTypeUInt64);
+    XCTAssertEqual(number.uint64Value, UINT64_MAX);
+    text = "00012345678901234567890,";
+    XCTAssertEqual(ttsdknum_parse(text, text + strlen(text), &number), text + strlen(text) - 1);
+    XCTAssertEqual(number.type, TTSDKNumberTypeUInt64);
+    XCTAssertEqual(number.uint64Value, 12345678901234567890ull);
+
+    // Parsing stops where the number does.
+    text = "1e+";
+    XCTAssertEqual(ttsdknum_parse(text, text + strlen(text), &number), text + 1);
+    XCTAssertEqual(number.type, TTSDKNumberTypeInt64);
+    XCTAssertEqual(number.int64Value, 1);
+    text = "12345678.5";
+    XCTAssertEqual(ttsdknum_parse(text, text + 4, &number), text + 4);
+    XCTAssertEqual(number.int64Value, 1234);
+    text = "-x";
+    XCTAssertTrue(ttsdknum_parse(text, text + strlen(text), &number) == NULL);
+    text = ".5";
+    XCTAssertTrue(ttsdknum_parse(text, text + strlen(text), &number) == NULL);
+}
+
+- (void)testParsingLongNumbersNearHalfway {
+    static char halfway[1200];
+    static char text[2100];
+    uint64_t state = 0x6A09E667F3BCC909ull;
+    int failures = 0;
+    for (int i = 0; i < 3000 && failures < 10; i++) {
+        const uint64_t mantissa = (1ull << 52) | (nextRandom(&state) & ((1ull << 52) - 1));
+        const int exponent = (int)(nextRandom(&state) % 2046) - 1074;
+        writeHalfway(halfway, mantissa, exponent);
+        const char *power = strchr(halfway, 'e');
+        const int digits = (int)(power - halfway);
+        // Exactly halfway, just above it past the 768th digit, and just below it.
+        for (int variant = 0; variant < 3; variant++) {
+            int length = digits;
+            memcpy(text, halfway, digits);
+            if (variant == 1) {
+                memset(text + length, '0', 800);
+                length += 800;
+                text[length++] = '1';
+            } else if (variant == 2) {
+                int last = length - 1;
+                for (; text[last] == '0' || text[last] == '.'; last--) {
+                    if (text[last] == '0') {
+                        text[last] = '9';
+                    }
+                }
+                text[last]--;
+                memset(text + length, '9', 800);
+                length += 800;
+            }
+            length += sprintf(text + length, "%s", power);
+
+            TTSDKNumber number;
+            const char *end = ttsdknum_parse(text, text + length, &number);
+            const double expected = strtod(text, NULL);
+            if (end != text + length || number.type != TTSDKNumberTypeDouble ||
+                memcmp(&expected, &number.doubleValue, sizeof(expected)) != 0) {
+                XCTFail(@"%.40s...%s parsed wrongly", text, power);
+                failures++;
+            }
+        }
+    }
+}
+
+- (void)testParsingThroughput {
+    const int count = 4096;
+    const int stride = 32;
+    char *texts = calloc(count, stride);
+    uint64_t state = 1;
+    for (int i = 0; i < count; i++) {
+        if (i % 2) {
+            snprintf(texts + i * stride, stride, "%llu", 0x100000000ull + nextRandom(&state) % 0x100000000ull);
+        } else {
+            snprintf(texts + i * stride, stride, "%.3f", 1729591200.0 + (double)(nextRandom(&state) % 1000000) / 1000.0);
+        }
+    }
+    volatile double sink = 0;
+    TTSDKNumber number;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < count; i++) {
+            const char *text = texts + i * stride;
+            ttsdknum_parse(text, text + strlen(text), &number);
+            sink += number.doubleValue;
+        }
+    }
+    CFTimeInterval builtIn = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < count; i++) {
+            sink += strtod(texts + i * stride, NULL);
+        }
+    }
+    CFTimeInterval strtodTime = CFAbsoluteTimeGetCurrent() - start;
+    free(texts);
+    NSLog(@"Number parsing: %.1f ns built in, %.1f ns strtod", builtIn * 1e9 / (count * 100),
+          strtodTime * 1e9 / (count * 100));
+}
+
+@end